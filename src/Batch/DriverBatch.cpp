@@ -108,13 +108,16 @@ bool DriverBatch::run()
     connect(pollThread, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
 
     connect(pollThread, SIGNAL(newVCP(const int)),diagPanel, SLOT(updateVCP(const int)));
-    connect(pollThread, SIGNAL(newCappi(GriddedData)),cappiDisplay, SLOT(constructImage(GriddedData)),Qt::DirectConnection);
+    connect(pollThread, SIGNAL(newCappi(CappiSnapshot)),cappiDisplay, SLOT(constructImage(CappiSnapshot)),Qt::QueuedConnection);
 
     connect(pollThread, SIGNAL(newCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),
             this, SLOT(updateCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),Qt::DirectConnection);
     connect(pollThread, SIGNAL(newCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),
             cappiDisplay, SLOT(setGBVTDResults(float, float, float, float, float, float, float ,float ,float, float)),Qt::DirectConnection);
     connect(pollThread, SIGNAL(vortexListUpdate(VortexList*)),this, SLOT(pollVortexUpdate(VortexList*)),Qt::DirectConnection);
+    // Queued behind the cappi, so the display already holds this volume
+    if (!configData->getSnapshot().cappi.imageDir.isEmpty())
+        connect(pollThread, SIGNAL(volumeAnalyzed(const QDateTime&)),this, SLOT(saveCappiImage(const QDateTime&)),Qt::QueuedConnection);
 
     atcf = new ATCF(configData);
     connect(atcf, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
@@ -128,9 +131,12 @@ bool DriverBatch::run()
     fetchremote = new FetchRemote(configData);
     connect(fetchremote, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
 
-    bool continuePreviousRun = false;
+    // <resume>true</resume> in the vortex section picks up a previous run
+    // from the lists in the working directory
+    bool continuePreviousRun = ("true" == configData->getParam(configData->getConfig("vortex"), "resume"));
 
     //set a flag in pollThread if continue previous run or not
+    pollThread->setContinuePreviousRun(continuePreviousRun);
     // Try to fetch new radar data every 5 minutes
     QString mode = configData->getParam(configData->getConfig("vortex"), "mode");
     if (mode == "operational") {
@@ -150,7 +156,6 @@ bool DriverBatch::run()
         madisTimer->start(1800000);
 
     } else {
-        pollThread->setContinuePreviousRun(continuePreviousRun);
         pollThread->setConfig(configData);
         thread->start();
 
@@ -253,3 +258,21 @@ void DriverBatch::updateTcvitals()
 //        thread->start();
 //    }
 }
+
+void DriverBatch::saveCappiImage(const QDateTime& volumeTime)
+{
+    // Named like the cappi file of the same volume
+    const CappiSettings& cappi = configData->getSnapshot().cappi;
+    QDir imageDir(cappi.imageDir);
+    if (imageDir.isRelative())
+        imageDir = QDir(workingDirectory.filePath(cappi.imageDir));
+    if (!imageDir.exists() && !imageDir.mkpath(imageDir.path())) {
+        emit log(Message(QString("Failed to create image directory: "+imageDir.path()),0,this->objectName()));
+        return;
+    }
+    QString fileName = volumeTime.toString(Qt::ISODate);
+    fileName.replace(QString(":"),QString("_"));
+    fileName = imageDir.filePath(fileName + ".png");
+    if (!cappiDisplay->renderToFile(fileName, cappi.imageSize, cappi.imageSize))
+        emit log(Message(QString("Could not save the cappi image "+fileName),0,this->objectName()));
+}
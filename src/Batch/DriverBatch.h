@@ -48,6 +48,7 @@ public:
 
 private slots:
     void updateTcvitals();
+    void saveCappiImage(const QDateTime& volumeTime);
 
 protected:
     QString xmlfile;
@@ -0,0 +1,352 @@
+/*
+ *  dealiasCheck.cpp
+ *  VORTRAC
+ *
+ *  Checks the dealiasers against the code they replaced. Random sweeps,
+ *  with missing gates, short and long rays and rays without velocities,
+ *  go through the old derivativeDealias and through RadarQC, one sweep
+ *  at a time and on the worker pool, and the velocities have to come out
+ *  bit for bit the same. BBWindow is checked against the sorted copy of
+ *  the window BB used to take its median from.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <math.h>
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QList>
+#include <QtAlgorithms>
+
+#include "Radar/RadarData.h"
+#include "NRL/RadarQC.h"
+
+static const float velNull = -999.;
+
+// Same numbers for the same seed on every platform, unlike rand()
+
+class Random {
+public:
+  Random(unsigned int seed) : state(seed * 2654435761u + 1) {}
+  int below(int n) {
+    state = state * 1664525u + 1013904223u;
+    return (int)((state >> 8) % (unsigned int)n);
+  }
+private:
+  unsigned int state;
+};
+
+// A volume of random sweeps. Rays own their velocities, as they do when
+// a radar file is read.
+
+class SyntheticRadar : public RadarData
+{
+public:
+  SyntheticRadar(unsigned int seed)
+    : RadarData("check", 25.0, -80.0, QCoreApplication::applicationFilePath())
+  {
+    altitude = 0;
+    vcp = 0;
+    radarDateTime = QDateTime::currentDateTimeUtc();
+
+    Random random(seed);
+    // RadarQC looks at the second sweep when it is set up
+    numSweeps = 2 + random.below(3);
+    QList<int> sweepRays, sweepGates;
+    numRays = 0;
+    for(int n = 0; n < numSweeps; n++) {
+      sweepRays << 2 + random.below(40);
+      sweepGates << 1 + random.below(30);
+      numRays += sweepRays.last();
+    }
+    Sweeps = new Sweep[numSweeps];
+    Rays = new Ray[numRays];
+
+    int first = 0;
+    for(int n = 0; n < numSweeps; n++) {
+      int rays = sweepRays.at(n);
+      int gates = sweepGates.at(n);
+      float nyquist = 8 + random.below(20);
+      Sweep& sweep = Sweeps[n];
+      sweep.setSweepIndex(n);
+      sweep.setElevation(0.5 + n);
+      sweep.setNyquist_vel(nyquist);
+      sweep.setRef_gatesp(250);
+      sweep.setVel_gatesp(250);
+      sweep.setVel_numgates(gates);
+      sweep.setFirstRay(first);
+      sweep.setLastRay(first + rays - 1);
+
+      for(int i = first; i < first + rays; i++) {
+	Ray& ray = Rays[i];
+	int rayGates = (random.below(5) == 0) ? random.below(gates + 5) : gates;
+	ray.setSweepIndex(n);
+	ray.setRayIndex(i);
+	ray.setElevation(0.5 + n);
+	ray.setAzimuth(360.0 * (i - first) / rays);
+	ray.setNyquist_vel(nyquist);
+	ray.setVel_gatesp(250);
+	ray.setFirst_vel_gate(0);
+	ray.setVel_numgates(rayGates);
+	if((rayGates == 0) || (random.below(15) == 0))
+	  continue;
+
+	float *velocities = new float[rayGates];
+	float base = random.below(60) - 30;
+	for(int j = 0; j < rayGates; j++) {
+	  float v = base + random.below(1000) / 100.0f * (random.below(2) ? 1 : -1);
+	  if(v > nyquist) v -= 2 * nyquist;
+	  if(v < -nyquist) v += 2 * nyquist;
+	  if(random.below(7) == 0) v = velNull;
+	  velocities[j] = v;
+	}
+	ray.setVelData(velocities);
+      }
+      first += rays;
+    }
+  }
+
+  ~SyntheticRadar()
+  {
+    delete [] Rays;
+    delete [] Sweeps;
+  }
+
+  bool readVolume() { return true; }
+};
+
+// derivativeDealias as it was before sweeps were dealiased on their own,
+// without the commented out code
+
+static void referenceDerivativeDealias(RadarData *radarData)
+{
+  for (int n = 0; n < radarData->getNumSweeps(); n++) {
+    Sweep* currentSweep = radarData->getSweep(n);
+    int rays = currentSweep->getNumRays();
+    int gates = currentSweep->getVel_numgates();
+    if (gates == 0) continue;
+
+    float nyquistVelocity = currentSweep->getNyquist_vel();
+    float** a1 = new float*[rays];
+    float** veldata = new float*[rays];
+    for (int i=0; i < rays; i++) {
+      a1[i] = new float[gates];
+      veldata[i] = new float[gates];
+      for (int j=0; j < gates; j++) {
+	a1[i][j] = veldata[i][j] = velNull;
+      }
+    }
+
+    float sum;
+    int ray_index;
+    for (int i=0; i < rays; i++)  {
+      for (int j=0; j < gates; j++) {
+	double weights[5] = { 1./12., -2./3., 0, 2./3., -1./12. };
+	sum = 0;
+	for (int m = i-2; m < i+3; m++) {
+	  ray_index = m + currentSweep->getFirstRay();
+	  if (ray_index < currentSweep->getFirstRay()) ray_index += rays;
+	  if (ray_index > currentSweep->getLastRay()) ray_index -= rays;
+	  Ray* currentRay = radarData->getRay(ray_index);
+	  float* raydata = currentRay->getVelData();
+	  int ri = (m >= rays) ? (m-rays) : m;
+	  ri = (ri < 0) ? (ri+rays) : ri;
+	  if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
+	    veldata[ri][j] = raydata[j];
+	  }
+	  if (veldata[ri][j] != velNull) {
+	    sum += weights[m-i+2]*veldata[ri][j];
+	  } else {
+	    sum = velNull;
+	    break;
+	  }
+	}
+	if (sum != velNull)
+	  a1[i][j] = fabs(sum);
+      }
+    }
+    for (int j=0; j < gates; j++) {
+      float mingrad = 1e34;
+      int startindex = 0;
+      for (int i=0; i < rays; i++)  {
+	if ((a1[i][j] != velNull) and (a1[i][j] < mingrad)) {
+	  mingrad = a1[i][j];
+	  startindex = i;
+	}
+      }
+      float startVelocity = veldata[startindex][j];
+      if(startVelocity==velNull)
+	continue;
+      for (int ri=startindex; ri < rays+startindex; ri++) {
+	int i = (ri >= rays) ? (ri-rays) : ri;
+	if(veldata[i][j]==velNull)
+	  continue;
+	int minfold = 0;
+	mingrad = 1e34;
+	for (int fold = -1; fold < 2; fold++) {
+	  double weights[3] = {1.0, -2.0, 1.0};
+	  sum = 0;
+	  for (int m = i-1; m < i+2; m++) {
+	    int ri = (m >= rays) ? (m-rays) : m;
+	    ri = (ri < 0) ? (ri+rays) : ri;
+	    if (veldata[ri][j] != velNull) {
+	      float tryVelocity = veldata[ri][j];
+	      if (ri == i) tryVelocity += (2.0*fold*nyquistVelocity);
+	      sum += weights[m-i+1]*tryVelocity;
+	    } else {
+	      sum = velNull;
+	      break;
+	    }
+	  }
+	  if ((sum != velNull) and (fabs(sum) < mingrad)) {
+	    mingrad = sum;
+	    minfold = fold;
+	  }
+	}
+	veldata[i][j]+= 2.0*minfold*(nyquistVelocity);
+	ray_index = i + currentSweep->getFirstRay();
+	Ray* currentRay = radarData->getRay(ray_index);
+	float* raydata = currentRay->getVelData();
+	if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
+	  raydata[j] = veldata[i][j];
+	}
+      }
+    }
+    for (int i=0; i < rays; i++)  {
+      delete[] veldata[i];
+      delete[] a1[i];
+    }
+    delete[] veldata;
+    delete[] a1;
+  }
+}
+
+// The median BB took from its window: the window with the newest value
+// replaced, sorted, element size/2
+
+static float referenceMedian(QList<float>& window, float value)
+{
+  int size = window.size();
+  QList<float> sortVelocity;
+  for(int m = 0; m < size-1; m++) {
+    sortVelocity << window[m];
+    window[m] = window[m+1];
+  }
+  sortVelocity << value;
+  window[size-1] = value;
+  qSort(sortVelocity);
+  return sortVelocity.at(size/2);
+}
+
+static bool sameVelocities(RadarData *a, RadarData *b)
+{
+  for(int i = 0; i < a->getNumRays(); i++) {
+    float *va = a->getRay(i)->getVelData();
+    float *vb = b->getRay(i)->getVelData();
+    if((va == NULL) || (vb == NULL))
+      continue;
+    if(memcmp(va, vb, a->getRay(i)->getVel_numgates() * sizeof(float)) != 0)
+      return false;
+  }
+  return true;
+}
+
+// Reaches the sweep and pool entry points of RadarQC
+
+class DealiasCheck {
+public:
+  static void bySweep(RadarQC& qc, DealiasWorkspace& workspace) {
+    for(int n = 0; n < qc.radarData->getNumSweeps(); n++)
+      qc.derivativeDealiasSweep(workspace, n);
+  }
+  static void onPool(RadarQC& qc, int threads) {
+    qc.numThreads = threads;
+    qc.derivativeDealias();
+  }
+};
+
+static void usage()
+{
+  std::cerr << "Usage: vortrac_dealias_check [options]\n"
+	    << "  --volumes n       number of random volumes (default 2000)\n"
+	    << "  --threads n       workers for the pooled run (default 4)\n";
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  int numVolumes = 2000;
+  int threads = 4;
+
+  QStringList args = app.arguments();
+  for(int i = 1; i < args.size(); i++) {
+    QString arg = args.at(i);
+    if(i + 1 >= args.size()) {
+      usage();
+      return 1;
+    }
+    QString value = args.at(++i);
+    if(arg == "--volumes") numVolumes = value.toInt();
+    else if(arg == "--threads") threads = value.toInt();
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  QcSettings qcSettings;
+  qcSettings.isSet = true;
+  qcSettings.windMethod = "user";
+
+  // One workspace for every volume, as a worker keeps it
+  DealiasWorkspace workspace;
+  int sweepMismatches = 0, poolMismatches = 0;
+  for(int v = 1; v <= numVolumes; v++) {
+    SyntheticRadar reference(v), bySweep(v), onPool(v);
+    referenceDerivativeDealias(&reference);
+
+    RadarQC sweepQC(&bySweep);
+    sweepQC.getConfig(qcSettings);
+    DealiasCheck::bySweep(sweepQC, workspace);
+    if(!sameVelocities(&reference, &bySweep))
+      sweepMismatches++;
+
+    RadarQC poolQC(&onPool);
+    poolQC.getConfig(qcSettings);
+    DealiasCheck::onPool(poolQC, threads);
+    if(!sameVelocities(&reference, &onPool))
+      poolMismatches++;
+  }
+  printf("derivativeDealias: %d volumes, %d differ by sweep, %d differ on the pool\n",
+	 numVolumes, sweepMismatches, poolMismatches);
+
+  Random random(1);
+  long windowMismatches = 0, medians = 0;
+  for(int size = 1; size <= 40; size++) {
+    for(int rep = 0; rep < 50; rep++) {
+      float start = random.below(20) - 10;
+      BBWindow window;
+      window.reset(size, start);
+      QList<float> reference;
+      for(int k = 0; k < size; k++)
+	reference << start;
+      for(int g = 0; g < 300; g++) {
+	// Repeats of the start value exercise the ties
+	float value = (random.below(7) == 0) ? start : (random.below(200) - 100) / 4.0f;
+	if(window.push(value) != referenceMedian(reference, value))
+	  windowMismatches++;
+	medians++;
+      }
+    }
+  }
+  printf("BBWindow: %ld medians, %ld differ\n", medians, windowMismatches);
+
+  return (sweepMismatches || poolMismatches || windowMismatches) ? 1 : 0;
+}
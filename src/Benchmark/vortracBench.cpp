@@ -0,0 +1,481 @@
+/*
+ *  vortracBench.cpp
+ *  VORTRAC
+ *
+ *  Runs synthetic volumes sampled from the analytic storm through the
+ *  analysis and reports the cost of each stage, so that changes to the
+ *  algorithms can be compared from one build to the next
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <new>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <math.h>
+#include <sys/resource.h>
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QDateTime>
+
+#include "Config/Configuration.h"
+#include "Radar/AnalyticRadar.h"
+#include "NRL/RadarQC.h"
+#include "NRL/Hvvp.h"
+#include "DataObjects/GriddedFactory.h"
+#include "DataObjects/GriddedData.h"
+#include "DataObjects/VortexData.h"
+#include "DataObjects/VortexList.h"
+#include "DataObjects/SimplexList.h"
+#include "Pressure/PressureList.h"
+#include "Threads/SimplexThread.h"
+#include "Threads/VortexThread.h"
+#include "ChooseCenter.h"
+
+#ifndef VORTRAC_RESOURCES
+#define VORTRAC_RESOURCES "../Resources"
+#endif
+
+// Every operator new in the program is counted, so each stage can
+// report how many allocations it made. Allocations Qt makes with
+// malloc directly (QString, QVector storage) are not included.
+
+static std::atomic<unsigned long long> allocCount(0);
+static std::atomic<unsigned long long> allocBytes(0);
+
+void* operator new(std::size_t size)
+{
+  allocCount++;
+  allocBytes += size;
+  void *ptr = malloc(size ? size : 1);
+  if(ptr == NULL)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  free(ptr);
+}
+
+// Peak resident memory in kB. On Linux the high water mark is reset
+// before each stage so the peak belongs to that stage; elsewhere the
+// peak of the whole process is reported.
+
+static bool resetPeakRss()
+{
+  QFile clearRefs("/proc/self/clear_refs");
+  if(!clearRefs.open(QIODevice::WriteOnly))
+    return false;
+  return clearRefs.write("5") == 1;
+}
+
+static long peakRss()
+{
+  QFile status("/proc/self/status");
+  if(status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QTextStream in(&status);
+    for(QString line = in.readLine(); !line.isNull(); line = in.readLine()) {
+      if(line.startsWith("VmHWM:"))
+	return line.mid(6).trimmed().split(' ').first().toLong();
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+class StageResult {
+public:
+  QString stage;
+  int volume;
+  bool ok;
+  double msecs;
+  long peakRssKb;
+  unsigned long long allocations;
+  unsigned long long allocatedBytes;
+};
+
+class StageTimer {
+public:
+  StageTimer(const QString& name, int volume) {
+    result.stage = name;
+    result.volume = volume;
+    result.ok = false;
+    resetPeakRss();
+    startCount = allocCount;
+    startBytes = allocBytes;
+    timer.start();
+  }
+  StageResult finish(bool ok) {
+    result.msecs = timer.nsecsElapsed() / 1.0e6;
+    result.ok = ok;
+    result.allocations = allocCount - startCount;
+    result.allocatedBytes = allocBytes - startBytes;
+    result.peakRssKb = peakRss();
+    return result;
+  }
+private:
+  StageResult result;
+  QElapsedTimer timer;
+  unsigned long long startCount, startBytes;
+};
+
+static void setOrAdd(Configuration& config, const QDomElement& element,
+		     const QString& name, const QString& value)
+{
+  if(element.firstChildElement(name).isNull())
+    config.addDom(element, name, value);
+  else
+    config.setParam(element, name, value);
+}
+
+static void usage()
+{
+  std::cerr << "Usage: vortrac_bench [options]\n"
+	    << "  --config file     main configuration (default vortrac_default.xml)\n"
+	    << "  --analytic file   analytic storm and radar (default vortrac_defaultAnalyticTC.xml)\n"
+	    << "  --volumes n       number of volumes to analyze (default 3)\n"
+	    << "  --seed n          seed for the sampling noise (default 1)\n"
+	    << "  --workdir dir     where the lists and cappis go (default a temporary directory)\n"
+	    << "  --json file       results as JSON (default vortrac_bench.json)\n"
+	    << "  --csv file        results as CSV\n";
+}
+
+static bool writeJson(const QString& fileName, const QVector<StageResult>& results,
+		      int numVolumes, int seed)
+{
+  QFile file(fileName);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+  QTextStream out(&file);
+  out << "{\n";
+  out << "  \"volumes\": " << numVolumes << ",\n";
+  out << "  \"seed\": " << seed << ",\n";
+  out << "  \"started\": \"" << QDateTime::currentDateTimeUtc().toString(Qt::ISODate) << "\",\n";
+  out << "  \"stages\": [\n";
+  for(int i = 0; i < results.size(); i++) {
+    const StageResult& r = results.at(i);
+    out << "    {\"stage\": \"" << r.stage << "\", \"volume\": " << r.volume
+	<< ", \"ok\": " << (r.ok ? "true" : "false")
+	<< ", \"wall_ms\": " << QString::number(r.msecs, 'f', 3)
+	<< ", \"peak_rss_kb\": " << r.peakRssKb
+	<< ", \"allocations\": " << r.allocations
+	<< ", \"allocated_bytes\": " << r.allocatedBytes << "}"
+	<< ((i < results.size() - 1) ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+  return out.status() == QTextStream::Ok;
+}
+
+static bool writeCsv(const QString& fileName, const QVector<StageResult>& results)
+{
+  QFile file(fileName);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+  QTextStream out(&file);
+  out << "stage,volume,ok,wall_ms,peak_rss_kb,allocations,allocated_bytes\n";
+  for(int i = 0; i < results.size(); i++) {
+    const StageResult& r = results.at(i);
+    out << r.stage << "," << r.volume << "," << (r.ok ? 1 : 0) << ","
+	<< QString::number(r.msecs, 'f', 3) << "," << r.peakRssKb << ","
+	<< r.allocations << "," << r.allocatedBytes << "\n";
+  }
+  return out.status() == QTextStream::Ok;
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QString configFile = QString(VORTRAC_RESOURCES) + "/vortrac_default.xml";
+  QString analyticFile = QString(VORTRAC_RESOURCES) + "/vortrac_defaultAnalyticTC.xml";
+  QString workPath, jsonFile("vortrac_bench.json"), csvFile;
+  int numVolumes = 3;
+  int seed = 1;
+
+  QStringList args = app.arguments();
+  for(int i = 1; i < args.size(); i++) {
+    QString arg = args.at(i);
+    if(i + 1 >= args.size()) {
+      usage();
+      return 1;
+    }
+    QString value = args.at(++i);
+    if(arg == "--config") configFile = value;
+    else if(arg == "--analytic") analyticFile = value;
+    else if(arg == "--volumes") numVolumes = value.toInt();
+    else if(arg == "--seed") seed = value.toInt();
+    else if(arg == "--workdir") workPath = value;
+    else if(arg == "--json") jsonFile = value;
+    else if(arg == "--csv") csvFile = value;
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  QTemporaryDir tempDir;
+  if(workPath.isEmpty()) {
+    if(!tempDir.isValid()) {
+      std::cerr << "Could not create a working directory\n";
+      return 1;
+    }
+    workPath = tempDir.path();
+  }
+  QDir workDir(workPath);
+  workDir.mkpath(".");
+
+  Configuration config;
+  if(!config.read(configFile)) {
+    std::cerr << "Could not read " << configFile.toStdString() << "\n";
+    return 1;
+  }
+  Configuration analyticConfig;
+  if(!analyticConfig.read(analyticFile)) {
+    std::cerr << "Could not read " << analyticFile.toStdString() << "\n";
+    return 1;
+  }
+
+  // The storm sits about 100 km from the radar, well inside the
+  // unambiguous range, and nothing is fetched or displayed
+  const float vortexLat = 27.0, vortexLon = -80.0;
+  const float radarLat = 27.6, radarLon = -80.8;
+  QDomElement vortex = config.getConfig("vortex");
+  setOrAdd(config, vortex, "name", "Bench");
+  setOrAdd(config, vortex, "mode", "research");
+  setOrAdd(config, vortex, "lat", QString().setNum(vortexLat));
+  setOrAdd(config, vortex, "lon", QString().setNum(vortexLon));
+  QDomElement radar = config.getConfig("radar");
+  setOrAdd(config, radar, "name", "ANLY");
+  setOrAdd(config, radar, "format", "MODEL");
+  setOrAdd(config, radar, "lat", QString().setNum(radarLat));
+  setOrAdd(config, radar, "lon", QString().setNum(radarLon));
+  setOrAdd(config, config.getConfig("cappi"), "output", "none");
+  // HVVP is timed as a stage of its own
+  setOrAdd(config, config.getConfig("vtd"), "closure", "original");
+  const char *dirConfigs[] = { "vortex", "radar", "cappi", "center", "choosecenter",
+			       "vtd", "pressure", "graphics" };
+  for(unsigned int i = 0; i < sizeof(dirConfigs)/sizeof(dirConfigs[0]); i++) {
+    QDomElement element = config.getConfig(dirConfigs[i]);
+    if(!element.isNull())
+      setOrAdd(config, element, "dir", workPath);
+  }
+
+  QDateTime firstTime(QDate(2006, 8, 29), QTime(12, 0, 0), Qt::UTC);
+  QDomElement chooseCenter = config.getConfig("choosecenter");
+  setOrAdd(config, chooseCenter, "startdate", firstTime.date().toString(Qt::ISODate));
+  setOrAdd(config, chooseCenter, "starttime", firstTime.time().toString(Qt::ISODate));
+  QDateTime lastTime = firstTime.addSecs(360 * numVolumes);
+  setOrAdd(config, chooseCenter, "enddate", lastTime.date().toString(Qt::ISODate));
+  setOrAdd(config, chooseCenter, "endtime", lastTime.time().toString(Qt::ISODate));
+
+  QDomElement analyticRadar = analyticConfig.getRoot().firstChildElement("analytic_radar");
+  setOrAdd(analyticConfig, analyticRadar, "sample", "true");
+  setOrAdd(analyticConfig, analyticRadar, "dealiasdata", "true");
+  setOrAdd(analyticConfig, analyticRadar, "seed", QString().setNum(seed));
+
+  const ConfigSnapshot& settings = config.getSnapshot();
+  if(!settings.isValid()) {
+    for(int i = 0; i < settings.getProblems().count(); i++)
+      std::cerr << settings.getProblems()[i].toStdString() << "\n";
+    return 1;
+  }
+  float bottomLevel = settings.center.bottomLevel;
+  QString namePrefix = workDir.filePath("Bench_ANLY_" + QString().setNum(firstTime.date().year()) + "_");
+
+  VortexList vortexList;
+  SimplexList simplexList;
+  PressureList pressureList;
+  vortexList.setFilePath(namePrefix + "vortexlist.xml");
+  simplexList.setFilePath(namePrefix + "simplexlist.xml");
+  pressureList.setFilePath(namePrefix + "pressurelist.xml");
+
+  QVector<StageResult> results;
+  ChooseCenter *centerFinder = NULL;
+  QString volumeConfig = workDir.filePath("bench_analytic.xml");
+  float firstGuessLat = vortexLat, firstGuessLon = vortexLon;
+
+  for(int v = 0; v < numVolumes; v++) {
+    // One volume every six minutes, like a WSR-88D in precipitation mode
+    setOrAdd(analyticConfig, analyticRadar, "datetime",
+	     firstTime.addSecs(360 * v).toString(Qt::ISODate));
+    analyticConfig.write(volumeConfig);
+
+    StageTimer synth("analytic", v);
+    AnalyticRadar *volume = new AnalyticRadar("ANLY", radarLat, radarLon, volumeConfig);
+    volume->setConfigElement(&config);
+    bool ok = volume->readVolume();
+    results.append(synth.finish(ok));
+    if(!ok) {
+      delete volume;
+      continue;
+    }
+
+    StageTimer qc("qc", v);
+    RadarQC *dealiaser = new RadarQC(volume);
+    dealiaser->getConfig(settings.qc);
+    ok = dealiaser->dealias();
+    delete dealiaser;
+    results.append(qc.finish(ok));
+
+    StageTimer cappi("cappi", v);
+    GriddedFactory gridFactory;
+    GriddedData *gridData = gridFactory.makeCappi(volume, settings, &firstGuessLat, &firstGuessLon);
+    ok = (gridData != NULL) && gridData->getFieldGrid().isAllocated();
+    results.append(cappi.finish(ok));
+    if(!ok) {
+      // Nothing for the center and wind stages to read
+      delete gridData;
+      delete volume;
+      continue;
+    }
+
+    VortexData *vortexData = new VortexData();
+    vortexData->setTime(volume->getDateTime());
+
+    StageTimer simplex("simplex", v);
+    SimplexThread *pSimplex = new SimplexThread();
+    pSimplex->initParam(settings, gridData, firstGuessLat, firstGuessLon);
+    ok = pSimplex->findCenter(&simplexList);
+    delete pSimplex;
+    results.append(simplex.finish(ok && !simplexList.isEmpty()));
+
+    // Same level choice as workThread::findCenter
+    int maxConvergedLevel = -1;
+    if(!simplexList.isEmpty()) {
+      simplexList.last().setTime(vortexData->getTime());
+      int maxConverged = 0;
+      for(int level = 0; level < simplexList.last().getNumLevels(); level++) {
+	int converged = 0;
+	for(int ridx = 0; ridx < simplexList.last().getNumRadii(); ridx++)
+	  if(simplexList.last().getNumConvergingCenters(level, ridx) > 0)
+	    converged++;
+	if(converged > maxConverged) {
+	  maxConverged = converged;
+	  maxConvergedLevel = level;
+	}
+      }
+    }
+
+    StageTimer choose("choosecenter", v);
+    if(maxConvergedLevel > -1) {
+      simplexList.timeSort();
+      if(centerFinder == NULL)
+	centerFinder = new ChooseCenter(settings, &simplexList, vortexData);
+      else
+	centerFinder->setVortexData(vortexData);
+      ok = centerFinder->findCenter(maxConvergedLevel);
+    } else {
+      ok = false;
+    }
+    results.append(choose.finish(ok));
+
+    bool centerFound = ok;
+    int bestLevel = maxConvergedLevel;
+    if(!centerFound) {
+      // Carry on from the first guess so the wind stages still run
+      bestLevel = 0;
+      for(int level = 0; level < vortexData->getMaxLevels(); level++) {
+	vortexData->setLat(level, firstGuessLat);
+	vortexData->setLon(level, firstGuessLon);
+	vortexData->setHeight(level, bottomLevel + level * gridData->getKGridsp());
+      }
+    }
+    vortexData->setBestLevel(bestLevel);
+
+    StageTimer hvvpTimer("hvvp", v);
+    float centerLat = vortexData->getLat(bestLevel);
+    float centerLon = vortexData->getLon(bestLevel);
+    float radLat = radarLat, radLon = radarLon;
+    float *distance = GriddedData::getCartesianPoint(&radLat, &radLon, &centerLat, &centerLon);
+    float rt = sqrt(distance[0]*distance[0] + distance[1]*distance[1]);
+    float cca = atan2(distance[0], distance[1])*180/acos(-1);
+    delete [] distance;
+    float rmw = vortexData->getAveRMW();
+    if(rmw <= 0)
+      rmw = settings.vortex.rmw;
+    Hvvp *hvvp = new Hvvp;
+    hvvp->setConfig(settings);
+    hvvp->setRadarData(volume, rt, cca, rmw);
+    ok = hvvp->findHVVPWinds(true);
+    delete hvvp;
+    results.append(hvvpTimer.finish(ok));
+
+    StageTimer vtd("vtd", v);
+    VortexThread *pVtd = new VortexThread();
+    pVtd->getWinds(settings, gridData, volume, vortexData, &pressureList);
+    delete pVtd;
+    results.append(vtd.finish(vortexData->getMaxValidRadius() != -999));
+
+    if(vortexData->getMaxValidRadius() != -999)
+      vortexList.append(*vortexData);
+    if(centerFound) {
+      firstGuessLat = vortexData->getLat(bestLevel);
+      firstGuessLon = vortexData->getLon(bestLevel);
+    }
+
+    StageTimer persistence("persistence", v);
+    ok = vortexList.saveXML();
+    ok = simplexList.saveXML() && ok;
+    ok = pressureList.saveXML() && ok;
+    results.append(persistence.finish(ok));
+
+    delete vortexData;
+    delete gridData;
+    delete volume;
+  }
+  delete centerFinder;
+
+  if(!writeJson(jsonFile, results, numVolumes, seed)) {
+    std::cerr << "Could not write " << jsonFile.toStdString() << "\n";
+    return 1;
+  }
+  if(!csvFile.isEmpty() && !writeCsv(csvFile, results)) {
+    std::cerr << "Could not write " << csvFile.toStdString() << "\n";
+    return 1;
+  }
+
+  // Totals per stage
+  QStringList stages;
+  stages << "analytic" << "qc" << "cappi" << "simplex" << "choosecenter"
+	 << "hvvp" << "vtd" << "persistence";
+  printf("\n%-14s %12s %12s %14s\n", "stage", "total ms", "peak kB", "allocations");
+  for(int s = 0; s < stages.size(); s++) {
+    double msecs = 0;
+    long peak = 0;
+    unsigned long long allocations = 0;
+    for(int i = 0; i < results.size(); i++) {
+      if(results.at(i).stage != stages.at(s))
+	continue;
+      msecs += results.at(i).msecs;
+      peak = qMax(peak, results.at(i).peakRssKb);
+      allocations += results.at(i).allocations;
+    }
+    printf("%-14s %12.1f %12ld %14llu\n", stages.at(s).toLatin1().data(),
+	   msecs, peak, allocations);
+  }
+
+  return 0;
+}
@@ -11,6 +11,7 @@
 
 #include "ChooseCenter.h"
 #include "Math/Matrix.h"
+#include "IO/Message.h"
 #include <math.h>
 #include <QDomElement>
 #include <QHash>
@@ -18,97 +19,16 @@
 #include <cstdlib>
 #include <ctime>
 
-ChooseCenter::ChooseCenter(Configuration* newConfig, const SimplexList* newList, VortexData* vortexPtr):
+ChooseCenter::ChooseCenter(const ConfigSnapshot& settings, const SimplexList* newList, VortexData* vortexPtr):
     MAX_ORDER(10),velNull(-999.0f)
 {
-    _config = newConfig;
     _simplexResults = newList;
     _vortexData = vortexPtr;
-    _pppScore = NULL;
-    _ppBestRadius = NULL;
-    _ppBestFitVariance = NULL;
-    _ppBestFitDegree = NULL;
-    _pppBestFitCoeff = NULL;
-    _ppNewBestRadius = NULL;
-    _ppNewBestCenter = NULL;
-    numHeights = NULL;
-    indexOfHeights = NULL;
+    _initialize(settings);
 }
 
 ChooseCenter::~ChooseCenter()
 {
-    if(_pppScore!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++) {
-            for(int j = 0; j < _simplexResults->at(i).getNumRadii(); j++) {
-                delete [] _pppScore[i][j];
-            }
-            delete [] _pppScore[i];
-        }
-        delete [] _pppScore;
-    }
-    else
-        delete _pppScore;
-
-    // We might not be able to delete these depending on weither they
-    // are passed out for further use or not after the ChooseCenter object is
-    // destroyed
-
-    if(_ppBestRadius!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++)
-            delete[] _ppBestRadius[i];
-        delete[] _ppBestRadius;   }
-    else
-        delete _ppBestRadius;
-
-    if(_ppNewBestRadius!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++)
-            delete[] _ppNewBestRadius[i];
-        delete[] _ppNewBestRadius; }
-    else
-        delete _ppNewBestRadius;
-
-    if(_ppNewBestCenter!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++)
-            delete[] _ppNewBestCenter[i];
-        delete[] _ppNewBestCenter;
-    }
-    else
-        delete _ppNewBestCenter;
-    if(_pppBestFitCoeff!=NULL) {
-        for(int m = 0; m < 4; m++) {
-            for(int p = 0; p < numHeights->count(); p++)
-                delete[] _pppBestFitCoeff[m][p];
-            delete[] _pppBestFitCoeff[m];
-        }
-        delete[] _pppBestFitCoeff;
-    }
-    else
-        delete _pppBestFitCoeff;
-
-    if(_ppBestFitDegree!=NULL) {
-        for(int m = 0; m < 4; m++)
-            delete[] _ppBestFitDegree[m];
-        delete[] _ppBestFitDegree;
-    }
-    else
-        delete _pppBestFitCoeff;
-
-    if(_ppBestFitVariance!=NULL) {
-        for(int m = 0; m < 4; m++)
-            delete[] _ppBestFitVariance[m];
-        delete[] _ppBestFitVariance;
-    }
-    if(numHeights!=NULL)
-        numHeights->clear();
-    if(indexOfHeights!=NULL) {
-        for(int ii = indexOfHeights->count()-1; ii >= 0; ii++) {
-            int* trash = indexOfHeights->take(ii);
-            delete [] trash;
-        }
-        indexOfHeights->clear();
-    }
-    delete numHeights;
-    delete indexOfHeights;
 }
 
 bool ChooseCenter::findCenter(int level)
@@ -117,60 +37,55 @@ bool ChooseCenter::findCenter(int level)
      * this function try to construct a polynomial fit of timeserial simplex data, at least 6 data points in
      * the recent 2 hours is needed to do this fitting. before performing the fitting, a average center is
      * compute, if the polynomial fitting fails or there is not enough history data, this average center is used.
+     * only the volumes of the last 2 hours are scored, and those scored by an earlier call are reused.
      */
-    _initialize();
+    if(_simplexResults->isEmpty()) {
+        std::cerr << "Data Issues Could Not Find Mean Center" << std::endl;
+        return false;
+    }
 
-    if(!_calMeanCenters()) {
+    QList<int> validList = _recentVolumes();
+    if(!_calMeanCenters(validList)) {
         std::cerr << "Data Issues Could Not Find Mean Center" << std::endl;
         return false;
     }
 
-    // TODO temporary
+    // The polynomial correction (_calPolyTest on the last 2 hours, with more
+    // than 6 volumes) stays off: it scores the invalid centers instead of
+    // the valid ones and can leave the center outside of the grid. Until
+    // it is fixed, the mean center of the best radius is the center.
+    Q_UNUSED(level);
     _useLastMean();
     return true;
-    
-    // TODO: Why was this commented out?
-    // polynomial fitting using data from last 2 hours, and volume number shoud > 6
-    QList<int> validList;
-    QDateTime lastTime = _simplexResults->last().getTime();
-    for(int ii = (_simplexResults->size() - 1) ; ii >= 0; --ii) {
-      if(_simplexResults->at(ii).getTime().secsTo(lastTime) < 2 * 60 * 60)
-	validList.prepend(ii);
-    }
-    if(validList.size() > 6) {
-      if (! _calPolyTest(validList, level) )   // TODO Why level 0?
-	_useLastMean();
-    }
-    else
-      _useLastMean();
-    
-    return true;
 }
 
-void ChooseCenter::_initialize()
+void ChooseCenter::_initialize(const ConfigSnapshot& settings)
 {
     // Pulls all the necessary user parameters from the configuration panel
     //  and initializes the array used for fTesting
 
-    QDomElement ccElement = _config->getConfig("choosecenter");
-    _paramMinVolumes= _config->getParam(ccElement, QString("min_volumes")).toInt();
-    _paramWindWeight= _config->getParam(ccElement, QString("wind_weight")).toFloat();
-    _paramStdWeight = _config->getParam(ccElement, QString("stddev_weight")).toFloat();
-    _paramPtsWeight = _config->getParam(ccElement, QString("pts_weight")).toFloat();
+    const ChooseCenterSettings& cc = settings.chooseCenter;
+    _paramMinVolumes= cc.minVolumes;
+    _paramWindWeight= cc.windWeight;
+    _paramStdWeight = cc.stdWeight;
+    _paramPtsWeight = cc.ptsWeight;
 
-    _paramPosWeight = _config->getParam(ccElement, QString("position_weight")).toFloat();
-    _paramRmwWeight = _config->getParam(ccElement, QString("rmw_weight")).toFloat();
-    _paramVelWeight = _config->getParam(ccElement, QString("vt_weight")).toFloat();
+    _paramPosWeight = cc.positionWeight;
+    _paramRmwWeight = cc.rmwWeight;
+    _paramVelWeight = cc.vtWeight;
 
-    QDate sDate = QDate::fromString(_config->getParam(ccElement,QString("startdate")),Qt::ISODate);
-    QDate eDate = QDate::fromString(_config->getParam(ccElement,QString("enddate")),Qt::ISODate);
-    QTime sTime = QTime::fromString(_config->getParam(ccElement,QString("starttime")),Qt::ISODate);
-    QTime eTime = QTime::fromString(_config->getParam(ccElement,QString("endtime")),Qt::ISODate);
+    startTime = cc.startTime;
+    endTime = cc.endTime;
 
-    startTime = QDateTime(sDate, sTime, Qt::UTC);
-    endTime = QDateTime(eDate, eTime, Qt::UTC);
+    _radarLat = settings.radar.lat;
+    _radarLon = settings.radar.lon;
+    float radarLatRadians = _radarLat * acos(-1.0) / 180.0;
+    _facLat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians)
+      + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
+    _facLon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians)
+      + 0.00012 * cos(5.0 * radarLatRadians);
 
-    int fPercent = _config->getParam(ccElement, QString("stats")).toInt();
+    int fPercent = cc.stats;
     if(fPercent == 99) {
         _fCriteria[0] = 4052.2;
         _fCriteria[1] = 98.50;
@@ -241,189 +156,179 @@ void ChooseCenter::_initialize()
         _fCriteria[28] = 4.1830;
         _fCriteria[29] = 4.1709;
     }
+}
 
-    _ppBestRadius= new int*[_simplexResults->count()];
-    _pppScore    = new float**[_simplexResults->count()];
-
-    for(int i = 0; i < _simplexResults->count(); i++) {
-        _pppScore[i] = new float*[_simplexResults->at(i).getNumRadii()];
-        _ppBestRadius[i] = new int[_simplexResults->at(i).getNumLevels()];
-
-#if 0
-	std::cout << "At " << i << ", levels: " << _simplexResults->at(i).getNumLevels()
-		  << ", radii: " << _simplexResults->at(i).getNumRadii() << std::endl;
-#endif
-	
-        for(int rad = 0; rad < _simplexResults->at(i).getNumRadii(); rad++) {
-            _pppScore[i][rad] = new float[_simplexResults->at(i).getNumLevels()];
-            for(int level = 0; level < _simplexResults->at(i).getNumLevels(); level++){
-                _pppScore[i][rad][level] = 0.0;
-                _ppBestRadius[i][level] = -1;
-            }
-        }
+QList<int> ChooseCenter::_recentVolumes() const
+{
+    // Indices of the volumes within 2 hours of the last one. The list is
+    // sorted by time, so they are all at the end.
+    QList<int> validList;
+    QDateTime lastTime = _simplexResults->last().getTime();
+    for(int ii = (_simplexResults->size() - 1) ; ii >= 0; --ii) {
+        if(_simplexResults->at(ii).getTime().secsTo(lastTime) >= 2 * 60 * 60)
+            break;
+        validList.prepend(ii);
     }
+    return validList;
 }
 
-bool ChooseCenter::_calMeanCenters()
+bool ChooseCenter::_calMeanCenters(const QList<int>& volIdx)
 {
     /*
    * the result of Simplex contains k levels, each level has i rings. this function first
    * finds peak wind in those rings and give a score to each of them. then choose the ring
-   * with a highest score as the ring of the level, then average all level to get a center
-   * estimation of the volume. for each volume, do the same thing.
-   * the score of each ring of all level from all volume are stored in (_pppScore[nVol][nLevel][nRing])
-   * the index of best ring of each level from each volume is stored in (_ppBestRadius[nVol][nLevel])
-   * the variation of center and radius of best ring if also stored in (_p
-   *?but the mean center is not stored
+   * with a highest score as the ring of the level (_scoreVolume).
+   * the index of best ring of each level of each volume is stored in (_bestRadii[time][nLevel])
+   * volumes scored by an earlier call keep their rings, so only the new volumes are scored.
    */
-    if(_simplexResults->isEmpty())
+    if(_simplexResults->isEmpty() || volIdx.isEmpty())
         return false;
 
-    for(int vidx = 0; vidx < _simplexResults->size(); vidx++) {
-        float meanRadius = 0;
-        float meanCenX = 0;
-        float meanCenY = 0;
-        const int NLEVEL = _simplexResults->at(vidx).getNumLevels();
-        const int NRADII = _simplexResults->at(vidx).getNumRadii();
-        for(int hidx = 0; hidx < NLEVEL; hidx++) {
-
-            float *winds= new float[NRADII];
-            float *stds = new float[NRADII];
-            float *pts  = new float[NRADII];
-            float bestWind = 0.0;
-            float bestStd = 50.;
-            float bestPts = 0.;
-            float ptRatio = (float)_simplexResults->at(vidx).getNumPointsUsed() / 2.718281828;
-
-            //get array of maxwind,centerSD,convegedPoints on this level, and calculate best value of these param
-            for(int ridx = 0; ridx < NRADII; ridx++) {
-                // Examine each radius based on index j, for the one containing the highest tangential winds
-
-                winds[ridx] = _simplexResults->at(vidx).getMaxVT(hidx, ridx);
-                stds[ridx]  = _simplexResults->at(vidx).getCenterStdDev(hidx, ridx);
-                pts[ridx]   = _simplexResults->at(vidx).getNumConvergingCenters(hidx, ridx);
-
-                if((winds[ridx] != SimplexData::_fillv) && (winds[ridx] > bestWind))
-                    bestWind = winds[ridx];
-
-                if((stds[ridx] != SimplexData::_fillv) && (stds[ridx] < bestStd))
-                    bestStd = stds[ridx];
-
-                if((pts[ridx] != SimplexData::_fillv) && (pts[ridx] > bestPts))
-                    bestPts = pts[ridx];
-            }
+    // Forget the volumes that are no longer in the window
+    QMap<QDateTime, int> windowTimes;
+    for(int i = 0; i < volIdx.size(); i++)
+        windowTimes.insert(_simplexResults->at(volIdx[i]).getTime(), volIdx[i]);
+    QMap<QDateTime, QVector<int> >::iterator it = _bestRadii.begin();
+    while(it != _bestRadii.end()) {
+        if(windowTimes.contains(it.key()))
+            ++it;
+        else
+            it = _bestRadii.erase(it);
+    }
+
+    for(int i = 0; i < volIdx.size(); i++)
+        _volumeRadii(volIdx[i]);
+    return true;
+}
+
+const QVector<int>& ChooseCenter::_volumeRadii(const int vidx)
+{
+    const SimplexData& simplex = _simplexResults->at(vidx);
+    QMap<QDateTime, QVector<int> >::iterator it = _bestRadii.find(simplex.getTime());
+    if((it == _bestRadii.end()) || (it.value().size() != simplex.getNumLevels())) {
+        QVector<int> bestRadius;
+        _scoreVolume(vidx, bestRadius);
+        it = _bestRadii.insert(simplex.getTime(), bestRadius);
+    }
+    return it.value();
+}
+
+void ChooseCenter::_scoreVolume(const int vidx, QVector<int>& bestRadius) const
+{
+    const int NLEVEL = _simplexResults->at(vidx).getNumLevels();
+    const int NRADII = _simplexResults->at(vidx).getNumRadii();
+    bestRadius.fill(-1, NLEVEL);
+    for(int hidx = 0; hidx < NLEVEL; hidx++) {
+
+        float *winds= new float[NRADII];
+        float *stds = new float[NRADII];
+        float *pts  = new float[NRADII];
+        float bestWind = 0.0;
+        float bestStd = 50.;
+        float bestPts = 0.;
+        float ptRatio = (float)_simplexResults->at(vidx).getNumPointsUsed() / 2.718281828;
+
+        //get array of maxwind,centerSD,convegedPoints on this level, and calculate best value of these param
+        for(int ridx = 0; ridx < NRADII; ridx++) {
+            // Examine each radius based on index j, for the one containing the highest tangential winds
+
+            winds[ridx] = _simplexResults->at(vidx).getMaxVT(hidx, ridx);
+            stds[ridx]  = _simplexResults->at(vidx).getCenterStdDev(hidx, ridx);
+            pts[ridx]   = _simplexResults->at(vidx).getNumConvergingCenters(hidx, ridx);
+
+            if((winds[ridx] != SimplexData::_fillv) && (winds[ridx] > bestWind))
+                bestWind = winds[ridx];
+
+            if((stds[ridx] != SimplexData::_fillv) && (stds[ridx] < bestStd))
+                bestStd = stds[ridx];
+
+            if((pts[ridx] != SimplexData::_fillv) && (pts[ridx] > bestPts))
+                bestPts = pts[ridx];
+        }
 
-            // Formely known as fix winds which was a sub routine in the perl version of this algorithm
-            // zeros all wind entrys that are not a local maxima, or adjacent to a local maxima
+        // Formely known as fix winds which was a sub routine in the perl version of this algorithm
+        // zeros all wind entrys that are not a local maxima, or adjacent to a local maxima
 	    
-            int count = 0;
-            float *peakWinds = new float[NRADII];
-            bool  *isPeaks   = new bool[NRADII];
+        int count = 0;
+        float *peakWinds = new float[NRADII];
+        bool  *isPeaks   = new bool[NRADII];
 	    
-            for(int z = 0; z < NRADII; z++) {
-                peakWinds[z] = 0.f;
-                isPeaks[z] = 0;
-            }
+        for(int z = 0; z < NRADII; z++) {
+            peakWinds[z] = 0.f;
+            isPeaks[z] = 0;
+        }
 	    
-            for(int a = 1; a < NRADII - 1; a++) {
-                if((winds[a] >= winds[a-1]) && (winds[a] >= winds[a + 1])) {
-                    peakWinds[count] = winds[a];
-                    isPeaks[a] = 1;
-                    count++;
-                }
-            }
-            float peakWindMean = 0.f, peakWindStd = 0.f;
-            for(int a = 0; a < count; a++) {
-                peakWindMean += peakWinds[a];
+        for(int a = 1; a < NRADII - 1; a++) {
+            if((winds[a] >= winds[a-1]) && (winds[a] >= winds[a + 1])) {
+                peakWinds[count] = winds[a];
+                isPeaks[a] = 1;
+                count++;
             }
-            if(count > 0) {
-                peakWindMean = peakWindMean/((float)count);
-                for(int z = 0; z < count; z++)
-                    peakWindStd += (peakWinds[z] - peakWindMean) * (peakWinds[z] - peakWindMean);
-                peakWindStd /= count;
-            }
-            delete[] peakWinds;
+        }
+        float peakWindMean = 0.f, peakWindStd = 0.f;
+        for(int a = 0; a < count; a++) {
+            peakWindMean += peakWinds[a];
+        }
+        if(count > 0) {
+            peakWindMean = peakWindMean/((float)count);
+            for(int z = 0; z < count; z++)
+                peakWindStd += (peakWinds[z] - peakWindMean) * (peakWinds[z] - peakWindMean);
+            peakWindStd /= count;
+        }
+        delete[] peakWinds;
 
-            //put point and points adjacent to peakwind into winds[]
-            for(int jj = 0; jj < NRADII; jj++) {
-                if(((jj > 0) && (jj < NRADII-1))
+        //put point and points adjacent to peakwind into winds[]
+        for(int jj = 0; jj < NRADII; jj++) {
+            if(((jj > 0) && (jj < NRADII-1))
 		   &&((isPeaks[jj] == 1) || (isPeaks[jj + 1] == 1) || (isPeaks[jj - 1] == 1))) {
-                    winds[jj] = _simplexResults->at(vidx).getMaxVT(hidx, jj);
-                    // Keep an eye out for the maxima
-                    if(winds[jj] > bestWind) {
-                        bestWind = winds[jj];
-                    }
-                }
-                else {
-                    winds[jj] = velNull;
+                winds[jj] = _simplexResults->at(vidx).getMaxVT(hidx, jj);
+                // Keep an eye out for the maxima
+                if(winds[jj] > bestWind) {
+                    bestWind = winds[jj];
                 }
             }
+            else {
+                winds[jj] = velNull;
+            }
+        }
 
-            //calculate a weight for each ring, and find a best on this level
-            float tempBest = 0.f, windScore, stdScore, ptsScore;
-            int   bestFlag = 0;
-            for(int rr = 0; rr < NRADII; rr++){
-                windScore = stdScore = ptsScore = 0.f;
-                _pppScore[vidx][rr][hidx] = velNull;
-                if((bestWind != 0.0) && (winds[rr] != velNull))
-                    windScore = exp(winds[rr] - bestWind) * _paramWindWeight;
-                if((stds[rr] != velNull) && (stds[rr] != 0.0))
-                    stdScore = bestStd / stds[rr] * _paramStdWeight;
-                if((bestPts !=0 ) && (pts[rr] != velNull) && (ptRatio != 0.0)) {
-                    ptsScore = log((float)pts[rr] / ptRatio) * _paramPtsWeight;
-                }
-                if(winds[rr] != velNull) {
-                    _pppScore[vidx][rr][hidx] = windScore + stdScore + ptsScore;
-                    if((_pppScore[vidx][rr][hidx] > tempBest) && (hidx >= 0) &&
-		       (hidx <= _simplexResults->at(vidx).getNumLevels())) {
-                        tempBest = _pppScore[vidx][rr][hidx];
-                        bestFlag = rr;
-                    }
+        //calculate a weight for each ring, and find a best on this level
+        float tempBest = 0.f, windScore, stdScore, ptsScore;
+        int   bestFlag = 0;
+        for(int rr = 0; rr < NRADII; rr++){
+            windScore = stdScore = ptsScore = 0.f;
+            if((bestWind != 0.0) && (winds[rr] != velNull))
+                windScore = exp(winds[rr] - bestWind) * _paramWindWeight;
+            if((stds[rr] != velNull) && (stds[rr] != 0.0))
+                stdScore = bestStd / stds[rr] * _paramStdWeight;
+            if((bestPts !=0 ) && (pts[rr] != velNull) && (ptRatio != 0.0)) {
+                ptsScore = log((float)pts[rr] / ptRatio) * _paramPtsWeight;
+            }
+            if(winds[rr] != velNull) {
+                float score = windScore + stdScore + ptsScore;
+                if(score > tempBest) {
+                    tempBest = score;
+                    bestFlag = rr;
                 }
-            }//end of radii
-            meanRadius += _simplexResults->at(vidx).getRadius(bestFlag);
-            meanCenX   += _simplexResults->at(vidx).getMeanX(hidx, bestFlag);
-            meanCenY   += _simplexResults->at(vidx).getMeanY(hidx, bestFlag);
-            _ppBestRadius[vidx][hidx] = bestFlag;
-
-            delete [] winds;
-            delete [] stds;
-            delete [] pts;
-            delete [] isPeaks;
-        }//end of levels
-
-        // calculate the mean radius and center scores over all levels
-        meanRadius = meanRadius/NLEVEL;
-        meanCenX   = meanCenX/NLEVEL;
-        meanCenY   = meanCenY/NLEVEL;
-        if(vidx == (_simplexResults->size() -1)){
-            // const float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
-            // const float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
-            // const float radarLatRadians = radarLat * acos(-1.0) / 180.0;
-            // const float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians) + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
-            // const float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians) + 0.00012 * cos(5.0 * radarLatRadians);
-
-            //std::cout<<"ChooseCenter found new mean center: "<<radarLat+meanCenY/fac_lat<<","<<radarLon+meanCenX/fac_lon<<","<<meanRadius<<std::endl;
-        }
-    }
-    return true;
+            }
+        }//end of radii
+        bestRadius[hidx] = bestFlag;
+
+        delete [] winds;
+        delete [] stds;
+        delete [] pts;
+        delete [] isPeaks;
+    }//end of levels
 }
 
 bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
 {
   bool retVal = true;
-  
-    const float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
-    const float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
-    const float radarLatRadians = radarLat * acos(-1.0)/180.0;
-    const float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians) + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
-    const float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians) + 0.00012 * cos(5.0 * radarLatRadians);
-
 
     const QDateTime firstTime =_simplexResults->at(volIdx[0]).getTime();
     const int nData = volIdx.size();
-    float* xData = new float[nData];
-    float* yData = new float[nData];
+    QVector<float> xData(nData);
+    QVector<float> yData(nData);
 
     //first get the xdata, which here is the time (in minute) from the firstTime
     for(int i = 0; i < volIdx.size(); ++i) {
@@ -431,15 +336,13 @@ bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
     }
 
     //then retrieve ydata, we have 4 different ydata, so we'll process them one by one
-    float** bestCoeff = new float*[4];
-    for(int i = 0; i < 4; i++)
-        bestCoeff[i] = new float[MAX_ORDER];
-    float*  bestOrder = new float[4];
-    float*  bestRSS = new float[4];
+    QVector<QVector<float> > bestCoeff(4, QVector<float>(MAX_ORDER));
+    QVector<float> bestOrder(4);
+    QVector<float> bestRSS(4);
 
     for(int n = 0; n < 4; n++) {
         for(int i = 0; i < volIdx.size(); ++i) {
-            int bestRadius =_ppBestRadius[volIdx[i]][levelIdx];
+            int bestRadius = _volumeRadii(volIdx[i]).at(levelIdx);
             switch(n) {
             case 0:
                 yData[i] = _simplexResults->at(volIdx[i]).getMeanX(levelIdx, bestRadius);
@@ -461,9 +364,9 @@ bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
 	
         float lastRSS;
         for(int nOrder = 1; nOrder < MAX_ORDER; ++nOrder) {
-            float* coeff = new float[nOrder + 1];
+            QVector<float> coeff(nOrder + 1);
             float  fitRSS;
-            _polyFit(nOrder, nData, xData, yData, coeff, fitRSS);
+            _polyFit(nOrder, nData, xData.constData(), yData.constData(), coeff.data(), fitRSS);
 	    
             if(nOrder > 1) {
                 if(_fTest(lastRSS, nData - nOrder + 1, fitRSS, nData - nOrder)) {
@@ -483,18 +386,17 @@ bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
                 for(int k = 0; k < nOrder; k++)
                     bestCoeff[n][k] = coeff[k];
             }
-            delete[] coeff;
         }
     }
     //use the best fitting model to 'correct' the center
     
-    int bestRadius = _ppBestRadius[volIdx.last()][levelIdx];
+    int bestRadius = _volumeRadii(volIdx.last()).at(levelIdx);
     float fitX, fitY, fitRad, fitWind;
     
-    _polyCal(bestOrder[0],bestCoeff[0], _simplexResults->at(volIdx.last()).getMeanX(levelIdx, bestRadius), fitX);
-    _polyCal(bestOrder[1],bestCoeff[1], _simplexResults->at(volIdx.last()).getMeanY(levelIdx, bestRadius), fitY);
-    _polyCal(bestOrder[2],bestCoeff[2], _simplexResults->at(volIdx.last()).getRadius(bestRadius), fitRad);
-    _polyCal(bestOrder[3],bestCoeff[3], _simplexResults->at(volIdx.last()).getMaxVT(levelIdx, bestRadius), fitWind);
+    _polyCal(bestOrder[0],bestCoeff[0].constData(), _simplexResults->at(volIdx.last()).getMeanX(levelIdx, bestRadius), fitX);
+    _polyCal(bestOrder[1],bestCoeff[1].constData(), _simplexResults->at(volIdx.last()).getMeanY(levelIdx, bestRadius), fitY);
+    _polyCal(bestOrder[2],bestCoeff[2].constData(), _simplexResults->at(volIdx.last()).getRadius(bestRadius), fitRad);
+    _polyCal(bestOrder[3],bestCoeff[3].constData(), _simplexResults->at(volIdx.last()).getMaxVT(levelIdx, bestRadius), fitWind);
 
     Center bestCenter;
     float minError =999.0f, error, xError, yError, radError, vtError;
@@ -523,8 +425,8 @@ bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
       retVal = false;
     } else {
       //modify the VortexData on this Level
-      _vortexData->setLat(levelIdx, radarLat + bestCenter.getX() / fac_lat);
-      _vortexData->setLon(levelIdx, radarLon + bestCenter.getY() / fac_lon);
+      _vortexData->setLat(levelIdx, _radarLat + bestCenter.getX() / _facLat);
+      _vortexData->setLon(levelIdx, _radarLon + bestCenter.getY() / _facLon);
       _vortexData->setHeight(levelIdx,_simplexResults->last().getHeight(levelIdx));
       _vortexData->setRMW(levelIdx, bestCenter.getRadius());
       _vortexData->setRMWUncertainty(levelIdx, radError);
@@ -534,15 +436,6 @@ bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
 		<< "," << bestCenter.getRadius() << std::endl;
     }
     
-    //clear up
-    
-    delete[] xData;
-    delete[] yData;
-    delete[] bestOrder;
-    delete[] bestRSS;
-    for(int i = 0; i < 4; i++)
-        delete[] bestCoeff[i];
-    delete[] bestCoeff;
     return retVal;
 }
 
@@ -563,23 +456,12 @@ bool ChooseCenter::_calPolyCenters()
 
     // Construct a least squares polynomial to fit track
 
-    _ppBestFitVariance = new float*[4];
-    _ppBestFitDegree = new int*[4];
-    _pppBestFitCoeff = new float**[4];
-    for(int criteria = 0; criteria < 4; criteria++) {
-        _ppBestFitVariance[criteria] = new float[numHeights->count()];
-        _ppBestFitDegree[criteria] = new int[numHeights->count()];
-        _pppBestFitCoeff[criteria] = new float*[numHeights->count()];
-        for(int k = 0;k < numHeights->count(); k++){
-            _ppBestFitVariance[criteria][k] = 0;
-            _ppBestFitDegree[criteria][k] = 0;
-            _pppBestFitCoeff[criteria][k] = new float[maxPolyArray];
-            for(int b = 0; b < maxPolyArray; b++)
-                _pppBestFitCoeff[criteria][k][b] = 0;
-        }
-    }
+    _bestFitVariance = QVector<QVector<float> >(4, QVector<float>(numHeights.count(), 0));
+    _bestFitDegree = QVector<QVector<int> >(4, QVector<int>(numHeights.count(), 0));
+    _bestFitCoeff = QVector<QVector<QVector<float> > >
+        (4, QVector<QVector<float> >(numHeights.count(), QVector<float>(maxPolyArray, 0)));
 
-    QList<int> heights = numHeights->keys();
+    QList<int> heights = numHeights.keys();
     // Sort heights so that k index is attached to a specific height
     // Sort smallest to largest
     // The sorting is nessecary because QHash randomizes ordering
@@ -588,9 +470,9 @@ bool ChooseCenter::_calPolyCenters()
             if(heights[t] < heights[s])
                 heights.swap(t,s);
 
-    for(int k = 0; k < numHeights->count(); k++) {
+    for(int k = 0; k < numHeights.count(); k++) {
         int currHeight = heights[k];
-        int* levelIndices = indexOfHeights->value(currHeight);
+        const QVector<int> levelIndices = indexOfHeights.value(currHeight);
 
         // In a lot of places we will replace k with
         // levelIndices[simplexResultIndex] to keep the height consistant
@@ -607,7 +489,7 @@ bool ChooseCenter::_calPolyCenters()
             timeRefIndex++;
         }
         firstTime = _simplexResults->at(timeRefIndex).getTime();
-        int goodVolumes = numHeights->value(currHeight);
+        int goodVolumes = numHeights.value(currHeight);
         for(int i = timeRefIndex+1; i < _simplexResults->count(); i++) {
             if(levelIndices[i]!=-1) {
                 if(_simplexResults->at(i).getTime()<firstTime) {
@@ -631,25 +513,21 @@ bool ChooseCenter::_calPolyCenters()
         // Things are stored here so far but never used
         // Store the variance of each polynomial fit by the maximum order
         // polynomial that the fit uses
-        float* squareVariance = new float[maxPoly+1];
-
-        // Initialize fitting matrices
-        float* BB = new float[goodVolumes];
-        float** MM = new float*[maxPoly+1];
-        for(int rr = 0; rr <=maxPoly; rr++) {
-            MM[rr] = new float[goodVolumes];
-            for(int ii = 0; ii < goodVolumes; ii++) {
-                MM[rr][ii] = 0;
-                BB[ii] = 0;
-            }
-        }
-
-        float *lastFitCoeff = new float[maxPoly+1];
-        float *currentCoeff = new float[maxPoly+1];
-        for(int ii = 0; ii <= maxPoly; ii++) {
-            lastFitCoeff[ii] = 0;
-            currentCoeff[ii] = 0;
-        }
+        QVector<float> squareVariance(maxPoly+1);
+
+        // Initialize fitting matrices. Matrix::lls takes plain arrays, so
+        // they point into vectors that free themselves on every return.
+        QVector<float> bbData(goodVolumes, 0);
+        QVector<QVector<float> > mmData(maxPoly+1, QVector<float>(goodVolumes, 0));
+        QVector<float*> mmRows(maxPoly+1);
+        for(int rr = 0; rr <= maxPoly; rr++)
+            mmRows[rr] = mmData[rr].data();
+        float* BB = bbData.data();
+        float** MM = mmRows.data();
+
+        QVector<float> lastFitCoeff(maxPoly+1, 0);
+        QVector<float> currentCoeffData(maxPoly+1, 0);
+        float* currentCoeff = currentCoeffData.data();
 
         for(int criteria = 0; criteria < 4; criteria++) {
             // Iterates through the procedure for the four different curve fitting criteria
@@ -679,7 +557,7 @@ bool ChooseCenter::_calPolyCenters()
                             float min = firstTime.secsTo(_simplexResults->at(i).getTime())/60.0;
                             MM[order][gv] = pow(min,(double)(order));
                         }
-                        int jBest = _ppBestRadius[i][levelIndices[i]];
+                        int jBest = _volumeRadii(i).at(levelIndices[i]);
                         float y = 0;
                         switch(criteria) {
                         case 0:
@@ -698,12 +576,12 @@ bool ChooseCenter::_calPolyCenters()
                 }
 
                 float stDev;
-                float *stError = new float[n+1];
+                QVector<float> stErrorData(n+1);
+                float *stError = stErrorData.data();
                 if(!Matrix::lls(n+1,goodVolumes,MM,BB,stDev,currentCoeff,stError)) {
                     std::cerr<<"Least Squares Fit Failed in Construct Polynomial"<<std::endl;
                     return false;
                 }
-                delete [] stError;
 
                 //use these coefficient to
                 float errorSum = 0;
@@ -716,7 +594,7 @@ bool ChooseCenter::_calPolyCenters()
                         }
                         //if(criteria == 2)
                         //Message::toScreen(" Fitted Radius = "+QString().setNum(func_y));
-                        int jBest = _ppBestRadius[i][levelIndices[i]];
+                        int jBest = _volumeRadii(i).at(levelIndices[i]);
                         switch(criteria) {
                         case 0:
                             errorSum +=pow(func_y-_simplexResults->at(i).getMeanX(levelIndices[i], jBest), 2); break;
@@ -738,22 +616,22 @@ bool ChooseCenter::_calPolyCenters()
                 if(n > 1) {
                     if(squareVariance[n] > squareVariance[n-1]) {
                         // we found the best fit!!!!
-                        _ppBestFitVariance[criteria][k] = squareVariance[n-1];
-                        _ppBestFitDegree[criteria][k] = n-1;
+                        _bestFitVariance[criteria][k] = squareVariance[n-1];
+                        _bestFitDegree[criteria][k] = n-1;
                         // Now we have to revert back to the old set
                         // This is why everything is kept in storage
                         for(int l = 0; l <= n; l++) {
-                            _pppBestFitCoeff[criteria][k][l] = lastFitCoeff[l];
+                            _bestFitCoeff[criteria][k][l] = lastFitCoeff[l];
                         }
                         break;
                     }
                     else {
                         if(n == maxPoly) {
                             // Maxed out
-                            _ppBestFitVariance[criteria][k] = squareVariance[n];
-                            _ppBestFitDegree[criteria][k] = n;
+                            _bestFitVariance[criteria][k] = squareVariance[n];
+                            _bestFitDegree[criteria][k] = n;
                             for(int l = 0; l <= n; l++) {
-                                _pppBestFitCoeff[criteria][k][l] = currentCoeff[l];
+                                _bestFitCoeff[criteria][k][l] = currentCoeff[l];
                             }
                         }
                         else {
@@ -770,11 +648,11 @@ bool ChooseCenter::_calPolyCenters()
                             float fCrit = _fCriteria[degFreedom-1];
                             if(fTest < fCrit) {
                                 // Found the best center
-                                _ppBestFitVariance[criteria][k] = squareVariance[n-1];
-                                _ppBestFitDegree[criteria][k] = n-1;
+                                _bestFitVariance[criteria][k] = squareVariance[n-1];
+                                _bestFitDegree[criteria][k] = n-1;
                                 // degree = n-1; phasing out
                                 for(int l = 0; l <= (n-1); l++) {
-                                    _pppBestFitCoeff[criteria][k][l] = lastFitCoeff[l];
+                                    _bestFitCoeff[criteria][k][l] = lastFitCoeff[l];
                                 }
                             }
                         }
@@ -782,24 +660,14 @@ bool ChooseCenter::_calPolyCenters()
                 }
                 else {
                     // Doing a linear fit with only 3 points
-                    _ppBestFitVariance[criteria][k] = squareVariance[n];
-                    _ppBestFitDegree[criteria][k] = n;
+                    _bestFitVariance[criteria][k] = squareVariance[n];
+                    _bestFitDegree[criteria][k] = n;
                     for(int l = 0; l <= n; l++) {
-                        _pppBestFitCoeff[criteria][k][l] = currentCoeff[l];
+                        _bestFitCoeff[criteria][k][l] = currentCoeff[l];
                     }
                 }
             }
         }
-        //Message::toScreen("Got to deleting arrays");
-        for(int ii = 0; ii <= maxPoly; ii++) {
-            delete [] MM[ii];
-        }
-        delete [] MM;
-        delete [] BB;
-        delete [] squareVariance;
-        delete [] lastFitCoeff;
-        delete [] currentCoeff;
-        //delete [] stError;
     }
 
     return true;
@@ -810,24 +678,9 @@ bool ChooseCenter::_calPolyCenters()
 bool ChooseCenter::fixCenters()
 {
 
-    // Set up parameters for populating the vortexData
-    float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
-    float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
-    float radarLatRadians = radarLat * acos(-1.0)/180.0;
-    float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians) + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
-    float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians) + 0.00012 * cos(5.0 * radarLatRadians);
-
 
-    _ppNewBestRadius = new int*[_simplexResults->count()];
-    _ppNewBestCenter = new int*[_simplexResults->count()];
-    for(int i = 0; i < _simplexResults->count(); i++) {
-        _ppNewBestRadius[i] = new int[numHeights->count()];
-        _ppNewBestCenter[i] = new int[numHeights->count()];
-        for(int k = 0; k < numHeights->count(); k++) {
-            _ppNewBestRadius[i][k] = 0;
-            _ppNewBestCenter[i][k] = 0;
-        }
-    }
+    _newBestRadius = QVector<QVector<int> >(_simplexResults->count(), QVector<int>(numHeights.count(), 0));
+    _newBestCenter = QVector<QVector<int> >(_simplexResults->count(), QVector<int>(numHeights.count(), 0));
 
     // Get the volume with the latest time so we know which one we are
     // currently working on.
@@ -850,7 +703,7 @@ bool ChooseCenter::fixCenters()
         }
     }
 
-    QList<int> heights = numHeights->keys();
+    QList<int> heights = numHeights.keys();
     // Sort heights so that k index is attached to a specific height
     // Sort smallest to largest
     // The sorting is nessecary because QHash randomizes ordering
@@ -859,11 +712,11 @@ bool ChooseCenter::fixCenters()
             if(heights[t] < heights[s])
                 heights.swap(t,s);
 
-    for(int hidx = 0; hidx < numHeights->count(); hidx++) {
+    for(int hidx = 0; hidx < numHeights.count(); hidx++) {
 
         int currHeight = heights[hidx];  // in meters
-        // int goodVolumes = numHeights->value(currHeight);
-        int* levelIndices = indexOfHeights->value(currHeight);
+        // int goodVolumes = numHeights.value(currHeight);
+        const QVector<int> levelIndices = indexOfHeights.value(currHeight);
 
         if(levelIndices[lastTimeIndex]==-1){
             continue;
@@ -896,17 +749,17 @@ bool ChooseCenter::fixCenters()
                 // float stdError = 0;
                 float min = ((float)firstTime.secsTo(_simplexResults->at(vidx).getTime())/60.0);
                 //check out use of n up to best degree of fit based on assignment
-                for(int n = 0; n <= _ppBestFitDegree[0][hidx]; n++) {
-                    polyFitx += _pppBestFitCoeff[0][hidx][n]*pow(min,n);
+                for(int n = 0; n <= _bestFitDegree[0][hidx]; n++) {
+                    polyFitx += _bestFitCoeff[0][hidx][n]*pow(min,n);
                 }
-                for(int n = 0; n <= _ppBestFitDegree[1][hidx]; n++) {
-                    polyFity += _pppBestFitCoeff[1][hidx][n]*pow(min,n);
+                for(int n = 0; n <= _bestFitDegree[1][hidx]; n++) {
+                    polyFity += _bestFitCoeff[1][hidx][n]*pow(min,n);
                 }
-                for(int n = 0; n <= _ppBestFitDegree[2][hidx]; n++) {
-                    polyFitrad += _pppBestFitCoeff[2][hidx][n]*pow(min,n);
+                for(int n = 0; n <= _bestFitDegree[2][hidx]; n++) {
+                    polyFitrad += _bestFitCoeff[2][hidx][n]*pow(min,n);
                 }
-                for(int n = 0; n <= _ppBestFitDegree[3][hidx]; n++) {
-                    polyFitwind += _pppBestFitCoeff[3][hidx][n]*pow(min,n);
+                for(int n = 0; n <= _bestFitDegree[3][hidx]; n++) {
+                    polyFitwind += _bestFitCoeff[3][hidx][n]*pow(min,n);
                 }
 
                 float totalMinError = 0;
@@ -918,18 +771,18 @@ bool ChooseCenter::fixCenters()
                         if(!_simplexResults->at(vidx).getCenter(levelIndices[vidx],ridx,pidx).isValid()) {
 
                             Center currCenter = _simplexResults->at(vidx).getCenter(levelIndices[vidx],ridx,pidx);
-                            float stdX = sqrt(_ppBestFitVariance[0][hidx]);
+                            float stdX = sqrt(_bestFitVariance[0][hidx]);
                             xError = exp(-.5*pow((polyFitx-currCenter.getX())/stdX, 2));
-                            float stdY = sqrt(_ppBestFitVariance[1][hidx]);
+                            float stdY = sqrt(_bestFitVariance[1][hidx]);
                             yError = exp(-.5*pow((polyFity-currCenter.getY())/stdY, 2));
-                            float stdRad = sqrt(_ppBestFitVariance[2][hidx]);
+                            float stdRad = sqrt(_bestFitVariance[2][hidx]);
                             if(stdRad == 0) {
                                 radError = 1;
                             }
                             else {
                                 radError = exp(-.5*pow((polyFitrad-currCenter.getRadius())/stdRad, 2));
                             }
-                            float stdWind = sqrt(_ppBestFitVariance[3][hidx]);
+                            float stdWind = sqrt(_bestFitVariance[3][hidx]);
                             windError = exp(-.5*pow((polyFitwind-currCenter.getMaxVT())/stdWind, 2));
                             xError    *= _paramPosWeight;
                             yError    *= _paramPosWeight;
@@ -939,8 +792,8 @@ bool ChooseCenter::fixCenters()
 
                             if(totalError > totalMinError) {
                                 totalMinError = totalError;
-                                _ppNewBestRadius[vidx][hidx] = ridx;
-                                _ppNewBestCenter[vidx][hidx] = pidx;
+                                _newBestRadius[vidx][hidx] = ridx;
+                                _newBestCenter[vidx][hidx] = pidx;
                             }
                         }
                     }
@@ -948,7 +801,7 @@ bool ChooseCenter::fixCenters()
                 // new variables here but why?
 
                 // get best simplex center;
-                Center bestCenter = _simplexResults->at(vidx).getCenter(levelIndices[vidx],_ppNewBestRadius[vidx][hidx],_ppNewBestCenter[vidx][hidx]);
+                Center bestCenter = _simplexResults->at(vidx).getCenter(levelIndices[vidx],_newBestRadius[vidx][hidx],_newBestCenter[vidx][hidx]);
                 float xError, yError, radError;
 
                 xError = (polyFitx-bestCenter.getX())*(polyFitx-bestCenter.getX());
@@ -959,10 +812,10 @@ bool ChooseCenter::fixCenters()
                     // if the volume we are looking at is the last one we will want to keep all the info in vortexData
                     // We don't check to see that any of these levels are in the search zone for vortexData in vtd
 
-                    // int j = _ppBestRadius[vidx][levelIndices[vidx]];
+                    // int j = _volumeRadii(vidx).at(levelIndices[vidx]);
 
-                    float centerLat = radarLat + bestCenter.getY()/fac_lat;
-                    float centerLon = radarLon + bestCenter.getX()/fac_lon;
+                    float centerLat = _radarLat + bestCenter.getY()/_facLat;
+                    float centerLon = _radarLon + bestCenter.getX()/_facLon;
                     _vortexData->setLat(levelIndices[vidx], centerLat);
                     _vortexData->setLon(levelIndices[vidx], centerLon);
                     _vortexData->setHeight(levelIndices[vidx], _simplexResults->at(vidx).getHeight(levelIndices[vidx]));
@@ -987,17 +840,10 @@ bool ChooseCenter::fixCenters()
 void ChooseCenter::_useLastMean()
 {
     // Fake fill of vortexData for testing purposes
-  
-    float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
-    float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
-    float radarLatRadians = radarLat * acos(-1.0) / 180.0;
-    float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians)
-      + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
-    float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians)
-      + 0.00012 * cos(5.0 * radarLatRadians);
 
+    const QVector<int>& lastRadii = _volumeRadii(_simplexResults->size() - 1);
     for(int k = 0; k < _simplexResults->last().getNumLevels(); k++) {
-        int bestRadii = _ppBestRadius[_simplexResults->size() - 1][k];
+        int bestRadii = lastRadii.at(k);
 	
 	// TODO _simplexResults->last().getMeanY(k,bestRadii) could be -999
 	// Seems to happen when bestRadii is 0, but this is probably just one case.
@@ -1008,8 +854,8 @@ void ChooseCenter::_useLastMean()
 	
 	float meanX = _simplexResults->last().getMeanX(k, bestRadii);
 	float meanY = _simplexResults->last().getMeanY(k, bestRadii);
-	float centerLat = radarLat + meanY / fac_lat;
-        float centerLon = radarLon + meanX / fac_lon;
+	float centerLat = _radarLat + meanY / _facLat;
+        float centerLon = _radarLon + meanX / _facLon;
 
         _vortexData->setLat(k, centerLat);
         _vortexData->setLon(k, centerLon);
@@ -1026,54 +872,32 @@ void ChooseCenter::_useLastMean()
 
 void ChooseCenter::findHeights()
 {
-    numHeights = new QHash<int, int>;
-    indexOfHeights = new QHash<int,int*>;
+    numHeights.clear();
+    indexOfHeights.clear();
 
     for(int i = 0; i < _simplexResults->count(); i++) {
         if((_simplexResults->at(i).getTime() >= startTime) &&(_simplexResults->at(i).getTime() <= endTime)) {
             for(int j = 0; j < _simplexResults->at(i).getNumLevels(); j++) {
                 int currHeight = int(_simplexResults->at(i).getHeight(j)*1000+.5);
-                if(numHeights->value(currHeight,-1)==-1) {
-                    numHeights->insert(currHeight,1);
-                    int* newHeightArray = new int[_simplexResults->count()];
-                    for(int kk = 0; kk < _simplexResults->count(); kk++)
-                        newHeightArray[kk] = -1;
-                    indexOfHeights->insert(currHeight,newHeightArray);
-                }
-                else
-                    numHeights->insert(currHeight, numHeights->value(currHeight)+1);
-            }
-        }
-    }
-
-    for(int i = 0; i < _simplexResults->count(); i++) {
-        if((_simplexResults->at(i).getTime() >= startTime) && (_simplexResults->at(i).getTime() <= endTime)) {
-            for(int j = 0; j < _simplexResults->at(i).getNumLevels(); j++) {
-                int currHeight = int(_simplexResults->at(i).getHeight(j)*1000+.5);
-                int* heightProfile = indexOfHeights->take(currHeight);
-                heightProfile[i] = j;
-                indexOfHeights->insert(currHeight,heightProfile);
+                if(!indexOfHeights.contains(currHeight))
+                    indexOfHeights.insert(currHeight, QVector<int>(_simplexResults->count(), -1));
+                numHeights[currHeight]++;
+                indexOfHeights[currHeight][i] = j;
             }
         }
     }
 
-    QHash<int, int>::const_iterator i1 = numHeights->constBegin();
-    while (i1 != numHeights->constEnd()) {
+    QHash<int, int>::const_iterator i1 = numHeights.constBegin();
+    while (i1 != numHeights.constEnd()) {
         std::cout << i1.key() << ": " << i1.value() << std::endl;
         ++i1;
     }
-    QHash<int, int*>::const_iterator i = indexOfHeights->constBegin();
-    while(i!=indexOfHeights->constEnd()){
-        std::cout << i.key() << ": "<< i.value() << std::endl;
-        ++i;
-    }
 
-    QList<int> heights = numHeights->keys();
+    QList<int> heights = numHeights.keys();
     for(int i = 0; i < heights.count(); i++) {
-        if(numHeights->value(heights[i]) <= 3) {
-            numHeights->remove(heights[i]);
-            indexOfHeights->remove(heights[i]);
-            continue;
+        if(numHeights.value(heights[i]) <= 3) {
+            numHeights.remove(heights[i]);
+            indexOfHeights.remove(heights[i]);
         }
     }
 
@@ -1081,16 +905,20 @@ void ChooseCenter::findHeights()
 
 bool ChooseCenter::_polyFit(const int nCoeff, const int nData, const float* xData, const float* yData, float* aData, float& rss )
 {
-    float** A=new float*[nCoeff+1];
-    for(int i=0;i<=nCoeff;i++)
-        A[i]=new float[nData];
-    for(int i=0;i<=nCoeff;i++)
+    QVector<QVector<float> > aRows(nCoeff+1, QVector<float>(nData));
+    QVector<float*> aPtrs(nCoeff+1);
+    for(int i=0;i<=nCoeff;i++) {
         for(int j=0;j<nData;j++)
-            A[i][j]=pow(xData[j],float(i));
-    float* b=new float[nData];
+            aRows[i][j]=pow(xData[j],float(i));
+        aPtrs[i]=aRows[i].data();
+    }
+    float** A=aPtrs.data();
+    QVector<float> bData(nData);
+    float* b=bData.data();
     for(int i=0;i<nData;i++)
         b[i]=yData[i];
-    float* stError=new float[nData];
+    QVector<float> stErrorData(nData);
+    float* stError=stErrorData.data();
     float dummyStd;
     Matrix::lls(nCoeff+1,nData,A,b,dummyStd,aData,stError);
     for(int i=0;i<nData;i++)
@@ -1098,12 +926,6 @@ bool ChooseCenter::_polyFit(const int nCoeff, const int nData, const float* xDat
     rss =0.0f;
     for(int i=0;i<nData;i++)
         rss +=(b[i]-yData[i])*(b[i]-yData[i]);
-
-    delete[] stError;
-    delete[] b;
-    for(int i=0;i<=nCoeff;i++)
-        delete[] A[i];
-    delete[] A;
 	return true;
 }
 
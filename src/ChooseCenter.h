@@ -12,22 +12,29 @@
 #ifndef CHOOSECENTER_H
 #define CHOOSECENTER_H
 
-#include "Config/Configuration.h"
+#include "Config/ConfigSnapshot.h"
 #include "DataObjects/SimplexList.h"
 #include "DataObjects/VortexData.h"
 #include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QVector>
 
 class ChooseCenter
 {
 public:
-     ChooseCenter(Configuration* newConfig,const SimplexList* newList,VortexData* vortexPtr);
+     ChooseCenter(const ConfigSnapshot& settings,const SimplexList* newList,VortexData* vortexPtr);
     ~ChooseCenter();
 
+    // One ChooseCenter can follow a storm from volume to volume. The
+    // radii picked for each volume are kept while the volume is within
+    // the fitting window, so each call only scores the volumes it has
+    // not seen yet. Point it at the VortexData of each new volume first.
+    void setVortexData(VortexData* vortexPtr) { _vortexData = vortexPtr; }
     bool findCenter(int level);
 
 private:
     const int MAX_ORDER ;
-    const Configuration* _config;       // Should this be a constant parameter
     const SimplexList* _simplexResults;
     const SimplexData* _simplexData;
     const float velNull;
@@ -37,6 +44,8 @@ private:
     float _paramWindWeight, _paramStdWeight, _paramPtsWeight;
     float _paramPosWeight, _paramRmwWeight, _paramVelWeight;
     float _fCriteria[30];
+    float _radarLat, _radarLon;
+    float _facLat, _facLon;
     QDateTime startTime, endTime;
     QDateTime firstTime;
     /*
@@ -67,24 +76,28 @@ private:
      *   that is used obtaining the curve of best fit. These values were
      *   from a text
      *
+     * radarLat, radarLon, facLat and facLon turn the cappi x and y of a
+     *   center into latitude and longitude (km per degree at the radar)
+     *
      * startTime and endTime contain the user entered parameters controlling
      *   which volumes are used in the choose center process
      *
      */
 
-    float*** _pppScore;
-    int**    _ppBestRadius;
+    QMap<QDateTime, QVector<int> > _bestRadii;
     /*
-     * bestRadius contains the index of the best radius for each level of
-     *   each volume used. Here the best radius is decided from examining the
-     *   means of all converging centers used in the simplex run.
-     *   bestRadius[# of volumes used][# of levels in each volume]
+     * bestRadii contains the index of the best radius for each level of
+     *   each volume scored, keyed by the volume time. Here the best radius
+     *   is decided from examining the means of all converging centers used
+     *   in the simplex run. Volumes that leave the fitting window, or the
+     *   simplex list, are dropped at the next findCenter.
+     *   bestRadii[volume time][# of levels in the volume]
      *
      */
 
-    float **_ppBestFitVariance;
-    int   **_ppBestFitDegree;
-    float ***_pppBestFitCoeff;
+    QVector<QVector<float> > _bestFitVariance;
+    QVector<QVector<int> > _bestFitDegree;
+    QVector<QVector<QVector<float> > > _bestFitCoeff;
     /*
      * centerDev holds the standard deviation of the center of the storm
      *   for an averaged center position that is created from all of the
@@ -119,7 +132,7 @@ private:
      *
      */
 
-    int **_ppNewBestRadius, **_ppNewBestCenter;
+    QVector<QVector<int> > _newBestRadius, _newBestCenter;
     /*
      * newBestRadius holds the interger index of the radius that provides the
      *   highest score within the given criteria for each volume and level
@@ -146,8 +159,11 @@ private:
     
     int _paramMinVolumes;
 
-    void  _initialize();
-    bool  _calMeanCenters();
+    void  _initialize(const ConfigSnapshot& settings);
+    QList<int> _recentVolumes() const;
+    bool  _calMeanCenters(const QList<int>& volIdx);
+    void  _scoreVolume(const int vidx, QVector<int>& bestRadius) const;
+    const QVector<int>& _volumeRadii(const int vidx);
     bool  _calPolyCenters();
     bool  _calPolyTest(const QList<int>& volIdx,const int& levelIdx);
 
@@ -159,9 +175,16 @@ private:
     void  _polyTest();
     bool  _fTest(const float& RSS1,const int& freedom1,const float& RSS2,const int& freedom2);
 
-    QHash<int, int> *numHeights;
-    QHash<int, int*> *indexOfHeights;
-    
+    QHash<int, int> numHeights;
+    QHash<int, QVector<int> > indexOfHeights;
+    /*
+     * numHeights counts the volumes in the time window that have a level
+     *   at each height (in meters)
+     * indexOfHeights holds the level index at that height for each volume
+     *   of the simplex list, or -1 when the volume has no such level
+     *   indexOfHeights[height][# of volumes in the simplex list]
+     *
+     */
 
 };
 
@@ -0,0 +1,486 @@
+/*
+ *  ConfigSnapshot.cpp
+ *  VORTRAC
+ *
+ *  Typed copy of the configuration sections the analysis reads for
+ *  every volume
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "ConfigSnapshot.h"
+#include "DataObjects/GriddedData.h"
+
+#include <math.h>
+
+// The text of the first child called name, or fallback if there is none
+static QString textOf(const QDomElement& section, const QString& name,
+                      const QString& fallback = QString())
+{
+    QDomElement child = section.firstChildElement(name);
+    if(child.isNull())
+        return fallback;
+    return child.text().trimmed();
+}
+
+static float floatOf(const QDomElement& section, const QString& name,
+                     float fallback, QStringList& problems)
+{
+    QString text = textOf(section, name);
+    if(text.isEmpty())
+        return fallback;
+    bool ok;
+    float value = text.toFloat(&ok);
+    if(!ok) {
+        problems << QString(section.tagName() + ": <" + name + "> is not a number: " + text);
+        return fallback;
+    }
+    return value;
+}
+
+static int intOf(const QDomElement& section, const QString& name,
+                 int fallback, QStringList& problems)
+{
+    QString text = textOf(section, name);
+    if(text.isEmpty())
+        return fallback;
+    bool ok;
+    int value = text.toInt(&ok);
+    if(!ok) {
+        // Accept 16.0 for 16
+        float number = text.toFloat(&ok);
+        if(ok && (number == floorf(number)))
+            return (int)number;
+        problems << QString(section.tagName() + ": <" + name + "> is not a whole number: " + text);
+        return fallback;
+    }
+    return value;
+}
+
+// Dates are yyyy-MM-dd and times hh:mm:ss
+static QDate dateOf(const QDomElement& section, const QString& name,
+                    QStringList& problems)
+{
+    QString text = textOf(section, name);
+    if(text.isEmpty())
+        return QDate();
+    QDate date = QDate::fromString(text, Qt::ISODate);
+    if(!date.isValid())
+        problems << QString(section.tagName() + ": <" + name + "> is not a yyyy-MM-dd date: " + text);
+    return date;
+}
+
+static QTime timeOf(const QDomElement& section, const QString& name,
+                    QStringList& problems)
+{
+    QString text = textOf(section, name);
+    if(text.isEmpty())
+        return QTime();
+    QTime time = QTime::fromString(text, Qt::ISODate);
+    if(!time.isValid())
+        problems << QString(section.tagName() + ": <" + name + "> is not a hh:mm:ss time: " + text);
+    return time;
+}
+
+// <maxdatagap wavenum="i"> for i from 0 to maxWave. As with getParam,
+// the last element for a wave number wins.
+static QVector<float> dataGapsOf(const QDomElement& section, int maxWave,
+                                 QStringList& problems)
+{
+    QVector<float> gaps;
+    for(int i = 0; i <= maxWave; i++) {
+        QString text;
+        QDomElement gap = section.firstChildElement("maxdatagap");
+        while(!gap.isNull()) {
+            if(gap.attribute("wavenum") == QString().setNum(i))
+                text = gap.text().trimmed();
+            gap = gap.nextSiblingElement("maxdatagap");
+        }
+        bool ok = false;
+        float value = text.toFloat(&ok);
+        if(!ok) {
+            problems << QString(section.tagName() + ": no <maxdatagap wavenum=\""
+                                + QString().setNum(i) + "\"> for <maxwavenumber> "
+                                + QString().setNum(maxWave));
+            value = 0;
+        }
+        gaps.append(value);
+    }
+    return gaps;
+}
+
+VortexSettings::VortexSettings()
+{
+    lat = lon = 0;
+    direction = speed = 0;
+    rmw = 0;
+}
+
+RadarSettings::RadarSettings()
+{
+    lat = lon = alt = 0;
+    preGridded = false;
+    maxUnambigRange = -1;
+}
+
+CappiSettings::CappiSettings()
+{
+    xdim = ydim = zdim = 0;
+    xgridsp = ygridsp = zgridsp = 0;
+    zmin = 0;
+    barnesPasses = 2;
+    barnesSmoothing = 0.3;
+    threads = 0;
+    displayLevel = -1;
+    justDisplay = false;
+    output = "asi";
+    compression = false;
+    imageSize = 500;
+}
+
+CenterSettings::CenterSettings()
+{
+    bottomLevel = topLevel = 0;
+    innerRadius = outerRadius = ringWidth = 0;
+    influenceRadius = convergence = 0;
+    maxIterations = 0;
+    boxDiameter = 0;
+    numPoints = 0;
+    threads = 0;
+    maxWaveNumber = 0;
+    skipSimplex = false;
+}
+
+ChooseCenterSettings::ChooseCenterSettings()
+{
+    minVolumes = 0;
+    windWeight = stdWeight = ptsWeight = 0;
+    positionWeight = rmwWeight = vtWeight = 0;
+    stats = 95;
+}
+
+VtdSettings::VtdSettings()
+{
+    bottomLevel = topLevel = 0;
+    innerRadius = outerRadius = ringWidth = 0;
+    maxWaveNumber = 0;
+}
+
+HvvpSettings::HvvpSettings()
+{
+    // Same as the Hvvp constructor
+    levels = maxLevels;
+    hgtStart = .6;
+    hInc = .1;
+    xt = 2.0;
+}
+
+PressureSettings::PressureSettings()
+{
+    maxObsTime = 0;
+    maxObsDist = 0;
+    avInterval = 0;
+    rapidLimit = 0;
+    gradientHeight = -999;
+}
+
+QcSettings::QcSettings()
+{
+    isSet = false;
+    velMin = velMax = refMin = refMax = 0;
+    swThreshold = 0;
+    bbCount = maxFold = 0;
+    windSpeed = windDirection = 0;
+    vadLevels = numCoeff = vadThr = gvadThr = 0;
+    threads = 0;
+}
+
+ConfigSnapshot::ConfigSnapshot()
+{
+}
+
+bool ConfigSnapshot::read(const QDomElement& root)
+{
+    *this = ConfigSnapshot();
+
+    // A section that is not there keeps its defaults. Configurations made
+    // for other purposes, like the analytic ones, only have a few.
+    QDomElement section;
+    if(!(section = root.firstChildElement("vortex")).isNull())
+        readVortex(section);
+    if(!(section = root.firstChildElement("radar")).isNull())
+        readRadar(section);
+    if(!(section = root.firstChildElement("cappi")).isNull())
+        readCappi(section);
+    if(!(section = root.firstChildElement("center")).isNull())
+        readCenter(section);
+    if(!(section = root.firstChildElement("choosecenter")).isNull())
+        readChooseCenter(section);
+    if(!(section = root.firstChildElement("vtd")).isNull())
+        readVtd(section);
+    if(!(section = root.firstChildElement("hvvp")).isNull())
+        readHvvp(section);
+    if(!(section = root.firstChildElement("pressure")).isNull())
+        readPressure(section);
+    if(!(section = root.firstChildElement("qc")).isNull())
+        readQc(section);
+
+    return isValid();
+}
+
+void ConfigSnapshot::readVortex(const QDomElement& section)
+{
+    vortex.id = textOf(section, "id");
+    vortex.mode = textOf(section, "mode");
+    vortex.name = textOf(section, "name");
+    vortex.dir = textOf(section, "dir");
+    vortex.centers = textOf(section, "centers");
+    vortex.persistence = textOf(section, "persistence");
+    vortex.lat = floatOf(section, "lat", 0, problems);
+    vortex.lon = floatOf(section, "lon", 0, problems);
+    vortex.direction = floatOf(section, "direction", 0, problems);
+    vortex.speed = floatOf(section, "speed", 0, problems);
+    vortex.rmw = floatOf(section, "rmw", 0, problems);
+    vortex.obsDate = dateOf(section, "obsdate", problems);
+    vortex.obsTime = timeOf(section, "obstime", problems);
+    vortex.profile = textOf(section, "profile").toLower();
+    // json and true were the first names of jsonl
+    if((vortex.profile == "json") || (vortex.profile == "true"))
+        vortex.profile = "jsonl";
+    else if((vortex.profile == "false") || (vortex.profile == "none"))
+        vortex.profile = QString();
+
+    if((vortex.lat < -90) || (vortex.lat > 90))
+        problems << QString("vortex: <lat> is outside -90 to 90");
+    if((vortex.lon < -180) || (vortex.lon > 180))
+        problems << QString("vortex: <lon> is outside -180 to 180");
+    if(!vortex.profile.isEmpty() && (vortex.profile != "jsonl") && (vortex.profile != "csv"))
+        problems << QString("vortex: <profile> must be jsonl, csv or false: " + vortex.profile);
+}
+
+void ConfigSnapshot::readRadar(const QDomElement& section)
+{
+    radar.name = textOf(section, "name");
+    radar.format = textOf(section, "format");
+    radar.dir = textOf(section, "dir");
+    radar.lat = floatOf(section, "lat", 0, problems);
+    radar.lon = floatOf(section, "lon", 0, problems);
+    radar.alt = floatOf(section, "alt", 0, problems);
+    radar.startDate = dateOf(section, "startdate", problems);
+    radar.preGridded = (textOf(section, "pre_gridded") == "true");
+    radar.maxUnambigRange = floatOf(section, "max_unambig_range", -1, problems);
+
+    if((radar.lat < -90) || (radar.lat > 90))
+        problems << QString("radar: <lat> is outside -90 to 90");
+    if((radar.lon < -180) || (radar.lon > 180))
+        problems << QString("radar: <lon> is outside -180 to 180");
+}
+
+void ConfigSnapshot::readCappi(const QDomElement& section)
+{
+    cappi.dir = textOf(section, "dir");
+    cappi.xdim = floatOf(section, "xdim", 0, problems);
+    cappi.ydim = floatOf(section, "ydim", 0, problems);
+    cappi.zdim = floatOf(section, "zdim", 0, problems);
+    cappi.xgridsp = floatOf(section, "xgridsp", 0, problems);
+    cappi.ygridsp = floatOf(section, "ygridsp", 0, problems);
+    cappi.zgridsp = floatOf(section, "zgridsp", 0, problems);
+    cappi.zmin = floatOf(section, "zmin", 0, problems);
+    cappi.interpolation = textOf(section, "interpolation").toLower();
+    cappi.barnesPasses = intOf(section, "barnes_passes", cappi.barnesPasses, problems);
+    cappi.barnesSmoothing = floatOf(section, "barnes_smoothing", cappi.barnesSmoothing, problems);
+    cappi.threads = intOf(section, "threads", 0, problems);
+    cappi.displayLevel = intOf(section, "cappi_display_level", -1, problems);
+    cappi.justDisplay = (textOf(section, "just_display") == "true");
+    cappi.reflectivity = textOf(section, "reflectivity");
+    cappi.velocity = textOf(section, "velocity");
+    cappi.output = textOf(section, "output").toLower();
+    if(cappi.output.isEmpty())
+        cappi.output = "asi";
+    QString compression = textOf(section, "compression");
+    cappi.compression = (compression == "true");
+    cappi.imageDir = textOf(section, "image_dir");
+    cappi.imageSize = intOf(section, "image_size", cappi.imageSize, problems);
+
+    if((cappi.xdim <= 0) || (cappi.ydim <= 0) || (cappi.zdim <= 0))
+        problems << QString("cappi: <xdim>, <ydim> and <zdim> must be positive");
+    else if(!GriddedData::fitsAllocationLimits((int)cappi.xdim, (int)cappi.ydim, (int)cappi.zdim))
+        problems << QString("cappi: the grid is over the limits of "
+                            + QString().setNum(GriddedData::getMaxIDim()) + " x "
+                            + QString().setNum(GriddedData::getMaxJDim()) + " x "
+                            + QString().setNum(GriddedData::getMaxKDim()) + " points and "
+                            + QString().setNum(GriddedData::getMaxGridBytes() / 1048576) + " MB");
+    if((cappi.xgridsp <= 0) || (cappi.ygridsp <= 0) || (cappi.zgridsp <= 0))
+        problems << QString("cappi: <xgridsp>, <ygridsp> and <zgridsp> must be positive");
+    // Names CappiInterpolatorFactory knows, missing is cressman
+    QStringList interpolations;
+    interpolations << "" << "cressman" << "barnes" << "bilinear" << "closestpoint" << "nearest";
+    if(!interpolations.contains(cappi.interpolation))
+        problems << QString("cappi: <interpolation> must be cressman, barnes, bilinear or closestpoint: "
+                            + cappi.interpolation);
+    if(cappi.barnesPasses < 1)
+        problems << QString("cappi: <barnes_passes> must be at least 1");
+    if(cappi.barnesSmoothing <= 0)
+        problems << QString("cappi: <barnes_smoothing> must be positive");
+    if(cappi.threads < 0)
+        problems << QString("cappi: <threads> can not be negative");
+    if(cappi.imageSize <= 0)
+        problems << QString("cappi: <image_size> must be positive");
+    if((cappi.output != "asi") && (cappi.output != "binary")
+       && (cappi.output != "netcdf") && (cappi.output != "none"))
+        problems << QString("cappi: <output> must be asi, binary, netcdf or none: " + cappi.output);
+    if(!compression.isEmpty() && (compression != "true") && (compression != "false"))
+        problems << QString("cappi: <compression> must be true or false: " + compression);
+}
+
+void ConfigSnapshot::readCenter(const QDomElement& section)
+{
+    center.geometry = textOf(section, "geometry");
+    center.closure = textOf(section, "closure");
+    center.reflectivity = textOf(section, "reflectivity");
+    center.velocity = textOf(section, "velocity");
+    center.bottomLevel = floatOf(section, "bottomlevel", 0, problems);
+    center.topLevel = floatOf(section, "toplevel", 0, problems);
+    center.innerRadius = floatOf(section, "innerradius", 0, problems);
+    center.outerRadius = floatOf(section, "outerradius", 0, problems);
+    center.ringWidth = floatOf(section, "ringwidth", 0, problems);
+    center.influenceRadius = floatOf(section, "influenceradius", 0, problems);
+    center.convergence = floatOf(section, "convergence", 0, problems);
+    center.maxIterations = intOf(section, "maxiterations", 0, problems);
+    center.boxDiameter = floatOf(section, "boxdiameter", 0, problems);
+    center.numPoints = intOf(section, "numpoints", 0, problems);
+    center.threads = intOf(section, "threads", 0, problems);
+    center.maxWaveNumber = intOf(section, "maxwavenumber", 0, problems);
+    if(center.maxWaveNumber >= 0)
+        center.maxDataGap = dataGapsOf(section, center.maxWaveNumber, problems);
+    center.skipSimplex = (textOf(section, "skipsimplex") == "true");
+
+    checkRings("center", center.bottomLevel, center.topLevel, center.innerRadius,
+               center.outerRadius, center.ringWidth, center.maxWaveNumber);
+    // The simplex thread keeps at most 24 searches
+    if((center.numPoints < 1) || (center.numPoints >= 25))
+        problems << QString("center: <numpoints> must be 1 to 24");
+    if(center.influenceRadius <= 0)
+        problems << QString("center: <influenceradius> must be positive");
+    if(center.maxIterations <= 0)
+        problems << QString("center: <maxiterations> must be positive");
+    if(center.threads < 0)
+        problems << QString("center: <threads> can not be negative");
+}
+
+void ConfigSnapshot::readChooseCenter(const QDomElement& section)
+{
+    QDate startDate = dateOf(section, "startdate", problems);
+    QDate endDate = dateOf(section, "enddate", problems);
+    QTime startTime = timeOf(section, "starttime", problems);
+    QTime endTime = timeOf(section, "endtime", problems);
+    chooseCenter.startTime = QDateTime(startDate, startTime, Qt::UTC);
+    chooseCenter.endTime = QDateTime(endDate, endTime, Qt::UTC);
+    chooseCenter.minVolumes = intOf(section, "min_volumes", 0, problems);
+    chooseCenter.windWeight = floatOf(section, "wind_weight", 0, problems);
+    chooseCenter.stdWeight = floatOf(section, "stddev_weight", 0, problems);
+    chooseCenter.ptsWeight = floatOf(section, "pts_weight", 0, problems);
+    chooseCenter.positionWeight = floatOf(section, "position_weight", 0, problems);
+    chooseCenter.rmwWeight = floatOf(section, "rmw_weight", 0, problems);
+    chooseCenter.vtWeight = floatOf(section, "vt_weight", 0, problems);
+    chooseCenter.stats = intOf(section, "stats", 95, problems);
+
+    if((chooseCenter.stats != 95) && (chooseCenter.stats != 99))
+        problems << QString("choosecenter: <stats> must be 95 or 99");
+}
+
+void ConfigSnapshot::readVtd(const QDomElement& section)
+{
+    vtd.dir = textOf(section, "dir");
+    vtd.geometry = textOf(section, "geometry");
+    vtd.closure = textOf(section, "closure");
+    vtd.reflectivity = textOf(section, "reflectivity");
+    vtd.velocity = textOf(section, "velocity");
+    vtd.bottomLevel = floatOf(section, "bottomlevel", 0, problems);
+    vtd.topLevel = floatOf(section, "toplevel", 0, problems);
+    vtd.innerRadius = floatOf(section, "innerradius", 0, problems);
+    vtd.outerRadius = floatOf(section, "outerradius", 0, problems);
+    vtd.ringWidth = floatOf(section, "ringwidth", 0, problems);
+    vtd.maxWaveNumber = intOf(section, "maxwavenumber", 0, problems);
+    if(vtd.maxWaveNumber >= 0)
+        vtd.maxDataGap = dataGapsOf(section, vtd.maxWaveNumber, problems);
+
+    checkRings("vtd", vtd.bottomLevel, vtd.topLevel, vtd.innerRadius,
+               vtd.outerRadius, vtd.ringWidth, vtd.maxWaveNumber);
+}
+
+void ConfigSnapshot::readHvvp(const QDomElement& section)
+{
+    hvvp.levels = intOf(section, "levels", hvvp.levels, problems);
+    hvvp.hgtStart = floatOf(section, "hgt_start", hvvp.hgtStart, problems);
+    hvvp.hInc = floatOf(section, "hinc", hvvp.hInc, problems);
+    hvvp.xt = floatOf(section, "xt", hvvp.xt, problems);
+
+    if((hvvp.levels < 1) || (hvvp.levels > HvvpSettings::maxLevels))
+        problems << QString("hvvp: <levels> must be 1 to " + QString().setNum(HvvpSettings::maxLevels));
+    if(hvvp.hInc <= 0)
+        problems << QString("hvvp: <hinc> must be positive");
+}
+
+void ConfigSnapshot::readPressure(const QDomElement& section)
+{
+    pressure.format = textOf(section, "format");
+    pressure.dir = textOf(section, "dir");
+    pressure.maxObsTime = floatOf(section, "maxobstime", 0, problems);
+    pressure.maxObsDist = floatOf(section, "maxobsdist", 0, problems);
+    pressure.maxObsMethod = textOf(section, "maxobsmethod");
+    pressure.avInterval = intOf(section, "av_interval", 0, problems);
+    pressure.rapidLimit = floatOf(section, "rapidlimit", 0, problems);
+    pressure.gradientHeight = floatOf(section, "gradient_height", -999, problems);
+
+    if(!pressure.maxObsMethod.isEmpty() && (pressure.maxObsMethod != "center")
+       && (pressure.maxObsMethod != "ring"))
+        problems << QString("pressure: <maxobsmethod> must be center or ring");
+}
+
+void ConfigSnapshot::readQc(const QDomElement& section)
+{
+    qc.isSet = true;
+    qc.windMethod = textOf(section, "wind_method");
+    qc.velMin = floatOf(section, "vel_min", 0, problems);
+    qc.velMax = floatOf(section, "vel_max", 0, problems);
+    qc.refMin = floatOf(section, "ref_min", 0, problems);
+    qc.refMax = floatOf(section, "ref_max", 0, problems);
+    qc.swThreshold = floatOf(section, "sw_threshold", 0, problems);
+    qc.bbCount = intOf(section, "bbcount", 0, problems);
+    qc.maxFold = intOf(section, "maxfold", 0, problems);
+    qc.windSpeed = floatOf(section, "windspeed", 0, problems);
+    qc.windDirection = floatOf(section, "winddirection", 0, problems);
+    qc.vadLevels = intOf(section, "vadlevels", 0, problems);
+    qc.numCoeff = intOf(section, "numcoeff", 0, problems);
+    qc.vadThr = intOf(section, "vadthr", 0, problems);
+    qc.gvadThr = intOf(section, "gvadthr", 0, problems);
+    qc.threads = intOf(section, "threads", 0, problems);
+
+    if(qc.velMin > qc.velMax)
+        problems << QString("qc: <vel_min> is above <vel_max>");
+    if(qc.refMin > qc.refMax)
+        problems << QString("qc: <ref_min> is above <ref_max>");
+    if(qc.bbCount < 0)
+        problems << QString("qc: <bbcount> can not be negative");
+    if(qc.threads < 0)
+        problems << QString("qc: <threads> can not be negative");
+}
+
+void ConfigSnapshot::checkRings(const QString& section, float bottomLevel, float topLevel,
+                                float innerRadius, float outerRadius, float ringWidth,
+                                int maxWaveNumber)
+{
+    if(bottomLevel > topLevel)
+        problems << QString(section + ": <bottomlevel> is above <toplevel>");
+    if(innerRadius > outerRadius)
+        problems << QString(section + ": <innerradius> is beyond <outerradius>");
+    if(innerRadius < 0)
+        problems << QString(section + ": <innerradius> can not be negative");
+    if(ringWidth <= 0)
+        problems << QString(section + ": <ringwidth> must be positive");
+    if(maxWaveNumber < 0)
+        problems << QString(section + ": <maxwavenumber> can not be negative");
+}
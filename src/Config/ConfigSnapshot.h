@@ -0,0 +1,190 @@
+/*
+ *  ConfigSnapshot.h
+ *  VORTRAC
+ *
+ *  Typed copy of the configuration sections the analysis reads for
+ *  every volume
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef CONFIGSNAPSHOT_H
+#define CONFIGSNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDate>
+#include <QTime>
+#include <QDateTime>
+#include <QDomElement>
+
+// Configuration keeps a snapshot of its vortrac sections, parsed and
+// checked when the file is read and again whenever a parameter changes.
+// The run copies it once, so the threads read plain members instead of
+// walking the DOM and parsing strings, and a volume never sees a change
+// made half way through it. A value that is missing reads as it did
+// through getParam (empty, or 0); a value that is there but does not
+// parse, or is out of range, is a problem.
+
+class VortexSettings {
+public:
+    VortexSettings();
+    QString id, mode, name, dir;
+    QString centers;        // file of known centers, optional
+    QString persistence;
+    float lat, lon;
+    float direction, speed; // storm motion, degrees and m/s
+    float rmw;
+    QDate obsDate;
+    QTime obsTime;
+    QString profile;        // jsonl or csv, empty when not profiling
+};
+
+class RadarSettings {
+public:
+    RadarSettings();
+    QString name, format, dir;
+    float lat, lon, alt;
+    QDate startDate;
+    bool preGridded;
+    float maxUnambigRange;  // km, -1 when not given
+};
+
+class CappiSettings {
+public:
+    CappiSettings();
+    QString dir;
+    float xdim, ydim, zdim;
+    float xgridsp, ygridsp, zgridsp;
+    float zmin;
+    QString interpolation;
+    int barnesPasses;       // default 2
+    float barnesSmoothing;  // default 0.3
+    int threads;            // 0 uses every core
+    int displayLevel;       // -1 when not given
+    bool justDisplay;
+    QString reflectivity, velocity; // fields of pre gridded files, optional
+    QString output;         // asi, binary, netcdf or none, default asi
+    bool compression;       // binary and netcdf files only
+    QString imageDir;       // batch runs save a PNG per volume here, optional
+    int imageSize;          // pixels on a side of those images, default 500
+};
+
+class CenterSettings {
+public:
+    CenterSettings();
+    QString geometry, closure, reflectivity, velocity;
+    float bottomLevel, topLevel;
+    float innerRadius, outerRadius, ringWidth;
+    float influenceRadius, convergence;
+    int maxIterations;
+    float boxDiameter;
+    int numPoints;
+    int threads;            // 0 uses every core
+    int maxWaveNumber;
+    QVector<float> maxDataGap; // by wave number
+    bool skipSimplex;
+};
+
+class ChooseCenterSettings {
+public:
+    ChooseCenterSettings();
+    QDateTime startTime, endTime;
+    int minVolumes;
+    float windWeight, stdWeight, ptsWeight;
+    float positionWeight, rmwWeight, vtWeight;
+    int stats;              // 95 or 99 percent F test
+};
+
+class VtdSettings {
+public:
+    VtdSettings();
+    QString dir, geometry, closure, reflectivity, velocity;
+    float bottomLevel, topLevel;
+    float innerRadius, outerRadius, ringWidth;
+    int maxWaveNumber;
+    QVector<float> maxDataGap; // by wave number
+};
+
+class HvvpSettings {
+public:
+    HvvpSettings();
+    // Hvvp sizes its arrays for maxLevels
+    static const int maxLevels = 14;
+    int levels;
+    float hgtStart, hInc;   // km
+    float xt;
+};
+
+class PressureSettings {
+public:
+    PressureSettings();
+    QString format, dir;
+    float maxObsTime;       // minutes
+    float maxObsDist;       // km
+    QString maxObsMethod;   // center or ring
+    int avInterval;
+    float rapidLimit;
+    float gradientHeight;   // km, -999 when not given
+};
+
+class QcSettings {
+public:
+    QcSettings();
+    bool isSet;             // false if there is no qc section
+    QString windMethod;     // user, vad or gvad
+    float velMin, velMax, refMin, refMax;
+    float swThreshold;
+    int bbCount, maxFold;
+    float windSpeed, windDirection;
+    int vadLevels, numCoeff, vadThr, gvadThr;
+    int threads;            // 0 uses every core
+};
+
+class ConfigSnapshot
+{
+
+public:
+    ConfigSnapshot();
+
+    // Parses the sections under the vortrac root element. Returns false if
+    // any value is bad.
+    bool read(const QDomElement& root);
+
+    bool isValid() const { return problems.isEmpty(); }
+    // One line per bad value, "section: element ..."
+    const QStringList& getProblems() const { return problems; }
+
+    VortexSettings vortex;
+    RadarSettings radar;
+    CappiSettings cappi;
+    CenterSettings center;
+    ChooseCenterSettings chooseCenter;
+    VtdSettings vtd;
+    HvvpSettings hvvp;
+    PressureSettings pressure;
+    QcSettings qc;
+
+private:
+    QStringList problems;
+
+    void readVortex(const QDomElement& section);
+    void readRadar(const QDomElement& section);
+    void readCappi(const QDomElement& section);
+    void readCenter(const QDomElement& section);
+    void readChooseCenter(const QDomElement& section);
+    void readVtd(const QDomElement& section);
+    void readHvvp(const QDomElement& section);
+    void readPressure(const QDomElement& section);
+    void readQc(const QDomElement& section);
+
+    // Common checks of the ring and level layout of center and vtd
+    void checkRings(const QString& section, float bottomLevel, float topLevel,
+                    float innerRadius, float outerRadius, float ringWidth,
+                    int maxWaveNumber);
+};
+
+#endif
@@ -85,6 +85,7 @@ bool Configuration::read(const QString &filename)
         QDomElement group = currNode.toElement();
         indexForTagName.insert(group.tagName(), i);
     }
+    updateSnapshot();
     isModified = false;
     return true;
 }
@@ -234,6 +235,7 @@ void Configuration::setParam(const QDomElement &element,
         message+=(element.tagName()+": "+paramName+" = "+paramValue);
         if(logChanges)
             emit log(Message(message));
+        updateSnapshot();
         emit configChanged();
     }
     else {
@@ -276,6 +278,7 @@ void Configuration::setParam(const QDomElement &element,
         message+=(" = "+paramValue);
         if(logChanges)
             emit log(Message(message));
+        updateSnapshot();
         emit configChanged();
     }
 }
@@ -332,6 +335,7 @@ void Configuration::addDom(const QDomElement &element,
         }
 
         isModified = true;
+        updateSnapshot();
         emit configChanged();
     }
 }
@@ -401,6 +405,7 @@ void Configuration::addDom(const QDomElement &element,
         }
 
         isModified = true;
+        updateSnapshot();
         emit configChanged();
     }
 
@@ -436,6 +441,7 @@ void Configuration::removeDom(const QDomElement &element,
         message+=(element.tagName()+": "+paramName+" was removed");
         if(logChanges)
             emit log(Message(message,0,this->objectName()));
+        updateSnapshot();
         emit configChanged();
     }
 }
@@ -469,6 +475,7 @@ void Configuration::removeDom(const QDomElement &element,
         if(logChanges)
             emit log(Message(message));
 
+        updateSnapshot();
         emit configChanged();
     }
 }
@@ -593,6 +600,7 @@ Configuration& Configuration::operator = (const Configuration &other)
     groupList = other.groupList;
     indexForTagName = other.indexForTagName;
     isModified = other.isModified;
+    snapshot = other.snapshot;
     return *this;
 
 }
@@ -635,3 +643,19 @@ bool Configuration::validate()
     }
     return true;
 }
+
+void Configuration::updateSnapshot()
+{
+    // Only vortrac configurations have the analysis sections
+    if(root.tagName() != "vortrac")
+        return;
+
+    QStringList previous = snapshot.getProblems();
+    snapshot.read(root);
+    const QStringList& problems = snapshot.getProblems();
+    for(int i = 0; i < problems.count(); i++) {
+        if(!previous.contains(problems[i]))
+            emit log(Message(QString("Configuration: " + problems[i]), 0, this->objectName(),
+                             Yellow, QString("Bad Configuration Value")));
+    }
+}
@@ -18,6 +18,7 @@
 #include <QTextStream>
 #include <QHash>
 #include "IO/Message.h"
+#include "Config/ConfigSnapshot.h"
 
 class Configuration:public QObject
 {
@@ -54,6 +55,10 @@ public:
                                const QString &attribName);
     bool checkModified() { return isModified; }
 
+    // Typed values of the vortrac sections, kept up to date with the DOM.
+    // Copy it before handing it to another thread.
+    const ConfigSnapshot& getSnapshot() const { return snapshot; }
+
     const QDomElement getElement(const QDomElement &element,const QString &paramName) const;
 
     const QDomElement getElementWithAttrib(const QDomElement &element,
@@ -114,6 +119,10 @@ private:
     QHash<QString, int> indexForTagName;
     bool isModified;
     bool logChanges;
+    ConfigSnapshot snapshot;
+
+    // Rereads the snapshot and logs the values that just went bad
+    void updateSnapshot();
 
 signals:
     void log(const Message& message) const;
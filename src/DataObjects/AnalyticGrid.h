@@ -67,7 +67,6 @@ class AnalyticGrid : public GriddedData
   float dialationAxis;
 
   float latReference, lonReference;
-  QString outFileName;
   float* relDist;
 
   float *vLat, *vLon, *rLat, *rLon;
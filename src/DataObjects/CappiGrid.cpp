@@ -9,11 +9,13 @@
  */
 
 #include "CappiGrid.h"
+#include "CappiInterpolator.h"
 #include "IO/Message.h"
 #include <math.h>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QThread>
 
 CappiGrid::CappiGrid() : GriddedData()
 {
@@ -24,23 +26,25 @@ CappiGrid::CappiGrid() : GriddedData()
     // To make the cappi bigger but still compute it in a reasonable amount of time,
     // skip the reflectivity grid, otherwise set this to true
     gridReflectivity = true;
+
+    numThreads = 1;
+    interpolationMsecs = 0;
 }
 
 CappiGrid::~CappiGrid()
 {
 }
 
-void CappiGrid::setDisplayIndex(QDomElement cappiConfig, float kSpacing) {
-  QDomElement n = cappiConfig.firstChildElement("cappi_display_level");
-  if (! n.isNull()) {
-    kDisplayIndex = n.text().toInt();
+void CappiGrid::setDisplayIndex(const CappiSettings& cappiConfig, float kSpacing) {
+  if (cappiConfig.displayLevel != -1) {
+    kDisplayIndex = cappiConfig.displayLevel;
   } else {
     // No value given. Set it to 3km as default
     kDisplayIndex = (int) (3.0 / kSpacing);
   }
 }
 
-void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,float *vortexLat, float *vortexLon)
+void CappiGrid::gridRadarData(RadarData *radarData, const CappiSettings& cappiConfig,float *vortexLat, float *vortexLon)
 {
     // Message::toScreen("IN CAPPI GRID DATA");
 
@@ -48,7 +52,7 @@ void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,floa
     //bool abort = returnExitNow();
 
     // Set the output file
-    QString cappiPath = cappiConfig.firstChildElement("dir").text();
+    QString cappiPath = cappiConfig.dir;
     QString cappiFile = radarData->getDateTimeString();
     cappiFile.replace(QString(":"),QString("_"));
     outFileName = cappiPath + "/" + cappiFile;
@@ -57,16 +61,23 @@ void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,floa
 
     // Get the dimensions from the configuration
     // all dimensions are in units of cappi grid points
-    iDim = cappiConfig.firstChildElement("xdim").text().toFloat();
-    jDim = cappiConfig.firstChildElement("ydim").text().toFloat();
-    kDim = cappiConfig.firstChildElement("zdim").text().toFloat();
+    iDim = cappiConfig.xdim;
+    jDim = cappiConfig.ydim;
+    kDim = cappiConfig.zdim;
 
     // all grid spacings are in units of km
-    iGridsp = cappiConfig.firstChildElement("xgridsp").text().toFloat();
-    jGridsp = cappiConfig.firstChildElement("ygridsp").text().toFloat();
-    kGridsp = cappiConfig.firstChildElement("zgridsp").text().toFloat();
+    iGridsp = cappiConfig.xgridsp;
+    jGridsp = cappiConfig.ygridsp;
+    kGridsp = cappiConfig.zgridsp;
 
     setDisplayIndex(cappiConfig, kGridsp);
+    setNumThreads(cappiConfig);
+
+    // Size the field storage from the configured dimensions
+    if (!allocateGrid()) {
+        Message::toScreen("CappiGrid: CAPPI dimensions exceed the allocation limits, check the cappi configuration");
+        return;
+    }
     
     // Should this be get cartesian point? Don't we use the grid spacing
     // in that calculation? -LM 6/11/07
@@ -92,68 +103,58 @@ void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,floa
     latReference = *radarData->getRadarLat();
     lonReference = *radarData->getRadarLon();
 
-    zmin = cappiConfig.firstChildElement("zmin").text().toFloat();;
+    zmin = cappiConfig.zmin;
     zmax = zmin + kDim*kGridsp;
 
     delete[] relDist;
 
     // Interpolate the data depending on method chosen
-    QString interpolation = cappiConfig.firstChildElement("interpolation").text();
-    if (interpolation == "cressman") {
-        CressmanInterpolation(radarData);
+    CappiInterpolator *interpolator = CappiInterpolatorFactory::newInterpolator(cappiConfig);
+    if (interpolator != NULL) {
+        if (interpolator->needsGateIndex())
+            indexGates(radarData);
+        interpolator->interpolate(*this, radarData);
+        interpolationName = interpolator->getName();
+        interpolationMsecs = interpolator->getElapsedMsecs();
+        delete interpolator;
+
+        // The gates are not needed once the grid is filled
+        refGates.release();
+        velGates.release();
+    } else {
+        Message::toScreen("CappiGrid: Unknown interpolation "
+                          + cappiConfig.interpolation
+                          + ", check the cappi configuration");
     }
 
     // Set the initial field names
     fieldNames << "DZ" << "VE" << "HT";
 }
 
-void CappiGrid::CressmanInterpolation(RadarData *radarData)
+void CappiGrid::setNumThreads(const CappiSettings& cappiConfig)
 {
-    // Cressman Interpolation
-
-    // Calculate radius of influence
-    float hROI = 2.0;
-    float vROI = 1.0;
-    float xRadius = (iGridsp * iGridsp) * (hROI*hROI);
-    float yRadius = (jGridsp * jGridsp) * (hROI*hROI);
-    float zRadius = (kGridsp * kGridsp) * (vROI*vROI);
-    float RSquare = xRadius + yRadius + zRadius;
-    int maxIplus = (int)(RSquare/iGridsp);
-    int maxJplus = (int)(RSquare/jGridsp);
-    int maxKplus = (int)(RSquare/kGridsp);
-
-    // Initialize weights
-    for (int k = 0; k < int(kDim); k++) {
-        for (int j = 0; j < int(jDim); j++) {
-            for (int i = 0; i < int(iDim); i++) {
-                refValues[i][j][k].sumRef = 0;
-                refValues[i][j][k].weight = 0;
-                velValues[i][j][k].sumVel = 0;
-                velValues[i][j][k].height = 0;
-                velValues[i][j][k].weight = 0;
-            }
-        }
-    }
+    // Optional: missing or 0 uses every core, 1 grids serially
+    numThreads = cappiConfig.threads;
+    if (numThreads <= 0)
+        numThreads = QThread::idealThreadCount();
+    if (numThreads < 1)
+        numThreads = 1;
+}
 
-    // Find the maximum unambiguous range for the volume
-    float maxUnambig_range = 0;
-    float maxNyquist = 0;
-    for (int n = 0; n < radarData->getNumSweeps(); n++) {
-        Sweep* currentSweep = radarData->getSweep(n);
-        float range = currentSweep->getUnambig_range() * 2;
-        if ((currentSweep->getVel_numgates() > 0) and (range > maxUnambig_range) and (currentSweep->getElevation() < 1.0)) {
-            maxUnambig_range = range;
-        }
-        float nyquist= currentSweep->getNyquist_vel();
-        if ((currentSweep->getVel_numgates() > 0) and (nyquist > maxNyquist))
-            maxNyquist = nyquist;
-    }
+void CappiGrid::indexGates(RadarData *radarData)
+{
+    // Every gate that can reach the grid, in grid cell units
+    refGates.reset((int)iDim, (int)jDim);
+    velGates.reset((int)iDim, (int)jDim);
 
-    // Find good values
     for (int n = 0; n < radarData->getNumRays(); n++) {
         Ray* currentRay = radarData->getRay(n);
         float theta = deg2rad * fmodf((450. - currentRay->getAzimuth()),360.);
         float phi = deg2rad * (90. - (currentRay->getElevation()));
+        float cosTheta = cos(theta);
+        float sinTheta = sin(theta);
+        float sinPhi = sin(phi);
+        GateIndex::Gate gate;
 
         if ((currentRay->getRef_numgates() > 0) and
                 (gridReflectivity)) {
@@ -164,372 +165,57 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
                 float range = float(currentRay->getFirst_ref_gate() +
                                     (g * currentRay->getRef_gatesp()))/1000.;
 
-                float x = range*sin(phi)*cos(theta);
+                float x = range*sinPhi*cosTheta;
                 if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                float y = range*sin(phi)*sin(theta);
+                float y = range*sinPhi*sinTheta;
                 if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
                 float z = radarData->radarBeamHeight(range,
                                                      currentRay->getElevation() );
                 if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
 
-                // Looks like a good point, find its closest Cartesian index
-                float i = (x - xmin)/iGridsp;
-                float j = (y - ymin)/jGridsp;
-                float k = (z - zmin)/kGridsp;
-                float RSquareLinear = RSquare*range*range / 30276.0;
-                for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                    for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                        int iIndex = (int)(i+iplus);
-                        int jIndex = (int)(j+jplus);
-                        int kIndex = (int)(k+kplus);
-                        if ((iIndex < 0) or (iIndex > (int)iDim)) { continue; }
-                        if ((jIndex < 0) or (jIndex > (int)jDim)) { continue; }
-                        if ((kIndex < 0) or (kIndex > (int)kDim)) { continue; }
-
-                        float dx = (i - (int)(i+iplus))*iGridsp;
-                        float dy = (j - (int)(j+jplus))*jGridsp;
-                        float dz = (k - (int)(k+kplus))*kGridsp;
-                        float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                        if (rSquare > RSquareLinear) { continue; }
-                        float weight = (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                        refValues[iIndex][jIndex][kIndex].weight += weight;
-                        refValues[iIndex][jIndex][kIndex].sumRef += weight*refData[g];
-                    }
-                }
-                }
+                gate.i = (x - xmin)/iGridsp;
+                gate.j = (y - ymin)/jGridsp;
+                gate.k = (z - zmin)/kGridsp;
+                gate.height = z;
+                gate.range = range;
+                gate.value = refData[g];
+                gate.nyquist = 0;
+                gate.source = &refData[g];
+                refGates.addGate(gate);
             }
-
         }
+
         if (currentRay->getVel_numgates() > 0) {
-                // Just grab the lowest elevation sweeps
-                //and (currentRay->getElevation() < 0.75)) {
-                //and (fabs(currentRay->getNyquist_vel() - maxNyquist) < 0.1)) {
             float* velData = currentRay->getVelData();
-            // float* swData = currentRay->getSwData();
             float nyquist = currentRay->getNyquist_vel();
             for (int g = 0; g <= (currentRay->getVel_numgates()-1); g++) {
                 if (velData[g] == -999.) { continue; }
 
                 float range = float(currentRay->getFirst_vel_gate() +
                                     (g * currentRay->getVel_gatesp()))/1000.;
-                float x = range*sin(phi)*cos(theta);
+                float x = range*sinPhi*cosTheta;
                 if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                float y = range*sin(phi)*sin(theta);
+                float y = range*sinPhi*sinTheta;
                 if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
                 float z = radarData->radarBeamHeight(range,
                                                      currentRay->getElevation() );
                 if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
 
-                // Looks like a good point, find its closest Cartesian index
-                float i = (x - xmin)/iGridsp;
-                float j = (y - ymin)/jGridsp;
-                float k = (z - zmin)/kGridsp;
-                float RSquareLinear = RSquare; //* range*range / 30276.0;
-                for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                    for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                        int iIndex = (int)(i+iplus);
-                        int jIndex = (int)(j+jplus);
-                        int kIndex = (int)(k+kplus);
-                        if ((iIndex < 0) or (iIndex >= (int)iDim)) { continue; }
-                        if ((jIndex < 0) or (jIndex >= (int)jDim)) { continue; }
-                        if ((kIndex < 0) or (kIndex >= (int)kDim)) { continue; }
-
-                        float dx = (i - (int)(i+iplus))*iGridsp;
-                        float dy = (j - (int)(j+jplus))*jGridsp;
-                        float dz = (k - (int)(k+kplus))*kGridsp;
-                        float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                        if (rSquare > RSquareLinear) { continue; }
-                        float weight = (100*nyquist) *(RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                        velValues[iIndex][jIndex][kIndex].weight += weight;
-                        velValues[iIndex][jIndex][kIndex].sumVel += weight*velData[g];
-                        velValues[iIndex][jIndex][kIndex].height += weight*z;
-                    }
-                }
-                }
-            }
-
-            velData = NULL;
-            // swData = NULL;
-            //delete velData;
-            //delete swData;
-        }
-        currentRay = NULL;
-        //delete currentRay;
-    }
-
-    //Message::toScreen("# of Reflectivity gates used in CAPPI = "+QString().setNum(r));
-    //Message::toScreen("# of Velocity gates used in CAPPI = "+QString().setNum(v));
-
-    for (int k = 0; k < int(kDim); k++) {
-        for (int j = 0; j < int(jDim); j++) {
-            for (int i = 0; i < int(iDim); i++) {
-
-                dataGrid[0][i][j][k] = -999;
-                dataGrid[1][i][j][k] = -999;
-                dataGrid[2][i][j][k] = -999;
-
-                if (refValues[i][j][k].weight > 0) {
-                    dataGrid[0][i][j][k] = refValues[i][j][k].sumRef/refValues[i][j][k].weight;
-                }
-                if (velValues[i][j][k].weight > 0) {
-                    dataGrid[1][i][j][k] = velValues[i][j][k].sumVel/velValues[i][j][k].weight;
-                    dataGrid[2][i][j][k] = velValues[i][j][k].height/velValues[i][j][k].weight;
-                }
-                velValues[i][j][k].sumVel = 0;
-                velValues[i][j][k].height = 0;
-                velValues[i][j][k].weight = 0;
+                gate.i = (x - xmin)/iGridsp;
+                gate.j = (y - ymin)/jGridsp;
+                gate.k = (z - zmin)/kGridsp;
+                gate.height = z;
+                gate.range = range;
+                gate.value = velData[g];
+                gate.nyquist = nyquist;
+                gate.source = &velData[g];
+                velGates.addGate(gate);
             }
         }
     }
 
-    int maxfoldpasses = 1;
-    int localArea = 10;
-    for (int foldpass = 0; foldpass < maxfoldpasses; foldpass++) {
-        // Find good values
-        for (int n = 0; n < radarData->getNumRays(); n++) {
-            Ray* currentRay = radarData->getRay(n);
-            float theta = deg2rad * fmodf((450. - currentRay->getAzimuth()),360.);
-            float phi = deg2rad * (90. - (currentRay->getElevation()));
-
-            if ((currentRay->getVel_numgates() > 0)) {
-                    // Just grab the lowest elevation sweeps & try to adjust bad folds
-                    //and (currentRay->getElevation() < 0.75)) {
-                float* velData = currentRay->getVelData();
-                // float* swData = currentRay->getSwData();
-                float nyquist = currentRay->getNyquist_vel();
-                for (int g = 0; g <= (currentRay->getVel_numgates()-1); g++) {
-                    if (velData[g] == -999.) { continue; }
-
-                    float range = float(currentRay->getFirst_vel_gate() +
-                                        (g * currentRay->getVel_gatesp()))/1000.;
-                    float x = range*sin(phi)*cos(theta);
-                    if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                    float y = range*sin(phi)*sin(theta);
-                    if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
-                    float z = radarData->radarBeamHeight(range,
-                                                         currentRay->getElevation() );
-                    if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
-
-                    // Looks like a good point, find its closest Cartesian index
-                    float i = (x - xmin)/iGridsp;
-                    float j = (y - ymin)/jGridsp;
-                    float k = (z - zmin)/kGridsp;
-                    float RSquareLinear = RSquare; //* range*range / 30276.0;
-                    for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                    for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                        for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                            int iIndex = (int)(i+iplus);
-                            int jIndex = (int)(j+jplus);
-                            int kIndex = (int)(k+kplus);
-                            if ((iIndex < 0) or (iIndex >= (int)iDim)) { continue; }
-                            if ((jIndex < 0) or (jIndex >= (int)jDim)) { continue; }
-                            if ((kIndex < 0) or (kIndex >= (int)kDim)) { continue; }
-
-                            float dx = (i - (int)(i+iplus))*iGridsp;
-                            float dy = (j - (int)(j+jplus))*jGridsp;
-                            float dz = (k - (int)(k+kplus))*kGridsp;
-                            float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                            if (rSquare > RSquareLinear) { continue; }
-                            float avgCappi = 0;
-                            float quadcount = 0;
-                            for (int quadi = iIndex-localArea; quadi <= iIndex+localArea; quadi++) {
-                                for (int quadj = jIndex-localArea; quadj <= jIndex+localArea; quadj++) {
-                                    if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
-                                    if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                                    if (dataGrid[1][quadi][quadj][kIndex] != -999) {
-                                        avgCappi += dataGrid[1][quadi][quadj][kIndex];
-                                        quadcount++;
-                                    }
-                                }
-                            }
-                            int minfold = 0;
-                            if (quadcount != 0) { // Need at least one seed from the higher nyquist, otherwise use original
-                                avgCappi /= quadcount;
-                                float velDiff = velData[g] - avgCappi;
-                                if (fabs(velDiff) > nyquist) {
-                                    // Potential folding problem
-                                    float mindiff = 999999;
-                                    for (int fold=-2; fold <=2; fold++) {
-                                        velDiff = velData[g]+2*fold*nyquist - avgCappi;
-                                        if (fabs(velDiff) < mindiff) {
-                                            mindiff = fabs(velDiff);
-                                            minfold = fold;
-                                        }
-                                    }
-                                }
-                            }
-                            velData[g] += 2*minfold*nyquist;
-                            float newVel = velData[g];
-                            float weight = (100*nyquist) * (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                            velValues[iIndex][jIndex][kIndex].weight += weight;
-                            velValues[iIndex][jIndex][kIndex].sumVel += weight*newVel;
-                        }
-                    }
-                    }
-                }
-
-                velData = NULL;
-                // swData = NULL;
-                //delete velData;
-                //delete swData;
-            }
-            currentRay = NULL;
-            //delete currentRay;
-        }
-
-
-
-        for (int k = 0; k < int(kDim); k++) {
-            for (int j = 0; j < int(jDim); j++) {
-                for (int i = 0; i < int(iDim); i++) {
-                    dataGrid[1][i][j][k] = -999;
-                    if (velValues[i][j][k].weight > 0) {
-                        dataGrid[1][i][j][k] = velValues[i][j][k].sumVel/velValues[i][j][k].weight;
-                    }
-                    velValues[i][j][k].sumVel = 0;
-                    velValues[i][j][k].weight = 0;
-                }
-            }
-        }
-    }
-
-    // Smooth local outliers
-    for (int k = 0; k < int(kDim); k++) {
-        // float sumtexture = 0;
-        // float maxtexture = 0;
-        for (int j = 1; j < int(jDim)-1; j++) {
-            for (int i = 1; i < int(iDim)-1; i++) {
-                float avgCappi = 0;
-                float quadcount = 0;
-                for (int quadi = i-localArea; quadi <= i+localArea; quadi++) {
-                    for (int quadj = j-localArea; quadj <= j+localArea; quadj++) {
-                        if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
-                        if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                        if (dataGrid[1][quadi][quadj][k] != -999) {
-                            avgCappi += dataGrid[1][quadi][quadj][k];
-                            quadcount++;
-                        }
-                    }
-                }
-                if (quadcount != 0) {
-                    avgCappi /= quadcount;
-                    float stdVel = 0;
-                    for (int quadi = i-localArea; quadi <= i+localArea; quadi++) {
-                        for (int quadj = j-localArea; quadj <= j+localArea; quadj++) {
-                            if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
-                            if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                            if (dataGrid[1][quadi][quadj][k] != -999) {
-                                stdVel += (dataGrid[1][quadi][quadj][k]-avgCappi)*
-                                        (dataGrid[1][quadi][quadj][k]-avgCappi);
-                            }
-                        }
-                    }
-                    stdVel = sqrt(stdVel/quadcount);
-                    float diffCappi = fabs(dataGrid[1][i][j][k] - avgCappi);
-                    if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)) {
-                        dataGrid[1][i][j][k] =avgCappi;
-                    }
-                }
-            }
-        }
-    }
-
-    /* Remove global outliers
- for (int k = 0; k < int(kDim); k++) {
-  // float sumtexture = 0;
-  // float maxtexture = 0;
-  float posCappi = 0;
-  float poscount = 0;
-  float negCappi = 0;
-  float negcount = 0;
-  for (int j = 1; j < int(jDim)-1; j++) {
-   abort = returnExitNow();
-   if(abort){
-    //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-    return;
-   }
-   for (int i = 1; i < int(iDim)-1; i++) {
-    if (dataGrid[1][i][j][k] != -999) {
-     if (dataGrid[1][i][j][k] > 0) {
-      posCappi += dataGrid[1][i][j][k];
-      QString pos;
-      poscount++;
-     } else {
-      negCappi += dataGrid[1][i][j][k];
-      negcount++;
-     }
-    }
-   }
-  }
-  if (poscount != 0) {
-   posCappi /= poscount;
-   float stdVel = 0;
-   for (int j = 1; j < int(jDim)-1; j++) {
-    abort = returnExitNow();
-    if(abort){
-     //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-     return;
-    }
-    for (int i = 1; i < int(iDim)-1; i++) {
-     if ((dataGrid[1][i][j][k] != -999) and (dataGrid[1][i][j][k] > 0)) {
-      stdVel += (dataGrid[1][i][j][k]-posCappi)*
-      (dataGrid[1][i][j][k]-posCappi);
-     }
-    }
-   }
-   stdVel = sqrt(stdVel/poscount);
-   for (int j = 1; j < int(jDim)-1; j++) {
-    abort = returnExitNow();
-    if(abort){
-     //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-     return;
-    }
-    for (int i = 1; i < int(iDim)-1; i++) {
-     float diffCappi = fabs(dataGrid[1][i][j][k] - posCappi);
-     if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)
-      and (dataGrid[1][i][j][k] > 0)) {
-      dataGrid[1][i][j][k] = -999;
-     }
-    }
-   }
-  }
-  if (negcount != 0) {
-   negCappi /= negcount;
-   float stdVel = 0;
-   for (int j = 1; j < int(jDim)-1; j++) {
-    abort = returnExitNow();
-    if(abort){
-     //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-     return;
-    }
-    for (int i = 1; i < int(iDim)-1; i++) {
-     if ((dataGrid[1][i][j][k] != -999) and (dataGrid[1][i][j][k] < 0)) {
-      stdVel += (dataGrid[1][i][j][k]-negCappi)*
-      (dataGrid[1][i][j][k]-negCappi);
-     }
-    }
-   }
-   stdVel = sqrt(stdVel/negcount);
-   for (int j = 1; j < int(jDim)-1; j++) {
-    abort = returnExitNow();
-    if(abort){
-     //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-     return;
-    }
-    for (int i = 1; i < int(iDim)-1; i++) {
-     float diffCappi = fabs(dataGrid[1][i][j][k] - negCappi);
-     if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)
-      and (dataGrid[1][i][j][k] < 0)) {
-      dataGrid[1][i][j][k] = -999;
-     }
-    }
-   }
-  }
- } */
-
-
+    refGates.build();
+    velGates.build();
 }
 
 // TODO
@@ -621,7 +307,7 @@ bool CappiGrid::getFillValue(Nc3Var *var, float &val)
 
 // Example: fieldNames.
 
-void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
+void CappiGrid::loadPreGridded(RadarData *radarData, const CappiSettings& cappiConfig)
 {
   Nc3Error ncError(Nc3Error::verbose_nonfatal); // Prevent NertCDF error from exiting the program
 
@@ -660,13 +346,12 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
     std::cerr << "Can't get z0 array from file" << std::endl;
 
   setDisplayIndex(cappiConfig, kGridsp);
-  
-  // TODO: Some debug stuff
-  // std::cout << "x0: " << iDim << ", y0: " << jDim << ", z0: " << kDim << std::endl;
-  // std::cout << "xmin: " << xmin << ", xmax: " << xmax << std::endl;
-  // std::cout << "ymin: " << ymin << ", ymax: " << ymax << std::endl;
-  // std::cout << "zmin: " << zmin << ", zmax: " << zmax << std::endl;
 
+  if (! allocateGrid() ) {
+    std::cerr << "Grid in " << fname.toLatin1().data() << " exceeds the allocation limits" << std::endl;
+    return;
+  }
+  
   // TODO There is confusion about latReference/lonReference, and originLat/originLon
   // SimplexThread assume thar Reference is the radar position
   
@@ -677,9 +362,8 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
     std::cerr << "Can't get origin Lat and Lon from " << fname.toLatin1().data() << std::endl;
 
   QString refVarName = "REF";	// default value
-  QDomElement r = cappiConfig.firstChildElement("reflectivity");
-  if (! r.isNull())
-    refVarName = r.text();
+  if (! cappiConfig.reflectivity.isEmpty())
+    refVarName = cappiConfig.reflectivity;
   
   Nc3Var *reflectivity = file.get_var(refVarName.toLatin1().data());	// radar_reflexivity
   if (reflectivity == NULL) {
@@ -689,12 +373,9 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
 
   // This can be user specified. Default: VU
   QString velVarName = "VU";
-  QDomElement s = cappiConfig.firstChildElement("velocity");
-  if (! s.isNull())
-    velVarName = s.text();
+  if (! cappiConfig.velocity.isEmpty())
+    velVarName = cappiConfig.velocity;
 
-  // std::cout << "Velocity Variable: " << velVarName.toLatin1().data() << std::endl;
-  
   Nc3Var *velocity = file.get_var(velVarName.toLatin1().data());
   if( velocity == NULL)
     std::cerr << "Can't get velocity (" << velVarName.toLatin1().data() << ") from " << fname.toLatin1().data() << std::endl;
@@ -776,17 +457,17 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
 	v = *(ref + i * yDim + j);		// reflectivity (REF)
 	if (v <= ref_fill)
 	  v = -999;
-	dataGrid[0][j][i][k] = v;	
+	dataGrid(0,j,i,k) = v;	
 
 	v = *(vel + i * yDim + j);		// dopler velocity magnitude (VU)
 	if (v <= vel_fill)
 	  v = -999;
-	dataGrid[1][j][i][k] = v;
+	dataGrid(1,j,i,k) = v;
 
 	v = *(spec + i * yDim + j);		// spectral grid width (SW)
 	if (v <= spec_fill)
 	  v = -999;
-	dataGrid[2][j][i][k] = v;
+	dataGrid(2,j,i,k) = v;
       }
     }
   }
@@ -796,279 +477,6 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
   free(spec);
 }
 
-/*
-void CappiGrid::ClosestPointInterpolation()
-{
-
- // Closest Point Interpolation
-
- // Calculate radius of influence
- float xRadius = (iGridsp * iGridsp);
- float yRadius = (jGridsp * jGridsp);
- float zRadius = (kGridsp * kGridsp);
- float gridsp = xRadius + yRadius + zRadius;
-
- // Create local abort variable
- bool abort = returnExitNow();
-
- for (int k = 0; k < int(kDim); k++) {
-  for (int j = 0; j < int(jDim); j++) {
-   abort = returnExitNow();
-   if(abort){
-    //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-    return;
-   }
-   for (int i = 0; i < int(iDim); i++) {
-
-    dataGrid[0][i][j][k] = -999.;
-    dataGrid[1][i][j][k] = -999.;
-    dataGrid[2][i][j][k] = -999.;
-
-    float minR = sqrt(iDim*iGridsp*iDim*iGridsp + jDim*jGridsp*jDim*jGridsp);
-
-    for (long n = 0; n <= maxRefIndex; n++) {
-     float dx = refValues[n].x - (xmin + i*iGridsp);
-     float dy = refValues[n].y - (ymin + j*jGridsp);
-     float dz = refValues[n].z - (zmin + k*kGridsp);
-     float r = sqrt((dx*dx) + (dy*dy) + (dz*dz));
-     if (r > gridsp) { continue; }
-     if (r < minR) {
-      minR = r;
-      dataGrid[0][i][j][k] = refValues[n].refValue;
-     }
-     if (minR < gridsp/10) {
-      // Close enough
-      break;
-     }
-    }
-
-    minR = sqrt(iDim*iGridsp*iDim*iGridsp + jDim*jGridsp*jDim*jGridsp);
-    for (long n = 0; n <= maxVelIndex; n++) {
-     float dx = velValues[n].x - (xmin + i*iGridsp);
-     float dy = velValues[n].y - (ymin + j*jGridsp);
-     float dz = velValues[n].z - (zmin + k*kGridsp);
-     float r = sqrt((dx*dx) + (dy*dy) + (dz*dz));
-     if (r > gridsp) { continue; }
-     if (r < minR) {
-      minR = r;
-      dataGrid[1][i][j][k] = velValues[n].velValue;
-      dataGrid[2][i][j][k] = velValues[n].swValue;
-     }
-     if (minR < gridsp/3) {
-      // Close enough
-      break;
-     }
-
-    }
-   }
-  }
- }
-}
-
-void CappiGrid::BilinearInterpolation(RadarData *radarData)
-{
-
- // Bilinear Interpolation (see Mohr and Vaughn, 1979 for details)
-
- // Create local abort variable
- bool abort = returnExitNow();
-
- for (int k = 0; k < int(kDim); k++) {
-  for (int j = 0; j < int(jDim); j++) {
-   abort = returnExitNow();
-   if(abort){
-    //Message::toScreen("ExitNow in Cressmand Interpolation in CappiGrid");
-    return;
-   }
-   for (int i = 0; i < int(iDim); i++) {
-
-    dataGrid[0][i][j][k] = -999.;
-    dataGrid[1][i][j][k] = -999.;
-    dataGrid[2][i][j][k] = -999.;
-
-    float x = xmin + i*iGridsp;
-    float y = ymin + j*jGridsp;
-    float z = zmin + k*kGridsp;
-    float gRange = sqrt(x*x + y*y +z*z);
-    float gTheta = fixAngle(atan2(y,x))*rad2deg;
-    float gPhi = fixAngle(atan2(sqrt(x*x + y*y),z))*rad2deg;
-    float rPhi1, rPhi2;
-    for (int n = 0; n < radarData->getNumSweeps()-1; n++) {
-     Sweep* currentSweep = radarData->getSweep(n);
-     Sweep* nextSweep = radarData->getSweep(n+1);
-     rPhi1 = deg2rad * (90. - (currentSweep->getElevation()));
-     rPhi2 = deg2rad * (90. - (nextSweep->getElevation()));
-     if ((rPhi1 < gPhi) and (rPhi2 >= gPhi)) { break; }
-    }
-
-    for (int n = 0; n < radarData->getNumRays(); n++) {
-     Ray* currentRay = radarData->getRay(n);
-     float rTheta = deg2rad * fmodf((450. - currentRay->getAzimuth()),360.);
-     float rPhi = deg2rad * (90. - (currentRay->getElevation()));
-
-
-     if ((currentRay->getRef_numgates() > 0) and
-      (gridReflectivity)) {
-
-      float* refData = currentRay->getRefData();
-      for (int g = 0; g <= (currentRay->getRef_numgates()-1); g++) {
-       if (refData[g] == -999.) { continue; }
-       float range = float(currentRay->getFirst_ref_gate() +
-            (g * currentRay->getRef_gatesp()))/1000.;
-
-   }
-  }
- }
-}
-
-void CappiGrid::BarnesInterpolation()
-{
-
-  // Barnes Interpolation (see Koch et al, 1983 for details)
-
-  // Barnes Interpolation does not seem to be working right now -LM
-
-  float falloff_x = 5.052*pow((4* iGridsp / Pi),2);
-  float falloff_y = 5.052*pow((4* jGridsp / Pi),2);
-  float falloff_z = 5.052*pow((4* kGridsp / Pi),2);
-  float smoother = 0.3;
-
-
-  for (int k = 0; k < int(kDim); k++) {
-    for (int j = 0; j < int(jDim); j++) {
-      for (int i = 0; i < int(iDim); i++) {
-
- dataGrid[0][i][j][k] = -999.;
- dataGrid[1][i][j][k] = -999.;
- dataGrid[2][i][j][k] = -999.;
-
- float sumRef = 0;
- float sumVel = 0;
- float sumSw = 0;
- float refWeight = 0;
- float velWeight = 0;
-
- if(gridReflectivity) {
-   for (int n = 0; n <= maxRefIndex; n++) {
-     float dx = refValues[n].x - (xmin + i*iGridsp);
-     if (fabs(dx) > sqrt(20 * falloff_x)) { continue; }
-
-     float dy = refValues[n].y - (ymin + j*jGridsp);
-     if (fabs(dy) > sqrt(20 * falloff_y)) { continue; }
-
-     float dz = refValues[n].z - (zmin + k*kGridsp);
-     if (fabs(dz) > sqrt(20 * falloff_z)) { continue; }
-
-     float weight = exp(-(dx*dx)/falloff_x
-          -(dy*dy)/falloff_y
-          -(dz*dz)/falloff_z);
-
-     refWeight += weight;
-     sumRef += weight*refValues[n].refValue;
-   }
- }
-
- for (int n = 0; n <= maxVelIndex; n++) {
-   float dx = velValues[n].x - (xmin + i*iGridsp);
-   if (fabs(dx) > sqrt(20 * falloff_x)) { continue; }
-
-   float dy = velValues[n].y - (ymin + j*jGridsp);
-   if (fabs(dy) > sqrt(20 * falloff_y)) { continue; }
-
-   float dz = velValues[n].z - (zmin + k*kGridsp);
-   if (fabs(dz) > sqrt(20 * falloff_z)) { continue; }
-
-   float weight = exp(-(dx*dx)/falloff_x
-        -(dy*dy)/falloff_y
-        -(dz*dz)/falloff_z);
-
-   velWeight += weight;
-   sumVel += weight*velValues[n].velValue;
-   sumSw += weight*velValues[n].swValue;
-
- }
-
- if (refWeight > 0) {
-   dataGrid[0][i][j][k] = sumRef/refWeight;
- }
- if (velWeight > 0) {
-   dataGrid[1][i][j][k] = sumVel/velWeight;
-   dataGrid[2][i][j][k] = sumSw/velWeight;
- }
-      }
-    }
-  }
-
-  for (int k = 0; k < int(kDim); k++) {
-    for (int j = 0; j < int(jDim); j++) {
-      for (int i = 0; i < int(iDim); i++) {
-
- float sumRef = 0;
- float sumVel = 0;
- float sumSw = 0;
- float refWeight = 0;
- float velWeight = 0;
-
- if(gridReflectivity) {
-   for (int n = 0; n <= maxRefIndex; n++) {
-
-     float dx = refValues[n].x - (xmin + i*iGridsp);
-     if (fabs(dx) > sqrt(20 * falloff_x)) { continue; }
-
-     float dy = refValues[n].y - (ymin + j*jGridsp);
-     if (fabs(dy) > sqrt(20 * falloff_y)) { continue; }
-
-     float dz = refValues[n].z - (zmin + k*kGridsp);
-     if (fabs(dz) > sqrt(20 * falloff_z)) { continue; }
-
-     float weight = exp(-(dx*dx)/(falloff_x*smoother)
-          -(dy*dy)/(falloff_y*smoother)
-          -(dz*dz)/(falloff_z*smoother));
-
-
-     refWeight += weight;
-     float interpRef = trilinear(dx,dy,dz,0);
-     sumRef += weight*(refValues[n].refValue - interpRef);
-   }
- }
- for (int n = 0; n <= maxVelIndex; n++) {
-   float dx = velValues[n].x - (xmin + i*iGridsp);
-   if (fabs(dx) > sqrt(20 * falloff_x)) { continue; }
-
-   float dy = velValues[n].y - (ymin + j*jGridsp);
-   if (fabs(dy) > sqrt(20 * falloff_y)) { continue; }
-
-   float dz = velValues[n].z - (zmin + k*kGridsp);
-   if (fabs(dz) > sqrt(20 * falloff_z)) { continue; }
-
-   float weight = exp(-(dx*dx)/falloff_x
-        -(dy*dy)/falloff_y
-        -(dz*dz)/falloff_z);
-
-
-   velWeight += weight;
-   float interpVel = trilinear(dx,dy,dz,1);
-   float interpSw = trilinear(dx,dy,dz,2);
-   sumVel += weight*(velValues[n].velValue - interpVel);
-   sumSw += weight*(velValues[n].swValue - interpSw);
-
- }
-
- if (refWeight > 0) {
-   dataGrid[0][i][j][k] += sumRef/refWeight;
- }
- if (velWeight > 0) {
-   dataGrid[1][i][j][k] += sumVel/velWeight;
-   dataGrid[2][i][j][k] += sumSw/velWeight;
- }
-      }
-    }
-  }
-  Message::toScreen("Leaving Barnes");
-}
-
-
-
 float CappiGrid::trilinear(const float &x, const float &y,
          const float &z, const int &param)
 {
@@ -1119,29 +527,29 @@ float CappiGrid::trilinear(const float &x, const float &y,
   }
 
   float interpValue = 0;
-  if (dataGrid[param][x0][y0][z0] != -999) {
-    interpValue += omdx*omdy*omdz*dataGrid[param][x0][y0][z0];
+  if (dataGrid(param,x0,y0,z0) != -999) {
+    interpValue += omdx*omdy*omdz*dataGrid(param,x0,y0,z0);
   }
-  if (dataGrid[param][x0][y1][z0] != -999) {
-    interpValue += omdx*dy*omdz*dataGrid[param][x0][y1][z0];
+  if (dataGrid(param,x0,y1,z0) != -999) {
+    interpValue += omdx*dy*omdz*dataGrid(param,x0,y1,z0);
   }
-  if (dataGrid[param][x1][y0][z0] != -999) {
-    interpValue += dx*omdy*omdz*dataGrid[param][x1][y0][z0];
+  if (dataGrid(param,x1,y0,z0) != -999) {
+    interpValue += dx*omdy*omdz*dataGrid(param,x1,y0,z0);
   }
-  if (dataGrid[param][x1][y1][z0] != -999) {
-    interpValue += dx*dy*omdz*dataGrid[param][x1][y1][z0];
+  if (dataGrid(param,x1,y1,z0) != -999) {
+    interpValue += dx*dy*omdz*dataGrid(param,x1,y1,z0);
   }
-  if (dataGrid[param][x0][y0][z1] != -999) {
-    interpValue += omdx*omdy*dz*dataGrid[param][x0][y0][z1];
+  if (dataGrid(param,x0,y0,z1) != -999) {
+    interpValue += omdx*omdy*dz*dataGrid(param,x0,y0,z1);
   }
-  if (dataGrid[param][x0][y1][z1] != -999) {
-    interpValue += omdx*dy*dz*dataGrid[param][x0][y1][z1];
+  if (dataGrid(param,x0,y1,z1) != -999) {
+    interpValue += omdx*dy*dz*dataGrid(param,x0,y1,z1);
   }
-  if (dataGrid[param][x1][y0][z1] != -999) {
-    interpValue += dx*omdy*dz*dataGrid[param][x1][y0][z1];
+  if (dataGrid(param,x1,y0,z1) != -999) {
+    interpValue += dx*omdy*dz*dataGrid(param,x1,y0,z1);
   }
-  if (dataGrid[param][x1][y1][z1] != -999) {
-    interpValue += dx*dy*dz*dataGrid[param][x1][y1][z1];
+  if (dataGrid(param,x1,y1,z1) != -999) {
+    interpValue += dx*dy*dz*dataGrid(param,x1,y1,z1);
   }
 
   return interpValue;
@@ -1253,7 +661,7 @@ void CappiGrid::writeAsi()
                 out << reset << left << fieldNames.at(n) << endl;
                 int line = 0;
                 for (int i = 0; i < int(iDim);  i++){
-                    out << reset << qSetRealNumberPrecision(3) << scientific << qSetFieldWidth(10) << dataGrid[n][i][j][k];
+                    out << reset << qSetRealNumberPrecision(3) << scientific << qSetFieldWidth(10) << dataGrid(n,i,j,k);
                     line++;
                     if (line == 8) {
                         out << endl;
@@ -11,12 +11,13 @@
 #ifndef CAPPIGRID_H
 #define CAPPIGRID_H
 
-#include <QDomElement>
 #include <QFile>
 
 #include <Ncxx/Nc3xFile.hh>
 #include "Radar/RadarData.h"
 #include "DataObjects/GriddedData.h"
+#include "DataObjects/GateIndex.h"
+#include "Config/ConfigSnapshot.h"
 
 class CappiGrid : public GriddedData
 {
@@ -24,46 +25,52 @@ class CappiGrid : public GriddedData
 public:
     CappiGrid();
     ~CappiGrid();
-    void  gridRadarData(RadarData *radarData, QDomElement cappiConfig,float *vortexLat, float *vortexLon);
+    void  gridRadarData(RadarData *radarData, const CappiSettings& cappiConfig,float *vortexLat, float *vortexLon);
     
-    void  loadPreGridded(RadarData *radarData, QDomElement cappiConfig);
+    void  loadPreGridded(RadarData *radarData, const CappiSettings& cappiConfig);
     bool  getGridMapping(Nc3File &file, float &radar_lat, float &radar_lon);
     bool  getOriginLatLon(Nc3File &file, float &origin_lat, float &origin_lon);
     bool  getDimInfo(Nc3File &file, int dim,  const char *varName, float &spacing, float &min, float &max);
     bool  getFillValue(Nc3Var *var, float &val);
 
-    void  CressmanInterpolation(RadarData *radarData);
     float trilinear(const float &x, const float &y,const float &z, const int &param);
     void  writeAsi();
     bool  writeAsi(const QString& fileName);
 
+    // Name of the interpolation that filled the grid and the time it took
+    QString getInterpolation() const { return interpolationName; }
+    qint64 getInterpolationMsecs() const { return interpolationMsecs; }
+
+    // For the CappiInterpolator engines
+    GateIndex& getRefGates() { return refGates; }
+    GateIndex& getVelGates() { return velGates; }
+    bool getGridReflectivity() const { return gridReflectivity; }
+    int getNumThreads() const { return numThreads; }
+    float& gridValue(int field, int i, int j, int k) { return dataGrid(field, i, j, k); }
+
 private:
 
-    void setDisplayIndex(QDomElement cappiConfig, float kSpacing);
+    void setDisplayIndex(const CappiSettings& cappiConfig, float kSpacing);
     
     float latReference;
     float lonReference;
 
-    QString outFileName;
     float* relDist;
 
-    class goodRef {
-    public:
-        float sumRef;
-        float weight;
-    };
-    class goodVel {
-    public:
-        float sumVel;
-        float height;
-        float weight;
-    };
-
     bool gridReflectivity;
     long maxRefIndex;
     long maxVelIndex;
-    goodRef refValues[maxIDim][maxJDim][maxKDim];
-    goodVel velValues[maxIDim][maxJDim][maxKDim];
+    int numThreads;
+
+    // Gates that reach the grid, binned by column while it is filled
+    GateIndex refGates;
+    GateIndex velGates;
+
+    QString interpolationName;
+    qint64 interpolationMsecs;
+
+    void setNumThreads(const CappiSettings& cappiConfig);
+    void indexGates(RadarData *radarData);
 
 };
 
@@ -0,0 +1,823 @@
+/*
+ *  CappiInterpolator.cpp
+ *  VORTRAC
+ *
+ *  Fills the CAPPI grid from the radar gates with the interpolation
+ *  chosen in the cappi configuration
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <QElapsedTimer>
+
+#include "CappiInterpolator.h"
+#include "CappiGrid.h"
+#include "Radar/RadarData.h"
+#include "Threads/ParallelSlices.h"
+
+CappiInterpolator::CappiInterpolator()
+{
+    grid = NULL;
+    iDim = jDim = kDim = 0;
+    iGridsp = jGridsp = kGridsp = 0;
+    xmin = ymin = zmin = 0;
+    elapsedMsecs = 0;
+}
+
+void CappiInterpolator::interpolate(CappiGrid& cappi, RadarData* radarData)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    grid = &cappi;
+    iDim = (int)cappi.getIdim();
+    jDim = (int)cappi.getJdim();
+    kDim = (int)cappi.getKdim();
+    iGridsp = cappi.getIGridsp();
+    jGridsp = cappi.getJGridsp();
+    kGridsp = cappi.getKGridsp();
+    xmin = cappi.getXmin();
+    ymin = cappi.getYmin();
+    zmin = cappi.getZmin();
+    run(radarData);
+    grid = NULL;
+
+    elapsedMsecs = timer.elapsed();
+}
+
+void CappiInterpolator::runSlices(int pass, int numSlices)
+{
+    runParallel(numSlices, grid->getNumThreads(),
+                [this, pass](int, int n) { slice(pass, n); });
+}
+
+int CappiInterpolator::columnReach(float radius, float gridsp) const
+{
+    return (int)ceilf(radius/gridsp) + 1;
+}
+
+// Cressman
+
+CressmanInterpolator::CressmanInterpolator()
+{
+    RSquare = 0;
+    maxIplus = maxJplus = maxKplus = 0;
+}
+
+void CressmanInterpolator::run(RadarData*)
+{
+    // Calculate radius of influence
+    float hROI = 2.0;
+    float vROI = 1.0;
+    float xRadius = (iGridsp * iGridsp) * (hROI*hROI);
+    float yRadius = (jGridsp * jGridsp) * (hROI*hROI);
+    float zRadius = (kGridsp * kGridsp) * (vROI*vROI);
+    RSquare = xRadius + yRadius + zRadius;
+    maxIplus = (int)(RSquare/iGridsp);
+    maxJplus = (int)(RSquare/jGridsp);
+    maxKplus = (int)(RSquare/kGridsp);
+
+    // Every cell gathers the gates within its radius of influence.
+    // Columns of cells are independent.
+    runSlices(Grid, iDim);
+
+    // Adjust folds against the local mean of the first pass and grid the
+    // velocity again
+    computeLocalMean();
+    runSlices(Unfold, iDim + 3);
+    runSlices(Regrid, iDim);
+    localMean.clear();
+
+    // Smooth local outliers
+    smoothOutliers();
+}
+
+void CressmanInterpolator::slice(int pass, int n)
+{
+    switch (pass) {
+    case Grid:
+        gridSlice(n);
+        break;
+    case Unfold:
+        unfoldSlice(n);
+        break;
+    case Regrid:
+        regridSlice(n);
+        break;
+    }
+}
+
+// Squared radius of influence of a gate. Reflectivity widens with range.
+
+float CressmanInterpolator::influenceRSquare(float range, bool velocity) const
+{
+    if (velocity)
+        return RSquare;
+    return RSquare*range*range / 30276.0;
+}
+
+// The fold of value closest to mean, when value is more than a Nyquist
+// interval away from it
+
+static inline float unfoldToMean(float value, float mean, float nyquist)
+{
+    if ((mean == -999) or (fabs(value - mean) <= nyquist))
+        return value;
+    int minfold = 0;
+    float mindiff = 999999;
+    for (int fold=-2; fold <=2; fold++) {
+        float velDiff = value+2*fold*nyquist - mean;
+        if (fabs(velDiff) < mindiff) {
+            mindiff = fabs(velDiff);
+            minfold = fold;
+        }
+    }
+    return value + 2*minfold*nyquist;
+}
+
+void CressmanInterpolator::gatherColumn(const GateIndex& gates, int i, int j, bool velocity,
+                                        bool unfold, float* weight, float* sum, float* height) const
+{
+    // Only the columns within the largest radius of influence, and never
+    // beyond the box of cells around the gate
+    float maxRadius = sqrt(influenceRSquare(gates.getMaxRange(), velocity));
+    int iReach = qMin(maxIplus, columnReach(maxRadius, iGridsp));
+    int jReach = qMin(maxJplus, columnReach(maxRadius, jGridsp));
+
+    for (int gi = i - iReach; gi <= i + iReach; gi++) {
+        for (int gj = j - jReach; gj <= j + jReach; gj++) {
+            long last = gates.columnEnd(gi, gj);
+            for (long n = gates.columnBegin(gi, gj); n < last; n++) {
+                const GateIndex::Gate& gate = gates.at(n);
+                float RSquareLinear = influenceRSquare(gate.range, velocity);
+                float dx = (gate.i - i)*iGridsp;
+                float dy = (gate.j - j)*jGridsp;
+                float rSquareH = (dx*dx) + (dy*dy);
+                if (rSquareH > RSquareLinear) { continue; }
+
+                int gk = (int)floorf(gate.k);
+                float dkMax = sqrt(RSquareLinear - rSquareH)/kGridsp;
+                int kFirst = qMax(qMax(0, gk - maxKplus), (int)ceilf(gate.k - dkMax));
+                int kLast = qMin(qMin(kDim - 1, gk + maxKplus), (int)floorf(gate.k + dkMax));
+                float scale = velocity ? 100*gate.nyquist : 1;
+                for (int k = kFirst; k <= kLast; k++) {
+                    float dz = (gate.k - k)*kGridsp;
+                    float rSquare = rSquareH + (dz*dz);
+                    if (rSquare > RSquareLinear) { continue; }
+                    float w = scale * (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
+                    float value = gate.value;
+                    if (unfold)
+                        value = unfoldToMean(value, localMean[cellIndex(i,j,k)], gate.nyquist);
+                    weight[k] += w;
+                    sum[k] += w*value;
+                    if (height != NULL)
+                        height[k] += w*gate.height;
+                }
+            }
+        }
+    }
+}
+
+void CressmanInterpolator::gridSlice(int i)
+{
+    std::vector<float> refWeight(kDim), refSum(kDim);
+    std::vector<float> velWeight(kDim), velSum(kDim), velHeight(kDim);
+    for (int j = 0; j < jDim; j++) {
+        std::fill(refWeight.begin(), refWeight.end(), 0);
+        std::fill(refSum.begin(), refSum.end(), 0);
+        std::fill(velWeight.begin(), velWeight.end(), 0);
+        std::fill(velSum.begin(), velSum.end(), 0);
+        std::fill(velHeight.begin(), velHeight.end(), 0);
+        gatherColumn(grid->getRefGates(), i, j, false, false, &refWeight[0], &refSum[0], NULL);
+        gatherColumn(grid->getVelGates(), i, j, true, false, &velWeight[0], &velSum[0], &velHeight[0]);
+
+        for (int k = 0; k < kDim; k++) {
+            grid->gridValue(0,i,j,k) = -999;
+            grid->gridValue(1,i,j,k) = -999;
+            grid->gridValue(2,i,j,k) = -999;
+            if (refWeight[k] > 0) {
+                grid->gridValue(0,i,j,k) = refSum[k]/refWeight[k];
+            }
+            if (velWeight[k] > 0) {
+                grid->gridValue(1,i,j,k) = velSum[k]/velWeight[k];
+                grid->gridValue(2,i,j,k) = velHeight[k]/velWeight[k];
+            }
+        }
+    }
+}
+
+void CressmanInterpolator::unfoldSlice(int slice)
+{
+    // Each gate is checked against the local mean of the cells it reaches,
+    // in the order the scatter version visited them, and keeps the last
+    // correction. The ray data is corrected too.
+    GateIndex& velGates = grid->getVelGates();
+    int gi = slice - 1;
+    float maxRadius = sqrt(RSquare);
+    for (int gj = -1; gj <= jDim + 1; gj++) {
+        long last = velGates.columnEnd(gi, gj);
+        for (long n = velGates.columnBegin(gi, gj); n < last; n++) {
+            GateIndex::Gate& gate = velGates[n];
+            int iFirst = qMax(qMax(0, (int)floorf(gate.i) - maxIplus), (int)ceilf(gate.i - maxRadius/iGridsp));
+            int iLast = qMin(qMin(iDim - 1, (int)floorf(gate.i) + maxIplus), (int)floorf(gate.i + maxRadius/iGridsp));
+            int jFirst = qMax(qMax(0, (int)floorf(gate.j) - maxJplus), (int)ceilf(gate.j - maxRadius/jGridsp));
+            int jLast = qMin(qMin(jDim - 1, (int)floorf(gate.j) + maxJplus), (int)floorf(gate.j + maxRadius/jGridsp));
+            int kFirst = qMax(qMax(0, (int)floorf(gate.k) - maxKplus), (int)ceilf(gate.k - maxRadius/kGridsp));
+            int kLast = qMin(qMin(kDim - 1, (int)floorf(gate.k) + maxKplus), (int)floorf(gate.k + maxRadius/kGridsp));
+
+            float value = gate.value;
+            for (int k = kFirst; k <= kLast; k++) {
+                float dz = (gate.k - k)*kGridsp;
+                for (int j = jFirst; j <= jLast; j++) {
+                    float dy = (gate.j - j)*jGridsp;
+                    for (int i = iFirst; i <= iLast; i++) {
+                        float dx = (gate.i - i)*iGridsp;
+                        float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
+                        if (rSquare > RSquare) { continue; }
+                        value = unfoldToMean(value, localMean[cellIndex(i,j,k)], gate.nyquist);
+                    }
+                }
+            }
+            gate.value = value;
+            *gate.source = value;
+        }
+    }
+}
+
+void CressmanInterpolator::regridSlice(int i)
+{
+    std::vector<float> velWeight(kDim), velSum(kDim);
+    for (int j = 0; j < jDim; j++) {
+        std::fill(velWeight.begin(), velWeight.end(), 0);
+        std::fill(velSum.begin(), velSum.end(), 0);
+        gatherColumn(grid->getVelGates(), i, j, true, true, &velWeight[0], &velSum[0], NULL);
+        for (int k = 0; k < kDim; k++) {
+            grid->gridValue(1,i,j,k) = -999;
+            if (velWeight[k] > 0) {
+                grid->gridValue(1,i,j,k) = velSum[k]/velWeight[k];
+            }
+        }
+    }
+}
+
+// Sum of a summed area table over cells i0..i1, j0..j1, clipped to the grid
+
+static inline double boxSum(const std::vector<double>& table, int jSize,
+                            int i0, int j0, int i1, int j1, int iDim, int jDim)
+{
+    i0 = qMax(i0, 0);
+    j0 = qMax(j0, 0);
+    i1 = qMin(i1, iDim - 1) + 1;
+    j1 = qMin(j1, jDim - 1) + 1;
+    return table[(size_t)i1*jSize + j1] - table[(size_t)i0*jSize + j1]
+        - table[(size_t)i1*jSize + j0] + table[(size_t)i0*jSize + j0];
+}
+
+// Summed area tables of the velocity at level k: count, sum and, if
+// wanted, sum of squares of the valid cells
+
+void CressmanInterpolator::velocityTables(int k, std::vector<double>& count, std::vector<double>& sum,
+                                          std::vector<double>* sumSquares) const
+{
+    int iSize = iDim + 1;
+    int jSize = jDim + 1;
+    count.assign((size_t)iSize*jSize, 0);
+    sum.assign((size_t)iSize*jSize, 0);
+    if (sumSquares != NULL)
+        sumSquares->assign((size_t)iSize*jSize, 0);
+    for (int i = 0; i < iDim; i++) {
+        for (int j = 0; j < jDim; j++) {
+            float value = grid->gridValue(1,i,j,k);
+            bool valid = (value != -999);
+            size_t cell = (size_t)(i+1)*jSize + j+1;
+            size_t up = (size_t)i*jSize + j+1;
+            size_t left = (size_t)(i+1)*jSize + j;
+            size_t corner = (size_t)i*jSize + j;
+            count[cell] = count[up] + count[left] - count[corner] + (valid ? 1 : 0);
+            sum[cell] = sum[up] + sum[left] - sum[corner] + (valid ? value : 0);
+            if (sumSquares != NULL) {
+                std::vector<double>& sq = *sumSquares;
+                sq[cell] = sq[up] + sq[left] - sq[corner] + (valid ? (double)value*value : 0);
+            }
+        }
+    }
+}
+
+void CressmanInterpolator::computeLocalMean()
+{
+    localMean.assign((size_t)iDim * jDim * kDim, -999);
+    std::vector<double> count, sum;
+    int jSize = jDim + 1;
+    for (int k = 0; k < kDim; k++) {
+        velocityTables(k, count, sum, NULL);
+        for (int i = 0; i < iDim; i++) {
+            for (int j = 0; j < jDim; j++) {
+                double quadcount = boxSum(count, jSize, i-localArea, j-localArea,
+                                          i+localArea, j+localArea, iDim, jDim);
+                if (quadcount > 0)
+                    localMean[cellIndex(i,j,k)] = boxSum(sum, jSize, i-localArea, j-localArea,
+                                                         i+localArea, j+localArea, iDim, jDim) / quadcount;
+            }
+        }
+    }
+}
+
+void CressmanInterpolator::smoothOutliers()
+{
+    // Replace velocities more than two standard deviations from the mean
+    // of the area around them. Means and deviations come from the field
+    // as it was before any replacement.
+    std::vector<double> count, sum, sumSquares;
+    int jSize = jDim + 1;
+    for (int k = 0; k < kDim; k++) {
+        velocityTables(k, count, sum, &sumSquares);
+        for (int j = 1; j < jDim-1; j++) {
+            for (int i = 1; i < iDim-1; i++) {
+                double quadcount = boxSum(count, jSize, i-localArea, j-localArea,
+                                          i+localArea, j+localArea, iDim, jDim);
+                if (quadcount == 0) { continue; }
+                double avgCappi = boxSum(sum, jSize, i-localArea, j-localArea,
+                                         i+localArea, j+localArea, iDim, jDim) / quadcount;
+                double variance = boxSum(sumSquares, jSize, i-localArea, j-localArea,
+                                         i+localArea, j+localArea, iDim, jDim) / quadcount
+                    - avgCappi*avgCappi;
+                float stdVel = sqrt(qMax(variance, 0.0));
+                float& value = grid->gridValue(1,i,j,k);
+                float diffCappi = fabs(value - avgCappi);
+                if ((diffCappi > stdVel*2) and (value != -999)) {
+                    value = avgCappi;
+                }
+            }
+        }
+    }
+}
+
+// Barnes
+
+const float BarnesInterpolator::cutoff = 10.0;
+
+BarnesInterpolator::BarnesInterpolator(int passes, float smoothing)
+{
+    numPasses = qMax(passes, 1);
+    smoother = smoothing;
+    falloffX = falloffY = falloffZ = 0;
+}
+
+void BarnesInterpolator::run(RadarData*)
+{
+    // Falloff for a data spacing of twice the grid spacing
+    const float Pi = acos(-1.0);
+    falloffX = 5.052*pow((4* iGridsp / Pi),2);
+    falloffY = 5.052*pow((4* jGridsp / Pi),2);
+    falloffZ = 5.052*pow((4* kGridsp / Pi),2);
+
+    runSlices(Grid, iDim);
+
+    // Each correction pass spreads what the previous passes missed at the
+    // gates, with a narrower falloff
+    const GateIndex& refGates = grid->getRefGates();
+    const GateIndex& velGates = grid->getVelGates();
+    for (int pass = 1; pass < numPasses; pass++) {
+        refResidual.assign(refGates.size(), 0);
+        refHasResidual.assign(refGates.size(), 0);
+        velResidual.assign(velGates.size(), 0);
+        velHasResidual.assign(velGates.size(), 0);
+        runSlices(Residuals, iDim + 3);
+        runSlices(Correct, iDim);
+    }
+    refResidual.clear();
+    refHasResidual.clear();
+    velResidual.clear();
+    velHasResidual.clear();
+}
+
+void BarnesInterpolator::slice(int pass, int n)
+{
+    switch (pass) {
+    case Grid:
+        gridSlice(n);
+        break;
+    case Residuals:
+        residualSlice(n);
+        break;
+    case Correct:
+        correctSlice(n);
+        break;
+    }
+}
+
+void BarnesInterpolator::gatherColumn(const GateIndex& gates, const std::vector<float>* residual,
+                                      const std::vector<unsigned char>* hasResidual,
+                                      int i, int j, float scale,
+                                      float* weight, float* sum, float* height) const
+{
+    // The weight falls off as exp(-q / scale), gates with q / scale above
+    // the cutoff are left out
+    float qLimit = cutoff*scale;
+    int iReach = columnReach(sqrt(qLimit*falloffX), iGridsp);
+    int jReach = columnReach(sqrt(qLimit*falloffY), jGridsp);
+
+    for (int gi = i - iReach; gi <= i + iReach; gi++) {
+        for (int gj = j - jReach; gj <= j + jReach; gj++) {
+            long last = gates.columnEnd(gi, gj);
+            for (long n = gates.columnBegin(gi, gj); n < last; n++) {
+                if ((hasResidual != NULL) and !(*hasResidual)[n]) { continue; }
+                const GateIndex::Gate& gate = gates.at(n);
+                float dx = (gate.i - i)*iGridsp;
+                float dy = (gate.j - j)*jGridsp;
+                float qH = (dx*dx)/falloffX + (dy*dy)/falloffY;
+                if (qH > qLimit) { continue; }
+
+                float dkMax = sqrt((qLimit - qH)*falloffZ)/kGridsp;
+                int kFirst = qMax(0, (int)ceilf(gate.k - dkMax));
+                int kLast = qMin(kDim - 1, (int)floorf(gate.k + dkMax));
+                float value = (residual != NULL) ? (*residual)[n] : gate.value;
+                for (int k = kFirst; k <= kLast; k++) {
+                    float dz = (gate.k - k)*kGridsp;
+                    float q = qH + (dz*dz)/falloffZ;
+                    if (q > qLimit) { continue; }
+                    float w = exp(-q/scale);
+                    weight[k] += w;
+                    sum[k] += w*value;
+                    if (height != NULL)
+                        height[k] += w*gate.height;
+                }
+            }
+        }
+    }
+}
+
+void BarnesInterpolator::gridSlice(int i)
+{
+    std::vector<float> refWeight(kDim), refSum(kDim);
+    std::vector<float> velWeight(kDim), velSum(kDim), velHeight(kDim);
+    for (int j = 0; j < jDim; j++) {
+        std::fill(refWeight.begin(), refWeight.end(), 0);
+        std::fill(refSum.begin(), refSum.end(), 0);
+        std::fill(velWeight.begin(), velWeight.end(), 0);
+        std::fill(velSum.begin(), velSum.end(), 0);
+        std::fill(velHeight.begin(), velHeight.end(), 0);
+        gatherColumn(grid->getRefGates(), NULL, NULL, i, j, 1, &refWeight[0], &refSum[0], NULL);
+        gatherColumn(grid->getVelGates(), NULL, NULL, i, j, 1, &velWeight[0], &velSum[0], &velHeight[0]);
+
+        for (int k = 0; k < kDim; k++) {
+            grid->gridValue(0,i,j,k) = -999;
+            grid->gridValue(1,i,j,k) = -999;
+            grid->gridValue(2,i,j,k) = -999;
+            if (refWeight[k] > 0) {
+                grid->gridValue(0,i,j,k) = refSum[k]/refWeight[k];
+            }
+            if (velWeight[k] > 0) {
+                grid->gridValue(1,i,j,k) = velSum[k]/velWeight[k];
+                grid->gridValue(2,i,j,k) = velHeight[k]/velWeight[k];
+            }
+        }
+    }
+}
+
+void BarnesInterpolator::residualSlice(int slice)
+{
+    int gi = slice - 1;
+    const GateIndex& refGates = grid->getRefGates();
+    const GateIndex& velGates = grid->getVelGates();
+    for (int gj = -1; gj <= jDim + 1; gj++) {
+        long last = refGates.columnEnd(gi, gj);
+        for (long n = refGates.columnBegin(gi, gj); n < last; n++) {
+            const GateIndex::Gate& gate = refGates.at(n);
+            float gridded = gridAt(0, gate.i, gate.j, gate.k);
+            if (gridded == -999) { continue; }
+            refResidual[n] = gate.value - gridded;
+            refHasResidual[n] = 1;
+        }
+        last = velGates.columnEnd(gi, gj);
+        for (long n = velGates.columnBegin(gi, gj); n < last; n++) {
+            const GateIndex::Gate& gate = velGates.at(n);
+            float gridded = gridAt(1, gate.i, gate.j, gate.k);
+            if (gridded == -999) { continue; }
+            velResidual[n] = gate.value - gridded;
+            velHasResidual[n] = 1;
+        }
+    }
+}
+
+void BarnesInterpolator::correctSlice(int i)
+{
+    std::vector<float> refWeight(kDim), refSum(kDim);
+    std::vector<float> velWeight(kDim), velSum(kDim);
+    for (int j = 0; j < jDim; j++) {
+        std::fill(refWeight.begin(), refWeight.end(), 0);
+        std::fill(refSum.begin(), refSum.end(), 0);
+        std::fill(velWeight.begin(), velWeight.end(), 0);
+        std::fill(velSum.begin(), velSum.end(), 0);
+        gatherColumn(grid->getRefGates(), &refResidual, &refHasResidual, i, j, smoother,
+                     &refWeight[0], &refSum[0], NULL);
+        gatherColumn(grid->getVelGates(), &velResidual, &velHasResidual, i, j, smoother,
+                     &velWeight[0], &velSum[0], NULL);
+
+        for (int k = 0; k < kDim; k++) {
+            if ((refWeight[k] > 0) and (grid->gridValue(0,i,j,k) != -999))
+                grid->gridValue(0,i,j,k) += refSum[k]/refWeight[k];
+            if ((velWeight[k] > 0) and (grid->gridValue(1,i,j,k) != -999))
+                grid->gridValue(1,i,j,k) += velSum[k]/velWeight[k];
+        }
+    }
+}
+
+float BarnesInterpolator::gridAt(int field, float i, float j, float k) const
+{
+    i = qMin(qMax(i, 0.0f), (float)(iDim - 1));
+    j = qMin(qMax(j, 0.0f), (float)(jDim - 1));
+    k = qMin(qMax(k, 0.0f), (float)(kDim - 1));
+    int i0 = qMin((int)i, iDim - 1);
+    int j0 = qMin((int)j, jDim - 1);
+    int k0 = qMin((int)k, kDim - 1);
+    int i1 = qMin(i0 + 1, iDim - 1);
+    int j1 = qMin(j0 + 1, jDim - 1);
+    int k1 = qMin(k0 + 1, kDim - 1);
+    float di = i - i0;
+    float dj = j - j0;
+    float dk = k - k0;
+
+    // Corners without a value are left out and the weights renormalized
+    float sum = 0;
+    float weight = 0;
+    for (int corner = 0; corner < 8; corner++) {
+        int ci = (corner & 1) ? i1 : i0;
+        int cj = (corner & 2) ? j1 : j0;
+        int ck = (corner & 4) ? k1 : k0;
+        float value = grid->gridValue(field, ci, cj, ck);
+        if (value == -999) { continue; }
+        float w = ((corner & 1) ? di : 1 - di) * ((corner & 2) ? dj : 1 - dj)
+            * ((corner & 4) ? dk : 1 - dk);
+        sum += w*value;
+        weight += w;
+    }
+    if (weight <= 0)
+        return -999;
+    return sum/weight;
+}
+
+// Bilinear
+
+BilinearInterpolator::BilinearInterpolator()
+{
+}
+
+void BilinearInterpolator::run(RadarData* radarData)
+{
+    sortSweeps(radarData, false, refSweeps);
+    sortSweeps(radarData, true, velSweeps);
+    if (!grid->getGridReflectivity())
+        refSweeps.clear();
+    runSlices(0, iDim);
+    refSweeps.clear();
+    velSweeps.clear();
+}
+
+static bool lowerAzimuth(const std::pair<float, int>& a, const std::pair<float, int>& b)
+{
+    return a.first < b.first;
+}
+
+bool BilinearInterpolator::lowerElevation(const SweepRays& a, const SweepRays& b)
+{
+    return a.elevation < b.elevation;
+}
+
+void BilinearInterpolator::sortSweeps(RadarData* radarData, bool velocity,
+                                      std::vector<SweepRays>& sweeps)
+{
+    sweeps.clear();
+    for (int s = 0; s < radarData->getNumSweeps(); s++) {
+        Sweep* sweep = radarData->getSweep(s);
+        std::vector<std::pair<float, int> > byAzimuth;
+        for (int n = sweep->getFirstRay(); n <= sweep->getLastRay(); n++) {
+            Ray* ray = radarData->getRay(n);
+            int numGates = velocity ? ray->getVel_numgates() : ray->getRef_numgates();
+            if (numGates > 0)
+                byAzimuth.push_back(std::make_pair(fmodf(ray->getAzimuth() + 360., 360.), n));
+        }
+        if (byAzimuth.empty())
+            continue;
+        std::sort(byAzimuth.begin(), byAzimuth.end(), lowerAzimuth);
+
+        SweepRays rays;
+        rays.elevation = sweep->getElevation();
+        for (size_t n = 0; n < byAzimuth.size(); n++) {
+            rays.azimuth.push_back(byAzimuth[n].first);
+            rays.rays.push_back(radarData->getRay(byAzimuth[n].second));
+        }
+        sweeps.push_back(rays);
+    }
+    std::stable_sort(sweeps.begin(), sweeps.end(), lowerElevation);
+}
+
+void BilinearInterpolator::slice(int, int i)
+{
+    // Same 4/3 earth beam as RadarData::radarBeamHeight, with the gate
+    // at range * cos(elevation) from the radar like the other engines
+    const float RE = 4*6371.0/3;
+    const float rad2deg = 180.0/acos(-1.0);
+    float x = xmin + i*iGridsp;
+    for (int j = 0; j < jDim; j++) {
+        float y = ymin + j*jGridsp;
+        float s = sqrt(x*x + y*y);
+        float azimuth = fmodf(450. - atan2(y, x)*rad2deg, 360.);
+        for (int k = 0; k < kDim; k++) {
+            float z = zmin + k*kGridsp;
+            grid->gridValue(0,i,j,k) = -999;
+            grid->gridValue(1,i,j,k) = -999;
+            grid->gridValue(2,i,j,k) = -999;
+
+            float top = (z + RE)*(z + RE) - s*s;
+            if (top <= 0) { continue; }
+            float u = sqrt(top) - RE;
+            float range = sqrt(s*s + u*u);
+            float elevation = atan2(u, s)*rad2deg;
+
+            grid->gridValue(0,i,j,k) = valueAt(refSweeps, false, range, azimuth, elevation);
+            float vel = valueAt(velSweeps, true, range, azimuth, elevation);
+            if (vel != -999) {
+                grid->gridValue(1,i,j,k) = vel;
+                grid->gridValue(2,i,j,k) = z;
+            }
+        }
+    }
+}
+
+// Weighted mean of two values that may be missing
+
+static inline float blend(float a, float b, float fraction)
+{
+    if (a == -999)
+        return b;
+    if (b == -999)
+        return a;
+    return a + fraction*(b - a);
+}
+
+float BilinearInterpolator::valueAt(const std::vector<SweepRays>& sweeps, bool velocity,
+                                    float range, float azimuth, float elevation) const
+{
+    if (sweeps.empty())
+        return -999;
+
+    // Half a beam width above the top sweep or below the bottom one
+    const float halfBeam = 0.5;
+    if ((elevation < sweeps.front().elevation - halfBeam)
+        or (elevation > sweeps.back().elevation + halfBeam))
+        return -999;
+
+    size_t upper = 0;
+    while ((upper < sweeps.size()) and (sweeps[upper].elevation < elevation))
+        upper++;
+    if (upper == 0)
+        return sweepValue(sweeps.front(), velocity, range, azimuth);
+    if (upper == sweeps.size())
+        return sweepValue(sweeps.back(), velocity, range, azimuth);
+
+    const SweepRays& below = sweeps[upper - 1];
+    const SweepRays& above = sweeps[upper];
+    float span = above.elevation - below.elevation;
+    float fraction = (span > 0) ? (elevation - below.elevation)/span : 0;
+    return blend(sweepValue(below, velocity, range, azimuth),
+                 sweepValue(above, velocity, range, azimuth), fraction);
+}
+
+float BilinearInterpolator::sweepValue(const SweepRays& sweep, bool velocity,
+                                       float range, float azimuth) const
+{
+    // The rays on either side, across north if need be
+    const float maxGap = 5.0;
+    size_t count = sweep.azimuth.size();
+    size_t after = std::upper_bound(sweep.azimuth.begin(), sweep.azimuth.end(), azimuth)
+        - sweep.azimuth.begin();
+    size_t before = (after == 0) ? count - 1 : after - 1;
+    if (after == count)
+        after = 0;
+
+    float gap = fmodf(sweep.azimuth[after] - sweep.azimuth[before] + 360., 360.);
+    float offset = fmodf(azimuth - sweep.azimuth[before] + 360., 360.);
+    if ((count == 1) or (gap > maxGap)) {
+        // Nothing to interpolate between, take a ray close enough
+        float toAfter = fmodf(sweep.azimuth[after] - azimuth + 360., 360.);
+        if ((offset <= maxGap/2) and (offset <= toAfter))
+            return rayValue(sweep.rays[before], velocity, range);
+        if (toAfter <= maxGap/2)
+            return rayValue(sweep.rays[after], velocity, range);
+        return -999;
+    }
+
+    float fraction = (gap > 0) ? offset/gap : 0;
+    return blend(rayValue(sweep.rays[before], velocity, range),
+                 rayValue(sweep.rays[after], velocity, range), fraction);
+}
+
+float BilinearInterpolator::rayValue(Ray* ray, bool velocity, float range) const
+{
+    float* data = velocity ? ray->getVelData() : ray->getRefData();
+    int numGates = velocity ? ray->getVel_numgates() : ray->getRef_numgates();
+    float firstGate = velocity ? ray->getFirst_vel_gate() : ray->getFirst_ref_gate();
+    float gateSpacing = velocity ? ray->getVel_gatesp() : ray->getRef_gatesp();
+    if ((data == NULL) or (numGates <= 0) or (gateSpacing <= 0))
+        return -999;
+
+    float gate = (range*1000. - firstGate)/gateSpacing;
+    if ((gate < -0.5) or (gate > numGates - 0.5))
+        return -999;
+    int g0 = qMax(0, qMin((int)floorf(gate), numGates - 1));
+    int g1 = qMin(g0 + 1, numGates - 1);
+    return blend(data[g0], data[g1], qMax(gate - g0, 0.0f));
+}
+
+// Closest point
+
+ClosestPointInterpolator::ClosestPointInterpolator()
+{
+    RSquare = 0;
+}
+
+void ClosestPointInterpolator::run(RadarData*)
+{
+    // Same radius of influence as Cressman
+    float hROI = 2.0;
+    float vROI = 1.0;
+    RSquare = (iGridsp * iGridsp) * (hROI*hROI) + (jGridsp * jGridsp) * (hROI*hROI)
+        + (kGridsp * kGridsp) * (vROI*vROI);
+    runSlices(0, iDim);
+}
+
+void ClosestPointInterpolator::nearestInColumn(const GateIndex& gates, int i, int j,
+                                               float* distance, float* value, float* height) const
+{
+    float radius = sqrt(RSquare);
+    int iReach = columnReach(radius, iGridsp);
+    int jReach = columnReach(radius, jGridsp);
+    for (int gi = i - iReach; gi <= i + iReach; gi++) {
+        for (int gj = j - jReach; gj <= j + jReach; gj++) {
+            long last = gates.columnEnd(gi, gj);
+            for (long n = gates.columnBegin(gi, gj); n < last; n++) {
+                const GateIndex::Gate& gate = gates.at(n);
+                float dx = (gate.i - i)*iGridsp;
+                float dy = (gate.j - j)*jGridsp;
+                float rSquareH = (dx*dx) + (dy*dy);
+                if (rSquareH > RSquare) { continue; }
+
+                float dkMax = sqrt(RSquare - rSquareH)/kGridsp;
+                int kFirst = qMax(0, (int)ceilf(gate.k - dkMax));
+                int kLast = qMin(kDim - 1, (int)floorf(gate.k + dkMax));
+                for (int k = kFirst; k <= kLast; k++) {
+                    float dz = (gate.k - k)*kGridsp;
+                    float rSquare = rSquareH + (dz*dz);
+                    if (rSquare >= distance[k]) { continue; }
+                    distance[k] = rSquare;
+                    value[k] = gate.value;
+                    if (height != NULL)
+                        height[k] = gate.height;
+                }
+            }
+        }
+    }
+}
+
+void ClosestPointInterpolator::slice(int, int i)
+{
+    std::vector<float> refDistance(kDim), refValue(kDim);
+    std::vector<float> velDistance(kDim), velValue(kDim), velHeight(kDim);
+    for (int j = 0; j < jDim; j++) {
+        std::fill(refDistance.begin(), refDistance.end(), RSquare*2 + 1);
+        std::fill(refValue.begin(), refValue.end(), -999);
+        std::fill(velDistance.begin(), velDistance.end(), RSquare*2 + 1);
+        std::fill(velValue.begin(), velValue.end(), -999);
+        std::fill(velHeight.begin(), velHeight.end(), -999);
+        nearestInColumn(grid->getRefGates(), i, j, &refDistance[0], &refValue[0], NULL);
+        nearestInColumn(grid->getVelGates(), i, j, &velDistance[0], &velValue[0], &velHeight[0]);
+        for (int k = 0; k < kDim; k++) {
+            grid->gridValue(0,i,j,k) = refValue[k];
+            grid->gridValue(1,i,j,k) = velValue[k];
+            grid->gridValue(2,i,j,k) = velHeight[k];
+        }
+    }
+}
+
+CappiInterpolator *CappiInterpolatorFactory::newInterpolator(const CappiSettings& cappiConfig)
+{
+    QString method = "cressman";
+    if (!cappiConfig.interpolation.isEmpty())
+        method = cappiConfig.interpolation;
+
+    if (method == "cressman")
+        return new CressmanInterpolator();
+    if (method == "barnes") {
+        return new BarnesInterpolator(cappiConfig.barnesPasses, cappiConfig.barnesSmoothing);
+    }
+    if (method == "bilinear")
+        return new BilinearInterpolator();
+    if ((method == "closestpoint") or (method == "nearest"))
+        return new ClosestPointInterpolator();
+    return NULL;
+}
@@ -0,0 +1,227 @@
+/*
+ *  CappiInterpolator.h
+ *  VORTRAC
+ *
+ *  Fills the CAPPI grid from the radar gates with the interpolation
+ *  chosen in the cappi configuration
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef CAPPIINTERPOLATOR_H
+#define CAPPIINTERPOLATOR_H
+
+#include <vector>
+#include <QString>
+
+#include "Config/ConfigSnapshot.h"
+#include "DataObjects/GateIndex.h"
+
+class CappiGrid;
+class RadarData;
+class Ray;
+
+// The interpolation is picked with <interpolation> in the cappi section:
+//   cressman      Cressman weights, then a fold correction against the
+//                 local mean and outlier smoothing (default)
+//   barnes        Gaussian weights, then <barnes_passes> - 1 correction
+//                 passes (default 2 passes in all) with the falloff scaled
+//                 by <barnes_smoothing> (default 0.3), Koch et al. 1983
+//   bilinear      linear in range, azimuth and elevation between the
+//                 gates around each cell, Mohr and Vaughan 1979
+//   closestpoint  the value of the nearest gate within the Cressman
+//                 radius of influence ("nearest" works too)
+// All of them fill DZ, VE and HT (the height of the velocity data).
+
+class CappiInterpolator {
+
+ public:
+
+  CappiInterpolator();
+  virtual ~CappiInterpolator() {}
+
+  virtual QString getName() const = 0;
+  // False if the engine reads the rays itself
+  virtual bool needsGateIndex() const { return true; }
+
+  // Fills the grid, which has indexed the gates if needsGateIndex()
+  void interpolate(CappiGrid& grid, RadarData* radarData);
+  qint64 getElapsedMsecs() const { return elapsedMsecs; }
+
+  // One slice of a pass, called from the worker threads. A slice only
+  // writes to its own cells or gates.
+  virtual void slice(int pass, int n) = 0;
+
+ protected:
+
+  virtual void run(RadarData* radarData) = 0;
+  // Calls slice(pass, n) for every n below numSlices on the grid's threads
+  void runSlices(int pass, int numSlices);
+
+  // How many columns of gates around a cell are within radius (km)
+  int columnReach(float radius, float gridsp) const;
+
+  CappiGrid* grid;
+  int iDim, jDim, kDim;
+  float iGridsp, jGridsp, kGridsp;
+  float xmin, ymin, zmin;
+
+ private:
+
+  qint64 elapsedMsecs;
+};
+
+class CressmanInterpolator : public CappiInterpolator {
+
+ public:
+
+  CressmanInterpolator();
+  QString getName() const { return "cressman"; }
+  void slice(int pass, int n);
+
+ protected:
+
+  void run(RadarData* radarData);
+
+ private:
+
+  enum Pass { Grid, Unfold, Regrid };
+
+  // Radius of influence squared, and the box of cells around a gate that
+  // it is limited to
+  float RSquare;
+  int maxIplus, maxJplus, maxKplus;
+
+  // Mean velocity over localArea cells on each side at the same level,
+  // -999 where there is none. Same [i][j][k] layout as the grid.
+  static const int localArea = 10;
+  std::vector<float> localMean;
+  long cellIndex(int i, int j, int k) const
+  { return ((long)i * (long)jDim + j) * (long)kDim + k; }
+
+  float influenceRSquare(float range, bool velocity) const;
+  // Adds the weights and weighted values of the gates within reach of
+  // column (i, j) to weight[k] and sum[k]
+  void gatherColumn(const GateIndex& gates, int i, int j, bool velocity, bool unfold,
+		    float* weight, float* sum, float* height) const;
+  void gridSlice(int i);
+  void unfoldSlice(int slice);
+  void regridSlice(int i);
+  void velocityTables(int k, std::vector<double>& count, std::vector<double>& sum,
+		      std::vector<double>* sumSquares) const;
+  void computeLocalMean();
+  void smoothOutliers();
+};
+
+class BarnesInterpolator : public CappiInterpolator {
+
+ public:
+
+  BarnesInterpolator(int passes, float smoothing);
+  QString getName() const { return "barnes"; }
+  void slice(int pass, int n);
+
+ protected:
+
+  void run(RadarData* radarData);
+
+ private:
+
+  enum Pass { Grid, Residuals, Correct };
+
+  int numPasses;
+  float smoother;
+  // Falloff parameter of each axis (km^2)
+  float falloffX, falloffY, falloffZ;
+  // Gates farther than this many falloffs away are left out
+  static const float cutoff;
+
+  // Difference between each gate and the grid at the gate, with a flag
+  // for gates where the grid has no value
+  std::vector<float> refResidual, velResidual;
+  std::vector<unsigned char> refHasResidual, velHasResidual;
+
+  void gatherColumn(const GateIndex& gates, const std::vector<float>* residual,
+		    const std::vector<unsigned char>* hasResidual, int i, int j, float scale,
+		    float* weight, float* sum, float* height) const;
+  void gridSlice(int i);
+  void residualSlice(int slice);
+  void correctSlice(int i);
+  // Trilinear value of a field at a fractional cell position, -999 if
+  // none of the cells around it has a value
+  float gridAt(int field, float i, float j, float k) const;
+};
+
+class BilinearInterpolator : public CappiInterpolator {
+
+ public:
+
+  BilinearInterpolator();
+  QString getName() const { return "bilinear"; }
+  bool needsGateIndex() const { return false; }
+  void slice(int pass, int n);
+
+ protected:
+
+  void run(RadarData* radarData);
+
+ private:
+
+  // The rays of one sweep that have gates of a field, by azimuth
+  class SweepRays {
+  public:
+    float elevation;
+    std::vector<float> azimuth;
+    std::vector<Ray*> rays;
+  };
+
+  // Sorted by elevation
+  std::vector<SweepRays> refSweeps, velSweeps;
+
+  static bool lowerElevation(const SweepRays& a, const SweepRays& b);
+  void sortSweeps(RadarData* radarData, bool velocity, std::vector<SweepRays>& sweeps);
+  float valueAt(const std::vector<SweepRays>& sweeps, bool velocity,
+		float range, float azimuth, float elevation) const;
+  float sweepValue(const SweepRays& sweep, bool velocity, float range, float azimuth) const;
+  float rayValue(Ray* ray, bool velocity, float range) const;
+};
+
+class ClosestPointInterpolator : public CappiInterpolator {
+
+ public:
+
+  ClosestPointInterpolator();
+  QString getName() const { return "closestpoint"; }
+  void slice(int pass, int n);
+
+ protected:
+
+  void run(RadarData* radarData);
+
+ private:
+
+  float RSquare;
+
+  // Value, and height if wanted, of the nearest gate to each cell of
+  // column (i, j)
+  void nearestInColumn(const GateIndex& gates, int i, int j, float* distance,
+		       float* value, float* height) const;
+};
+
+class CappiInterpolatorFactory {
+
+ public:
+
+  // Returns NULL if the interpolation is not known
+  static CappiInterpolator *newInterpolator(const CappiSettings& cappiConfig);
+
+ private:
+
+  // Static class. Don't let anybody create instances
+
+  CappiInterpolatorFactory();
+};
+
+#endif
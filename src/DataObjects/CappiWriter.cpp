@@ -0,0 +1,244 @@
+/*
+ *  CappiWriter.cpp
+ *  VORTRAC
+ *
+ *  Writes the CAPPI of each volume to disk in the format chosen in the
+ *  cappi configuration
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QByteArray>
+#include <QSysInfo>
+#include <Ncxx/Nc3xFile.hh>
+
+#include "CappiWriter.h"
+#include "GriddedData.h"
+
+bool AsiCappiWriter::write(GriddedData& grid, const QString& basePath, const QDateTime&)
+{
+  return grid.writeAsi(basePath);
+}
+
+bool BinaryCappiWriter::write(GriddedData& grid, const QString& basePath,
+			      const QDateTime& volumeTime)
+{
+  const FieldGrid& data = grid.getFieldGrid();
+  if (! data.isAllocated())
+    return false;
+
+  // Nothing replaces a previous file until the new one is complete
+  QSaveFile file(basePath + ".cappi");
+  if (! file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  bool littleEndian = (QSysInfo::ByteOrder == QSysInfo::LittleEndian);
+  out << magic << version << compressed << littleEndian << volumeTime
+      << (qint32) data.getIDim() << (qint32) data.getJDim() << (qint32) data.getKDim()
+      << grid.getIGridsp() << grid.getJGridsp() << grid.getKGridsp()
+      << grid.getXmin() << grid.getYmin() << grid.getZmin()
+      << grid.getOriginLat() << grid.getOriginLon();
+
+  QStringList names = grid.getFieldNames();
+  while (names.size() < data.getNumFields())
+    names << QString("field%1").arg(names.size());
+  while (names.size() > data.getNumFields())
+    names.removeLast();
+  out << names;
+
+  size_t fieldBytes = data.size() / data.getNumFields() * sizeof(float);
+  for (int n = 0; n < data.getNumFields(); n++) {
+    QByteArray raw = QByteArray::fromRawData((const char *) data.fieldData(n), (int) fieldBytes);
+    if (compressed)
+      out << qCompress(raw);
+    else
+      out << raw;
+  }
+
+  return (out.status() == QDataStream::Ok) && file.commit();
+}
+
+// CF attributes for the fields CappiGrid knows about
+
+static void describeField(Nc3Var *var, const QString& name)
+{
+  if (name == "DZ") {
+    var->add_att("long_name", "reflectivity");
+    var->add_att("standard_name", "equivalent_reflectivity_factor");
+    var->add_att("units", "dBZ");
+  } else if (name == "VE") {
+    var->add_att("long_name", "dealiased radial velocity");
+    var->add_att("standard_name", "radial_velocity_of_scatterers_away_from_instrument");
+    var->add_att("units", "m/s");
+  } else if (name == "HT") {
+    var->add_att("long_name", "height of the velocity data");
+    var->add_att("units", "km");
+  } else {
+    var->add_att("long_name", name.toLatin1().data());
+  }
+}
+
+bool NetcdfCappiWriter::write(GriddedData& grid, const QString& basePath,
+			      const QDateTime& volumeTime)
+{
+  Nc3Error ncError(Nc3Error::verbose_nonfatal); // Prevent NetCDF errors from exiting the program
+
+  const FieldGrid& data = grid.getFieldGrid();
+  if (! data.isAllocated())
+    return false;
+
+  QString fileName = basePath + ".nc";
+  Nc3File file(fileName.toLatin1().data(), Nc3File::Replace);
+  if (! file.is_valid())
+    return false;
+
+  int xDim = data.getIDim();
+  int yDim = data.getJDim();
+  int zDim = data.getKDim();
+
+  // Same names and [time][z][y][x] layout that loadPreGridded reads
+  Nc3Dim *timeDim = file.add_dim("time", 1);
+  Nc3Dim *z0 = file.add_dim("z0", zDim);
+  Nc3Dim *y0 = file.add_dim("y0", yDim);
+  Nc3Dim *x0 = file.add_dim("x0", xDim);
+
+  file.add_att("Conventions", "CF-1.6");
+  file.add_att("title", "VORTRAC CAPPI");
+
+  Nc3Var *timeVar = file.add_var("time", nc3Double, timeDim);
+  timeVar->add_att("standard_name", "time");
+  timeVar->add_att("units", "seconds since 1970-01-01T00:00:00Z");
+  timeVar->add_att("calendar", "gregorian");
+
+  Nc3Var *zVar = file.add_var("z0", nc3Float, z0);
+  zVar->add_att("long_name", "height above the radar");
+  zVar->add_att("units", "km");
+  zVar->add_att("positive", "up");
+  zVar->add_att("axis", "Z");
+
+  Nc3Var *yVar = file.add_var("y0", nc3Float, y0);
+  yVar->add_att("standard_name", "projection_y_coordinate");
+  yVar->add_att("units", "km");
+  yVar->add_att("axis", "Y");
+
+  Nc3Var *xVar = file.add_var("x0", nc3Float, x0);
+  xVar->add_att("standard_name", "projection_x_coordinate");
+  xVar->add_att("units", "km");
+  xVar->add_att("axis", "X");
+
+  // x and y are km from the radar
+  Nc3Var *mapping = file.add_var("grid_mapping_0", nc3Int);
+  mapping->add_att("grid_mapping_name", "azimuthal_equidistant");
+  mapping->add_att("latitude_of_projection_origin", grid.getOriginLat());
+  mapping->add_att("longitude_of_projection_origin", grid.getOriginLon());
+  mapping->add_att("false_easting", 0.0f);
+  mapping->add_att("false_northing", 0.0f);
+
+  const short packedFill = -32768;
+  const float missing = -999.;
+  QStringList names = grid.getFieldNames();
+  std::vector<Nc3Var *> vars(data.getNumFields());
+  std::vector<float> scale(data.getNumFields(), 1.0f);
+  std::vector<float> offset(data.getNumFields(), 0.0f);
+  size_t fieldSize = data.size() / data.getNumFields();
+
+  for (int n = 0; n < data.getNumFields(); n++) {
+    QString name = (n < names.size()) ? names.at(n) : QString("field%1").arg(n);
+    vars[n] = file.add_var(name.toLatin1().data(), packed ? nc3Short : nc3Float,
+			   timeDim, z0, y0, x0);
+    describeField(vars[n], name);
+    vars[n]->add_att("grid_mapping", "grid_mapping_0");
+    if (! packed) {
+      vars[n]->add_att("_FillValue", missing);
+      continue;
+    }
+
+    // Spread the valid range of the field over the shorts
+    const float *values = data.fieldData(n);
+    float minValue = 0, maxValue = 0;
+    bool found = false;
+    for (size_t m = 0; m < fieldSize; m++) {
+      if (values[m] == missing)
+	continue;
+      if (! found || values[m] < minValue) minValue = values[m];
+      if (! found || values[m] > maxValue) maxValue = values[m];
+      found = true;
+    }
+    offset[n] = (maxValue + minValue) / 2;
+    if (maxValue > minValue)
+      scale[n] = (maxValue - minValue) / 65533.;
+    vars[n]->add_att("_FillValue", packedFill);
+    vars[n]->add_att("scale_factor", scale[n]);
+    vars[n]->add_att("add_offset", offset[n]);
+  }
+
+  // Coordinates
+  double seconds = volumeTime.isValid() ? (double) volumeTime.toTime_t() : 0.;
+  timeVar->put(&seconds, 1);
+  std::vector<float> coords(std::max(xDim, std::max(yDim, zDim)));
+  for (int i = 0; i < xDim; i++)
+    coords[i] = grid.getXmin() + i * grid.getIGridsp();
+  xVar->put(&coords[0], xDim);
+  for (int j = 0; j < yDim; j++)
+    coords[j] = grid.getYmin() + j * grid.getJGridsp();
+  yVar->put(&coords[0], yDim);
+  for (int k = 0; k < zDim; k++)
+    coords[k] = grid.getZmin() + k * grid.getKGridsp();
+  zVar->put(&coords[0], zDim);
+
+  // One level at a time, transposed from [i][j][k] to [y][x]
+  std::vector<float> level(packed ? 0 : (size_t) xDim * yDim);
+  std::vector<short> packedLevel(packed ? (size_t) xDim * yDim : 0);
+  bool ok = true;
+  for (int n = 0; (n < data.getNumFields()) && ok; n++) {
+    for (int k = 0; (k < zDim) && ok; k++) {
+      for (int j = 0; j < yDim; j++) {
+	for (int i = 0; i < xDim; i++) {
+	  float value = data(n, i, j, k);
+	  size_t cell = (size_t) j * xDim + i;
+	  if (! packed)
+	    level[cell] = value;
+	  else if (value == missing)
+	    packedLevel[cell] = packedFill;
+	  else
+	    packedLevel[cell] = (short) lrintf((value - offset[n]) / scale[n]);
+	}
+      }
+      ok = vars[n]->set_cur(0, k, 0, 0);
+      if (ok && packed)
+	ok = vars[n]->put(&packedLevel[0], 1, 1, yDim, xDim);
+      else if (ok)
+	ok = vars[n]->put(&level[0], 1, 1, yDim, xDim);
+    }
+  }
+
+  return file.close() && ok;
+}
+
+CappiWriter *CappiWriterFactory::newWriter(const CappiSettings& cappiConfig)
+{
+  const QString& format = cappiConfig.output;
+  bool compress = cappiConfig.compression;
+
+  if (format == "binary")
+    return new BinaryCappiWriter(compress);
+  if (format == "netcdf")
+    return new NetcdfCappiWriter(compress);
+  if (format == "asi")
+    return new AsiCappiWriter();
+  if (format != "none")
+    Message::toScreen("CappiWriter: Unknown output " + format
+                      + ", no CAPPI files will be written");
+  return NULL;
+}
@@ -0,0 +1,96 @@
+/*
+ *  CappiWriter.h
+ *  VORTRAC
+ *
+ *  Writes the CAPPI of each volume to disk in the format chosen in the
+ *  cappi configuration
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef CAPPIWRITER_H
+#define CAPPIWRITER_H
+
+#include <QString>
+#include <QDateTime>
+#include "Config/ConfigSnapshot.h"
+
+class GriddedData;
+
+// The output format is picked with <output> in the cappi section:
+//   asi     the text format read by grid2ps (default)
+//   binary  header and raw float fields, see BinaryCappiWriter
+//   netcdf  CF compliant netCDF-3 file laid out like the pre-gridded input
+//   none    nothing is written
+// <compression>true</compression> deflates the binary fields and packs
+// the netCDF fields into shorts with scale_factor / add_offset.
+
+class CappiWriter {
+
+ public:
+
+  // basePath is the output file name without extension
+  virtual bool write(GriddedData& grid, const QString& basePath,
+		     const QDateTime& volumeTime) = 0;
+  virtual ~CappiWriter() {}
+
+};
+
+class AsiCappiWriter : public CappiWriter {
+
+ public:
+
+  bool write(GriddedData& grid, const QString& basePath, const QDateTime& volumeTime);
+};
+
+// <basePath>.cappi, a QDataStream (Qt 5.0, big endian) holding:
+//   magic, version, compressed flag, little endian flag of the field data,
+//   volume time, i/j/k dimensions, i/j/k grid spacing (km),
+//   xmin, ymin, zmin (km from the radar), radar lat and lon, field names
+// followed by one byte array per field with the [i][j][k] (k fastest)
+// float values, zlib compressed (qCompress) if the compressed flag is set.
+
+class BinaryCappiWriter : public CappiWriter {
+
+ public:
+
+  BinaryCappiWriter(bool compress) { compressed = compress; }
+  bool write(GriddedData& grid, const QString& basePath, const QDateTime& volumeTime);
+
+  static const quint32 magic = 0x56435049;   // "VCPI"
+  static const quint32 version = 1;
+
+ private:
+
+  bool compressed;
+};
+
+class NetcdfCappiWriter : public CappiWriter {
+
+ public:
+
+  NetcdfCappiWriter(bool pack) { packed = pack; }
+  bool write(GriddedData& grid, const QString& basePath, const QDateTime& volumeTime);
+
+ private:
+
+  bool packed;
+};
+
+class CappiWriterFactory {
+
+ public:
+
+  // Returns NULL if no CAPPI should be written, or the format is unknown
+  static CappiWriter *newWriter(const CappiSettings& cappiConfig);
+
+ private:
+
+  // Static class. Don't let anybody create instances
+
+  CappiWriterFactory();
+};
+
+#endif
@@ -10,20 +10,77 @@
 
 #include "Coefficient.h"
 
+Coefficient::Term Coefficient::termFromName(const QString &name)
+{
+    // V<T|R|M><C|S><wavenumber>
+    if((name.length() < 4) || (name.at(0) != QChar('V')))
+        return NoTerm;
+    bool ok;
+    int wave = name.mid(3).toInt(&ok);
+    if(!ok || (wave < 0))
+        return NoTerm;
+
+    QChar component = name.at(1);
+    QChar phase = name.at(2);
+    if(wave == 0) {
+        if(phase != QChar('C'))
+            return NoTerm;
+        if(component == QChar('T')) return VTC0;
+        if(component == QChar('R')) return VRC0;
+        if(component == QChar('M')) return VMC0;
+        return NoTerm;
+    }
+
+    int term = (phase == QChar('C')) ? 2 * wave + 1 : 2 * wave + 2;
+    if((component != QChar('T')) || ((phase != QChar('C')) && (phase != QChar('S')))
+       || (term >= NumTerms))
+        return NoTerm;
+    return (Term)term;
+}
+
+QString Coefficient::termName(int term)
+{
+    switch(term) {
+    case VTC0: return QString("VTC0");
+    case VRC0: return QString("VRC0");
+    case VMC0: return QString("VMC0");
+    }
+    if((term < VTC1) || (term >= NumTerms))
+        return QString("NULL");
+    QString kind = ((term - VTC1) % 2 == 0) ? QString("VTC") : QString("VTS");
+    return kind + QString().setNum((term - 1) / 2);
+}
+
+Coefficient::Term Coefficient::cosineTerm(int wave)
+{
+    int term = 2 * wave + 1;
+    if((wave < 1) || (term >= NumTerms))
+        return NoTerm;
+    return (Term)term;
+}
+
+Coefficient::Term Coefficient::sineTerm(int wave)
+{
+    int term = 2 * wave + 2;
+    if((wave < 1) || (term >= NumTerms))
+        return NoTerm;
+    return (Term)term;
+}
+
 Coefficient::Coefficient()
 {
     level = -999;
     radius = -999;
     value = -999;
-    parameter = QString("NULL");
+    term = NoTerm;
 }
 
-Coefficient::Coefficient(float newLevel, float newRadius, float newValue,QString name)
+Coefficient::Coefficient(float newLevel, float newRadius, float newValue, Term newTerm)
 {
     level = newLevel;
     radius = newRadius;
     value = newValue;
-    parameter = name;
+    term = newTerm;
 
 }
 
@@ -32,7 +89,7 @@ Coefficient::Coefficient(const Coefficient &other)
     this->level = other.level;
     this->radius = other.radius;
     this->value = other.value;
-    this->parameter = other.parameter;
+    this->term = other.term;
 }
 
 bool Coefficient::isValid() const {
@@ -56,16 +113,21 @@ void Coefficient::setValue(const float &newValue)
     value = newValue;
 }
 
+void Coefficient::setTerm(Term newTerm)
+{
+    term = newTerm;
+}
+
 void Coefficient::setParameter(const QString &newParameter)
 {
-    parameter = newParameter;
+    term = termFromName(newParameter);
 }
 
 bool Coefficient::operator == (const Coefficient &other)
 {
     if(level == other.getLevel())
         if(radius == other.getRadius())
-            if(parameter == other.getParameter())
+            if(term == other.term)
                 if(value == other.getValue())
                     return true;
     return false;
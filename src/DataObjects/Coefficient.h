@@ -17,8 +17,27 @@ class Coefficient
 {
 
 public:
+    // The wind terms of the VTD analysis, in the order they are stored
+    // in VortexData. Wavenumber n > 0 has its cosine term at 2n+1 and
+    // its sine term at 2n+2.
+    enum Term {
+        NoTerm = -1,
+        VTC0, VRC0, VMC0,
+        VTC1, VTS1, VTC2, VTS2, VTC3, VTS3, VTC4, VTS4,
+        VTC5, VTS5, VTC6, VTS6, VTC7, VTS7,
+        NumTerms
+    };
+
+    // Names are only used when coefficients are read or written out,
+    // everything else goes by Term
+    static Term termFromName(const QString &name);
+    static QString termName(int term);
+    // Terms of wavenumber wave > 0, NoTerm past the last one
+    static Term cosineTerm(int wave);
+    static Term sineTerm(int wave);
+
     Coefficient();
-    Coefficient(float newLevel, float newRadius, float newValue, QString name);
+    Coefficient(float newLevel, float newRadius, float newValue, Term newTerm);
     Coefficient(const Coefficient &other);
 
     bool isValid() const;
@@ -32,7 +51,11 @@ public:
     float getValue() const { return value; }
     void setValue(const float &newValue);
 
-    QString getParameter() const { return parameter; }
+    Term getTerm() const { return term; }
+    void setTerm(Term newTerm);
+
+    // The name of the term, for files
+    QString getParameter() const { return termName(term); }
     void setParameter(const QString &newParameter);
 
     bool operator == (const Coefficient &other);
@@ -44,7 +67,7 @@ private:
     float level;
     float radius;
     float value;
-    QString parameter;
+    Term term;
 
 };
 
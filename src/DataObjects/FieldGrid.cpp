@@ -0,0 +1,98 @@
+/*
+ *  FieldGrid.cpp
+ *  VORTRAC
+ *
+ *  Runtime sized storage for the fields held by GriddedData.
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "FieldGrid.h"
+#include <cstdlib>
+
+FieldGrid::FieldGrid()
+  : data(NULL), nFields(0), nI(0), nJ(0), nK(0),
+    iStride(0), fieldStride(0), nValues(0)
+{
+}
+
+FieldGrid::FieldGrid(const FieldGrid &other)
+  : data(NULL), nFields(0), nI(0), nJ(0), nK(0),
+    iStride(0), fieldStride(0), nValues(0)
+{
+    *this = other;
+}
+
+FieldGrid::~FieldGrid()
+{
+    release();
+}
+
+FieldGrid& FieldGrid::operator=(const FieldGrid &other)
+{
+    if (this == &other)
+        return *this;
+
+    block = other.block;
+    data = other.data;
+    nFields = other.nFields;
+    nI = other.nI;
+    nJ = other.nJ;
+    nK = other.nK;
+    iStride = other.iStride;
+    fieldStride = other.fieldStride;
+    nValues = other.nValues;
+    return *this;
+}
+
+size_t FieldGrid::bytesFor(int fields, int iDim, int jDim, int kDim)
+{
+    return (size_t)fields * (size_t)iDim * (size_t)jDim * (size_t)kDim * sizeof(float);
+}
+
+bool FieldGrid::allocate(int fields, int iDim, int jDim, int kDim, float fill)
+{
+    release();
+
+    if ((fields <= 0) || (iDim <= 0) || (jDim <= 0) || (kDim <= 0))
+        return false;
+
+    size_t bytes = bytesFor(fields, iDim, jDim, kDim);
+    if (bytes > maxBytes)
+        return false;
+
+    // Round up so the block size is a multiple of the alignment
+    size_t padded = ((bytes + alignment - 1) / alignment) * alignment;
+    void *memory = NULL;
+    if (posix_memalign(&memory, alignment, padded) != 0)
+        return false;
+
+    data = static_cast<float*>(memory);
+    block = QSharedPointer<float>(data, free);
+    nFields = fields;
+    nI = iDim;
+    nJ = jDim;
+    nK = kDim;
+    iStride = (size_t)jDim * kDim;
+    fieldStride = (size_t)iDim * iStride;
+    nValues = (size_t)fields * fieldStride;
+    this->fill(fill);
+    return true;
+}
+
+void FieldGrid::release()
+{
+    // The block is freed with the last grid sharing it
+    block.clear();
+    data = NULL;
+    nFields = nI = nJ = nK = 0;
+    iStride = fieldStride = nValues = 0;
+}
+
+void FieldGrid::fill(float value)
+{
+    for (size_t n = 0; n < nValues; n++)
+        data[n] = value;
+}
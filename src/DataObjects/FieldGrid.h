@@ -0,0 +1,93 @@
+/*
+ *  FieldGrid.h
+ *  VORTRAC
+ *
+ *  Runtime sized storage for the fields held by GriddedData.
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef FIELDGRID_H
+#define FIELDGRID_H
+
+#include <cstddef>
+#include <QSharedPointer>
+
+// One contiguous, cache line aligned block holding every field of a grid.
+// Values are laid out as [field][i][j][k] with k varying fastest, so a
+// vertical column at (i, j) is contiguous and consecutive j columns of the
+// same i row follow each other. This matches the k innermost loops used by
+// CappiGrid and the cylindrical ring extraction in GriddedData.
+//
+// Copies share the block instead of copying it, so a finished grid can be
+// handed to another thread for the price of a reference count. Values are
+// only written while a grid is filled, right after allocate() has taken a
+// fresh block; do not write to a grid once it has been copied.
+
+class FieldGrid
+{
+
+ public:
+  FieldGrid();
+  FieldGrid(const FieldGrid &other);
+  ~FieldGrid();
+
+  FieldGrid& operator=(const FieldGrid &other);
+
+  // Allocate storage for the given dimensions and set every value to fill.
+  // Returns false (and leaves the grid empty) when the request exceeds the
+  // allocation limits or the memory can not be obtained.
+  bool allocate(int fields, int iDim, int jDim, int kDim, float fill = -999.);
+  void release();
+  void fill(float value);
+
+  bool isAllocated() const { return data != NULL; }
+  int  getNumFields() const { return nFields; }
+  int  getIDim() const { return nI; }
+  int  getJDim() const { return nJ; }
+  int  getKDim() const { return nK; }
+  size_t size() const { return nValues; }
+
+  float& operator()(int field, int i, int j, int k)
+  { return data[index(field, i, j, k)]; }
+  const float& operator()(int field, int i, int j, int k) const
+  { return data[index(field, i, j, k)]; }
+
+  // Pointer to the contiguous k column at (i, j)
+  float* column(int field, int i, int j) { return data + index(field, i, j, 0); }
+  const float* column(int field, int i, int j) const { return data + index(field, i, j, 0); }
+
+  // Pointer to the start of a field
+  float* fieldData(int field) { return data + (size_t)field * fieldStride; }
+  const float* fieldData(int field) const { return data + (size_t)field * fieldStride; }
+
+  size_t getIStride() const { return iStride; }
+  size_t getJStride() const { return (size_t)nK; }
+
+  static size_t bytesFor(int fields, int iDim, int jDim, int kDim);
+  static size_t getMaxBytes() { return maxBytes; }
+
+ private:
+  size_t index(int field, int i, int j, int k) const
+  { return (size_t)field * fieldStride + (size_t)i * iStride + (size_t)j * nK + k; }
+
+  static const size_t alignment = 64;
+  // Upper bound for a single grid, roughly the size of the old fixed array
+  static const size_t maxBytes = (size_t)512 * 1024 * 1024;
+
+  // Owns the block, shared by the copies
+  QSharedPointer<float> block;
+  float *data;
+  int nFields;
+  int nI;
+  int nJ;
+  int nK;
+  size_t iStride;
+  size_t fieldStride;
+  size_t nValues;
+
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ *  GateIndex.cpp
+ *  VORTRAC
+ *
+ *  Radar gates binned by the CAPPI grid column they fall in.
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <math.h>
+#include "GateIndex.h"
+
+GateIndex::GateIndex()
+{
+  numI = numJ = 0;
+  maxRange = 0;
+}
+
+void GateIndex::reset(int iDim, int jDim)
+{
+  // One column on the low side, two on the high side for gates on the edge
+  numI = iDim + 3;
+  numJ = jDim + 3;
+  maxRange = 0;
+  gates.clear();
+  columnStart.assign((size_t)numI * numJ + 1, 0);
+}
+
+int GateIndex::columnOf(const Gate& gate) const
+{
+  int i = (int)floorf(gate.i) + 1;
+  int j = (int)floorf(gate.j) + 1;
+  if (i < 0) i = 0;
+  if (i >= numI) i = numI - 1;
+  if (j < 0) j = 0;
+  if (j >= numJ) j = numJ - 1;
+  return i * numJ + j;
+}
+
+void GateIndex::build()
+{
+  // Counting sort, keeping the ray order within a column
+  size_t numColumns = (size_t)numI * numJ;
+  columnStart.assign(numColumns + 1, 0);
+  std::vector<int> column(gates.size());
+  for (size_t n = 0; n < gates.size(); n++) {
+    column[n] = columnOf(gates[n]);
+    columnStart[column[n] + 1]++;
+    if (gates[n].range > maxRange)
+      maxRange = gates[n].range;
+  }
+  for (size_t c = 0; c < numColumns; c++)
+    columnStart[c + 1] += columnStart[c];
+
+  std::vector<long> next(columnStart.begin(), columnStart.end() - 1);
+  std::vector<Gate> sorted(gates.size());
+  for (size_t n = 0; n < gates.size(); n++)
+    sorted[next[column[n]]++] = gates[n];
+  gates.swap(sorted);
+}
+
+void GateIndex::release()
+{
+  numI = numJ = 0;
+  maxRange = 0;
+  std::vector<Gate>().swap(gates);
+  std::vector<long>().swap(columnStart);
+}
+
+long GateIndex::columnBegin(int i, int j) const
+{
+  i++;
+  j++;
+  if ((i < 0) or (i >= numI) or (j < 0) or (j >= numJ))
+    return 0;
+  return columnStart[(size_t)i * numJ + j];
+}
+
+long GateIndex::columnEnd(int i, int j) const
+{
+  i++;
+  j++;
+  if ((i < 0) or (i >= numI) or (j < 0) or (j >= numJ))
+    return 0;
+  return columnStart[(size_t)i * numJ + j + 1];
+}
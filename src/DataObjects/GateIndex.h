@@ -0,0 +1,69 @@
+/*
+ *  GateIndex.h
+ *  VORTRAC
+ *
+ *  Radar gates binned by the CAPPI grid column they fall in.
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef GATEINDEX_H
+#define GATEINDEX_H
+
+#include <vector>
+
+// Built once per volume so an interpolation can visit, for each grid cell,
+// only the gates near it instead of spreading every gate over a box of
+// cells. Gate positions are in grid cells from (xmin, ymin, zmin), and a
+// gate belongs to the column (floor(i), floor(j)). The columns run from -1
+// to iDim + 1 and -1 to jDim + 1 to hold the gates just outside the grid.
+
+class GateIndex
+{
+
+ public:
+  class Gate {
+  public:
+    float i, j, k;
+    float height;     // km
+    float range;      // km from the radar
+    float value;
+    float nyquist;
+    // The gate in its ray, for corrections made while gridding
+    float* source;
+  };
+
+  GateIndex();
+
+  // Drops the gates of the previous volume
+  void reset(int iDim, int jDim);
+  void addGate(const Gate& gate) { gates.push_back(gate); }
+  // Sorts the gates into their columns, call after the last addGate
+  void build();
+  // Frees the gates and columns
+  void release();
+
+  long size() const { return (long)gates.size(); }
+  float getMaxRange() const { return maxRange; }
+
+  const Gate& at(long n) const { return gates[n]; }
+  Gate& operator[](long n) { return gates[n]; }
+
+  // Gates of column (i, j) are at columnBegin to columnEnd - 1. Columns
+  // outside the index are empty.
+  long columnBegin(int i, int j) const;
+  long columnEnd(int i, int j) const;
+
+ private:
+  int numI, numJ;
+  float maxRange;
+  std::vector<Gate> gates;
+  // Offset of each column in gates, plus the total
+  std::vector<long> columnStart;
+
+  int columnOf(const Gate& gate) const;
+};
+
+#endif
@@ -14,6 +14,7 @@
 // Coordinate systems
 
 #include "GriddedData.h"
+#include "CappiWriter.h"
 #include "IO/Message.h"
 #include <cmath>
 
@@ -42,6 +43,9 @@ GriddedData::GriddedData()
     jGridsp = 0;
     kGridsp = 0;
 
+    iDim = jDim = kDim = 0;
+    numFields = maxFields;
+
     // TODO:
     kDisplayIndex = 0;
 }
@@ -51,6 +55,38 @@ GriddedData::~GriddedData()
 
 }
 
+bool GriddedData::fitsAllocationLimits(int xDim, int yDim, int zDim)
+{
+    if ((xDim <= 0) || (yDim <= 0) || (zDim <= 0))
+        return false;
+    if ((xDim > maxIDim) || (yDim > maxJDim) || (zDim > maxKDim))
+        return false;
+    return FieldGrid::bytesFor(maxFields, xDim, yDim, zDim) <= getMaxGridBytes();
+}
+
+bool GriddedData::allocateGrid()
+{
+    // The grid is sized from the current dimensions, so they need to be
+    // set before any data is written into it.
+
+    int fields = int(numFields);
+    if (!fitsAllocationLimits(int(iDim), int(jDim), int(kDim))
+        || !dataGrid.allocate(fields, int(iDim), int(jDim), int(kDim))) {
+        Message::toScreen("GriddedData: unable to allocate a "
+                          + QString().setNum(iDim) + " x " + QString().setNum(jDim)
+                          + " x " + QString().setNum(kDim) + " grid of "
+                          + QString().setNum(fields) + " fields ("
+                          + QString().setNum(double(FieldGrid::bytesFor(fields, int(iDim), int(jDim), int(kDim))) / 1048576., 'f', 1)
+                          + " MB, limit " + QString().setNum(getMaxGridBytes() / 1048576) + " MB)");
+        iDim = jDim = kDim = 0;
+        ringCache.clear();
+        return false;
+    }
+    // Ring offsets depend on the grid shape
+    ringCache.clear();
+    return true;
+}
+
 void GriddedData::writeAsi()
 {
     Message::toScreen("Using unimplemented functions from GriddedData to try to write to unnamed file ");
@@ -62,6 +98,22 @@ bool GriddedData::writeAsi(const QString& fileName)
     return false;
 }
 
+bool GriddedData::writeCappi(CappiWriter& writer, const QDateTime& volumeTime)
+{
+    // Pre-gridded data comes from a file already and has no output name
+    if (outFileName.isEmpty() || !dataGrid.isAllocated())
+        return false;
+    return writer.write(*this, outFileName, volumeTime);
+}
+
+CappiSnapshot GriddedData::snapshot() const
+{
+    // Only the GriddedData part is kept, and the field values are shared
+    GriddedData *copy = new GriddedData(*this);
+    copy->ringCache = RingCache();
+    return CappiSnapshot(copy);
+}
+
 void GriddedData::setLatLonOrigin(float *knownLat, float *knownLon, float *relX, float *relY)
 {
     // takes a Lat Lon point and its cooresponding grid coordinates in km
@@ -77,7 +129,7 @@ void GriddedData::setLatLonOrigin(float *knownLat, float *knownLon, float *relX,
     // testing Message::toScreen("Set Zero: ZeroLat = "+QString().setNum(zeroLat)+" ZeroLon = "+QString().setNum(zeroLon));
 }
 
-float GriddedData::fixAngle(float angle) {
+float GriddedData::fixAngle(float angle) const {
     // Takes and angle in radians and puts it in the 0-2Pi range
 
     float fixangle = angle;
@@ -367,10 +419,12 @@ float GriddedData::getIndexValue(QString& fieldName, float& ii, float& jj, float
     // a point on the defined cartesian grid in km.
     // It is a simple accessor function.
 
-    if((ii > iDim)||(ii < 0)||(jj > jDim)||(jj < 0)||(kk > kDim)||(kk < 0))
+    if((ii >= iDim)||(ii < 0)||(jj >= jDim)||(jj < 0)||(kk >= kDim)||(kk < 0))
         return -999.;
     int field = getFieldIndex(fieldName);
-    return dataGrid[field][(int)ii][(int)jj][(int)kk];
+    if((field < 0)||(field >= dataGrid.getNumFields()))
+        return -999.;
+    return dataGrid(field,(int)ii,(int)jj,(int)kk);
 
 }
 
@@ -401,10 +455,10 @@ float* GriddedData::getCartesianXslice(const QString& fieldName,
 
     for(int i = 0; i < iDim; i++) {
         float ave = 0;
-        ave += (1-jjMaxDiff)*(1-kkMinDiff)*dataGrid[field][i][jjMax][kkMin];
-        ave += (1-jjMinDiff)*(1-kkMinDiff)*dataGrid[field][i][jjMin][kkMin];
-        ave += (1-jjMaxDiff)*(1-kkMaxDiff)*dataGrid[field][i][jjMax][kkMax];
-        ave += (1-jjMinDiff)*(1-kkMaxDiff)*dataGrid[field][i][jjMin][kkMax];
+        ave += (1-jjMaxDiff)*(1-kkMinDiff)*dataGrid(field,i,jjMax,kkMin);
+        ave += (1-jjMinDiff)*(1-kkMinDiff)*dataGrid(field,i,jjMin,kkMin);
+        ave += (1-jjMaxDiff)*(1-kkMaxDiff)*dataGrid(field,i,jjMax,kkMax);
+        ave += (1-jjMinDiff)*(1-kkMaxDiff)*dataGrid(field,i,jjMin,kkMax);
         values[i] = ave;
     }
     return values;
@@ -438,10 +492,10 @@ float* GriddedData::getCartesianYslice(const QString& fieldName,
 
     for(int j = 0; j < jDim; j++) {
         float ave = 0;
-        ave += (1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][j][kkMax];
-        ave += (1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][j][kkMax];
-        ave += (1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][j][kkMin];
-        ave += (1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][j][kkMin];
+        ave += (1-iiMinDiff)*(1-kkMaxDiff)*dataGrid(field,iiMin,j,kkMax);
+        ave += (1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid(field,iiMax,j,kkMax);
+        ave += (1-iiMinDiff)*(1-kkMinDiff)*dataGrid(field,iiMin,j,kkMin);
+        ave += (1-iiMaxDiff)*(1-kkMinDiff)*dataGrid(field,iiMax,j,kkMin);
         values[j] = ave;
     }
     return values;
@@ -474,10 +528,10 @@ float* GriddedData::getCartesianZslice(const QString& fieldName,
 
     for(int k = 0; k < kDim; k++) {
         float ave = 0;
-        ave += (1-jjMinDiff)*(1-iiMaxDiff)*dataGrid[field][iiMax][jjMin][k];
-        ave += (1-jjMaxDiff)*(1-iiMaxDiff)*dataGrid[field][iiMax][jjMax][k];
-        ave += (1-jjMinDiff)*(1-iiMinDiff)*dataGrid[field][iiMin][jjMin][k];
-        ave += (1-jjMaxDiff)*(1-iiMinDiff)*dataGrid[field][iiMin][jjMax][k];
+        ave += (1-jjMinDiff)*(1-iiMaxDiff)*dataGrid(field,iiMax,jjMin,k);
+        ave += (1-jjMaxDiff)*(1-iiMaxDiff)*dataGrid(field,iiMax,jjMax,k);
+        ave += (1-jjMinDiff)*(1-iiMinDiff)*dataGrid(field,iiMin,jjMin,k);
+        ave += (1-jjMaxDiff)*(1-iiMinDiff)*dataGrid(field,iiMin,jjMax,k);
         values[k] = ave;
     }
     return values;
@@ -513,14 +567,14 @@ float GriddedData::getCartesianValue(const QString& fieldName, const float& x,
     float iiMaxDiff = iiMax - iiIndex;
 
     float ave = 0;
-    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][jjMin][kkMin];
-    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][jjMax][kkMin];
-    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][jjMin][kkMin];
-    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][jjMax][kkMin];
-    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][jjMin][kkMax];
-    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][jjMax][kkMax];
-    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][jjMin][kkMax];
-    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][jjMax][kkMax];
+    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid(field,iiMax,jjMin,kkMin);
+    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid(field,iiMax,jjMax,kkMin);
+    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid(field,iiMin,jjMin,kkMin);
+    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid(field,iiMin,jjMax,kkMin);
+    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid(field,iiMax,jjMin,kkMax);
+    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid(field,iiMax,jjMax,kkMax);
+    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid(field,iiMin,jjMin,kkMax);
+    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid(field,iiMin,jjMax,kkMax);
     return ave;
 
 }
@@ -575,7 +629,7 @@ float* GriddedData::getSphericalRangeData(QString& fieldName, float azimuth,
                         && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
                     if((pElevation <=(elevation+sphericalElevationSpacing/2.))
                             && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -659,7 +713,7 @@ float* GriddedData::getSphericalAzimuthData(QString& fieldName,
                         && (r > (range-sphericalRangeSpacing/2.))) {
                     if((pElevation <=(elevation+sphericalElevationSpacing/2.))
                             && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -736,7 +790,7 @@ float* GriddedData::getSphericalElevationData(QString& fieldName, float range,
                         && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
                     if((r <= (range+sphericalRangeSpacing/2.))
                             && (r > (range-sphericalRangeSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -810,7 +864,7 @@ float* GriddedData::getCylindricalRadiusData(QString& fieldName, float azimuth,
                         && (pAzimuth > (azimuth-cylindricalAzimuthSpacing/2.))) {
                     if((k*kGridsp <= ((height/kGridsp)-zmin+cylindricalHeightSpacing/2.))
                             && (k*kGridsp > ((height/kGridsp)-zmin-cylindricalHeightSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -872,38 +926,7 @@ int GriddedData::getCylindricalAzimuthLength(float radius, float height)
 
 int GriddedData::getCylindricalAzimuthLength(float radius, float height)
 {
-    int count = 0;
-    float r = 0;
-    // 2 is for a little extra :)
-    int iLow = int(refPointI)-int((radius+cylindricalRadiusSpacing)/iGridsp)-2;
-    int iHigh = int(refPointI) + int((radius+cylindricalRadiusSpacing)/iGridsp) + 2;
-    if(iLow < 0)
-        iLow = 0;
-    if(iHigh > iDim)
-        iHigh = int(iDim);
-    int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
-    int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
-    if(jLow < 0)
-        jLow = 0;
-    if(jHigh > jDim)
-        jHigh = int(jDim);
-    // Do k too!
-    for(int i = iLow; i < iHigh; i ++) {
-        for(int j = jLow; j < jHigh; j ++) {
-            for(int k = 0; k < kDim; k ++) {
-                r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                if((r <= (radius+cylindricalRadiusSpacing/2.))
-                        && (r > (radius-cylindricalRadiusSpacing/2.))) {
-                    if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
-                            && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        count++;
-                    }
-                }
-            }
-        }
-    }
-    return count;
-
+    return getCylindricalRing(radius, height).size();
 }
 
 int GriddedData::getCylindricalAzimuthLengthTest2(float radius, float height)
@@ -1029,7 +1052,7 @@ void GriddedData::getCylindricalAzimuthData(QString& fieldName, int numPoints,
     && (r > (radius-cylindricalRadiusSpacing/2.))) {
    if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
       && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-     values[count] = dataGrid[field][i][j][k];
+     values[count] = dataGrid(field,i,j,k);
      count++;
      if(count > numPoints) {
        // Memory overflow ... bail out
@@ -1048,50 +1071,14 @@ void GriddedData::getCylindricalAzimuthData(QString& fieldName,
                                             int numPoints,float radius,
                                             float height, float* values)
 {
-    //  int numPoints = getCylindricalAzimuthLength(radius, height);
     int field = getFieldIndex(fieldName);
-
-    //  float *values = new float[numPoints];
-
-    int count = 0;
-    float r = 0;
-
-    // 2 is for a little extra :)
-    int iLow = int(refPointI)-int((radius+cylindricalRadiusSpacing)/iGridsp)-2;
-    int iHigh = int(refPointI) + int((radius+cylindricalRadiusSpacing)/iGridsp) + 2;
-    if(iLow < 0)
-        iLow = 0;
-    if(iHigh > iDim)
-        iHigh = int(iDim);
-    int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
-    int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
-    if(jLow < 0)
-        jLow = 0;
-    if(jHigh > jDim)
-        jHigh = int(jDim);
-    // Do k too!
-    for(int i = iLow; i < iHigh; i ++) {
-        for(int j = jLow; j < jHigh; j ++) {
-            for(int k = 0; k < kDim; k ++) {
-                r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                if((r <= (radius+cylindricalRadiusSpacing/2.))
-                        && (r > (radius-cylindricalRadiusSpacing/2.))) {
-                    if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
-                            && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
-			// TODO debug
-			// std::cout << "val[" << count << "] = " << values[count] << std::endl;
-                        count++;
-                        if(count > numPoints) {
-                            // Memory overflow ... bail out
-                            Message::toScreen("GriddedData: getCylindricalAzimuthData: HUGE Problems!");
-                        }
-                    }
-                }
-            }
-        }
+    const RingIndex& ring = getCylindricalRing(radius, height);
+    if(ring.size() > numPoints) {
+        // Memory overflow ... bail out
+        Message::toScreen("GriddedData: getCylindricalAzimuthData: HUGE Problems!");
+        return;
     }
-    //return values;
+    getCylindricalRingData(ring, field, values);
 }
 
 void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName, 
@@ -1155,7 +1142,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1174,7 +1161,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1191,7 +1178,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1210,7 +1197,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1261,50 +1248,110 @@ void GriddedData::getCylindricalAzimuthPosition(int numPoints, float radius, flo
 
 void GriddedData::getCylindricalAzimuthPosition(int numPoints, float radius, float height, float* positions) 
 {
-    //  int numPoints = getCylindricalAzimuthLength(radius, height);
+    const RingIndex& ring = getCylindricalRing(radius, height);
+    if (ring.size() > numPoints) {
+        // Memory overflow, bail out
+        return;
+    }
+    getCylindricalRingPositions(ring, positions);
+}
 
-    //  float *positions = new float[numPoints];
+const RingIndex& GriddedData::getCylindricalRing(float radius, float height)
+{
+    return findCylindricalRing(refPointI, refPointJ, radius, height, ringCache);
+}
 
-    int count = 0;
-    float r = 0;
+const RingIndex& GriddedData::getCylindricalRing(float x, float y, float radius, float height,
+                                                 RingCache& cache) const
+{
+    // Same rounding as setCartesianReferencePoint
+    float refI = int(floor((x - xmin)/iGridsp+.5));
+    float refJ = int(floor((y - ymin)/jGridsp+.5));
+    return findCylindricalRing(refI, refJ, radius, height, cache);
+}
+
+const RingIndex& GriddedData::findCylindricalRing(float refI, float refJ, float radius, float height,
+                                                  RingCache& cache) const
+{
+    const RingIndex* ring = cache.find(refI, refJ, radius, height,
+                                       cylindricalRadiusSpacing, cylindricalHeightSpacing);
+    if (ring != NULL)
+        return *ring;
+
+    RingIndex* newRing = cache.replace();
+    buildCylindricalRing(refI, refJ, radius, height, *newRing);
+    return *newRing;
+}
+
+void GriddedData::buildCylindricalRing(float refI, float refJ, float radius, float height,
+                                       RingIndex& ring) const
+{
+    // Same membership test as the original scan over the bounding box,
+    // but the height test only depends on k and the radius test only on
+    // (i, j), so each is done once instead of once per cell.
 
+    ring.reset(refI, refJ, radius, height, cylindricalRadiusSpacing, cylindricalHeightSpacing);
 
     // 2 is for a little extra :)
-    int iLow = int(refPointI)-int((radius+cylindricalRadiusSpacing)/iGridsp)-2;
-    int iHigh = int(refPointI) + int((radius+cylindricalRadiusSpacing)/iGridsp) + 2;
+    int iLow = int(refI)-int((radius+cylindricalRadiusSpacing)/iGridsp)-2;
+    int iHigh = int(refI) + int((radius+cylindricalRadiusSpacing)/iGridsp) + 2;
     if(iLow < 0)
         iLow = 0;
     if(iHigh > iDim)
         iHigh = int(iDim);
-    int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
-    int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
+    int jLow = int(refJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
+    int jHigh = int(refJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
     if(jLow < 0)
         jLow = 0;
     if(jHigh > jDim)
         jHigh = int(jDim);
-    // Do k too!
+
+    int kLow = int(kDim);
+    int kHigh = 0;
+    for(int k = 0; k < kDim; k ++) {
+        if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
+                && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
+            if (k < kLow)
+                kLow = k;
+            kHigh = k + 1;
+        }
+    }
+    if (kLow >= kHigh)
+        return;
+
+    size_t iStride = dataGrid.getIStride();
+    size_t jStride = dataGrid.getJStride();
     for(int i = iLow; i < iHigh; i ++) {
         for(int j = jLow; j < jHigh; j ++) {
-            for(int k = 0; k < kDim; k ++) {
-                r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)
-                         + jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                if((r <= (radius+cylindricalRadiusSpacing/2.))
-                        && (r > (radius-cylindricalRadiusSpacing/2.))) {
-                    if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
-                            && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        float azimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                        if (count > numPoints) {
-                            // Memory overflow, bail out
-                            return;
-                        } else {
-                            positions[count] = azimuth;
-                            count++;
-                        }
-                    }
-                }
+            float r = sqrt(iGridsp*iGridsp*(i-refI)*(i-refI)
+                           + jGridsp*jGridsp*(j-refJ)*(j-refJ));
+            if((r <= (radius+cylindricalRadiusSpacing/2.))
+                    && (r > (radius-cylindricalRadiusSpacing/2.))) {
+                float azimuth = fixAngle(atan2((j-refJ),(i-refI)))*rad2deg;
+                size_t column = i * iStride + j * jStride;
+                for(int k = kLow; k < kHigh; k ++)
+                    ring.append(column + k, azimuth);
             }
         }
     }
+    ring.sortByAzimuth();
+}
+
+void GriddedData::getCylindricalRingData(const RingIndex& ring, int field, float* values) const
+{
+    if ((field < 0) || (field >= dataGrid.getNumFields()))
+        return;
+    const float* fieldData = dataGrid.fieldData(field);
+    int numPoints = ring.size();
+    for (int n = 0; n < numPoints; n++)
+        values[n] = fieldData[ring.at(n).offset];
+}
+
+void GriddedData::getCylindricalRingPositions(const RingIndex& ring, float* positions) const
+{
+    int numPoints = ring.size();
+    for (int n = 0; n < numPoints; n++)
+        positions[n] = ring.at(n).azimuth;
 }
 
 void GriddedData::getCylindricalAzimuthPositionTest2(int numPoints, float radius, float height, float* positions) 
@@ -1485,7 +1532,7 @@ float* GriddedData::getCylindricalHeightData(QString& fieldName, float radius,
                 if((pAzimuth <= azimuth+cylindricalAzimuthSpacing/2.)
                         && (pAzimuth > azimuth-cylindricalAzimuthSpacing/2.)) {
                     for(int k = 0; k < kDim; k++){
-                        data[count] = dataGrid[field][i][j][k];
+                        data[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -1534,11 +1581,13 @@ bool GriddedData::test()
     iGridsp = 2;
     jGridsp = 2;
     kGridsp = 1;
+    if(!allocateGrid())
+        return false;
     for(int i = 0; i < iDim; i++) {
         for(int j = 0; j < jDim; j++) {
             for(int k = 0; k < kDim; k++) {
                 for(int dataField = 0; dataField < 3; dataField++) {
-                    dataGrid[dataField][i][j][k] = dataField*j;
+                    dataGrid(dataField,i,j,k) = dataField*j;
                 }
             }
         }
@@ -1555,8 +1604,8 @@ bool GriddedData::test()
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" from getCartesianValue");
                     Message::toScreen(message);
                 }
-                if(xValues[i]!=(dataGrid[0][i][j][k]+dataGrid[0][i][j+1][k])) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[0][i][j][k]));
+                if(xValues[i]!=(dataGrid(0,i,j,k)+dataGrid(0,i,j+1,k))) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid(0,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1565,8 +1614,8 @@ bool GriddedData::test()
             xValues = getCartesianXslice(fieldName,(j+ymin)*jGridsp,
                                          (k+zmin)*kGridsp);
             for(int i = 0; i < iDim; i++) {
-                if(xValues[i]!=dataGrid[1][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(j)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[1][i][j][k]));
+                if(xValues[i]!=dataGrid(1,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(j)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid(1,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1575,8 +1624,8 @@ bool GriddedData::test()
             xValues = getCartesianXslice(fieldName,(j+ymin)*jGridsp,
                                          (k+zmin)*kGridsp);
             for(int i = 0; i < iDim; i++) {
-                if(xValues[i]!=dataGrid[2][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[2][i][j][k]));
+                if(xValues[i]!=dataGrid(2,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid(2,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1591,8 +1640,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[0][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual: "+QString().setNum(dataGrid[0][i][j][k]));
+                if(yValues[j]!=dataGrid(0,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual: "+QString().setNum(dataGrid(0,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1600,8 +1649,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[1][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid[1][i][j][k]));
+                if(yValues[j]!=dataGrid(1,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid(1,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1609,8 +1658,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[2][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid[2][i][j][k]));
+                if(yValues[j]!=dataGrid(2,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid(2,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1624,7 +1673,7 @@ bool GriddedData::test()
             float *zValues = new float[int(floor(kDim))];
             zValues= getCartesianZslice(fieldName,(i+xmin)*iGridsp,(j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[0][i][j][k]) {
+                if(zValues[k]!=dataGrid(0,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1633,7 +1682,7 @@ bool GriddedData::test()
             zValues = getCartesianZslice(fieldName,(i+xmin)*iGridsp,
                                          (j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[1][i][j][k]) {
+                if(zValues[k]!=dataGrid(1,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1642,7 +1691,7 @@ bool GriddedData::test()
             zValues = getCartesianZslice(fieldName,(i+xmin)*iGridsp,
                                          (j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[2][i][j][k]) {
+                if(zValues[k]!=dataGrid(2,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1737,7 +1786,7 @@ float* GriddedData::getSphericalRangeDataTest(QString& fieldName,
                         && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
                     if((pElevation <=(elevation+sphericalElevationSpacing/2.))
                             && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = dataGrid(field,i,j,k);
                         count++;
                     }
                 }
@@ -13,8 +13,19 @@
 
 #include "Radar/RadarData.h"
 #include "IO/Message.h"
+#include "DataObjects/FieldGrid.h"
+#include "DataObjects/RingIndex.h"
 #include <QDomElement>
 #include <QStringList>
+#include <QSharedPointer>
+
+class CappiWriter;
+class GriddedData;
+
+// A finished CAPPI as handed to the displays. It shares the field values
+// with the grid it was made from, and is only read from then on, so it
+// can cross to the GUI thread while the analysis goes on with the grid.
+typedef QSharedPointer<const GriddedData> CappiSnapshot;
 
 class GriddedData 
 {
@@ -27,6 +38,11 @@ class GriddedData
   // These 2 currently do nothing
   virtual void writeAsi(); // = 0;
   virtual bool writeAsi(const QString& fileName); // = 0;
+  // Writes the grid next to the other CAPPIs with the configured writer
+  bool writeCappi(CappiWriter& writer, const QDateTime& volumeTime);
+  // Read only copy for the displays, without copying the field values
+  CappiSnapshot snapshot() const;
+  QString getOutputFileName() const { return outFileName; }
 
   float getIdim() const { return iDim; }
   float getJdim() const { return jDim; }
@@ -40,11 +56,11 @@ class GriddedData
   //void setIGridsp(const float& iSpacing);
   //void setJGridsp(const float& jSpacing);
   //void setKGridsp(const float& kSpacing);
-  float fixAngle(float angle);
+  float fixAngle(float angle) const;
   
   void setLatLonOrigin(float *knownLat, float *knownLon, float *relX,float *relY);
-  float getOriginLat()	{ return originLat; }
-  float getOriginLon()	{ return originLon; }
+  float getOriginLat() const	{ return originLat; }
+  float getOriginLon() const	{ return originLon; }
   
   void setReferencePoint(int ii, int jj, int kk);
   void setCartesianReferencePoint(float ii, float jj, float kk); 
@@ -122,6 +138,22 @@ class GriddedData
   int    getCylindricalAzimuthLength(float radius, float height);
   void   getCylindricalAzimuthData(QString& fieldName,int numPoints, float radius, float height, float* values);
   void   getCylindricalAzimuthPosition(int numPoints, float radius, float height, float* positions);
+  // Ring membership index for the current reference point. The three
+  // getCylindricalAzimuth* functions above are served from it, so a ring
+  // is only searched once per (center, radius, height).
+  const RingIndex& getCylindricalRing(float radius, float height);
+  // Ring around an explicit center given in km, placed on the grid the same
+  // way setCartesianReferencePoint does. Leaves the reference point alone and
+  // uses the caller's cache, so threads can share one grid if each keeps
+  // its own RingCache.
+  const RingIndex& getCylindricalRing(float x, float y, float radius, float height,
+                                      RingCache& cache) const;
+  // Same search for an explicit center (grid indices), without touching
+  // the reference point or the internal cache
+  void   buildCylindricalRing(float refI, float refJ, float radius, float height,
+                              RingIndex& ring) const;
+  void   getCylindricalRingData(const RingIndex& ring, int field, float* values) const;
+  void   getCylindricalRingPositions(const RingIndex& ring, float* positions) const;
   int    getCylindricalHeightLength(float radius, float height);
   float* getCylindricalHeightData(QString& fieldName, float radius,float height);
   float* getCylindricalHeightPosition(float radius, float height);
@@ -140,6 +172,10 @@ class GriddedData
   static int getMaxIDim() { return maxIDim; }
   static int getMaxJDim() { return maxJDim; }
   static int getMaxKDim() { return maxKDim; }
+  // Largest grid (in bytes) that will be allocated for the given dimensions
+  static size_t getMaxGridBytes() { return FieldGrid::getMaxBytes(); }
+  static bool fitsAllocationLimits(int xDim, int yDim, int zDim);
+  size_t getGridBytes() const { return dataGrid.size() * sizeof(float); }
 
   float getCylindricalAzimuthSpacing() { return cylindricalAzimuthSpacing; }
   void  setCylindricalAzimuthSpacing(const float& newSpacing);
@@ -147,6 +183,13 @@ class GriddedData
   // TODO: This is really a graphic attribute.
   //       But I find no other way to cleanly pass a value to CappiDisplay::constructImage()
   int getDisplayKIndex() const { return kDisplayIndex; }
+
+  // Extent of the grid, km from the radar
+  float getXmin() const { return xmin; }
+  float getYmin() const { return ymin; }
+  float getZmin() const { return zmin; }
+  const QStringList& getFieldNames() const { return fieldNames; }
+  const FieldGrid& getFieldGrid() const { return dataGrid; }
     
  protected:
   float iDim;
@@ -161,15 +204,19 @@ class GriddedData
   float numFields;
   QStringList fieldNames;
 
+  // Allocation limits, checked by allocateGrid() before any memory is taken
   static const int maxFields = 3;
   static const int maxIDim = 1024; // 256;
   static const int maxJDim = 1024; // 256;
   static const int maxKDim = 40;   // 20;
 
-  float dataGrid[maxFields][maxIDim][maxJDim][maxKDim];
-  //dataGrid[0] = reflectivity
-  //dataGrid[1] = doppler velocity magnitude
-  //dataGrid[2] = spectral width
+  // Size dataGrid from iDim, jDim, kDim and numFields
+  bool allocateGrid();
+
+  FieldGrid dataGrid;
+  //dataGrid(0,i,j,k) = reflectivity
+  //dataGrid(1,i,j,k) = doppler velocity magnitude
+  //dataGrid(2,i,j,k) = spectral width
 
   float sphericalRangeSpacing;
   float sphericalAzimuthSpacing;
@@ -179,6 +226,11 @@ class GriddedData
   float cylindricalAzimuthSpacing;
   float cylindricalHeightSpacing;
 
+  // Rings recently requested through the reference point
+  RingCache ringCache;
+  const RingIndex& findCylindricalRing(float refI, float refJ, float radius, float height,
+                                       RingCache& cache) const;
+
   float refPointI;
   float refPointJ;
   float refPointK;
@@ -195,6 +247,9 @@ class GriddedData
 
   // At what k index CappiDisplay gets its data
   int kDisplayIndex;
+
+  // Output file for the CAPPI, without extension
+  QString outFileName;
   
   bool test();
   
@@ -30,17 +30,17 @@ GriddedData* GriddedFactory::makeEmptyGrid()
 
 }
 
-GriddedData* GriddedFactory::makeCappi(RadarData *radarData,Configuration* mainConfig,float *vortexLat, float *vortexLon)
+GriddedData* GriddedFactory::makeCappi(RadarData *radarData,const ConfigSnapshot& settings,float *vortexLat, float *vortexLon)
 {
     CappiGrid* cappi = new CappiGrid;
-    cappi->gridRadarData(radarData,mainConfig->getConfig("cappi"),vortexLat,vortexLon);
+    cappi->gridRadarData(radarData,settings.cappi,vortexLat,vortexLon);
     return cappi;
 }
 
-GriddedData* GriddedFactory::fillPreGriddedData(RadarData *radarData, Configuration* mainConfig)
+GriddedData* GriddedFactory::fillPreGriddedData(RadarData *radarData, const ConfigSnapshot& settings)
 {
   CappiGrid *cappi = new CappiGrid;
-  cappi->loadPreGridded(radarData, mainConfig->getConfig("cappi"));
+  cappi->loadPreGridded(radarData, settings.cappi);
   return cappi;
 }
 
@@ -59,7 +59,7 @@ GriddedData* GriddedFactory::makeAnalytic(RadarData *radarData,
         return data;
     }
     else {
-        return makeCappi(radarData, mainConfig,vortexLat, vortexLon);
+        return makeCappi(radarData, mainConfig->getSnapshot(),vortexLat, vortexLon);
     }
 
     Message::toScreen("Error in make Analytic GriddedFactory");
@@ -22,10 +22,10 @@ public:
     ~GriddedFactory();
     GriddedData* makeEmptyGrid();
     GriddedData* makeCappi(RadarData *radarData,
-                           Configuration* mainConfig,
+                           const ConfigSnapshot& settings,
                            float *vortexLat, float *vortexLon);
     GriddedData* fillPreGriddedData(RadarData *radarData,
-				    Configuration* mainConfig);
+				    const ConfigSnapshot& settings);
     GriddedData* makeAnalytic(RadarData *radarData,
                               Configuration* mainConfig,
                               Configuration* analyticConfig,
@@ -0,0 +1,112 @@
+/*
+ *  RingIndex.cpp
+ *  VORTRAC
+ *
+ *  Precomputed cell membership of a cylindrical ring in a GriddedData
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "RingIndex.h"
+#include <algorithm>
+
+static bool azimuthLess(const RingIndex::Cell &a, const RingIndex::Cell &b)
+{
+    return a.azimuth < b.azimuth;
+}
+
+RingIndex::RingIndex()
+{
+    clear();
+}
+
+bool RingIndex::matches(float newRefI, float newRefJ, float newRadius, float newHeight,
+                        float newRadiusSpacing, float newHeightSpacing) const
+{
+    return valid
+            && (refI == newRefI) && (refJ == newRefJ)
+            && (radius == newRadius) && (height == newHeight)
+            && (radiusSpacing == newRadiusSpacing)
+            && (heightSpacing == newHeightSpacing);
+}
+
+void RingIndex::reset(float newRefI, float newRefJ, float newRadius, float newHeight,
+                      float newRadiusSpacing, float newHeightSpacing)
+{
+    // Keep the capacity, rings of similar size are rebuilt over and over
+    cells.clear();
+    refI = newRefI;
+    refJ = newRefJ;
+    radius = newRadius;
+    height = newHeight;
+    radiusSpacing = newRadiusSpacing;
+    heightSpacing = newHeightSpacing;
+    valid = true;
+}
+
+void RingIndex::clear()
+{
+    cells.clear();
+    valid = false;
+    refI = refJ = radius = height = -999.;
+    radiusSpacing = heightSpacing = 0;
+}
+
+void RingIndex::append(size_t offset, float azimuth)
+{
+    Cell cell;
+    cell.azimuth = azimuth;
+    cell.offset = offset;
+    cells.push_back(cell);
+}
+
+void RingIndex::sortByAzimuth()
+{
+    // Stable, so cells at the same azimuth keep their grid order
+    std::stable_sort(cells.begin(), cells.end(), azimuthLess);
+}
+
+RingCache::RingCache(int capacity)
+    : rings(capacity > 0 ? capacity : 1),
+      lastUse(capacity > 0 ? capacity : 1, 0)
+{
+    useClock = 0;
+    hits = 0;
+    misses = 0;
+}
+
+const RingIndex* RingCache::find(float refI, float refJ, float radius, float height,
+                                 float radiusSpacing, float heightSpacing)
+{
+    for (size_t n = 0; n < rings.size(); n++) {
+        if (rings[n].matches(refI, refJ, radius, height, radiusSpacing, heightSpacing)) {
+            lastUse[n] = ++useClock;
+            hits++;
+            return &rings[n];
+        }
+    }
+    misses++;
+    return NULL;
+}
+
+RingIndex* RingCache::replace()
+{
+    size_t oldest = 0;
+    for (size_t n = 1; n < rings.size(); n++) {
+        if (lastUse[n] < lastUse[oldest])
+            oldest = n;
+    }
+    lastUse[oldest] = ++useClock;
+    return &rings[oldest];
+}
+
+void RingCache::clear()
+{
+    for (size_t n = 0; n < rings.size(); n++) {
+        rings[n].clear();
+        lastUse[n] = 0;
+    }
+    useClock = 0;
+}
@@ -0,0 +1,91 @@
+/*
+ *  RingIndex.h
+ *  VORTRAC
+ *
+ *  Precomputed cell membership of a cylindrical ring in a GriddedData
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef RINGINDEX_H
+#define RINGINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+// The cells of one ring (center, radius, height) with their azimuths,
+// sorted by azimuth. Offsets are relative to the start of a field in
+// the FieldGrid, so one index serves every field of the grid.
+
+class RingIndex
+{
+
+ public:
+  RingIndex();
+
+  class Cell {
+  public:
+    float azimuth;
+    size_t offset;
+  };
+
+  bool matches(float refI, float refJ, float radius, float height,
+	       float radiusSpacing, float heightSpacing) const;
+  void reset(float refI, float refJ, float radius, float height,
+	     float radiusSpacing, float heightSpacing);
+  void clear();
+
+  void append(size_t offset, float azimuth);
+  void sortByAzimuth();
+
+  int size() const { return (int)cells.size(); }
+  const Cell& at(int n) const { return cells[n]; }
+  bool isValid() const { return valid; }
+
+  float getRefI() const { return refI; }
+  float getRefJ() const { return refJ; }
+
+ private:
+  bool valid;
+  float refI;
+  float refJ;
+  float radius;
+  float height;
+  float radiusSpacing;
+  float heightSpacing;
+  std::vector<Cell> cells;
+
+};
+
+// A small least recently used set of ring indices. Each GriddedData keeps
+// one for its stateful reference point; threads evaluating rings in
+// parallel each keep their own.
+
+class RingCache
+{
+
+ public:
+  RingCache(int capacity = 8);
+
+  // Returns the matching ring, or NULL if it has to be built
+  const RingIndex* find(float refI, float refJ, float radius, float height,
+			float radiusSpacing, float heightSpacing);
+  // Returns the slot to rebuild when find() misses
+  RingIndex* replace();
+  void clear();
+
+  long getHits() const { return hits; }
+  long getMisses() const { return misses; }
+
+ private:
+  std::vector<RingIndex> rings;
+  std::vector<unsigned long> lastUse;
+  unsigned long useClock;
+  long hits;
+  long misses;
+
+};
+
+#endif
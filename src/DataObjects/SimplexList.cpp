@@ -10,13 +10,17 @@
  */
 
 #include "SimplexList.h"
+#include "IO/ListSnapshot.h"
 #include <QFileInfo>
 #include <QFile>
 #include <QXmlStreamWriter>
+#include <QDomDocument>
 
-SimplexList::SimplexList(QString filePath) : QList<SimplexData>()
+SimplexList::SimplexList(QString filePath) : QList<SimplexData>(), _journal("simplex")
 {
     _filePath = filePath;
+    _journal.setListFilePath(filePath);
+    _journaling = false;
 }
 
 SimplexList::~SimplexList()
@@ -51,15 +55,17 @@ bool SimplexList::saveXML()
             for(int ridx=0;ridx<record->getNumRadii();ridx++){
                 xmlWriter.writeStartElement("ring");
                 xmlWriter.writeAttribute("range",QString().setNum(record->getRadius(ridx)));
+                xmlWriter.writeAttribute("converging",
+                                         QString().setNum(record->getNumConvergingCenters(hidx, ridx)));
                 tmpStr.sprintf("%6.2f,%6.2f,%6.2f,%6.2f", record->getMeanX(hidx, ridx),
 			       record->getMeanY(hidx, ridx), record->getCenterStdDev(hidx, ridx),
                                record->getMaxVT(hidx, ridx) // , record->getVTUncertainty(hidx, ridx)
 			       );
-                xmlWriter.writeTextElement("mean value",tmpStr);
+                xmlWriter.writeTextElement("mean_value",tmpStr);
                 for(int pidx=0;pidx<record->getNumPointsUsed();pidx++){
                     Center center=record->getCenter(hidx,ridx,pidx);
                     tmpStr.sprintf("%6.2f,%6.2f,%6.2f,%6.2f,%6.2f",center.getStartX(),center.getStartY(),center.getX(),center.getY(),center.getMaxVT());
-                    xmlWriter.writeTextElement("point value",tmpStr);
+                    xmlWriter.writeTextElement("point_value",tmpStr);
                 }
                 xmlWriter.writeEndElement();
             }
@@ -69,13 +75,306 @@ bool SimplexList::saveXML()
     }
     xmlWriter.writeEndElement();
     delete record;
+    file.close();
+
+    return true;
+}
+
+bool SimplexList::save()
+{
+    bool ok = true;
+    if(!_journaling)
+        ok = saveXML();
+    return appendToJournal() && ok;
+}
+
+bool SimplexList::saveAll()
+{
+    bool ok = saveXML();
+    return saveSnapshot() && ok;
+}
+
+bool SimplexList::compact()
+{
+    bool ok = true;
+    if(_journaling)
+        ok = saveXML();
+    return saveSnapshot() && ok;
+}
+
+bool SimplexList::appendToJournal()
+{
+    // Only records that were added since the last save are written,
+    // unless the journal has to start over from a snapshot
+    int saved = _journal.savedCount();
+    QString savedKey;
+    if((saved > 0) && (saved <= count()))
+        savedKey = recordKey(this->at(saved - 1));
+    int first = _journal.firstUnsaved(count(), savedKey);
+    if((first < 0) || _journal.needsCompaction())
+        return compact();
+    for(int vid = first; vid < count(); vid++) {
+        QDataStream* out = _journal.beginRecord();
+        if(out == NULL)
+            return compact();
+        writeRecord(*out, this->at(vid));
+        if(!_journal.commitRecord(recordKey(this->at(vid)))) {
+            std::cout<<"error: Cannot append to "<<_journal.getFilePath().toStdString()<<std::endl;
+            return compact();
+        }
+    }
     return true;
 }
 
+void SimplexList::setFilePath(QString filePath)
+{
+    _filePath = filePath;
+    _journal.setListFilePath(filePath);
+}
+
+void SimplexList::setJournaling(bool journal)
+{
+    _journaling = journal;
+}
+
+QString SimplexList::recordKey(const SimplexData& record)
+{
+    return record.getTime().toString("yyyy-MM-ddThh:mm:ss.zzz");
+}
+
+QString SimplexList::lastKey() const
+{
+    if(isEmpty())
+        return QString();
+    return recordKey(last());
+}
+
+void SimplexList::writeRecord(QDataStream& out, const SimplexData& record)
+{
+    out << record.getTime() << (qint32)record.getNumLevels() << (qint32)record.getNumRadii()
+        << (qint32)record.getNumCenters() << (qint32)record.getNumPointsUsed();
+    for(int hidx = 0; hidx < record.getNumLevels(); hidx++)
+        out << record.getHeight(hidx);
+    for(int ridx = 0; ridx < record.getNumRadii(); ridx++)
+        out << record.getRadius(ridx);
+    for(int hidx = 0; hidx < record.getNumLevels(); hidx++) {
+        for(int ridx = 0; ridx < record.getNumRadii(); ridx++) {
+            out << record.getMeanX(hidx, ridx) << record.getMeanY(hidx, ridx)
+                << record.getCenterStdDev(hidx, ridx) << record.getMaxVT(hidx, ridx)
+                << record.getVTUncertainty(hidx, ridx)
+                << (qint32)record.getNumConvergingCenters(hidx, ridx);
+            for(int pidx = 0; pidx < record.getNumCenters(); pidx++) {
+                Center center = record.getCenter(hidx, ridx, pidx);
+                out << center.getStartX() << center.getStartY() << center.getX()
+                    << center.getY() << center.getMaxVT() << center.getLevel()
+                    << center.getRadius()
+                    << record.getInitialX(hidx, ridx, pidx) << record.getInitialY(hidx, ridx, pidx);
+            }
+        }
+    }
+}
+
+bool SimplexList::readRecord(QDataStream& in, QList<SimplexData>& records)
+{
+    QDateTime time;
+    qint32 numLevels, numRadii, numCenters, numPointsUsed;
+    in >> time >> numLevels >> numRadii >> numCenters >> numPointsUsed;
+    if((in.status() != QDataStream::Ok) || (numLevels < 0) || (numLevels > SimplexData::getMaxLevels())
+       || (numRadii < 0) || (numRadii > SimplexData::getMaxRadii())
+       || (numCenters < 0) || (numCenters > SimplexData::getMaxCenters()))
+        return false;
+
+    SimplexData *record = new SimplexData(numLevels, numRadii, numCenters);
+    record->setTime(time);
+    record->setNumPointsUsed(numPointsUsed);
+    for(int hidx = 0; hidx < numLevels; hidx++) {
+        float height;
+        in >> height;
+        record->setHeight(hidx, height);
+    }
+    for(int ridx = 0; ridx < numRadii; ridx++) {
+        float radius;
+        in >> radius;
+        record->setRadius(ridx, radius);
+    }
+    for(int hidx = 0; hidx < numLevels; hidx++) {
+        for(int ridx = 0; ridx < numRadii; ridx++) {
+            float meanX, meanY, stdDev, maxVT, vtUncertainty;
+            qint32 converging;
+            in >> meanX >> meanY >> stdDev >> maxVT >> vtUncertainty >> converging;
+            record->setMeanX(hidx, ridx, meanX);
+            record->setMeanY(hidx, ridx, meanY);
+            record->setCenterStdDev(hidx, ridx, stdDev);
+            record->setMaxVT(hidx, ridx, maxVT);
+            record->setVTUncertainty(hidx, ridx, vtUncertainty);
+            record->setNumConvergingCenters(hidx, ridx, converging);
+            for(int pidx = 0; pidx < numCenters; pidx++) {
+                float startX, startY, endX, endY, centerVT, level, radius, initialX, initialY;
+                in >> startX >> startY >> endX >> endY >> centerVT >> level >> radius
+                   >> initialX >> initialY;
+                record->setCenter(hidx, ridx, pidx,
+                                  Center(startX, startY, endX, endY, centerVT, level, radius));
+                record->setInitialX(hidx, ridx, pidx, initialX);
+                record->setInitialY(hidx, ridx, pidx, initialY);
+            }
+        }
+    }
+    records.append(*record);
+    delete record;
+    return (in.status() == QDataStream::Ok);
+}
+
+bool SimplexList::saveSnapshot()
+{
+    ListSnapshot snapshot(_filePath, "simplex");
+    quint64 snapshotId = _journal.nextSnapshotId();
+    QDataStream* out = snapshot.beginWrite(count(), snapshotId);
+    if(out == NULL) {
+        std::cout<<"error: Cannot open file"<<snapshot.getFilePath().toStdString()<<std::endl;
+        return false;
+    }
+
+    for(int vid = 0; vid < count(); vid++)
+        writeRecord(*out, this->at(vid));
+    if(!snapshot.commit())
+        return false;
+    return _journal.snapshotSaved(snapshotId, count(), lastKey());
+}
 
 bool SimplexList::restore()
 {
-    return false;
+    if(restoreSnapshot())
+        return true;
+    return restoreXML();
+}
+
+bool SimplexList::restoreSnapshot()
+{
+    ListSnapshot snapshot(_filePath, "simplex");
+    int numRecords;
+    quint64 snapshotId;
+    QDataStream* in = snapshot.beginRead(numRecords, &snapshotId);
+    if(in == NULL)
+        return false;
+
+    QList<SimplexData> records;
+    for(int vid = 0; vid < numRecords; vid++) {
+        if(!readRecord(*in, records))
+            return false;
+    }
+    if(!snapshot.readOk())
+        return false;
+
+    // Then the records saved since the snapshot
+    QList<QByteArray> entries;
+    _journal.readEntries(snapshotId, entries);
+    for(int ii = 0; ii < entries.count(); ii++) {
+        QDataStream entry(entries.at(ii));
+        ListJournal::prepareStream(entry);
+        if(!readRecord(entry, records))
+            return false;
+    }
+
+    clear();
+    append(records);
+    _journal.restored(snapshotId, count(), lastKey());
+    return true;
+}
+
+bool SimplexList::restoreXML()
+{
+    QFile file(_filePath);
+    if(!file.open(QFile::ReadOnly|QFile::Text))
+        return false;
+    QDomDocument doc;
+    if(!doc.setContent(&file))
+        return false;
+    file.close();
+
+    // Only accept a list written for this hurricane and radar
+    QStringList fileParts=QFileInfo(_filePath).fileName().split("_");
+    QDomElement root = doc.documentElement();
+    if((fileParts.count() < 2) || (root.tagName() != "vortex")
+       || (root.firstChildElement("hurricane").text() != fileParts.at(0))
+       || (root.firstChildElement("radar").text() != fileParts.at(1)))
+        return false;
+
+    QList<SimplexData> records;
+    for(QDomElement element = root.firstChildElement("record"); !element.isNull();
+        element = element.nextSiblingElement("record")) {
+        QDateTime time = QDateTime::fromString(element.firstChildElement("time").text(),
+                                               "yyyy/MM/dd hh:mm:ss");
+        time.setTimeSpec(Qt::UTC);
+        if(!time.isValid())
+            return false;
+
+        // The dimensions come from the first level and ring
+        QDomNodeList levels = element.elementsByTagName("level");
+        int numLevels = levels.count();
+        QDomElement firstLevel = element.firstChildElement("level");
+        int numRadii = firstLevel.elementsByTagName("ring").count();
+        int numCenters = firstLevel.firstChildElement("ring").elementsByTagName("point_value").count();
+        if((numLevels > SimplexData::getMaxLevels()) || (numRadii > SimplexData::getMaxRadii())
+           || (numCenters > SimplexData::getMaxCenters()))
+            return false;
+
+        SimplexData *record = new SimplexData(numLevels, numRadii, numCenters);
+        record->setTime(time);
+        record->setNumPointsUsed(numCenters);
+
+        int hidx = 0;
+        for(QDomElement level = firstLevel; !level.isNull() && (hidx < numLevels);
+            level = level.nextSiblingElement("level"), hidx++) {
+            record->setHeight(hidx, level.attribute("height").toFloat());
+            int ridx = 0;
+            for(QDomElement ring = level.firstChildElement("ring"); !ring.isNull() && (ridx < numRadii);
+                ring = ring.nextSiblingElement("ring"), ridx++) {
+                record->setRadius(ridx, ring.attribute("range").toFloat());
+                QStringList mean = ring.firstChildElement("mean_value").text().split(",");
+                if(mean.count() != 4) {
+                    delete record;
+                    return false;
+                }
+                record->setMeanX(hidx, ridx, mean.at(0).trimmed().toFloat());
+                record->setMeanY(hidx, ridx, mean.at(1).trimmed().toFloat());
+                record->setCenterStdDev(hidx, ridx, mean.at(2).trimmed().toFloat());
+                record->setMaxVT(hidx, ridx, mean.at(3).trimmed().toFloat());
+
+                int pidx = 0;
+                int validCenters = 0;
+                for(QDomElement point = ring.firstChildElement("point_value");
+                    !point.isNull() && (pidx < numCenters);
+                    point = point.nextSiblingElement("point_value"), pidx++) {
+                    QStringList values = point.text().split(",");
+                    if(values.count() != 5) {
+                        delete record;
+                        return false;
+                    }
+                    float startX = values.at(0).trimmed().toFloat();
+                    float startY = values.at(1).trimmed().toFloat();
+                    Center center(startX, startY, values.at(2).trimmed().toFloat(),
+                                  values.at(3).trimmed().toFloat(), values.at(4).trimmed().toFloat(),
+                                  record->getHeight(hidx), record->getRadius(ridx));
+                    if(center.isValid())
+                        validCenters++;
+                    record->setCenter(hidx, ridx, pidx, center);
+                    record->setInitialX(hidx, ridx, pidx, startX);
+                    record->setInitialY(hidx, ridx, pidx, startY);
+                }
+                // Older lists did not record the converging centers
+                if(ring.hasAttribute("converging"))
+                    record->setNumConvergingCenters(hidx, ridx, ring.attribute("converging").toInt());
+                else
+                    record->setNumConvergingCenters(hidx, ridx, validCenters);
+            }
+        }
+        records.append(*record);
+        delete record;
+    }
+
+    clear();
+    append(records);
+    return true;
 }
 
 void SimplexList::timeSort()
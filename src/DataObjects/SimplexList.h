@@ -16,6 +16,9 @@
 #include <QList>
 #include "Config/Configuration.h"
 #include <QString>
+#include <QStringList>
+#include <QDataStream>
+#include "IO/ListJournal.h"
 
 class SimplexList : public QList<SimplexData>
 {
@@ -23,15 +26,39 @@ class SimplexList : public QList<SimplexData>
 public:
     SimplexList(QString filePath = QString());
     virtual ~SimplexList();
-    void setFilePath(QString filePath) {_filePath=filePath;}
+    void setFilePath(QString filePath);
     void timeSort();
+    // Rebuild the list from the snapshot and journal, or from the
+    // xml file if there is no usable snapshot
     bool restore();
+    // Writes the xml file
     bool saveXML();
+    // Writes the xml file and a snapshot of the whole list, and starts a
+    // new journal. For the end of a run.
+    bool saveAll();
+    // Appends the records added since the last save to the journal, and
+    // rewrites the xml file unless journaling is on. The snapshot is only
+    // written when the journal is compacted.
+    bool save();
+    // With journaling on the xml file is only rewritten on compaction
+    void setJournaling(bool journal);
 
     void dump() const;
     
 private:
     QString _filePath;
+    ListJournal _journal;
+    bool _journaling;
+
+    static QString recordKey(const SimplexData& record);
+    QString lastKey() const;
+    static void writeRecord(QDataStream& out, const SimplexData& record);
+    static bool readRecord(QDataStream& in, QList<SimplexData>& records);
+    bool saveSnapshot();
+    bool appendToJournal();
+    bool compact();
+    bool restoreSnapshot();
+    bool restoreXML();
 };
 
 #endif
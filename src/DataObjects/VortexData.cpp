@@ -19,6 +19,9 @@ constexpr float VortexData::_fillv;
 
 VortexData::VortexData()
 {
+    static_assert(MAXWAVENUM*2+3 == Coefficient::NumTerms,
+                  "every wavenumber needs its terms in Coefficient::Term");
+
     _numLevels = MAXLEVELS;
     _numRadii = MAXRADII;
     _numWaveNum = MAXWAVENUM;
@@ -91,12 +94,10 @@ VortexData::VortexData(const VortexData &other)
         this->_RMW[i] = other._RMW[i];
         this->_RMWUncertainty[i] = other._RMWUncertainty[i];
         this->_centerSD[i] = other._centerSD[i];
-        for(int j = 0; j < _numRadii; j++) {
-            for(int k = 0; k < _numWaveNum; k++) {
-                this->coefficients[i][j][k] = coefficients[i][j][k];
-            }
-        }
     }
+    this->_coeffValues = other._coeffValues;
+    this->_ringHeight = other._ringHeight;
+    this->_ringRadius = other._ringRadius;
 
     this->_time = other._time;
 
@@ -143,20 +144,98 @@ int VortexData::getHeightIndex(const float& height) const
     return closestIndex;
 }
 
-Coefficient VortexData::getCoefficient(const int& lev, const int& rad, 
-                                       const int& waveNum) const
+void VortexData::setNumLevels(const int& num)
+{
+    if((num < 0) || (num > MAXLEVELS))
+        return;
+    if(!_coeffValues.isEmpty())
+        resizeCoefficients(num, _numRadii);
+    _numLevels = num;
+}
+
+void VortexData::setNumRadii(const int& num)
+{
+    if((num < 0) || (num > MAXRADII))
+        return;
+    if(!_coeffValues.isEmpty())
+        resizeCoefficients(_numLevels, num);
+    _numRadii = num;
+}
+
+void VortexData::resizeCoefficients(int numLevels, int numRadii)
+{
+    // Keeps whatever falls inside the new dimensions
+    QVector<float> values(numLevels * numRadii * Coefficient::NumTerms, _fillv);
+    QVector<float> heights(numLevels * numRadii, _fillv);
+    QVector<float> radii(numLevels * numRadii, _fillv);
+    if(!_coeffValues.isEmpty()) {
+        for(int lev = 0; lev < qMin(numLevels, _numLevels); lev++) {
+            for(int rad = 0; rad < qMin(numRadii, _numRadii); rad++) {
+                int from = ringIndex(lev, rad);
+                int to = lev * numRadii + rad;
+                heights[to] = _ringHeight[from];
+                radii[to] = _ringRadius[from];
+                for(int term = 0; term < Coefficient::NumTerms; term++)
+                    values[to * Coefficient::NumTerms + term]
+                        = _coeffValues[from * Coefficient::NumTerms + term];
+            }
+        }
+    }
+    _coeffValues = values;
+    _ringHeight = heights;
+    _ringRadius = radii;
+}
+
+float VortexData::getCoefficientValue(int lev, int rad, Coefficient::Term term) const
+{
+    if(_coeffValues.isEmpty() || (lev < 0) || (lev >= _numLevels) || (rad < 0)
+       || (rad >= _numRadii) || (term < 0) || (term >= Coefficient::NumTerms))
+        return _fillv;
+    int ring = ringIndex(lev, rad);
+    if((_ringHeight[ring] == _fillv) || (_ringRadius[ring] == _fillv))
+        return _fillv;
+    return _coeffValues[ring * Coefficient::NumTerms + term];
+}
+
+// Ring index of a radius at a level, counted from the innermost ring
+// with a coefficient, or -1
+
+int VortexData::radiusIndex(int lev, const float& rad) const
+{
+    float minRad = _fillv;
+    if(!_coeffValues.isEmpty() && (_numRadii > 0))
+        minRad = _ringRadius[ringIndex(lev, 0)];
+    if(minRad == _fillv)
+        minRad = 0;
+    int radIndex = int(rad - minRad);
+    if((radIndex < 0) || (radIndex >= _numRadii))
+        return -1;
+    return radIndex;
+}
+
+float VortexData::getCoefficientValue(const float& height, const float& rad,
+                                      Coefficient::Term term) const
+{
+    int level = getHeightIndex(height);
+    if(level < 0)
+        return _fillv;
+    return getCoefficientValue(level, radiusIndex(level, rad), term);
+}
+
+Coefficient VortexData::getCoefficient(const int& lev, const int& rad,
+                                       Coefficient::Term term) const
 {
-    return coefficients[lev][rad][waveNum];
+    float value = getCoefficientValue(lev, rad, term);
+    if(value == _fillv)
+        return Coefficient();
+    int ring = ringIndex(lev, rad);
+    return Coefficient(_ringHeight[ring], _ringRadius[ring], value, term);
 }
 
 Coefficient VortexData::getCoefficient(const int& lev, const int& rad,
                                        const QString& parameter) const
 {
-    for(int i = 0; i < _numWaveNum; i++) {
-        if(coefficients[lev][rad][i].getParameter() == parameter)
-            return coefficients[lev][rad][i];
-    }
-    return Coefficient();
+    return getCoefficient(lev, rad, Coefficient::termFromName(parameter));
 }
 
 Coefficient VortexData::getCoefficient(const float& height, const int& rad,
@@ -175,21 +254,27 @@ Coefficient VortexData::getCoefficient(const float& height, const float& rad,
 {
     int level = getHeightIndex(height);
     if (level < 0) return Coefficient();
-    float minRad = getCoefficient(level, 0, parameter).getRadius();
-    if(minRad == -999)
-        minRad = 0;
-    int radIndex = int(rad - minRad);
-    if((level == -1) || (radIndex < 0 ) || (radIndex > _numRadii)) {
+    int radIndex = radiusIndex(level, rad);
+    if(radIndex < 0) {
         //Message::toScreen("VortexData: GetCoefficient(4): Can't Get Needed Indices: Level = "+QString().setNum(level)+" radIndex = "+QString().setNum(radIndex));
         return Coefficient();
     }
     return getCoefficient(level, radIndex, parameter);
 }
 
-void VortexData::setCoefficient(const int& lev, const int& rad, 
-                                const int& coeffNum, const Coefficient &coefficient)
+void VortexData::setCoefficient(const int& lev, const int& rad, const Coefficient &coefficient)
 {
-    coefficients[lev][rad][coeffNum] = coefficient;
+    Coefficient::Term term = coefficient.getTerm();
+    if((term == Coefficient::NoTerm) || (lev < 0) || (lev >= _numLevels)
+       || (rad < 0) || (rad >= _numRadii))
+        return;
+    if(_coeffValues.isEmpty())
+        resizeCoefficients(_numLevels, _numRadii);
+
+    int ring = ringIndex(lev, rad);
+    _ringHeight[ring] = coefficient.getLevel();
+    _ringRadius[ring] = coefficient.getRadius();
+    _coeffValues[ring * Coefficient::NumTerms + term] = coefficient.getValue();
 }
 
 bool VortexData::operator ==(const VortexData &other)
@@ -213,7 +298,9 @@ bool VortexData::operator > (const VortexData &other)
     return false;
 }
 
-// Append the vortex coefficients to a file
+// Append the vortex coefficients to a file. Each ring's terms are written
+// in Term order, so VTC1 comes before VTS1 whichever VTD produced them
+// (GBVTD runs used to list VTS1 first); readers go by the name column.
 
 void VortexData::saveCoefficients(QString &fname)
 {
@@ -221,17 +308,22 @@ void VortexData::saveCoefficients(QString &fname)
 
   outfile << "# Vortex time: " << getTime().toString("yyyy-MM-dd:hh:mm").toLatin1().data() << std::endl;
 
+    if(_coeffValues.isEmpty())
+      return;
+
     for(int lev = 0; lev < _numLevels; lev++)
-      for(int rad = 0; rad < _numRadii; rad++)
-	for(int wave = 0; wave < _numWaveNum; wave++) {
-	  Coefficient current = getCoefficient(lev, rad, wave);
-	  if(current.getValue() <= _fillv)
+      for(int rad = 0; rad < _numRadii; rad++) {
+	int ring = ringIndex(lev, rad);
+	for(int term = 0; term < Coefficient::NumTerms; term++) {
+	  float value = _coeffValues[ring * Coefficient::NumTerms + term];
+	  if(value <= _fillv)
 	    continue;
-	  outfile  << current.getLevel()
-		   << "," << current.getRadius()
-		   << "," << current.getParameter().toLatin1().data()
-		   << "," << current.getValue()
+	  outfile  << _ringHeight[ring]
+		   << "," << _ringRadius[ring]
+		   << "," << Coefficient::termName(term).toLatin1().data()
+		   << "," << value
 		   << std::endl;
 	}
+      }
     // file closed by the destructor.
 }
@@ -13,6 +13,7 @@
 
 #include "Coefficient.h"
 #include <QDateTime>
+#include <QVector>
 
 class VortexData
 {
@@ -83,11 +84,16 @@ public:
     inline void  setCenterStdDev(int index,float value) { if(index<_numLevels) _centerSD[index]=value; }
     inline void  setCenterStdDev(float a[],int howMany) { for(int i=0;i<howMany;i++) setCenterStdDev(i,a[i]); }
 
-    Coefficient getCoefficient(const int& lev, const int& rad,const int& waveNum) const;
+    // The coefficients are stored as values indexed by level, ring and
+    // Coefficient::Term. Copies share them until one of them is changed.
+    float getCoefficientValue(int lev, int rad, Coefficient::Term term) const;
+    float getCoefficientValue(const float& height, const float& rad, Coefficient::Term term) const;
+    Coefficient getCoefficient(const int& lev, const int& rad, Coefficient::Term term) const;
     Coefficient getCoefficient(const int& lev, const int& rad,const QString& parameter) const;
     Coefficient getCoefficient(const float& height, const int& rad,const QString& parameter) const;
     Coefficient getCoefficient(const float& height, const float& rad,const QString& parameter) const;
-    void	setCoefficient(const int& lev, const int& rad,const int& coeffNum, const Coefficient &coefficient);
+    // Stored under the term named by its parameter
+    void	setCoefficient(const int& lev, const int& rad, const Coefficient &coefficient);
     void	saveCoefficients(QString &fname);
 
     // void operator = (const VortexData &other);
@@ -99,8 +105,8 @@ public:
     inline int getNumRadii() const   { return _numRadii; }
     inline int getNumWaveNum() const { return _numWaveNum; }
 
-    inline void setNumLevels(const int& num)  { if(num <= MAXLEVELS)  _numLevels = num; }
-    inline void setNumRadii(const int& num)   { if(num <= MAXRADII)   _numRadii = num; }
+    void setNumLevels(const int& num);
+    void setNumRadii(const int& num);
     inline void setNumWaveNum(const int& num) { if(num <= MAXWAVENUM) _numWaveNum = num; }
 
     static int getMaxLevels()  { return MAXLEVELS; }
@@ -128,7 +134,16 @@ private:
     float _RMW[MAXLEVELS];
     float _RMWUncertainty[MAXLEVELS];
     float _centerSD[MAXLEVELS];
-    Coefficient coefficients[MAXLEVELS][MAXRADII][MAXWAVENUM*2+3];
+
+    // [level][ring][term] values and the [level][ring] height and radius
+    // they were found at. Empty until the first coefficient is set.
+    QVector<float> _coeffValues;
+    QVector<float> _ringHeight;
+    QVector<float> _ringRadius;
+
+    int ringIndex(int lev, int rad) const { return lev * _numRadii + rad; }
+    int radiusIndex(int lev, const float& rad) const;
+    void resizeCoefficients(int numLevels, int numRadii);
 
     QDateTime _time;
     float _maxValidRadius;
@@ -11,17 +11,21 @@
 
 #include <QDir>
 #include <QXmlStreamWriter>
+#include <QDomDocument>
 #include <QFile>
 #include <QStringList>
 #include <QString>
 #include <math.h>
 #include <iostream>
 #include "VortexList.h"
+#include "IO/ListSnapshot.h"
 
 
-VortexList::VortexList(QString filePath) : QList<VortexData>()
+VortexList::VortexList(QString filePath) : QList<VortexData>(), _journal("vortex")
 {
     _filePath = filePath;
+    _journal.setListFilePath(filePath);
+    _journaling = false;
 }
 
 VortexList::~VortexList()
@@ -64,17 +68,243 @@ bool VortexList::saveXML()
         xmlWriter.writeEndElement();
     }
     xmlWriter.writeEndElement();
+    file.close();
+
+    return true;
+}
+
+bool VortexList::save()
+{
+    bool ok = true;
+    if(!_journaling)
+        ok = saveXML();
+    return appendToJournal() && ok;
+}
+
+bool VortexList::saveAll()
+{
+    bool ok = saveXML();
+    return saveSnapshot() && ok;
+}
+
+bool VortexList::compact()
+{
+    bool ok = true;
+    if(_journaling)
+        ok = saveXML();
+    return saveSnapshot() && ok;
+}
+
+bool VortexList::appendToJournal()
+{
+    // Only records that were added since the last save are written,
+    // unless the journal has to start over from a snapshot
+    int saved = _journal.savedCount();
+    QString savedKey;
+    if((saved > 0) && (saved <= count()))
+        savedKey = recordKey(this->at(saved - 1));
+    int first = _journal.firstUnsaved(count(), savedKey);
+    if((first < 0) || _journal.needsCompaction())
+        return compact();
+    for(int ii = first; ii < count(); ii++) {
+        QDataStream* out = _journal.beginRecord();
+        if(out == NULL)
+            return compact();
+        writeRecord(*out, this->at(ii));
+        if(!_journal.commitRecord(recordKey(this->at(ii)))) {
+            std::cout<<"error: Cannot append to "<<_journal.getFilePath().toStdString()<<std::endl;
+            return compact();
+        }
+    }
+    return true;
+}
+
+void VortexList::setJournaling(bool journal)
+{
+    _journaling = journal;
+}
+
+QString VortexList::recordKey(const VortexData& record)
+{
+    return record.getTime().toString("yyyy-MM-ddThh:mm:ss.zzz");
+}
+
+QString VortexList::lastKey() const
+{
+    if(isEmpty())
+        return QString();
+    return recordKey(last());
+}
+
+// Everything but the coefficients, which go to the coefficient list
+
+void VortexList::writeRecord(QDataStream& out, const VortexData& record)
+{
+    out << record.getTime() << (qint32)record.getNumLevels() << (qint32)record.getNumRadii()
+        << (qint32)record.getNumWaveNum() << (qint32)record.getBestLevel();
+    for(int level = 0; level < record.getNumLevels(); level++) {
+        out << record.getLat(level) << record.getLon(level) << record.getHeight(level)
+            << record.getMaxVT(level) << record.getRMW(level)
+            << record.getRMWUncertainty(level) << record.getCenterStdDev(level);
+    }
+    out << record.getMaxValidRadius() << record.getAveRMW() << record.getAveRMWUncertainty()
+        << record.getPressure() << record.getPressureUncertainty()
+        << record.getPressureDeficit() << record.getDeficitUncertainty()
+        << record.getMaxSfcWind();
+}
+
+bool VortexList::readRecord(QDataStream& in, QList<VortexData>& records)
+{
+    QDateTime time;
+    qint32 numLevels, numRadii, numWaveNum, bestLevel;
+    in >> time >> numLevels >> numRadii >> numWaveNum >> bestLevel;
+    if((in.status() != QDataStream::Ok) || (numLevels < 0) || (numLevels > VortexData::getMaxLevels())
+       || (numRadii < 0) || (numRadii > VortexData::getMaxRadii())
+       || (numWaveNum < 0) || (numWaveNum > VortexData::getMaxWaveNum())
+       || (bestLevel < 0) || (bestLevel >= numLevels))
+        return false;
+
+    VortexData record(numLevels, numRadii, numWaveNum);
+    record.setTime(time);
+    record.setBestLevel(bestLevel);
+    for(int level = 0; level < numLevels; level++) {
+        float lat, lon, height, maxVT, rmw, rmwUncertainty, centerStdDev;
+        in >> lat >> lon >> height >> maxVT >> rmw >> rmwUncertainty >> centerStdDev;
+        record.setLat(level, lat);
+        record.setLon(level, lon);
+        record.setHeight(level, height);
+        record.setMaxVT(level, maxVT);
+        record.setRMW(level, rmw);
+        record.setRMWUncertainty(level, rmwUncertainty);
+        record.setCenterStdDev(level, centerStdDev);
+    }
+    float maxValidRadius, aveRMW, aveRMWUncertainty, pressure, pressureUncertainty;
+    float deficit, deficitUncertainty, maxSfcWind;
+    in >> maxValidRadius >> aveRMW >> aveRMWUncertainty >> pressure >> pressureUncertainty
+       >> deficit >> deficitUncertainty >> maxSfcWind;
+    record.setMaxValidRadius(maxValidRadius);
+    record.setAveRMW(aveRMW);
+    record.setAveRMWUncertainty(aveRMWUncertainty);
+    record.setPressure(pressure);
+    record.setPressureUncertainty(pressureUncertainty);
+    record.setPressureDeficit(deficit);
+    record.setDeficitUncertainty(deficitUncertainty);
+    record.setMaxSfcWind(maxSfcWind);
+    if(in.status() != QDataStream::Ok)
+        return false;
+    records.append(record);
     return true;
 }
 
+bool VortexList::saveSnapshot()
+{
+    ListSnapshot snapshot(_filePath, "vortex");
+    quint64 snapshotId = _journal.nextSnapshotId();
+    QDataStream* out = snapshot.beginWrite(count(), snapshotId);
+    if(out == NULL) {
+        std::cout<<"error: Cannot open file"<<snapshot.getFilePath().toStdString()<<std::endl;
+        return false;
+    }
+
+    for(int ii = 0; ii < count(); ii++)
+        writeRecord(*out, this->at(ii));
+    if(!snapshot.commit())
+        return false;
+    return _journal.snapshotSaved(snapshotId, count(), lastKey());
+}
+
 bool VortexList::restore()
 {
-    return false;
+    if(restoreSnapshot())
+        return true;
+    return restoreXML();
+}
+
+bool VortexList::restoreSnapshot()
+{
+    ListSnapshot snapshot(_filePath, "vortex");
+    int numRecords;
+    quint64 snapshotId;
+    QDataStream* in = snapshot.beginRead(numRecords, &snapshotId);
+    if(in == NULL)
+        return false;
+
+    QList<VortexData> records;
+    for(int ii = 0; ii < numRecords; ii++) {
+        if(!readRecord(*in, records))
+            return false;
+    }
+    if(!snapshot.readOk())
+        return false;
+
+    // Then the records saved since the snapshot
+    QList<QByteArray> entries;
+    _journal.readEntries(snapshotId, entries);
+    for(int ii = 0; ii < entries.count(); ii++) {
+        QDataStream entry(entries.at(ii));
+        ListJournal::prepareStream(entry);
+        if(!readRecord(entry, records))
+            return false;
+    }
+
+    clear();
+    append(records);
+    _journal.restored(snapshotId, count(), lastKey());
+    return true;
+}
+
+bool VortexList::restoreXML()
+{
+    QFile file(_filePath);
+    if(!file.open(QFile::ReadOnly|QFile::Text))
+        return false;
+    QDomDocument doc;
+    if(!doc.setContent(&file))
+        return false;
+    file.close();
+
+    // Only accept a list written for this hurricane and radar
+    QStringList fileParts=QFileInfo(_filePath).fileName().split("_");
+    QDomElement root = doc.documentElement();
+    if((fileParts.count() < 2) || (root.tagName() != "vortex")
+       || (root.firstChildElement("hurricane").text() != fileParts.at(0))
+       || (root.firstChildElement("radar").text() != fileParts.at(1)))
+        return false;
+
+    QList<VortexData> records;
+    for(QDomElement element = root.firstChildElement("record"); !element.isNull();
+        element = element.nextSiblingElement("record")) {
+        QDateTime time = QDateTime::fromString(element.firstChildElement("time").text(),
+                                               "yyyy/MM/dd hh:mm:ss");
+        time.setTimeSpec(Qt::UTC);
+        QStringList center = element.firstChildElement("center").text().split(",");
+        QStringList strength = element.firstChildElement("strength").text().split(",");
+        if(!time.isValid() || (center.count() != 3) || (strength.count() != 4))
+            return false;
+
+        // The xml only keeps the best level, store it as level 0
+        VortexData record(1, 1, 1);
+        record.setTime(time);
+        record.setBestLevel(0);
+        record.setLat(0, center.at(0).trimmed().toFloat());
+        record.setLon(0, center.at(1).trimmed().toFloat());
+        record.setHeight(0, center.at(2).trimmed().toFloat());
+        record.setMaxVT(0, strength.at(0).trimmed().toFloat());
+        record.setRMW(0, strength.at(1).trimmed().toFloat());
+        record.setPressure(strength.at(2).trimmed().toFloat());
+        record.setPressureDeficit(strength.at(3).trimmed().toFloat());
+        records.append(record);
+    }
+
+    clear();
+    append(records);
+    return true;
 }
 
 void VortexList::setFilePath(QString newFileName)
 {
     _filePath = newFileName;
+    _journal.setListFilePath(newFileName);
 }
 
 
@@ -13,7 +13,10 @@
 #define VORTEXLIST_H
 
 #include <QList>
+#include <QStringList>
+#include <QDataStream>
 #include "DataObjects/VortexData.h"
+#include "IO/ListJournal.h"
 
 class QString;
 
@@ -24,13 +27,37 @@ public:
      VortexList(QString filePath = QString());
      virtual ~VortexList();
      
+     // Writes the xml file
      bool saveXML();
+     // Writes the xml file and a snapshot of the whole list, and starts a
+     // new journal. For the end of a run.
+     bool saveAll();
+     // Appends the records added since the last save to the journal, and
+     // rewrites the xml file unless journaling is on. The snapshot is only
+     // written when the journal is compacted.
+     bool save();
+     // With journaling on the xml file is only rewritten on compaction
+     void setJournaling(bool journal);
+     // Rebuild the list from the snapshot and journal, or from the
+     // xml file if there is no usable snapshot (best level only)
      bool restore();
      void setFilePath(QString filePath);
      void timeSort();
 
 private:
      QString _filePath;
+     ListJournal _journal;
+     bool _journaling;
+
+     static QString recordKey(const VortexData& record);
+     QString lastKey() const;
+     static void writeRecord(QDataStream& out, const VortexData& record);
+     static bool readRecord(QDataStream& in, QList<VortexData>& records);
+     bool saveSnapshot();
+     bool appendToJournal();
+     bool compact();
+     bool restoreSnapshot();
+     bool restoreXML();
 };
 
 #endif
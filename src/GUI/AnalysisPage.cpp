@@ -557,7 +557,7 @@ void AnalysisPage::runThread()
 
     connect(pollThread, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
     connect(pollThread, SIGNAL(newVCP(const int)),diagPanel, SLOT(updateVCP(const int)));
-    connect(pollThread, SIGNAL(newCappi(GriddedData)),cappiDisplay, SLOT(constructImage(GriddedData)),Qt::DirectConnection);
+    connect(pollThread, SIGNAL(newCappi(CappiSnapshot)),cappiDisplay, SLOT(constructImage(CappiSnapshot)),Qt::QueuedConnection);
 
     connect(pollThread, SIGNAL(newCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),
             this, SLOT(updateCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),Qt::DirectConnection);
@@ -587,12 +587,17 @@ void AnalysisPage::runThread()
     QStringList allPossibleFiles = workingDirectory.entryList(QDir::Files);
     allPossibleFiles = allPossibleFiles.filter(nameFilter, Qt::CaseInsensitive);
     bool continuePreviousRun = false;
-    QString openOldMessage = QString(tr("Vortrac has found information about a previous run. Continuing will erase this data!\nPress 'Yes' to continue."));
+    QString openOldMessage = QString(tr("Vortrac has found information about a previous run.\nPress 'Yes' to resume it, 'No' to start over and erase this data."));
     if(allPossibleFiles.count()> 0){
-        if(allPossibleFiles.filter("vortexList").count()>0 && allPossibleFiles.filter("simplexList").count()>0)
+        if(allPossibleFiles.filter("vortexlist", Qt::CaseInsensitive).count()>0
+           && allPossibleFiles.filter("simplexlist", Qt::CaseInsensitive).count()>0)
         {
-            int answer = QMessageBox::information(this,tr("VORTRAC"),openOldMessage,3,4,0);
-            if(answer==3) {
+            int answer = QMessageBox::question(this,tr("VORTRAC"),openOldMessage,
+                                               QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel,
+                                               QMessageBox::Yes);
+            if(answer == QMessageBox::Yes) {
+                continuePreviousRun = true;
+            } else if(answer == QMessageBox::No) {
                 continuePreviousRun = false;
             } else {
                 return;
@@ -600,6 +605,7 @@ void AnalysisPage::runThread()
         }
     }
     //set a flag in pollThread if continue previous run or not
+    pollThread->setContinuePreviousRun(continuePreviousRun);
 	// Try to fetch new radar data every 5 minutes
     QString mode = configData->getParam(configData->getConfig("vortex"), "mode");
     if (mode == "operational") {
@@ -619,7 +625,6 @@ void AnalysisPage::runThread()
         madisTimer->start(1800000);
         
 	} else {
-        pollThread->setContinuePreviousRun(continuePreviousRun);
         pollThread->setConfig(configData);
         thread->start();
     }
@@ -662,7 +667,6 @@ void AnalysisPage::updateTcvitals()
         return;
     }
     if (!thread->isRunning()) {
-        pollThread->setContinuePreviousRun(false);
         pollThread->setConfig(configData);
         thread->start();
     }
@@ -36,6 +36,7 @@ CappiDisplay::CappiDisplay(QWidget *parent)
 
     displayLevel = -1;  // default level comes from cappi, unless overwritten here.
     contourIncr = 1;
+    minValue = 0;
     
     //Set the palette
     imageHolder.lock();
@@ -87,6 +88,7 @@ CappiDisplay::CappiDisplay(QWidget *parent)
     image.setColor(42, qRgb((int)(.949*255), (int)(.273*255), (int)(.355*255)));
     image.setColor(43, qRgb((int)(1.000*255), (int)(.012*255), (int)(.000*255)));
     
+    palette = image.colorTable();
     imageHolder.unlock();
 
     hasGBVTDInfo = false;
@@ -130,8 +132,8 @@ void CappiDisplay::clearImage()
     imageHolder.lock();
     image.fill(qRgb(0,0,0));
     legendImage.fill(qRgb(0,0,0));
-    image = image.scaled((int)500,(int)500);
-    legendImage = legendImage.scaled(70,500);
+    image = image.scaled(displaySize,displaySize);
+    legendImage = legendImage.scaled(70,displaySize);
     this->setMinimumSize(QSize(int(image.size().width()*1.2),int(image.size().height())));
     this->resize(this->minimumSize());
     imageHolder.unlock();
@@ -145,26 +147,26 @@ void CappiDisplay::clearImage()
 // Print a line showing grid coordinates, and lat and lon at that point.
 // This can be used for debugging (to copyt/paste a location for example)
 
-// Currently we have a 500x500 grid, which has nothing to do with the Cappi grid.
+// Currently we have a displaySize square image, which has nothing to do with the Cappi grid.
 // In the future we might make this configurable in the config file.
 
 void CappiDisplay::mousePressEvent(QMouseEvent *event)
 {
-    if (event->button() == Qt::LeftButton) {
+    if ((event->button() == Qt::LeftButton) && hasCappi) {
         lastPoint = event->pos();
 
 	// Display origin is at the top left. Cappi origin is at the radar.
 
 	// Map the point to the grid:
-	float click_x = lastPoint.x() * currentCappi.getIdim() / 500;
-	float click_y = (500 - lastPoint.y()) * currentCappi.getJdim() / 500;
+	float click_x = lastPoint.x() * currentCappi->getIdim() / displaySize;
+	float click_y = (displaySize - lastPoint.y()) * currentCappi->getJdim() / displaySize;
 	
-	int x = currentCappi.getCartesianPointFromIndexI(click_x);
-	// int y = currentCappi.getCartesianPointFromIndexJ(currentCappi.getJdim() - lastPoint.y());
-	int y = currentCappi.getCartesianPointFromIndexJ(click_y);
+	int x = currentCappi->getCartesianPointFromIndexI(click_x);
+	// int y = currentCappi->getCartesianPointFromIndexJ(currentCappi->getJdim() - lastPoint.y());
+	int y = currentCappi->getCartesianPointFromIndexJ(click_y);
 
-	float *coords = currentCappi.getAdjustedLatLon(currentCappi.getOriginLat(),
-						       currentCappi.getOriginLon(),
+	float *coords = currentCappi->getAdjustedLatLon(currentCappi->getOriginLat(),
+						       currentCappi->getOriginLon(),
 						       x, y);
 	// coords[0] -> Lon
 	// coords[1] -> Lat
@@ -184,18 +186,20 @@ void CappiDisplay::mousePressEvent(QMouseEvent *event)
 void CappiDisplay::mouseMoveEvent(QMouseEvent *event)
 {
   lastPoint = event->pos();
+  if (!hasCappi)
+    return;
 
   // Map the point to the grid:
   // Display origin is at the top left. Cappi origin is at the radar.
 
-  float click_x = lastPoint.x() * currentCappi.getIdim() / 500;
-  float click_y = (500 - lastPoint.y()) * currentCappi.getJdim() / 500;
+  float click_x = lastPoint.x() * currentCappi->getIdim() / displaySize;
+  float click_y = (displaySize - lastPoint.y()) * currentCappi->getJdim() / displaySize;
 	
-  int x = currentCappi.getCartesianPointFromIndexI(click_x);
-  int y = currentCappi.getCartesianPointFromIndexJ(click_y);
+  int x = currentCappi->getCartesianPointFromIndexI(click_x);
+  int y = currentCappi->getCartesianPointFromIndexJ(click_y);
   
-  float *coords = currentCappi.getAdjustedLatLon(currentCappi.getOriginLat(),
-						 currentCappi.getOriginLon(),
+  float *coords = currentCappi->getAdjustedLatLon(currentCappi->getOriginLat(),
+						 currentCappi->getOriginLon(),
 						 x, y);
 
   QToolTip::showText(event->globalPos(),
@@ -247,7 +251,7 @@ void CappiDisplay::paintEvent(QPaintEvent * /* event */)
 
     painter.save();
     
-    if(hasGBVTDInfo) {
+    if(hasGBVTDInfo && hasCappi) {
         // Given the relevant GBVTD and config parameters
         // Draw an X (small hurricane symbol?) at (x, y) to mark
         // GBVTD center
@@ -262,11 +266,11 @@ void CappiDisplay::paintEvent(QPaintEvent * /* event */)
 	// Draw a small X at the radar
 	float zero = 0.0;
 
-	int radX = (int) currentCappi.getIndexFromCartesianPointI(zero);
-	int radY = (int) currentCappi.getIndexFromCartesianPointJ(zero);
+	int radX = (int) currentCappi->getIndexFromCartesianPointI(zero);
+	int radY = (int) currentCappi->getIndexFromCartesianPointJ(zero);
 	
 	// Display origin is top left corner. Cappi origin is bottom left. Adjust radY accordingly
-	// radY = currentCappi.getJdim() - radY;
+	// radY = currentCappi->getJdim() - radY;
 #if 0
 	radY = 500 - radY;
 
@@ -345,36 +349,36 @@ void CappiDisplay::resizeImage(QImage *image, const QSize &newSize)
     imageHolder.unlock();
 }
 
-void CappiDisplay::constructImage(const GriddedData& cappi)
+void CappiDisplay::constructImage(const CappiSnapshot& cappi)
 {
     // Fill the pixmap with data from the cappi
     currentCappi = cappi;
     hasCappi = true;
     imageHolder.lock();
     //hasGBVTDInfo = false;
-    image.fill(qRgb(255, 255, 255));
-    iDim = (int)cappi.getIdim();
-    jDim = (int)cappi.getJdim();
-    QSize cappiSize((int)iDim,(int)jDim);
-    image = image.scaled(cappiSize);
+    iDim = (int)cappi->getIdim();
+    jDim = (int)cappi->getJdim();
 
     // Get the minimum and maximum Doppler velocities
     maxVel = -9999;
     minVel= 9999;
     
-    float k = getDisplayLevel();
+    int k = getDisplayLevel();
+    float kIndex = k;
+    const FieldGrid& grid = cappi->getFieldGrid();
+    bool haveLevel = (k >= 0) and (k < grid.getKDim());
+    int velIndex = cappi->getFieldIndex("ve");
+    bool haveVel = haveLevel and (velIndex >= 0) and (velIndex < grid.getNumFields());
       
-    QString velfield("ve");
-    QString dbzfield("dz");
     QString heightfield("ht");
     float minI, maxI, minJ, maxJ;
     if(hasGBVTDInfo) {
         float xIndex = xPercent*iDim;
         float yIndex = yPercent*jDim;
-        minI = xIndex-(simplexMax*iDim*cappi.getIGridsp());
-        maxI = xIndex+(simplexMax*iDim*cappi.getIGridsp());
-        minJ = yIndex-(simplexMax*iDim*cappi.getJGridsp());
-        maxJ = yIndex+(simplexMax*iDim*cappi.getJGridsp());
+        minI = xIndex-(simplexMax*iDim*cappi->getIGridsp());
+        maxI = xIndex+(simplexMax*iDim*cappi->getIGridsp());
+        minJ = yIndex-(simplexMax*iDim*cappi->getJGridsp());
+        maxJ = yIndex+(simplexMax*iDim*cappi->getJGridsp());
         if (minI < 0) minI = 0;
         if (maxI > iDim) maxI = iDim;
         if (minJ < 0) minJ = 0;
@@ -389,9 +393,9 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
     float maxAppYindex = -999.0;
     float maxRecXindex = -999.0;
     float maxRecYindex = -999.0;
-    for (float i = minI; i < maxI; i++) {
+    for (float i = minI; haveVel && (i < maxI); i++) {
         for (float j = minJ; j < maxJ; j++) {
-            float vel = cappi.getIndexValue(velfield,i,j,k);
+            float vel = grid(velIndex,(int)i,(int)j,k);
             if (vel != -999) {
 	        vel *= 1.9438445;
                 if (vel > maxVel) {
@@ -430,9 +434,9 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
         }
         
         if ((maxAppXindex != -999.0) and (maxAppYindex != -999.0)) {
-            heightMaxApp = cappi.getIndexValue(heightfield,maxAppXindex,maxAppYindex,k);
-            float cartI = cappi.getCartesianPointFromIndexI(maxAppXindex);
-            float cartJ = cappi.getCartesianPointFromIndexJ(maxAppYindex);
+            heightMaxApp = cappi->getIndexValue(heightfield,maxAppXindex,maxAppYindex,kIndex);
+            float cartI = cappi->getCartesianPointFromIndexI(maxAppXindex);
+            float cartJ = cappi->getCartesianPointFromIndexJ(maxAppYindex);
             distMaxApp = sqrt(cartI*cartI + cartJ*cartJ);
             dirMaxApp = atan2(cartJ,cartI)*57.2957795130823;
             dirMaxApp = 450.0 - dirMaxApp;
@@ -443,9 +447,9 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
             heightMaxApp = distMaxApp = dirMaxApp = -999.0;
         }
         if ((maxRecXindex != -999.0) and (maxRecYindex != -999.0)) {
-            heightMaxRec = cappi.getIndexValue(heightfield,maxRecXindex,maxRecYindex,k);
-            float cartI = cappi.getCartesianPointFromIndexI(maxRecXindex);
-            float cartJ = cappi.getCartesianPointFromIndexJ(maxRecYindex);
+            heightMaxRec = cappi->getIndexValue(heightfield,maxRecXindex,maxRecYindex,kIndex);
+            float cartI = cappi->getCartesianPointFromIndexI(maxRecXindex);
+            float cartJ = cappi->getCartesianPointFromIndexJ(maxRecYindex);
             distMaxRec = sqrt(cartI*cartI + cartJ*cartJ);
             dirMaxRec = atan2(cartJ,cartI)*57.2957795130823;
             dirMaxRec = 450.0 - dirMaxRec;
@@ -457,47 +461,23 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
         }
     }
     //Message::toScreen("maxVel is "+QString().setNum(maxVel)+" minVel is "+QString().setNum(minVel));
-    QString field;
-    float minValue;
     if (displayType == velocity) {
         contourIncr = velRange/41;
-        field = velfield;
         minValue = minVel;
     } else if (displayType == reflectivity) {
         contourIncr = 1.5;
-        field = dbzfield;
         minValue = -11.5;
     }
-    // Set each pixel color scaled to the max and min ranges
-    for (float i = 0; i < iDim; i++) {
-        for (float j = 0; j < jDim; j++) {
-            float value = cappi.getIndexValue(field,i,j,k);
-            int color = 1;
-            if (value == -999) {
-                color = 0;
-            } else {
-				if (displayType == velocity) value *= 1.9438445;				
-                color = (int)((value - minValue)/contourIncr) + 2;
-                if ((color < 0) or (color > 43)) {
-                    // Bad color
-                    color = 1;
-                }
-            }
-            int x = (int)i;
-            int y = (int)(jDim-j-1);
-            if (image.valid(x,y)) {
-                image.setPixel(x,y,color);
-            }
-        }
-    }
 
-    // TODO
-    // Support the ability to have different image size on the config.
-    // image = image.scaled((int)iDim,(int)jDim);
-    
-    image = image.scaled((int)500,(int)500);
+    // Draw straight at the size shown rather than at the grid size. The
+    // window stays at displaySize; <image_size> only sets the size of the
+    // images batch runs save through renderToFile.
+    if (image.size() != QSize(displaySize, displaySize))
+        image = QImage(displaySize, displaySize, QImage::Format_Indexed8);
+    image.setColorTable(palette);
+    renderLevel(*cappi, displayField(*cappi), k, image);
     
-    legendImage = legendImage.scaled(70,500);
+    legendImage = legendImage.scaled(70,displaySize);
     legendImage.fill(qRgb(backColor.red(),backColor.green(),backColor.blue()));
 
     this->setMinimumSize(QSize(int(image.size().width()*1.2),int(image.size().height())));
@@ -506,6 +486,79 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
     update();
 }
 
+int CappiDisplay::displayField(const GriddedData& cappi) const
+{
+    if (displayType == reflectivity)
+        return cappi.getFieldIndex("dz");
+    return cappi.getFieldIndex("ve");
+}
+
+void CappiDisplay::renderLevel(const GriddedData& cappi, int field, int k,
+                               QImage& target) const
+{
+    // Set each pixel color scaled to the max and min ranges. Pixels take
+    // the nearest grid cell, so the grid is sampled once per pixel of the
+    // target instead of being drawn in full and scaled afterwards.
+    const FieldGrid& grid = cappi.getFieldGrid();
+    int width = target.width();
+    int height = target.height();
+    int nI = grid.getIDim();
+    int nJ = grid.getJDim();
+    if ((field < 0) or (field >= grid.getNumFields()) or (k < 0) or (k >= grid.getKDim())
+        or (nI <= 0) or (nJ <= 0)) {
+        target.fill(0);
+        return;
+    }
+
+    // Offset of the cell under each column of pixels, and the color index
+    // as a single multiply and add of the value
+    QVector<size_t> iOffset(width);
+    for (int x = 0; x < width; x++) {
+        int i = (int)(((float)x + 0.5) * nI / width);
+        if (i >= nI) i = nI - 1;
+        iOffset[x] = (size_t)i * grid.getIStride();
+    }
+    float valueScale = 1.0 / contourIncr;
+    if (displayType == velocity) valueScale *= 1.9438445;
+    float valueOffset = minValue / contourIncr;
+
+    const float* level = grid.fieldData(field) + k;
+    for (int y = 0; y < height; y++) {
+        // Image rows run from the top, grid rows from the bottom
+        int j = nJ - 1 - (int)(((float)y + 0.5) * nJ / height);
+        if (j < 0) j = 0;
+        const float* row = level + (size_t)j * grid.getJStride();
+        uchar* line = target.scanLine(y);
+        for (int x = 0; x < width; x++) {
+            float value = row[iOffset[x]];
+            uchar color = 1;
+            if (value == -999) {
+                color = 0;
+            } else {
+                int index = (int)(value * valueScale - valueOffset) + 2;
+                if ((index >= 0) and (index <= 43))
+                    color = (uchar)index;
+            }
+            line[x] = color;
+        }
+    }
+}
+
+bool CappiDisplay::renderToFile(const QString& fileName, int width, int height)
+{
+    // Draws the last CAPPI with the current colors into an image of its
+    // own, leaving the display alone. Works without a window, so batch
+    // runs can keep a picture of each volume.
+    if (!hasCappi || (width <= 0) || (height <= 0))
+        return false;
+    QImage offScreen(width, height, QImage::Format_Indexed8);
+    imageHolder.lock();
+    offScreen.setColorTable(palette);
+    renderLevel(*currentCappi, displayField(*currentCappi), getDisplayLevel(), offScreen);
+    imageHolder.unlock();
+    return offScreen.save(fileName, "PNG");
+}
+
 // If level was overwritten from the GUI, return that.
 // Otherwise, ask the cappi what level to use
 
@@ -513,7 +566,7 @@ int CappiDisplay::getDisplayLevel()
 {
   if (displayLevel >= 0)
     return displayLevel;
-  return currentCappi.getDisplayKIndex();
+  return currentCappi->getDisplayKIndex();
 }
 
 void CappiDisplay::levelChanged(int level)
@@ -29,6 +29,8 @@ public:
 
     bool openImage(const QString &fileName);
     bool saveImage(const QString &fileName, const char *fileFormat);
+    // Off screen PNG of the current CAPPI at any size
+    bool renderToFile(const QString &fileName, int width, int height);
 
     float getMaxRec() { return maxRec; }
     float getMaxRecHeight() { return heightMaxRec; }
@@ -42,7 +44,7 @@ public:
     
 public slots:
     void clearImage();
-    void constructImage(const GriddedData& cappi);
+    void constructImage(const CappiSnapshot& cappi);
     void setGBVTDResults(float x, float y,float rmwEstimate, float sMin, float sMax, float vMax,
                          float userlat, float userlon,float lat, float lon);
     void toggleRadarDisplay();
@@ -60,6 +62,12 @@ protected:
 private:
     void resizeImage(QImage *image, const QSize &newSize);
     int getDisplayLevel();
+    int displayField(const GriddedData& cappi) const;
+    // Colors level k of field into target, sampling one cell per pixel
+    void renderLevel(const GriddedData& cappi, int field, int k, QImage& target) const;
+    // Side of the square CAPPI image, in pixels
+    static const int displaySize = 500;
+    QVector<QRgb> palette;
     QString cappiLabel;
     QImage image;
     QMutex imageHolder;
@@ -73,6 +81,7 @@ private:
     float maxVel;
     float minVel;
     float contourIncr;
+    float minValue;
     bool hasGBVTDInfo;
     bool hasCappi;
     float xPercent, yPercent;
@@ -87,7 +96,7 @@ private:
         spectrumWidth
     };
     int displayType;
-    GriddedData currentCappi;
+    CappiSnapshot currentCappi;
     float heightMaxApp, heightMaxRec;
     float distMaxApp, distMaxRec;
     float dirMaxApp, dirMaxRec;
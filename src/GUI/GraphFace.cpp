@@ -21,6 +21,35 @@
 
 #include "GraphFace.h"
 
+GraphPoint::GraphPoint()
+{
+  pressure = pressureUncertainty = 0;
+  deficit = deficitUncertainty = 0;
+  rmw = rmwUncertainty = 0;
+}
+
+GraphPoint::GraphPoint(const VortexData& d)
+{
+  time = d.getTime();
+  pressure = d.getPressure();
+  pressureUncertainty = d.getPressureUncertainty();
+  deficit = d.getPressureDeficit();
+  deficitUncertainty = d.getDeficitUncertainty();
+  rmw = d.getAveRMWnm();
+  rmwUncertainty = d.getAveRMWUncertaintynm();
+}
+
+bool GraphPoint::operator==(const GraphPoint& other) const
+{
+  return (time == other.time)
+    && (pressure == other.pressure)
+    && (pressureUncertainty == other.pressureUncertainty)
+    && (deficit == other.deficit)
+    && (deficitUncertainty == other.deficitUncertainty)
+    && (rmw == other.rmw)
+    && (rmwUncertainty == other.rmwUncertainty);
+}
+
 GraphFace::GraphFace(QWidget *parent, const QString& title)
   : QWidget(parent)
   //constructor to create the GraphFace object
@@ -66,6 +95,7 @@ GraphFace::GraphFace(QWidget *parent, const QString& title)
   last = QDateTime();
   
   imageAltered = true;
+  drawnPoints = 0;
   showPressure = true;
 
   image = new QImage(graph_width+LEFT_MARGIN_WIDTH+RIGHT_MARGIN_WIDTH,graph_height+TOP_MARGIN_HEIGHT+BOTTOM_MARGIN_HEIGHT,QImage::Format_ARGB32_Premultiplied);
@@ -114,44 +144,52 @@ void GraphFace::paintEvent(QPaintEvent *event)
   // paintEvent is called when the widget is first created, 
   // and any time update is called
 
+  // The graph is kept in image. It is redrawn when the axes or the size
+  // change, otherwise only the points that arrived since are added to it.
+
 {
   
   QPainter *painter = new QPainter(this);
 
   if (imageAltered) {
     imageAltered = false;
-    updateImage(painter);
-    QBrush myBackground = painter->background();
-    if (painter->isActive())
-      painter->end();
-    
-    delete painter;
-    
-    // Now update the image too...  
+    background = painter->background();
     
     QPainter* imagePainter = new QPainter(image);
-    imagePainter->setBackground(myBackground);
+    imagePainter->setBackground(background);
     imagePainter->fillRect(QRectF(QPointF(0,0),image->size()),
-			 myBackground);
+			 background);
     updateImage(imagePainter);
     
     if (imagePainter->isActive())
       imagePainter->end();
     
     delete imagePainter;
+    drawnPoints = points.count();
     
-  } else {
-    painter->drawImage(QPoint(0,0), *image);
-    resize(this->size());
-      
-    //Message::toScreen("Repaint Event");
-  
-    if (painter->isActive())
-      painter->end();
+  } else if (drawnPoints < points.count()) {
+    
+    QPainter* imagePainter = new QPainter(image);
+    imagePainter->setBackground(background);
+    imagePainter->setBackgroundMode(Qt::OpaqueMode);
+    imagePainter->setRenderHint(QPainter::Antialiasing);
+    imagePainter->translate(LEFT_MARGIN_WIDTH,TOP_MARGIN_HEIGHT+graph_height);
+    drawPoints(imagePainter, drawnPoints);
     
-    delete painter;
+    if (imagePainter->isActive())
+      imagePainter->end();
+    
+    delete imagePainter;
+    drawnPoints = points.count();
   }
 
+  painter->drawImage(QPoint(0,0), *image);
+  
+  if (painter->isActive())
+    painter->end();
+  
+  delete painter;
+
   event->accept();
 
 }
@@ -173,8 +211,8 @@ bool GraphFace::event(QEvent *e)
     if(index != -1) {
       if(ONDropSonde) {
 	// Drop Sonde Measurement
-	measurement.setNum(dropList->value(index).getPressure());
-	time = dropList->value(index).getTime().toString("dd-hh:mm");
+	measurement.setNum(dropPoints[index].pressure);
+	time = dropPoints[index].time.toString("dd-hh:mm");
 	QString message("DropWindSonde\nPressure = "
 			+ measurement + " mb\n" + time);
 	QToolTip::showText(find->globalPos(), message, this);
@@ -182,8 +220,8 @@ bool GraphFace::event(QEvent *e)
       else {
 	if ((unScalePressure(find->y()) > (pGMin)) && showPressure) {
 	  // Pressure Point
-	  measurement.setNum(VortexDataList->value(index).getPressure(), 'f', 0);
-	  time = VortexDataList->value(index).getTime().toString("dd-hh:mm");
+	  measurement.setNum(points[index].pressure, 'f', 0);
+	  time = points[index].time.toString("dd-hh:mm");
 	  QString message("Pressure Estimate\nPressure = "
 			  + measurement + " mb\n"+ time);
 	  //			  +"\nClick For More Info...");
@@ -192,8 +230,8 @@ bool GraphFace::event(QEvent *e)
 	else {
 	  if((unScaleDeficit(find->y()) > (dGMin)) && !showPressure) {
 	    // Deficit Point
-	    measurement.setNum(VortexDataList->value(index).getPressureDeficit());
-	    time = VortexDataList->value(index).getTime().toString("dd-hh:mm");
+	    measurement.setNum(points[index].deficit);
+	    time = points[index].time.toString("dd-hh:mm");
 	    QString message("Pressure Deficit Estimate\nPressure Deficit = "
 			    + measurement +" mb\n"+ time);
 	    //              + "\nClick For More Info...");
@@ -201,8 +239,8 @@ bool GraphFace::event(QEvent *e)
 	  }
 	  else {
 	    // RMW Point
-	    measurement.setNum(VortexDataList->value(index).getAveRMWnm(), 'f', 0);
-	    time = VortexDataList->value(index).getTime().toString("dd-hh:mm");
+	    measurement.setNum(points[index].rmw, 'f', 0);
+	    time = points[index].time.toString("dd-hh:mm");
 	    QString message("Radius of Maximum Wind Estimate\nRMW = "
 			    +measurement+" nm\n"+time);
 	    QToolTip::showText(find->globalPos(), message , this);
@@ -307,6 +345,8 @@ void GraphFace::newInfo(VortexList* gList)
 { 
   if(gList==NULL){
     VortexDataList = NULL;
+    points.clear();
+    drawnPoints = 0;
     
     // Reset all member variables
     rmwMax = 0; autoRmwMax = 0;
@@ -333,32 +373,37 @@ void GraphFace::newInfo(VortexList* gList)
   gList->timeSort();
   if(first.isNull()) 
     first = gList->at(0).getTime();
-   
-  for(int i = 0; i < gList->count(); i++) {
-    VortexData new_point = gList->value(i);
- 
-    checkPressure(&new_point);
-    checkDeficit(&new_point);
-    checkRmw(&new_point);
-    checkRanges();
-    
-    // set time range as the number of seconds between the time of the first 
-    // point and the time of this point
-    if(last == QDateTime()) {
-      if(first.secsTo(new_point.getTime())> timeRange){
-	timeRange = first.secsTo(new_point.getTime());
-      }
-    }
-    else {
-      timeRange = first.secsTo(last);
-    }
+
+  // Usually the list only grew by a volume, so only the points past the
+  // ones already cached have to be checked and drawn. If any earlier
+  // point changed the cache and the image are made again.
+  QVector<GraphPoint> listPoints;
+  listPoints.reserve(gList->count());
+  for(int i = 0; i < gList->count(); i++)
+    listPoints.append(GraphPoint(gList->at(i)));
+
+  int start = points.count();
+  if((listPoints.count() < start) || (listPoints.mid(0, start) != points)) {
+    start = 0;
+    imageAltered = true;
+  }
+  QVector<float> oldScale = axisScale();
   
-    if (timeRange == 0)
-      timeRange = 60;
+  for(int i = start; i < listPoints.count(); i++) {
+    checkPressure(listPoints[i]);
+    checkDeficit(listPoints[i]);
+    checkRmw(listPoints[i]);
   }
+  points = listPoints;
   VortexDataList = NULL;     // TODO ??
   VortexDataList = gList;
-  imageAltered = true;
+  
+  checkRanges();
+  if (timeRange == 0)
+    timeRange = 60;
+  
+  if(axisScale() != oldScale)
+    imageAltered = true;
   emit update(); 
   
   return;
@@ -371,19 +416,15 @@ void GraphFace::newDropSonde(VortexList* dropPointer)
   // Checks the Drop Wind Sonde pressure values to make sure they don't 
   // change the range
 {
-  VortexData new_drop = dropPointer->last(); 
-  checkPressure(&new_drop);
-  checkDeficit(&new_drop);
+  GraphPoint new_drop(dropPointer->last()); 
+  checkPressure(new_drop);
+  checkDeficit(new_drop);
+
+  dropPoints.clear();
+  dropPoints.reserve(dropPointer->count());
+  for(int i = 0; i < dropPointer->count(); i++)
+    dropPoints.append(GraphPoint(dropPointer->at(i)));
   checkRanges();
-
-  if(last == QDateTime()) {
-    if(first.secsTo(new_drop.getTime())> timeRange){
-      timeRange = first.secsTo(new_drop.getTime());
-    }
-  }
-  else {
-    timeRange = first.secsTo(last);
-  }
   
   dropList = NULL;
   dropList = dropPointer;  
@@ -412,8 +453,8 @@ void GraphFace::manualAxes(const QString& name, const bool change)
       deficitMin = autoDeficitMin;
       dGMax = autoDGMax;
       deficitMax = autoDeficitMax;
-      if((VortexDataList!=NULL)&&(VortexDataList->count() > 0)) 
-	first = VortexDataList->at(0).getTime();
+      if(!points.isEmpty()) 
+	first = points.first().time;
       else
 	first = QDateTime();
       last = QDateTime();
@@ -699,38 +740,42 @@ void GraphFace::checkRanges()
     }
   }
   else {
-    if((!first.isNull())&&(VortexDataList!=NULL)&&(VortexDataList->count()>0)){
-      QDateTime tempLast = VortexDataList->at(VortexDataList->count()-1).getTime();
-      for(int i = 0; i < VortexDataList->count()-1; i++) {
-	if(VortexDataList->at(i).getTime() > tempLast)
-	  tempLast = VortexDataList->at(i).getTime();
+    QDateTime tempLast = latestTime();
+    if((!first.isNull())&&(!tempLast.isNull())){
+      // Leave some room after the latest point, so a new volume usually
+      // lands inside the axis and the rest of the graph does not move
+      float span = first.secsTo(tempLast);
+      if((span > timeRange) || (timeRange > 1.5*span + 60)) {
+	float room = span/4;
+	if (room < 60)
+	  room = 60;
+	timeRange = span + room;
       }
-      timeRange = first.secsTo(tempLast);
     }
     else
       timeRange = -1;
   }
 }
 
-void GraphFace::checkPressure(VortexData* point)
+void GraphFace::checkPressure(const GraphPoint& point)
 {
 	
-  if ((point->getPressure() + 
-       point->getPressureUncertainty())> autoPressureMax) {
+  if ((point.pressure + 
+       point.pressureUncertainty)> autoPressureMax) {
     
     // Updates the Max and Min for pressure, 
-    autoPressureMax = (point->getPressure()
-		       + point->getPressureUncertainty());
-    autoPGMax = (point->getPressure() + 
-		 2*point->getPressureUncertainty() + 1);       
+    autoPressureMax = (point.pressure
+		       + point.pressureUncertainty);
+    autoPGMax = (point.pressure + 
+		 2*point.pressureUncertainty + 1);       
     // And add on an little bit so nothing hits the sides
   }
-  if((point->getPressure()-point->getPressureUncertainty()) 
+  if((point.pressure-point.pressureUncertainty) 
      < autoPressureMin) {
     
-    autoPressureMin = (point->getPressure()-point->getPressureUncertainty());
-    autoPGMin = point->getPressure()
-      -1* 2*point->getPressureUncertainty() - 1;
+    autoPressureMin = (point.pressure-point.pressureUncertainty);
+    autoPGMin = point.pressure
+      -1* 2*point.pressureUncertainty - 1;
   }
   if(autoAxes) {
     pressureMax = autoPressureMax;
@@ -740,24 +785,24 @@ void GraphFace::checkPressure(VortexData* point)
   } 
 }
 
-void GraphFace::checkDeficit(VortexData* point)
+void GraphFace::checkDeficit(const GraphPoint& point)
 {
 	
-  if ((-1*point->getPressureDeficit() + 
-       point->getDeficitUncertainty())> autoDeficitMax) {
+  if ((-1*point.deficit + 
+       point.deficitUncertainty)> autoDeficitMax) {
     
     // Updates the Max and Min for pressure, 
-    autoDeficitMax = (-1*point->getPressureDeficit()
-		       + point->getDeficitUncertainty());
-    autoDGMax = (-1*point->getPressureDeficit() + 
-		 2*point->getDeficitUncertainty() + 1);       
+    autoDeficitMax = (-1*point.deficit
+		       + point.deficitUncertainty);
+    autoDGMax = (-1*point.deficit + 
+		 2*point.deficitUncertainty + 1);       
     // And add on an little bit so nothing hits the sides
   }
-  if((-1*point->getPressureDeficit()-point->getDeficitUncertainty()) 
+  if((-1*point.deficit-point.deficitUncertainty) 
      < autoDeficitMin) {
     
-    autoDeficitMin = (-1*point->getPressureDeficit()-point->getDeficitUncertainty());
-    autoDGMin = -1*point->getPressureDeficit() -1* 2*point->getDeficitUncertainty() - 1;
+    autoDeficitMin = (-1*point.deficit-point.deficitUncertainty);
+    autoDGMin = -1*point.deficit -1* 2*point.deficitUncertainty - 1;
   }
   if(autoAxes) {
     deficitMax = autoDeficitMax;
@@ -767,13 +812,13 @@ void GraphFace::checkDeficit(VortexData* point)
   } 
 }
 
-void GraphFace::checkRmw(VortexData* point)
+void GraphFace::checkRmw(const GraphPoint& point)
 {
   
   // We want to get statistics on all the rmws and then take the average
 
-  float aveRmw = int(point->getAveRMWnm() + 0.5);
-  float aveRmwUn = point->getAveRMWUncertaintynm();
+  float aveRmw = int(point.rmw + 0.5);
+  float aveRmwUn = point.rmwUncertainty;
 
   if ((aveRmw + aveRmwUn) > autoRmwMax) {
     // Update the Max and Min for rmw
@@ -796,70 +841,55 @@ void GraphFace::checkRmw(VortexData* point)
 
 }
 
-QPointF GraphFace::makePressurePoint(VortexData d)
+QDateTime GraphFace::latestTime()
 {
-  // take in data from newInfo and creates graphable point using real data 
-  // (mbar -> QPointF)
-
-  QPointF temp;
-  if((d.getPressure()<pGMax)&&(d.getPressure()>pGMin)) {
-    float tempTime = scaleTime(d.getTime());
-    if(tempTime != -999)
-      temp = QPointF(tempTime, scalePressure(d.getPressure()));
+  QDateTime latest;
+  if(!points.isEmpty())
+    latest = points.last().time;
+  for(int i = 0; i < dropPoints.count(); i++) {
+    if(latest.isNull() || (dropPoints[i].time > latest))
+      latest = dropPoints[i].time;
   }
-  return (temp);
+  return latest;
+}
+
+QVector<float> GraphFace::axisScale()
+{
+  QVector<float> scale;
+  scale << pGMin << pGMax << dGMin << dGMax << rGMin << rGMax << timeRange
+	<< graph_width << graph_height;
+  return scale;
 }
 
-QPointF GraphFace::makeDeficitPoint(VortexData d)
+QPointF GraphFace::makePressurePoint(const GraphPoint& p)
 {
   // take in data from newInfo and creates graphable point using real data 
   // (mbar -> QPointF)
 
   QPointF temp;
-  if((-1*d.getPressureDeficit()<dGMax)&&(-1*d.getPressureDeficit()>dGMin)) {
-    float tempTime = scaleTime(d.getTime());
+  if((p.pressure<pGMax)&&(p.pressure>pGMin)) {
+    float tempTime = scaleTime(p.time);
     if(tempTime != -999)
-      temp = QPointF(tempTime, scaleDeficit(-1*d.getPressureDeficit()));
+      temp = QPointF(tempTime, scalePressure(p.pressure));
   }
   return (temp);
 }
 
-QPointF GraphFace::makeRmwPoint(VortexData d)
+QPointF GraphFace::makeDeficitPoint(const GraphPoint& p)
 {
+  // take in data from newInfo and creates graphable point using real data 
+  // (mbar -> QPointF)
 
-  // This constructs a RMW point in the right scale cooresponding to the
-  // Zeroth level rmw
-  // takes in information from a VortexData and creates a real point 
-  // ready for graphing (meters -> QPointF)
-
-  QPointF temp;  
-  if((d.getAveRMWnm()< rGMax)&&(d.getAveRMWnm()>rGMin)) {
-    float tempTime = scaleTime(d.getTime());
-    if(tempTime != -999)
-      temp = QPointF(tempTime, scaleRmw(d.getAveRMWnm()));
-  }
-  return(temp);
-}
-
-QPointF GraphFace::makeRmwPoint(VortexData d, int bestLevel)
-{
-
-  // This constructs a RMW point in the right scale cooresponding to the
-  // level indicated by bestLevel
-
-  // takes in information from a VortexData and creates a real point 
-  // ready for graphing (meters -> QPointF)
-
-  QPointF temp;  
-  if((d.getRMWnm(bestLevel)< rGMax)&&(d.getRMWnm(bestLevel)>rGMin)) {
-    float tempTime = scaleTime(d.getTime());
+  QPointF temp;
+  if((-1*p.deficit<dGMax)&&(-1*p.deficit>dGMin)) {
+    float tempTime = scaleTime(p.time);
     if(tempTime != -999)
-      temp = QPointF(tempTime ,scaleRmw(d.getRMWnm(bestLevel)));
+      temp = QPointF(tempTime, scaleDeficit(-1*p.deficit));
   }
-  return(temp);
+  return (temp);
 }
 
-QPointF GraphFace::makeRmwPoint(VortexData d, float rmw)
+QPointF GraphFace::makeRmwPoint(const GraphPoint& p, float rmw)
 {
   // This constructs a RMW point in the right scale for a given radius of 
   // maximum wind (rmw) is the case that we are not using a specific level
@@ -868,7 +898,7 @@ QPointF GraphFace::makeRmwPoint(VortexData d, float rmw)
 
   QPointF temp;  
   if((rmw < rGMax)&&(rmw > rGMin)) {
-    float tempTime = scaleTime(d.getTime());
+    float tempTime = scaleTime(p.time);
     if(tempTime != -999)
       temp = QPointF(tempTime, scaleRmw(rmw));
   }
@@ -972,7 +1002,7 @@ float GraphFace::scaleDDeficit(float unscaled_dDeficit)
 
 
 
-float GraphFace::getSTDMultiplier(VortexData p, float z)
+float GraphFace::getSTDMultiplier(const VortexData& p, float z)
 {
   // do something with the probability z to find and return the corresponding 
   // number multiple of standard deviations to display
@@ -1007,22 +1037,22 @@ int GraphFace::pointAt(const QPointF & position, bool& ONDropSonde)
   //Message::toScreen("Rax = "+QString().setNum(rmax)+" Rmin = "+QString().setNum(rmin));
   float dmax = unScaleDeficit(position.y()-5);
   float dmin = unScaleDeficit(position.y()+5);
-  for (int i = 0; i < VortexDataList->size(); i++) {
+  for (int i = 0; i < points.size(); i++) {
     //if(i==0)
-    //Message::toScreen("First: T~ "+VortexDataList->at(i).getTime().toString("dd-hh:mm:ss")+" P ~ "+QString().setNum(VortexDataList->at(i).getPressure()));
-    if(VortexDataList->at(i).getTime()<=tmax)
-      if(VortexDataList->at(i).getTime()>=tmin) {
-	if((VortexDataList->at(i).getPressure() <= pmax)
-	   && (VortexDataList->at(i).getPressure() >= pmin)
+    //Message::toScreen("First: T~ "+points[i].time.toString("dd-hh:mm:ss")+" P ~ "+QString().setNum(points[i].pressure));
+    if(points[i].time<=tmax)
+      if(points[i].time>=tmin) {
+	if((points[i].pressure <= pmax)
+	   && (points[i].pressure >= pmin)
 	   && showPressure) {
 	  return i;
 	}
-	if((VortexDataList->at(i).getAveRMWnm() <= rmax) 
-	   && (VortexDataList->at(i).getAveRMWnm() >= rmin)) {
+	if((points[i].rmw <= rmax) 
+	   && (points[i].rmw >= rmin)) {
 	  return i;
 	}
-	if((-1*VortexDataList->at(i).getPressureDeficit() <= dmax)
-	   &&(-1*VortexDataList->at(i).getPressureDeficit() >= dmin)
+	if((-1*points[i].deficit <= dmax)
+	   &&(-1*points[i].deficit >= dmin)
 	   && !showPressure)
 	  return i;
       }
@@ -1033,11 +1063,11 @@ int GraphFace::pointAt(const QPointF & position, bool& ONDropSonde)
   if(dropList==NULL)
     return -1;
   else {
-    for(int i = 0; i < dropList->size(); i++) {
-      if(dropList->at(i).getTime()<tmax)
-	if(dropList->at(i).getTime()>tmin)
-	  if((dropList->at(i).getPressure() < pmax)  
-	     && (dropList->at(i).getPressure() > pmin)) {
+    for(int i = 0; i < dropPoints.size(); i++) {
+      if(dropPoints[i].time<tmax)
+	if(dropPoints[i].time>tmin)
+	  if((dropPoints[i].pressure < pmax)  
+	     && (dropPoints[i].pressure > pmin)) {
 	    ONDropSonde = true;
 	    return i;
 	  }
@@ -1088,14 +1118,19 @@ QPainter* GraphFace::updateImage(QPainter* painter)
   // to the origin of the graphable area
 
 {
-  //  QImage *imageTemp = new QImage(graph_width+LEFT_MARGIN_WIDTH+RIGHT_MARGIN_WIDTH,graph_height+TOP_MARGIN_HEIGHT+BOTTOM_MARGIN_HEIGHT,QImage::Format_ARGB32_Premultiplied);
-
-  //QPainter* painter = new QPainter(imageTemp);
-  //QPainter* painter = new QPainter(imageTemp);
   painter->setBackgroundMode(Qt::OpaqueMode);
   painter->setRenderHint(QPainter::Antialiasing);
   //this option makes lines appear smoother;
 
+  drawAxes(painter);
+  drawPoints(painter, 0);
+  drawDrops(painter);
+
+  return painter;
+}
+
+void GraphFace::drawAxes(QPainter* painter)
+{
   //DRAW IN ALL AXES
 
   painter->translate(LEFT_MARGIN_WIDTH,TOP_MARGIN_HEIGHT);     
@@ -1350,26 +1385,31 @@ QPainter* GraphFace::updateImage(QPainter* painter)
 
   // this leaves the space between the axises at graph_width 
   // by graph_height tall for now
+}
+
+void GraphFace::drawPoints(QPainter* painter, int from)
+{
 
 
   //-------------------------------Draw Pressure Points--------------
 
-  if(!(VortexDataList == NULL) 
-     &&!VortexDataList->isEmpty()) {       // Process is used provided data 
-                                           // points are already available
+  // Points before from are already on the image. The lines joining the
+  // last of them to the new points are drawn here.
+
+  if(from < points.size()) {
     if(showPressure) {
       painter->setPen(pressurePen);
       painter->setBrush(pressureBrush);
-      for (int i=0;i<VortexDataList->size();i++) {
+      for (int i=from;i<points.size();i++) {
 	
 	//-------------------------------ErrorBars----------------------------
 	
 	// This draws the errorbars about the point 
-	QPointF xypoint = makePressurePoint(VortexDataList->value(i));
+	QPointF xypoint = makePressurePoint(points[i]);
 	
 	if(!xypoint.isNull()) {
-	  if (VortexDataList->at(i).getPressureUncertainty()>0) {                           // if uncertainty = 0 there are no bars
-	    float errorBarHeight = scaleDPressure(VortexDataList->at(i).getPressureUncertainty());
+	  if (points[i].pressureUncertainty>0) {                           // if uncertainty = 0 there are no bars
+	    float errorBarHeight = scaleDPressure(points[i].pressureUncertainty);
 	    
 	    float upper2, upper1, lower1, lower2;
 	    bool upperBar2, upperBar1, lowerBar1, lowerBar2;
@@ -1449,10 +1489,10 @@ QPainter* GraphFace::updateImage(QPainter* painter)
       
       // This loop connects all the pressure points in the VortexDataList 
       // to the previous one with a line
-      int j = 1;
-      while(j < VortexDataList->size())	{
-	QPointF point1 = makePressurePoint(VortexDataList->value(j-1));
-	QPointF point2 = makePressurePoint(VortexDataList->value(j));
+      int j = (from > 1) ? from : 1;
+      while(j < points.size())	{
+	QPointF point1 = makePressurePoint(points[j-1]);
+	QPointF point2 = makePressurePoint(points[j]);
 	if(!point1.isNull()&&!point2.isNull())
 	  painter->drawLine(point1, point2);
 	j++;
@@ -1461,16 +1501,16 @@ QPainter* GraphFace::updateImage(QPainter* painter)
     else {
       painter->setPen(pressurePen);
       painter->setBrush(pressureBrush);
-      for (int i=0;i<VortexDataList->size();i++) {
+      for (int i=from;i<points.size();i++) {
 	
 	//-------------------------------ErrorBars----------------------------
 	
 	// This draws the errorbars about the point 
-	QPointF xypoint = makeDeficitPoint(VortexDataList->value(i));
+	QPointF xypoint = makeDeficitPoint(points[i]);
 	
 	if(!xypoint.isNull()) {
-	  if (VortexDataList->at(i).getDeficitUncertainty()>0) {                           // if uncertainty = 0 there are no bars
-	    float errorBarHeight = scaleDDeficit(VortexDataList->at(i).getDeficitUncertainty());
+	  if (points[i].deficitUncertainty>0) {                           // if uncertainty = 0 there are no bars
+	    float errorBarHeight = scaleDDeficit(points[i].deficitUncertainty);
 	    
 	    float upper2, upper1, lower1, lower2;
 	    bool upperBar2, upperBar1, lowerBar1, lowerBar2;
@@ -1549,10 +1589,10 @@ QPainter* GraphFace::updateImage(QPainter* painter)
       
       // This loop connects all the deficit points in the VortexDataList 
       // to the previous one with a line
-      int j = 1;
-      while(j < VortexDataList->size())	{
-	QPointF point1 = makeDeficitPoint(VortexDataList->value(j-1));
-	QPointF point2 = makeDeficitPoint(VortexDataList->value(j));
+      int j = (from > 1) ? from : 1;
+      while(j < points.size())	{
+	QPointF point1 = makeDeficitPoint(points[j-1]);
+	QPointF point2 = makeDeficitPoint(points[j]);
 	if(!point1.isNull()&&!point2.isNull())
 	  painter->drawLine(point1, point2);
 	j++;
@@ -1563,17 +1603,19 @@ QPainter* GraphFace::updateImage(QPainter* painter)
       painter->setPen(rmwPen);
       painter->setBrush(rmwBrush);
       QPointF lastPoint;
+      for (int i=from-1;(i>=0)&&lastPoint.isNull();i--)
+	lastPoint = makeRmwPoint(points[i], points[i].rmw);
 
-      for (int i=0;i<VortexDataList->size();i++) {          
+      for (int i=from;i<points.size();i++) {          
 	
 	// uses the loop to move through all data points
 
-	float aveRmw = VortexDataList->at(i).getAveRMWnm();
-	float aveRmwUn = VortexDataList->at(i).getAveRMWUncertaintynm();
+	float aveRmw = points[i].rmw;
+	float aveRmwUn = points[i].rmwUncertainty;
 
 	float rawErrorBarHeight = aveRmwUn;
 
-	QPointF xypoint = makeRmwPoint(VortexDataList->at(i), aveRmw);
+	QPointF xypoint = makeRmwPoint(points[i], aveRmw);
 	if(!xypoint.isNull()) {
 	  
 	  //-------------------------------ErrorBars---------------------------
@@ -1677,37 +1719,27 @@ QPainter* GraphFace::updateImage(QPainter* painter)
       }
       */
   }
+}
+
+void GraphFace::drawDrops(QPainter* painter)
+{
   //-----------------------------------Draw Drops-------------------------------
   
-  if(!(dropList == NULL)
-     &&!dropList->isEmpty())              // Goes through the same process 
+  if(!dropPoints.isEmpty())              // Goes through the same process 
                                           // of drawing drops but with
     {                                     // a different member box to draw 
                                           // an ellipse in 
       painter->setPen(dropPen);
 
       painter->setBrush(dropBrush);
-      for (int i = 0; i < dropList->size();i++) {
-	QPointF xypoint = makePressurePoint(dropList->value(i));
+      for (int i = 0; i < dropPoints.size();i++) {
+	QPointF xypoint = makePressurePoint(dropPoints[i]);
 	if(!xypoint.isNull()) {
 	  drop.moveCenter(xypoint);
 	  painter->drawEllipse(drop);
 	}
       }
     }
-  //if (painter->isActive())
-  //  painter->end();
-  //delete painter;
-  //image = NULL;
-  
-  //image = imageTemp;
-
-  // Memory leak here?
-  //imageTemp = NULL;
-  //delete imageTemp;
-  //autoSave();
-
-  return painter;
 }
 
 
@@ -18,12 +18,30 @@
 #include<QImage>
 #include<QDir>
 #include<QPainter>
+#include<QVector>
 
 #include "DataObjects/VortexList.h"
 #include "DataObjects/VortexData.h"
 #include "KeyPicture.h"
 #include "IO/Message.h"
 
+// The values the timeline plots for one estimate or dropsonde. GraphFace
+// keeps these instead of reading the VortexData, which is large, every
+// time it paints or shows a tooltip.
+
+class GraphPoint
+{
+public:
+    GraphPoint();
+    GraphPoint(const VortexData& d);
+    bool operator==(const GraphPoint& other) const;
+
+    QDateTime time;
+    float pressure, pressureUncertainty;
+    float deficit, deficitUncertainty;
+    float rmw, rmwUncertainty;      // nm
+};
+
 class GraphFace:public QWidget
 {
     Q_OBJECT
@@ -90,6 +108,13 @@ private:
 
     VortexList* VortexDataList;
     VortexList*  dropList;
+    // Plot ready copies of VortexDataList and dropList, in time order
+    QVector<GraphPoint> points;
+    QVector<GraphPoint> dropPoints;
+    // Points already on image. The ones after them are added on the next
+    // paint, unless imageAltered asks for the whole image to be redrawn.
+    int drawnPoints;
+    QBrush background;
     QDateTime first;                // Time of first data points
     QDateTime last;
     QDialog* key;
@@ -150,11 +175,9 @@ private:
     // These functions use information within the list of data points
     // to create a point that is scaled to the current ranges that the graph covers
     // when this point is returned it is ready to graph
-    QPointF makePressurePoint(VortexData d);
-    QPointF makeDeficitPoint(VortexData d);
-    QPointF makeRmwPoint(VortexData d);
-    QPointF makeRmwPoint(VortexData d, int bestLevel);
-    QPointF makeRmwPoint(VortexData d, float rmw);
+    QPointF makePressurePoint(const GraphPoint& p);
+    QPointF makeDeficitPoint(const GraphPoint& p);
+    QPointF makeRmwPoint(const GraphPoint& p, float rmw);
 
     // These functions are used to scale each of the variable to their relative position in
     // the current variable ranges on the graph
@@ -169,7 +192,7 @@ private:
     float scaleDPressure(float unscaled_dPressure);
     float scaleDRmw(float unscaled_dRmw);
     float scaleDDeficit(float unscaled_dDeficit);
-    float getSTDMultiplier(VortexData p, float z);
+    float getSTDMultiplier(const VortexData& p, float z);
     int pointAt(const QPointF & position, bool& ONDropSonde);
     void setColors();
     bool autoSave();
@@ -177,9 +200,14 @@ private:
     // this function checks to see if the ranges need to be update
     // it will also update ranges when necessary
     void checkRanges();
-    void checkPressure(VortexData* point);
-    void checkRmw(VortexData* point);
-    void checkDeficit(VortexData* point);
+    void checkPressure(const GraphPoint& point);
+    void checkRmw(const GraphPoint& point);
+    void checkDeficit(const GraphPoint& point);
+    // Latest time on the plot, from the estimates and dropsondes
+    QDateTime latestTime();
+    // Everything the positions of the points depend on, to tell whether
+    // new data moved the axes
+    QVector<float> axisScale();
 
     // Constants related to the absolute size of the margins and face of the graph
     // These are in Qt sizes not scaled sizes
@@ -195,6 +223,11 @@ private:
     static constexpr float Z2 = .95;
 
     QPainter* updateImage(QPainter* painter);
+    // Pieces of updateImage. drawPoints and drawDrops expect the painter at
+    // the bottom left corner of the graph area, where drawAxes leaves it.
+    void drawAxes(QPainter* painter);
+    void drawPoints(QPainter* painter, int from);
+    void drawDrops(QPainter* painter);
     void altUpdateImage();
 
 private slots:
@@ -41,7 +41,7 @@ MainWindow::MainWindow()
 
     readSettings();
     qRegisterMetaType<Message>("Message");
-    qRegisterMetaType<GriddedData>("GriddedData");
+    qRegisterMetaType<CappiSnapshot>("CappiSnapshot");
     qRegisterMetaType<VortexList>("VortexList");
     setWindowTitle(tr("VORTRAC"));
 }
@@ -807,12 +807,12 @@ CappiPanel::CappiPanel():AbstractPanel()
     interpolationMethod = new QHash<QString, QString>;
     interpolationMethod->insert(QString("Cressman Interpolation"),
                                 QString("cressman"));
-    //interpolationMethod->insert(QString("Barnes Interpolation"),
-    //			      QString("barnes"));
-    //interpolationMethod->insert(QString("Closest Point Interpolation"),
-    //QString("closestpoint"));
-    //interpolationMethod->insert(QString("Bilinear Interpolation"),
-    // QString("bilinear"));
+    interpolationMethod->insert(QString("Barnes Interpolation"),
+                                QString("barnes"));
+    interpolationMethod->insert(QString("Closest Point Interpolation"),
+                                QString("closestpoint"));
+    interpolationMethod->insert(QString("Bilinear Interpolation"),
+                                QString("bilinear"));
     interpolationMethod->insert(QString("Select Interpolation Method"),
                                 QString(""));
     // add some more of these interpolation method options as nessecary
@@ -1078,10 +1078,8 @@ bool CappiPanel::checkValues()
         return false;
     }
 
-    // Gridded Data has a maximum number of points at (last I checked)
-    // 256 in x
-    // 256 in y
-    // 20 in z
+    // Gridded Data is allocated at the configured size, but each
+    // dimension and the total grid size are limited (see GriddedData).
     // We must make sure that is how many we have selected
 
     // We should be using zgridsp here like in AnalysisThread 459
@@ -1098,7 +1096,12 @@ bool CappiPanel::checkValues()
     }
     if(zDimBox->value() > GriddedData::getMaxKDim()) {
         emit log(Message(QString(),0, this->objectName(), Red,
-                         QString(tr("Cappi Z dimension has exceeded ")+QString().setNum(GriddedData::getMaxIDim())+tr(" points, Please decrease the dimension of cappi in z"))));
+                         QString(tr("Cappi Z dimension has exceeded ")+QString().setNum(GriddedData::getMaxKDim())+tr(" points, Please decrease the dimension of cappi in z"))));
+        return false;
+    }
+    if(!GriddedData::fitsAllocationLimits((int)xDimBox->value(), (int)yDimBox->value(), (int)zDimBox->value())) {
+        emit log(Message(QString(),0, this->objectName(), Red,
+                         QString(tr("Cappi grid would exceed ")+QString().setNum(GriddedData::getMaxGridBytes()/1048576)+tr(" MB, Please decrease the dimensions of the cappi"))));
         return false;
     }
 
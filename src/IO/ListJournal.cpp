@@ -0,0 +1,219 @@
+/*
+ * ListJournal.cpp
+ * VORTRAC
+ *
+ * Append-only file of the records added to the vortex, simplex or
+ * pressure list since its last snapshot, so saving a volume does not
+ * rewrite the whole history of the storm.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include "ListJournal.h"
+#include "ListSnapshot.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+ListJournal::ListJournal(const QString& kind)
+{
+    _kind = kind;
+    _ready = false;
+    _snapshotId = 0;
+    _savedCount = 0;
+    _journalBytes = 0;
+    _snapshotBytes = 0;
+}
+
+void ListJournal::setListFilePath(const QString& listFilePath)
+{
+    _journalPath = journalPath(listFilePath);
+    _snapshotPath = ListSnapshot::snapshotPath(listFilePath);
+    QStringList fileParts = QFileInfo(listFilePath).fileName().split("_");
+    _hurricane.clear();
+    _radar.clear();
+    if(fileParts.count() > 1) {
+        _hurricane = fileParts.at(0);
+        _radar = fileParts.at(1);
+    }
+
+    // Whatever was known about the old file does not apply
+    _ready = false;
+    _snapshotId = 0;
+    _savedCount = 0;
+    _lastSavedKey.clear();
+    _journalBytes = 0;
+    _snapshotBytes = 0;
+}
+
+QString ListJournal::journalPath(const QString& listFilePath)
+{
+    QString path = listFilePath;
+    if(path.endsWith(".xml", Qt::CaseInsensitive))
+        path.chop(4);
+    return path + ".journal";
+}
+
+void ListJournal::prepareStream(QDataStream& stream)
+{
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+}
+
+int ListJournal::firstUnsaved(int numRecords, const QString& savedKey) const
+{
+    if(numRecords < _savedCount)
+        return -1;
+    if((_savedCount > 0) && (savedKey != _lastSavedKey))
+        return -1;
+    return _savedCount;
+}
+
+bool ListJournal::needsCompaction() const
+{
+    return !_ready || (_journalBytes > qMax(_snapshotBytes, (qint64)minCompactBytes));
+}
+
+void ListJournal::readSnapshotSize()
+{
+    _snapshotBytes = QFileInfo(_snapshotPath).size();
+}
+
+quint64 ListJournal::nextSnapshotId() const
+{
+    // Time based, so a journal left over from another run never matches
+    quint64 id = (quint64)QDateTime::currentMSecsSinceEpoch();
+    return (id > _snapshotId) ? id : _snapshotId + 1;
+}
+
+bool ListJournal::writeHeader(quint64 snapshotId)
+{
+    QSaveFile file(_journalPath);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    prepareStream(out);
+    out << magic << version << _kind << _hurricane << _radar << snapshotId;
+    return (out.status() == QDataStream::Ok) && file.commit();
+}
+
+bool ListJournal::snapshotSaved(quint64 snapshotId, int numRecords, const QString& lastKey)
+{
+    _snapshotId = snapshotId;
+    _savedCount = numRecords;
+    _lastSavedKey = lastKey;
+    _journalBytes = 0;
+    readSnapshotSize();
+    _ready = writeHeader(snapshotId);
+    return _ready;
+}
+
+void ListJournal::restored(quint64 snapshotId, int numRecords, const QString& lastKey)
+{
+    _snapshotId = snapshotId;
+    _savedCount = numRecords;
+    _lastSavedKey = lastKey;
+    readSnapshotSize();
+}
+
+QDataStream* ListJournal::beginRecord()
+{
+    if(!_ready)
+        return NULL;
+    _stream.setDevice(NULL);
+    _device.close();
+    _buffer.clear();
+    _device.setBuffer(&_buffer);
+    _device.open(QIODevice::WriteOnly);
+    _stream.setDevice(&_device);
+    _stream.resetStatus();
+    prepareStream(_stream);
+    return &_stream;
+}
+
+bool ListJournal::commitRecord(const QString& key)
+{
+    if(!_ready || (_stream.status() != QDataStream::Ok))
+        return false;
+
+    QByteArray entry;
+    QDataStream out(&entry, QIODevice::WriteOnly);
+    prepareStream(out);
+    out << (quint32)_buffer.size() << qChecksum(_buffer.constData(), _buffer.size());
+    entry.append(_buffer);
+
+    QFile file(_journalPath);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        _ready = false;
+        return false;
+    }
+    bool ok = (file.write(entry) == entry.size()) && file.flush();
+#ifdef Q_OS_UNIX
+    ok = ok && (fsync(file.handle()) == 0);
+#endif
+    file.close();
+    if(!ok) {
+        // The tail may be torn, start over from a snapshot next time
+        _ready = false;
+        return false;
+    }
+
+    _savedCount++;
+    _lastSavedKey = key;
+    _journalBytes += entry.size();
+    return true;
+}
+
+bool ListJournal::readEntries(quint64 snapshotId, QList<QByteArray>& entries)
+{
+    entries.clear();
+    _ready = false;
+    _journalBytes = 0;
+
+    QFile file(_journalPath);
+    if(!file.open(QIODevice::ReadWrite))
+        return false;
+
+    QDataStream in(&file);
+    prepareStream(in);
+    quint32 fileMagic, fileVersion;
+    QString fileKind, fileHurricane, fileRadar;
+    quint64 fileId;
+    in >> fileMagic >> fileVersion >> fileKind >> fileHurricane >> fileRadar >> fileId;
+    if((in.status() != QDataStream::Ok) || (fileMagic != magic) || (fileVersion != version)
+       || (fileKind != _kind) || (fileHurricane != _hurricane) || (fileRadar != _radar)
+       || (fileId != snapshotId))
+        return false;
+
+    qint64 headerSize = file.pos();
+    qint64 goodSize = headerSize;
+    while(!in.atEnd()) {
+        quint32 size;
+        quint16 checksum;
+        in >> size >> checksum;
+        if((in.status() != QDataStream::Ok) || (size > (quint32)(file.size() - file.pos())))
+            break;
+        QByteArray payload = file.read(size);
+        if(((quint32)payload.size() != size)
+           || (qChecksum(payload.constData(), payload.size()) != checksum))
+            break;
+        entries.append(payload);
+        goodSize = file.pos();
+    }
+
+    // Drop a torn last entry so new ones follow whole ones
+    if(file.size() > goodSize)
+        file.resize(goodSize);
+    file.close();
+
+    _journalBytes = goodSize - headerSize;
+    _ready = true;
+    return true;
+}
@@ -0,0 +1,110 @@
+/*
+ * ListJournal.h
+ * VORTRAC
+ *
+ * Append-only file of the records added to the vortex, simplex or
+ * pressure list since its last snapshot, so saving a volume does not
+ * rewrite the whole history of the storm.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef LISTJOURNAL_H
+#define LISTJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QByteArray>
+#include <QBuffer>
+#include <QDataStream>
+
+// <list file without .xml>.journal holds magic, version, list kind,
+// hurricane name, radar name and the id of the snapshot it continues,
+// followed by one entry per record: payload size, payload checksum and
+// the payload, which the list writes the same way as in its snapshot.
+// Each entry is flushed to disk before the save returns. An entry cut
+// short by a crash is dropped when the journal is read back.
+//
+// The journal counts the records saved so far and keeps the key of the
+// last one, so a save only has to look at the records after it. The lists
+// only ever append, sort or drop records, and sorting or dropping moves
+// the last saved record, so if the list no longer has that key there the
+// list writes a full snapshot instead and the journal starts over. It does
+// the same once the journal has grown larger than the snapshot (and
+// minCompactBytes), so replaying the journal never costs more than reading
+// the snapshot, and each snapshot is paid for by the appends before it.
+// A journal is only replayed on top of the snapshot whose id it carries,
+// so a crash between writing the snapshot and starting the new journal
+// loses nothing.
+
+class ListJournal
+{
+
+public:
+  ListJournal(const QString& kind);
+
+  void setListFilePath(const QString& listFilePath);
+  // <list file without .xml>.journal
+  static QString journalPath(const QString& listFilePath);
+  QString getFilePath() const { return _journalPath; }
+
+  // Number of records in the snapshot and journal
+  int savedCount() const { return _savedCount; }
+  // Index of the first record that has not been saved, or -1 if the saved
+  // records are no longer at the start of the list. savedKey is the key of
+  // record savedCount() - 1 of a list of numRecords, empty if it has none.
+  int firstUnsaved(int numRecords, const QString& savedKey) const;
+  // True when the next save should write a snapshot instead
+  bool needsCompaction() const;
+
+  // Returns the stream for one record, or NULL
+  QDataStream* beginRecord();
+  // Appends the record and syncs the journal
+  bool commitRecord(const QString& key);
+
+  // Larger than any id handed out before
+  quint64 nextSnapshotId() const;
+  // A snapshot of numRecords records, the last with key lastKey, was
+  // committed, start an empty journal
+  bool snapshotSaved(quint64 snapshotId, int numRecords, const QString& lastKey);
+  // Payloads appended after the snapshot, oldest first. Returns false if
+  // there is no journal for it.
+  bool readEntries(quint64 snapshotId, QList<QByteArray>& entries);
+  // The list now holds exactly numRecords records, the last with key lastKey
+  void restored(quint64 snapshotId, int numRecords, const QString& lastKey);
+
+  // Stream settings shared with ListSnapshot
+  static void prepareStream(QDataStream& stream);
+
+private:
+  static const quint32 magic = 0x56544a4c;   // "VTJL"
+  static const quint32 version = 1;
+  static const qint64 minCompactBytes = 256*1024;
+
+  QString _kind;
+  QString _journalPath;
+  QString _snapshotPath;
+  QString _hurricane;
+  QString _radar;
+
+  // The journal on disk continues _snapshotId and ends with a whole entry
+  bool _ready;
+  quint64 _snapshotId;
+  int _savedCount;
+  QString _lastSavedKey;
+  // Entries in the journal, without its header
+  qint64 _journalBytes;
+  qint64 _snapshotBytes;
+
+  QByteArray _buffer;
+  QBuffer _device;
+  QDataStream _stream;
+
+  bool writeHeader(quint64 snapshotId);
+  void readSnapshotSize();
+};
+
+#endif
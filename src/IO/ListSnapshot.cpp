@@ -0,0 +1,120 @@
+/*
+ * ListSnapshot.cpp
+ * VORTRAC
+ *
+ * Binary snapshot written next to the xml files of the vortex, simplex
+ * and pressure lists, so a previous run can be restored exactly.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <QFileInfo>
+#include <QStringList>
+#include "ListSnapshot.h"
+
+ListSnapshot::ListSnapshot(const QString& listFilePath, const QString& kind)
+{
+    _snapshotPath = snapshotPath(listFilePath);
+    _kind = kind;
+
+    QStringList fileParts = QFileInfo(listFilePath).fileName().split("_");
+    if(fileParts.count() > 1) {
+        _hurricane = fileParts.at(0);
+        _radar = fileParts.at(1);
+    }
+
+    _saveFile = NULL;
+    _readFile = NULL;
+}
+
+ListSnapshot::~ListSnapshot()
+{
+    close();
+}
+
+QString ListSnapshot::snapshotPath(const QString& listFilePath)
+{
+    QString path = listFilePath;
+    if(path.endsWith(".xml", Qt::CaseInsensitive))
+        path.chop(4);
+    return path + ".snapshot";
+}
+
+QDataStream* ListSnapshot::beginWrite(int numRecords, quint64 snapshotId)
+{
+    close();
+    _saveFile = new QSaveFile(_snapshotPath);
+    if(!_saveFile->open(QIODevice::WriteOnly)) {
+        close();
+        return NULL;
+    }
+
+    _stream.setDevice(_saveFile);
+    _stream.setVersion(QDataStream::Qt_5_0);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    _stream << magic << version << _kind << _hurricane << _radar << (qint32)numRecords
+            << snapshotId;
+    return &_stream;
+}
+
+bool ListSnapshot::commit()
+{
+    if(_saveFile == NULL)
+        return false;
+    bool ok = (_stream.status() == QDataStream::Ok) && _saveFile->commit();
+    close();
+    return ok;
+}
+
+QDataStream* ListSnapshot::beginRead(int& numRecords, quint64* snapshotId)
+{
+    close();
+    numRecords = 0;
+    if(snapshotId != NULL)
+        *snapshotId = 0;
+    _readFile = new QFile(_snapshotPath);
+    if(!_readFile->open(QIODevice::ReadOnly)) {
+        close();
+        return NULL;
+    }
+
+    _stream.setDevice(_readFile);
+    _stream.setVersion(QDataStream::Qt_5_0);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 fileMagic, fileVersion;
+    QString fileKind, fileHurricane, fileRadar;
+    qint32 count;
+    quint64 fileId = 0;
+    _stream >> fileMagic >> fileVersion >> fileKind >> fileHurricane >> fileRadar >> count;
+    if(fileVersion >= 2)
+        _stream >> fileId;
+    if((_stream.status() != QDataStream::Ok) || (fileMagic != magic)
+       || (fileVersion < 1) || (fileVersion > version) || (fileKind != _kind)
+       || (fileHurricane != _hurricane) || (fileRadar != _radar) || (count < 0)) {
+        close();
+        return NULL;
+    }
+
+    numRecords = count;
+    if(snapshotId != NULL)
+        *snapshotId = fileId;
+    return &_stream;
+}
+
+bool ListSnapshot::readOk() const
+{
+    return (_readFile != NULL) && (_stream.status() == QDataStream::Ok);
+}
+
+void ListSnapshot::close()
+{
+    _stream.setDevice(NULL);
+    // An uncommitted QSaveFile leaves the previous snapshot in place
+    delete _saveFile;
+    _saveFile = NULL;
+    delete _readFile;
+    _readFile = NULL;
+}
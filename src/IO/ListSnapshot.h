@@ -0,0 +1,70 @@
+/*
+ * ListSnapshot.h
+ * VORTRAC
+ *
+ * Binary snapshot written next to the xml files of the vortex, simplex
+ * and pressure lists, so a previous run can be restored exactly.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef LISTSNAPSHOT_H
+#define LISTSNAPSHOT_H
+
+#include <QString>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+// Layout: magic, version, list kind, hurricane name, radar name, the
+// record count and the snapshot id, followed by the records written by
+// the list itself. The id ties the snapshot to the journal of records
+// appended after it (see ListJournal); version 1 snapshots have id 0.
+// The hurricane and radar names come from the list file name
+// (<hurricane>_<radar>_<year>_<kind>list.xml), which is built from the
+// configuration, so a snapshot from another storm or radar is rejected.
+
+class ListSnapshot
+{
+
+public:
+  ListSnapshot(const QString& listFilePath, const QString& kind);
+  ~ListSnapshot();
+
+  // <list file without .xml>.snapshot
+  static QString snapshotPath(const QString& listFilePath);
+  QString getFilePath() const { return _snapshotPath; }
+
+  QString getHurricane() const { return _hurricane; }
+  QString getRadar() const { return _radar; }
+
+  // Returns the stream to write numRecords records to, or NULL. Nothing
+  // replaces the previous snapshot until commit() succeeds.
+  QDataStream* beginWrite(int numRecords, quint64 snapshotId = 0);
+  bool commit();
+
+  // Returns the stream positioned at the first record, or NULL if there
+  // is no snapshot or its header does not match this list
+  QDataStream* beginRead(int& numRecords, quint64* snapshotId = NULL);
+  // True if the reading stream is still good
+  bool readOk() const;
+
+private:
+  static const quint32 magic = 0x56545253;   // "VTRS"
+  static const quint32 version = 2;
+
+  QString _snapshotPath;
+  QString _kind;
+  QString _hurricane;
+  QString _radar;
+
+  QSaveFile* _saveFile;
+  QFile* _readFile;
+  QDataStream _stream;
+
+  void close();
+};
+
+#endif
@@ -12,6 +12,21 @@
 #include "Log.h"
 #include <QFileDialog>
 #include <QDateTime>
+#include <QThread>
+
+// Writes the queued log entries until the Log is destroyed
+class LogWriter : public QThread
+{
+
+public:
+    LogWriter(Log* owner) : owner(owner) {}
+
+protected:
+    void run() { owner->writeLoop(); }
+
+private:
+    Log* owner;
+};
 
 Log::Log(QWidget *parent) 
     : QWidget(parent)
@@ -37,12 +52,24 @@ Log::Log(QWidget *parent)
     absoluteProgress = 0;
     //displayLocation = false;
     displayLocation = true;
-    //  usingFile = false;
     // Message::toScreen("log:constructor: "+workingDirectory.path());
+
+    droppedLines = 0;
+    flushNow = false;
+    stopWriter = false;
+    writer = new LogWriter(this);
+    writer->start();
 }
 
 Log::~Log()
 {
+    queueMutex.lock();
+    stopWriter = true;
+    queueReady.wakeAll();
+    queueMutex.unlock();
+    // The writer writes what is left before it returns
+    writer->wait();
+    delete writer;
     delete logFile;
     for(int i = StopLightQueue.count()-1; i >= 0; i--) {
         delete StopLightQueue[i];
@@ -86,10 +113,12 @@ void Log::setWorkingDirectory(QDir& newDir)
     newLogFile.setFileName(workingDirectory.filePath(newName+".log"));
 
     usingFile.lock();
+    writeToFile();
     if(logFile->isOpen())
         logFile->close();
 
     if(!logFile->copy(newDir.filePath(newFileName))) {
+        usingFile.unlock();
         emit log(Message(QString("SetWorkingDirectory: Could not copy "+logFile->fileName()+" to "+newDir.filePath(newFileName)+".  May not be logging errors"),0,this->objectName(),Yellow,QString("Could not move log file!")));
         return;
     }
@@ -105,10 +134,10 @@ void Log::setWorkingDirectory(QDir& newDir)
     logFile = new QFile(workingDirectory.filePath(logFileName));
     logFile->setFileName(workingDirectory.filePath(logFileName));
 
-    emit log(Message(QString("Log location after working dir changed, log file = "+logFile->fileName()),0,this->objectName(),Green));
-
     usingFile.unlock();
 
+    emit log(Message(QString("Log location after working dir changed, log file = "+logFile->fileName()),0,this->objectName(),Green));
+
 }
 
 void Log::setLogFileName(QString& newName) 
@@ -126,6 +155,9 @@ void Log::setLogFileName(QString& newName)
     }
 
     usingFile.lock();
+    writeToFile();
+    if(logFile->isOpen())
+        logFile->close();
 
     if(!logFile->copy(workingDirectory.filePath(newName)))
         //Message::toScreen("Log::setWorkingDirectory: could not copy "+logFile->fileName()+" to "+workingDirectory.filePath(newName));
@@ -141,6 +173,7 @@ bool Log::saveLogFile()
 
     if(!saveName.isEmpty()) {
         usingFile.lock();
+        writeToFile();
         if(logFile->copy(saveName)) {
             usingFile.unlock();
             return true;
@@ -174,6 +207,7 @@ bool Log::saveLogFile(const QString& fileName)
         QFile::remove(newFileName);
 
     usingFile.lock();
+    writeToFile();
     if(check.isAbsolute()) {
         if(logFile->copy(fileName)) {
             usingFile.unlock();
@@ -200,25 +234,32 @@ bool Log::saveLogFile(const QString& fileName)
 
 void Log::catchLog(const Message& logEntry)
 {
-    QMutex mutex;
-    mutex.lock();
-    Message* logg = new Message(logEntry);
-    QString message = logg->getLogMessage();
-    int progress = logg->getProgress();
-    QString location = logg->getLocation();
-    StopLightColor stopLightColor = logg->getColor();
-    QString stopLightMessage = logg->getStopLightMessage();
-    StormSignalStatus stormSignalStatus = logg->getStatus();
-    QString stormSignalMessage = logg->getStormSignalMessage();
+    QString message = logEntry.getLogMessage();
+    int progress = logEntry.getProgress();
+    QString location = logEntry.getLocation();
+    StopLightColor stopLightColor = logEntry.getColor();
+    QString stopLightMessage = logEntry.getStopLightMessage();
+    StormSignalStatus stormSignalStatus = logEntry.getStatus();
+    QString stormSignalMessage = logEntry.getStormSignalMessage();
     bool debug = false;
     if(message!=QString()) {
         if(displayLocation && (location!=QString()) and debug) {
             message = location+": "+message;
         }
         message+="\n";
-        messagesWaiting.append(message);
         emit(newLogEntry(message));
-        writeToFile();
+
+        // Hand the entry to the writer thread
+        queueMutex.lock();
+        if(pendingLines.count() < maxPendingLines)
+            pendingLines.append(message);
+        else
+            droppedLines++;
+        if((stopLightColor == Red) || (stopLightColor == Yellow))
+            flushNow = true;
+        if(flushNow || (pendingLines.count() >= batchLines))
+            queueReady.wakeAll();
+        queueMutex.unlock();
     }
 
     if(progress!=0) {
@@ -250,35 +291,78 @@ void Log::catchLog(const Message& logEntry)
     if (stopLightColor == Red) {
         emit redLightAbort();
     }
-
-    delete logg;
-    mutex.unlock();
 }
 
-bool Log::writeToFile()
+void Log::writeLoop()
 {
-    if(usingFile.tryLock()) {
-        if(logFile->isOpen()) {
-            logFile->close();
-            //Message::toScreen("LOG: WRITETOFILE: LogFile "+logFile->fileName()+" was open and then I closed it");
-        }
-        //Message::toScreen("LOG: WRITETOFILE: Trying To Open "+logFile->fileName());
-        if(logFile->open(QIODevice::Append)) {
-            while((messagesWaiting.count() > 0)) {
-                logFile->write(messagesWaiting.first().toLatin1());
-                QString message = messagesWaiting.takeFirst();
-            }
+    bool stopping = false;
+    while(!stopping) {
+        queueMutex.lock();
+        if(!stopWriter && !flushNow && (pendingLines.count() < batchLines))
+            queueReady.wait(&queueMutex, flushMsecs);
+        stopping = stopWriter;
+        queueMutex.unlock();
+
+        usingFile.lock();
+        writeToFile();
+        if(stopping && logFile->isOpen())
             logFile->close();
-            if(logFile->isOpen()) {
-                Message::toScreen("When logging messags logFile did not close but did not fail");
-                usingFile.unlock();
-                return false;
-            }
-        }
         usingFile.unlock();
+    }
+}
+
+bool Log::writeToFile()
+{
+    QStringList batch;
+    queueMutex.lock();
+    batch.swap(pendingLines);
+    long dropped = droppedLines;
+    droppedLines = 0;
+    flushNow = false;
+    queueMutex.unlock();
+
+    if(batch.isEmpty() && (dropped == 0))
         return true;
+
+    if(!logFile->isOpen()) {
+        bool isNew = !logFile->exists() || (logFile->size() == 0);
+        if(!logFile->open(QIODevice::Append)) {
+            Message::toScreen("Log: could not open "+logFile->fileName()
+                              +", "+QString().setNum(batch.count())+" messages were not written");
+            return false;
+        }
+        if(isNew || !logFileStarted.isValid())
+            logFileStarted = QDateTime::currentDateTimeUtc();
     }
-    return false;
+
+    QByteArray text;
+    for(int i = 0; i < batch.count(); i++)
+        text += batch[i].toLatin1();
+    if(dropped > 0)
+        text += QString("Log: "+QString().setNum(dropped)
+                        +" messages were dropped, the log could not keep up\n").toLatin1();
+    bool written = (logFile->write(text) == text.size());
+    logFile->flush();
+
+    if((logFile->size() >= maxLogBytes)
+       || (logFileStarted.secsTo(QDateTime::currentDateTimeUtc()) >= maxLogSecs))
+        rotateLogFile();
+    return written;
+}
+
+void Log::rotateLogFile()
+{
+    // name.log becomes name.log.1, name.log.1 becomes name.log.2 and so on
+    QString name = logFile->fileName();
+    logFile->close();
+    QFile::remove(name + "." + QString().setNum(maxRotatedLogs));
+    for(int i = maxRotatedLogs - 1; i >= 1; i--) {
+        QString older = name + "." + QString().setNum(i);
+        if(QFile::exists(older))
+            QFile::rename(older, name + "." + QString().setNum(i + 1));
+    }
+    QFile::rename(name, name + ".1");
+    logFileStarted = QDateTime();
 }
 
 bool Log::handleStopLightUpdate(StopLightColor newColor, QString message, 
@@ -18,8 +18,17 @@
 #include <QDomElement>
 #include <QDir>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QDateTime>
 #include "IO/Message.h"
 
+class LogWriter;
+
+// Log entries are shown right away, but written to the log file by a
+// writer thread in batches, so the threads that log never wait on the
+// disk. The queue is bounded; entries that do not fit are counted and
+// the count is written in their place.
+
 class Log : public QWidget
 {
     Q_OBJECT
@@ -52,11 +61,34 @@ private:
     QDir workingDirectory;
     int absoluteProgress;
     bool displayLocation;
-    QStringList messagesWaiting;
-    // bool usingFile;
+    // Held while the log file is written, copied or renamed
     QMutex usingFile;
 
+    friend class LogWriter;
+    LogWriter *writer;
+    // Guards pendingLines, droppedLines, flushNow and stopWriter
+    QMutex queueMutex;
+    QWaitCondition queueReady;
+    QStringList pendingLines;
+    long droppedLines;
+    bool flushNow;
+    bool stopWriter;
+    QDateTime logFileStarted;
+
+    // The writer wakes this often, or as soon as a batch is full or a
+    // Red or Yellow entry arrives
+    static const int flushMsecs = 1000;
+    static const int batchLines = 256;
+    static const int maxPendingLines = 20000;
+    // The log file is rotated to .1, .2, ... when it is this big or old
+    static const qint64 maxLogBytes = 10 * 1024 * 1024;
+    static const int maxLogSecs = 24 * 3600;
+    static const int maxRotatedLogs = 5;
+
+    void writeLoop();
+    // Call with usingFile locked
     bool writeToFile();
+    void rotateLogFile();
 
     struct SLChange {
         StopLightColor color;
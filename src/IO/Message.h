@@ -53,28 +53,28 @@ public:
 
     ~Message();
 
-    QString getLogMessage() { return logMessage; }
+    QString getLogMessage() const { return logMessage; }
     void setLogMessage(const QString newLogMessage);
     void setLogMessage(const char *newLogMessage);
 
-    int getProgress() { return progress; }
+    int getProgress() const { return progress; }
     void setProgress(int progressPercentage);
 
-    QString getLocation() { return location; }
+    QString getLocation() const { return location; }
     void setLocation(const QString newLocation);
     void setLocation(const char *newLocation);
 
-    StopLightColor getColor() { return color; }
+    StopLightColor getColor() const { return color; }
     void setColor(StopLightColor newColor);
 
-    QString getStopLightMessage() { return stopLightMessage; }
+    QString getStopLightMessage() const { return stopLightMessage; }
     void setStopLightMessage(const QString newStopLightMessage);
     void setStopLightMessage(const char *newStopLightMessage);
 
-    StormSignalStatus getStatus() { return status; }
+    StormSignalStatus getStatus() const { return status; }
     void setStatus(StormSignalStatus newStatus);
 
-    QString getStormSignalMessage() { return stormSignalMessage; }
+    QString getStormSignalMessage() const { return stormSignalMessage; }
     void setStormSignalMessage(const QString newMessage);
     void setStormSignalMessage(const char *newMessage);
 
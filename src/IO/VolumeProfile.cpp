@@ -0,0 +1,161 @@
+/*
+ * VolumeProfile.cpp
+ * VORTRAC
+ *
+ * Time spent in each stage of the analysis and work counters, collected
+ * per radar volume and appended to a file next to the vortex list.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include "VolumeProfile.h"
+
+std::atomic<VolumeProfile*> VolumeProfile::_active(NULL);
+
+VolumeProfile* VolumeProfile::newProfile(const VortexSettings& vortexConfig,
+					 const QString& pathPrefix)
+{
+  const QString& format = vortexConfig.profile;
+  if(format == "jsonl")
+    return new VolumeProfile(pathPrefix + "profile.jsonl", false);
+  if(format == "csv")
+    return new VolumeProfile(pathPrefix + "profile.csv", true);
+  return NULL;
+}
+
+VolumeProfile::VolumeProfile(const QString& filePath, bool csv)
+{
+  _filePath = filePath;
+  _csv = csv;
+  for(int s = 0; s < NumStages; s++)
+    _nsecs[s] = 0;
+  for(int c = 0; c < NumCounters; c++)
+    _counters[c] = 0;
+}
+
+VolumeProfile::~VolumeProfile()
+{
+  if(_active.load() == this)
+    endVolume(false);
+}
+
+void VolumeProfile::beginVolume(const QString& fileName)
+{
+  if(_active.load() == this)
+    endVolume(false);
+
+  _volumeFile = fileName;
+  _volumeTime = QDateTime();
+  for(int s = 0; s < NumStages; s++)
+    _nsecs[s] = 0;
+  for(int c = 0; c < NumCounters; c++)
+    _counters[c] = 0;
+  _volumeTimer.start();
+  _active.store(this);
+}
+
+bool VolumeProfile::endVolume(bool analyzed)
+{
+  VolumeProfile* expected = this;
+  if(!_active.compare_exchange_strong(expected, NULL))
+    return false;
+  qint64 totalNsecs = _volumeTimer.nsecsElapsed();
+
+  QFile file(_filePath);
+  bool writeHeader = _csv && !file.exists();
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    return false;
+  QTextStream out(&file);
+  if(writeHeader)
+    out << csvHeader() << "\n";
+  out << (_csv ? csvRecord(analyzed, totalNsecs) : jsonRecord(analyzed, totalNsecs)) << "\n";
+  out.flush();
+  return (out.status() == QTextStream::Ok);
+}
+
+const char* VolumeProfile::stageName(Stage stage)
+{
+  switch(stage) {
+  case ReadVolume:     return "read_volume";
+  case QualityControl: return "dealias";
+  case Cappi:          return "cappi";
+  case FindCenter:     return "find_center";
+  case Winds:          return "winds";
+  case SaveLists:      return "save_lists";
+  default:             return "unknown";
+  }
+}
+
+const char* VolumeProfile::counterName(Counter counter)
+{
+  switch(counter) {
+  case RingsAnalyzed:      return "rings_analyzed";
+  case SimplexIterations:  return "simplex_iterations";
+  case LeastSquaresSolves: return "lls_solves";
+  case GatesRejected:      return "qc_gates_rejected";
+  default:                 return "unknown";
+  }
+}
+
+static QString msecs(qint64 nsecs)
+{
+  return QString::number(nsecs / 1.0e6, 'f', 3);
+}
+
+QString VolumeProfile::jsonRecord(bool analyzed, qint64 totalNsecs) const
+{
+  QString name = _volumeFile;
+  name.replace("\\", "\\\\").replace("\"", "\\\"");
+
+  QString record = "{\"volume\":\"" + name + "\"";
+  record += ",\"time\":\"" + _volumeTime.toString(Qt::ISODate) + "\"";
+  record += ",\"processed\":\"" + QDateTime::currentDateTimeUtc().toString(Qt::ISODate) + "\"";
+  record += QString(",\"analyzed\":") + (analyzed ? "true" : "false");
+  record += ",\"total_ms\":" + msecs(totalNsecs);
+  record += ",\"stages_ms\":{";
+  for(int s = 0; s < NumStages; s++) {
+    if(s > 0)
+      record += ",";
+    record += QString("\"") + stageName((Stage)s) + "\":" + msecs(_nsecs[s].load());
+  }
+  record += "},\"counters\":{";
+  for(int c = 0; c < NumCounters; c++) {
+    if(c > 0)
+      record += ",";
+    record += QString("\"") + counterName((Counter)c) + "\":"
+      + QString::number(_counters[c].load());
+  }
+  record += "}}";
+  return record;
+}
+
+QString VolumeProfile::csvHeader()
+{
+  QStringList columns;
+  columns << "volume" << "time" << "processed" << "analyzed" << "total_ms";
+  for(int s = 0; s < NumStages; s++)
+    columns << QString(stageName((Stage)s)) + "_ms";
+  for(int c = 0; c < NumCounters; c++)
+    columns << counterName((Counter)c);
+  return columns.join(",");
+}
+
+QString VolumeProfile::csvRecord(bool analyzed, qint64 totalNsecs) const
+{
+  QStringList columns;
+  QString name = _volumeFile;
+  name.replace("\"", "\"\"");
+  columns << "\"" + name + "\"" << _volumeTime.toString(Qt::ISODate)
+	  << QDateTime::currentDateTimeUtc().toString(Qt::ISODate)
+	  << (analyzed ? "1" : "0") << msecs(totalNsecs);
+  for(int s = 0; s < NumStages; s++)
+    columns << msecs(_nsecs[s].load());
+  for(int c = 0; c < NumCounters; c++)
+    columns << QString::number(_counters[c].load());
+  return columns.join(",");
+}
@@ -0,0 +1,131 @@
+/*
+ * VolumeProfile.h
+ * VORTRAC
+ *
+ * Time spent in each stage of the analysis and work counters, collected
+ * per radar volume and appended to a file next to the vortex list.
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef VOLUMEPROFILE_H
+#define VOLUMEPROFILE_H
+
+#include <atomic>
+#include <QString>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include "Config/ConfigSnapshot.h"
+
+// Profiling is turned on with <profile> in the vortex section:
+//   jsonl            one JSON object per volume in <prefix>profile.jsonl
+//   csv              one row per volume in <prefix>profile.csv
+// While no volume is being profiled count() and ProfileTimer only test
+// a pointer, so they can stay in the inner loops.
+
+class VolumeProfile
+{
+
+public:
+  enum Stage {
+    ReadVolume,
+    QualityControl,
+    Cappi,
+    FindCenter,
+    Winds,
+    SaveLists,
+    NumStages
+  };
+
+  enum Counter {
+    RingsAnalyzed,
+    SimplexIterations,
+    LeastSquaresSolves,
+    GatesRejected,
+    NumCounters
+  };
+
+  // Returns NULL if the configuration does not ask for profiling
+  static VolumeProfile* newProfile(const VortexSettings& vortexConfig,
+				   const QString& pathPrefix);
+  ~VolumeProfile();
+
+  QString getFilePath() const { return _filePath; }
+
+  // Everything timed or counted from now on, in any thread, belongs to
+  // this volume. A volume still open is written out first.
+  void beginVolume(const QString& fileName);
+  void setVolumeTime(const QDateTime& volumeTime) { _volumeTime = volumeTime; }
+  // Appends the record of the current volume and stops collecting
+  bool endVolume(bool analyzed = true);
+
+  static bool enabled() { return _active.load(std::memory_order_relaxed) != NULL; }
+
+  static void count(Counter counter, long amount = 1) {
+    VolumeProfile* profile = _active.load(std::memory_order_relaxed);
+    if(profile != NULL)
+      profile->_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  static void addTime(Stage stage, qint64 nsecs) {
+    VolumeProfile* profile = _active.load(std::memory_order_relaxed);
+    if(profile != NULL)
+      profile->_nsecs[stage].fetch_add(nsecs, std::memory_order_relaxed);
+  }
+
+  static const char* stageName(Stage stage);
+  static const char* counterName(Counter counter);
+
+private:
+  VolumeProfile(const QString& filePath, bool csv);
+
+  static std::atomic<VolumeProfile*> _active;
+
+  QString _filePath;
+  bool _csv;
+
+  QString _volumeFile;
+  QDateTime _volumeTime;
+  QElapsedTimer _volumeTimer;
+  std::atomic<qint64> _nsecs[NumStages];
+  std::atomic<long> _counters[NumCounters];
+
+  QString jsonRecord(bool analyzed, qint64 totalNsecs) const;
+  QString csvRecord(bool analyzed, qint64 totalNsecs) const;
+  static QString csvHeader();
+
+  VolumeProfile(const VolumeProfile&);
+  VolumeProfile& operator=(const VolumeProfile&);
+};
+
+// Adds the time until it goes out of scope, or until stop(), to a stage
+// of the volume being profiled
+
+class ProfileTimer
+{
+
+public:
+  ProfileTimer(VolumeProfile::Stage stage) {
+    _stage = stage;
+    _running = VolumeProfile::enabled();
+    if(_running)
+      _timer.start();
+  }
+  ~ProfileTimer() { stop(); }
+
+  void stop() {
+    if(_running) {
+      VolumeProfile::addTime(_stage, _timer.nsecsElapsed());
+      _running = false;
+    }
+  }
+
+private:
+  VolumeProfile::Stage _stage;
+  bool _running;
+  QElapsedTimer _timer;
+};
+
+#endif
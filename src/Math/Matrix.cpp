@@ -12,6 +12,7 @@
 #include <QString>
 #include "Matrix.h"
 #include "IO/Message.h"
+#include "IO/VolumeProfile.h"
 #include <QFile>
 #include <QTextStream>
 
@@ -25,7 +26,57 @@ Matrix::~Matrix()
 
 }
 
+// Relative size below which a Cholesky pivot is treated as zero
+static const double choleskyTolerance = 1.0e-12;
+
+LLSWorkspace::LLSWorkspace(int maxCoeff)
+{
+    capacity = 0;
+    store = NULL;
+    normal = rhs = column = invDiag = NULL;
+    conditionNumber = -999.;
+    assign(inlineStore, inlineCoeff);
+    reserve(maxCoeff);
+}
+
+LLSWorkspace::~LLSWorkspace()
+{
+    if(store != inlineStore)
+        delete[] store;
+}
+
+bool LLSWorkspace::reserve(int numCoeff)
+{
+    if(numCoeff <= capacity)
+        return true;
+
+    double *block = new double[numCoeff * (numCoeff + 3)];
+    if(store != inlineStore)
+        delete[] store;
+    assign(block, numCoeff);
+    return true;
+}
+
+void LLSWorkspace::assign(double *block, int numCoeff)
+{
+    capacity = numCoeff;
+    store = block;
+    normal = store;
+    rhs = normal + numCoeff * numCoeff;
+    column = rhs + numCoeff;
+    invDiag = column + numCoeff;
+}
+
 bool Matrix::lls(const int &numCoeff,const int &numData,float** &x, float* &y, float &stDeviation, float* &coeff, float* &stError)
+{
+    // The workspace lives on the stack and only allocates for unusually
+    // large fits
+    LLSWorkspace work(numCoeff);
+    return lls(work, numCoeff, numData, x, y, stDeviation, coeff, stError);
+}
+
+bool Matrix::lls(LLSWorkspace &work, const int &numCoeff, const int &numData,
+                 float** &x, float* &y, float &stDeviation, float* &coeff, float* &stError)
 {
     /*
    * this function solve a problem xa=y
@@ -37,112 +88,137 @@ bool Matrix::lls(const int &numCoeff,const int &numData,float** &x, float* &y, f
    *
    */
 
+    work.conditionNumber = -999.;
+
     if(numData < numCoeff) {
         //emit log(Message("Least Squares: Not Enough Data"));
         return false;
     }
-    // We need at least one more data point than coefficient in order to
-    // estimate the standard deviation of the fit.
+    if(!llsBegin(work, numCoeff))
+        return false;
 
-    float** A = new float*[numCoeff];
-    float** AA = new float*[numCoeff];
-    float* B = new float[numCoeff];
-    float** BB = new float*[numCoeff];
-    for(int row = 0; row < numCoeff; row++) {
-        A[row] = new float[numCoeff];
-        AA[row] = new float[numCoeff];
-        BB[row] = new float[1];
-        for(int col = 0; col < numCoeff; col++) {
-            A[row][col] = 0;
-            AA[row][col] = 0;
-            BB[row][0] = 0;
-        }
-        B[row] = 0;
+    int n = numCoeff;
+    double* A = work.normal;
+    double* B = work.rhs;
+    for(int row = 0; row < n; row++)
         coeff[row] = 0;
-    }
 
     // accumulate the covariances of all the data into the regression
-    // matrices
+    // matrices, upper triangle only since A is symmetric
 
     for(long i = 0; i < numData; i++) {
-        for(int row = 0; row < numCoeff; row++) {
-            for(int col = 0; col < numCoeff; col++) {
-                A[row][col] +=(x[row][i]*x[col][i]);
-                AA[row][col]+=(x[row][i]*x[col][i]);
-            }
-            B[row]     +=(x[row][i]*y[i]);
-            BB[row][0] +=(x[row][i]*y[i]);
+        for(int row = 0; row < n; row++) {
+            double xRow = x[row][i];
+            double* ARow = A + row*n;
+            for(int col = row; col < n; col++)
+                ARow[col] += xRow*x[col][i];
+            B[row] += xRow*y[i];
         }
     }
 
-
-    float** Ainv = new float*[numCoeff];
-    for(int p = 0; p < numCoeff; p++)
-        Ainv[p] = new float[numCoeff];
-
-    //The C++ Recipes Code Works so All this can be done away with
-
-    /*
-  // find the inverse of A
-  if(!matrixInverse(A, numCoeff, numCoeff, Ainv)) {
-    Message::toScreen("lls: matrix inverse failed");
-    return false;
-  }
-  
-  // use the inverse of A to find coeff
-  if(!matrixMultiply(Ainv, numCoeff, numCoeff, B, numCoeff, coeff, numCoeff)) {
-    Message::toScreen("lls: Matrix Multiply Failed");
-    return false;
-  }
-  */
-
-
-    //Message::toScreen("Printing AA");
-    //printMatrix(AA, numCoeff, numCoeff);
-
-    //Message::toScreen("Printing BB");
-    //printMatrix(BB, numCoeff, 1);
-
-
-    if(!gaussJordan(AA,BB, numCoeff, 1)) {
+    if(!llsSolve(work, numCoeff, numData, coeff)) {
         // emit log(Message("Least Squares Fit Failed"));
         return false;
     }
 
-
-    //printMatrix(BB, numCoeff, 1);
-
-    /*
-  Message::toScreen("CHECK: coeff[0] = "+QString().setNum(coeff[0])+" coeff[1] = "
-   +QString().setNum(coeff[1])+" coeff[2] = "
-   +QString().setNum(coeff[2]));
-  Message::toScreen("     : BB[0][0] = "+QString().setNum(BB[0][0])+" BB[1][0] = "
-   +QString().setNum(BB[1][0])+" BB[2][0] = "
-   +QString().setNum(BB[2][0]));
-  */
-
-    for(int i = 0; i < numCoeff; i++) {
-        coeff[i] = BB[i][0];
-        for(int j = 0; j < numCoeff; j++) {
-            Ainv[i][j] = AA[i][j];
-        }
-    }
-
     // calculate the stDeviation and stError
-    float sum = 0;
+    double sum = 0;
     for(long i = 0; i < numData; i++) {
         float regValue = 0;
-        for(int j = 0; j < numCoeff; j++) {
+        for(int j = 0; j < n; j++) {
             regValue += coeff[j]*x[j][i];
         }
         sum +=((y[i]-regValue)*(y[i]-regValue));
     }
 
+    llsErrors(work, numCoeff, numData, sum, stDeviation, stError);
+    return true;
+}
 
-    if(numData!=numCoeff)
-        stDeviation = sqrt(sum/float(numData-long(numCoeff)));
+bool Matrix::llsBegin(LLSWorkspace &work, const int &numCoeff)
+{
+    work.conditionNumber = -999.;
+    if((numCoeff <= 0) || !work.reserve(numCoeff))
+        return false;
+
+    int n = numCoeff;
+    for(int k = 0; k < n*n; k++)
+        work.normal[k] = 0;
+    for(int row = 0; row < n; row++)
+        work.rhs[row] = 0;
+    return true;
+}
+
+void Matrix::llsAdd(LLSWorkspace &work, const int &numCoeff, const float *row,
+                    const float &y)
+{
+    int n = numCoeff;
+    for(int r = 0; r < n; r++) {
+        double xRow = row[r];
+        double* ARow = work.normal + r*n;
+        for(int col = r; col < n; col++)
+            ARow[col] += xRow*row[col];
+        work.rhs[r] += xRow*y;
+    }
+}
+
+bool Matrix::llsSolve(LLSWorkspace &work, const int &numCoeff, const long &numData,
+                      float *coeff)
+{
+    if(numData < numCoeff)
+        return false;
+    VolumeProfile::count(VolumeProfile::LeastSquaresSolves);
+
+    int n = numCoeff;
+    double* A = work.normal;
+    double* B = work.rhs;
+
+    // Fill in the lower triangle and take the 1-norm for the condition number
+    double normA = 0;
+    for(int row = 0; row < n; row++)
+        for(int col = 0; col < row; col++)
+            A[row*n + col] = A[col*n + row];
+    for(int col = 0; col < n; col++) {
+        double sum = 0;
+        for(int row = 0; row < n; row++)
+            sum += fabs(A[row*n + col]);
+        if(sum > normA)
+            normA = sum;
+    }
+
+    if(!choleskyFactor(A, n))
+        return false;
+
+    choleskySolve(A, n, B);
+    for(int i = 0; i < n; i++)
+        coeff[i] = B[i];
+
+    // Columns of the inverse give the standard errors and the condition number
+    double normInv = 0;
+    for(int col = 0; col < n; col++) {
+        double* e = work.column;
+        for(int row = 0; row < n; row++)
+            e[row] = 0;
+        e[col] = 1;
+        choleskySolve(A, n, e);
+        work.invDiag[col] = e[col];
+        double sum = 0;
+        for(int row = 0; row < n; row++)
+            sum += fabs(e[row]);
+        if(sum > normInv)
+            normInv = sum;
+    }
+    work.conditionNumber = normA*normInv;
+    return true;
+}
+
+void Matrix::llsErrors(LLSWorkspace &work, const int &numCoeff, const long &numData,
+                       const double &sumSquares, float &stDeviation, float *stError)
+{
+    if(numData != numCoeff)
+        stDeviation = sqrt(sumSquares/float(numData-long(numCoeff)));
     else
-        stDeviation = sqrt(sum);
+        stDeviation = sqrt(sumSquares);
 
     // Added this to avoid getting bad numbers, don't know if it is statistically
     // correct, made note of it and will check later - LM (Aug 13)
@@ -150,26 +226,48 @@ bool Matrix::lls(const int &numCoeff,const int &numData,float** &x, float* &y, f
     // calculate the standard error for the coefficients
 
     for(int i = 0; i < numCoeff; i++) {
-        stError[i] = stDeviation*sqrt(fabs(Ainv[i][i]));
+        stError[i] = stDeviation*sqrt(fabs(work.invDiag[i]));
     }
+}
 
-    // Clean up
-    for(int row = 0; row < numCoeff; row++) {
-        delete[] A[row];
-        delete[] AA[row];
-        delete[] BB[row];
+bool Matrix::choleskyFactor(double *A, int n)
+{
+    for(int j = 0; j < n; j++) {
+        double* Lj = A + j*n;
+        double diag = Lj[j];
+        double d = diag;
+        for(int k = 0; k < j; k++)
+            d -= Lj[k]*Lj[k];
+        if((d <= 0) || (d <= choleskyTolerance*diag))
+            return false;
+        Lj[j] = sqrt(d);
+        for(int i = j+1; i < n; i++) {
+            double* Li = A + i*n;
+            double s = Li[j];
+            for(int k = 0; k < j; k++)
+                s -= Li[k]*Lj[k];
+            Li[j] = s/Lj[j];
+        }
     }
-    delete[] A;
-    delete[] AA;
-    delete[] B;
-    delete[] BB;
-
-    for(int p = 0; p < numCoeff; p++)
-        delete[] Ainv[p];
-    delete[] Ainv;
-
     return true;
-} 
+}
+
+void Matrix::choleskySolve(const double *L, int n, double *b)
+{
+    // Forward substitution with L, then back substitution with L^T
+    for(int i = 0; i < n; i++) {
+        double s = b[i];
+        for(int k = 0; k < i; k++)
+            s -= L[i*n + k]*b[k];
+        b[i] = s/L[i*n + i];
+    }
+    for(int i = n-1; i >= 0; i--) {
+        double s = b[i];
+        for(int k = i+1; k < n; k++)
+            s -= L[k*n + i]*b[k];
+        b[i] = s/L[i*n + i];
+    }
+}
 
 bool Matrix::oldlls(const int &numCoeff,const long &numData, 
                     float** &x, float* &y,
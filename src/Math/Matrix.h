@@ -11,6 +11,50 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+class Matrix;
+
+// Scratch space for the normal equations solved by Matrix::lls. Sized once
+// for the largest fit a caller makes, so repeated fits do not allocate.
+// Fits of up to inlineCoeff coefficients need no heap memory at all.
+
+class LLSWorkspace
+{
+
+public:
+
+  LLSWorkspace(int maxCoeff = 0);
+  ~LLSWorkspace();
+
+  // Make room for numCoeff coefficients, keeping the current size if it
+  // is already large enough
+  bool reserve(int numCoeff);
+  int getMaxCoeff() const { return capacity; }
+
+  // 1-norm condition number of the normal matrix of the last fit, or
+  // -999 if the last fit failed before it could be computed
+  double getConditionNumber() const { return conditionNumber; }
+
+private:
+
+  friend class Matrix;
+
+  LLSWorkspace(const LLSWorkspace &other);
+  LLSWorkspace& operator=(const LLSWorkspace &other);
+
+  static const int inlineCoeff = 16;
+
+  int capacity;
+  double *store;
+  double *normal;   // capacity x capacity, the normal matrix then its Cholesky factor
+  double *rhs;      // right hand side, then the solution
+  double *column;   // one column of the inverse
+  double *invDiag;  // diagonal of the inverse
+  double conditionNumber;
+  double inlineStore[inlineCoeff * (inlineCoeff + 3)];
+
+  void assign(double *block, int numCoeff);
+};
+
 class Matrix
 {
 
@@ -24,6 +68,30 @@ public:
   // Preforms a least squares regression on the velocity values
   // on the selected VAD ring to deduce the environmental wind
 
+  static bool lls(LLSWorkspace &work, const int &numCoeff, const int &numData,
+		  float** &x, float* &y,
+		  float &stDeviation, float* &coeff, float* &stError);
+  // Same fit using the caller's workspace. The normal equations are
+  // accumulated in double precision and solved by Cholesky factorization;
+  // the condition number is left in the workspace.
+
+  static bool llsBegin(LLSWorkspace &work, const int &numCoeff);
+  static void llsAdd(LLSWorkspace &work, const int &numCoeff, const float *row,
+		     const float &y);
+  static bool llsSolve(LLSWorkspace &work, const int &numCoeff, const long &numData,
+		       float *coeff);
+  static void llsErrors(LLSWorkspace &work, const int &numCoeff, const long &numData,
+			const double &sumSquares, float &stDeviation, float *stError);
+  // The same fit built one data row at a time, for callers that do not
+  // keep the design matrix: llsBegin, llsAdd for each row, llsSolve, then
+  // llsErrors with the sum of the squared residuals of the solution.
+
+  static bool choleskyFactor(double *A, int n);
+  static void choleskySolve(const double *L, int n, double *b);
+  // A is n x n, row major and symmetric. choleskyFactor overwrites the
+  // lower triangle with L (A = L L^T) and fails if A is not numerically
+  // positive definite. choleskySolve overwrites b with the solution.
+
   static bool oldlls(const int &numCoeff, const long &numData, 
 		  float** &x, float* &y, 
 		  float &stDeviation, float* &coeff, float* &stError, 
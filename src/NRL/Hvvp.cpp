@@ -38,7 +38,8 @@ Hvvp::Hvvp()
 	xlsDimension = 16;
 	// New HVVP number of predictor variables
 	//  xlsDimension = 10;
-	maxpoints = 500000;               // **
+	row.resize(xlsDimension);
+	llsWork.reserve(xlsDimension);
   
 	z = new float[levels];
 	u = new float[levels];
@@ -62,15 +63,6 @@ Hvvp::Hvvp()
 		xr[i] = velNull;
 	}
 
-	xls = new float*[xlsDimension];
-	wgt = new float[maxpoints];
-	yls = new float[maxpoints];
-	for(int k = 0; k < xlsDimension; k++) {
-		xls[k] = new float[maxpoints];
-		for(long kk = 0; kk < maxpoints; kk++)
-			xls[k][kk] = velNull;
-	}
-
 	printOutput = true;
 	hgtStart = .600;                // km   // Most Recently Used
 	//hgtStart = 1.0;
@@ -91,13 +83,6 @@ Hvvp::~Hvvp()
 	delete [] vt;
 	delete [] xr;
 	delete [] vr;
-  
-	for(int i = 0; i < xlsDimension; i++) {
-		delete [] xls[i];
-	}
-	delete [] yls;
-	delete [] xls;
-	delete [] wgt;
 }
 
 void Hvvp::setRadarData(RadarData *newVolume, float range, float angle, float vortexRmw)
@@ -108,20 +93,17 @@ void Hvvp::setRadarData(RadarData *newVolume, float range, float angle, float vo
 	rmw = vortexRmw;        // in km
 }
 
-void Hvvp::setConfig(Configuration* newConfig)
+void Hvvp::setConfig(const ConfigSnapshot& settings)
 {
-	configData = newConfig;
-  
 	// Load all configuration parameters
 	// If this function is not called the parameters default
 	//  to values in the constructor
 
-	QDomElement hvvp = configData->getConfig("hvvp");
-	levels = configData->getParam(hvvp, QString("levels")).toInt();
-	hgtStart = configData->getParam(hvvp, QString("hgt_start")).toFloat();
-	hInc = configData->getParam(hvvp, QString("hinc")).toFloat();
-	xt_threshold = configData->getParam(hvvp, QString("xt")).toFloat();
-	QDir workingDirectoryPath(configData->getParam(configData->getConfig("vortex"),"dir"));
+	levels = settings.hvvp.levels;
+	hgtStart = settings.hvvp.hgtStart;
+	hInc = settings.hvvp.hInc;
+	xt_threshold = settings.hvvp.xt;
+	QDir workingDirectoryPath(settings.vortex.dir);
 	HVVPLogFile.setFileName(workingDirectoryPath.filePath("HVVP_output.txt"));
   
 }
@@ -137,176 +119,209 @@ float Hvvp::rotateAzimuth(const float &angle)
 	return newAngle;
 }
 
-long Hvvp::hvvpPrep(int m) {
+void Hvvp::collectGates(int numLevels) {
+
+	/*
+	* Collects the gates of the first numLevels levels in one pass over the
+	*   volume. A level is a layer 2*hInc thick, so most gates fall in two
+	*   levels.
+	*
+	*/
 
 	float cumin = 5.0/rt;                 // What are the units here?
 	float cuspec = 0.6;                   // Unitless
 	float curmw = (rt - rmw)/rt;          // Unitless
 	float cuthr;                          // Unitless
 	float ae = 4.0*6371.0/3.0;                // km
-	Sweep* currentSweep = NULL;
-	Ray* currentRay = NULL;
-	float* vel = NULL; 
 
 	if(cuspec < curmw)
 		cuthr = cuspec; 
 	else 
 		cuthr = curmw;
 
-	/*
-	// For Printing the results to file for Fortran Comparisons
- 
-	Message::toScreen("hgtStart = "+QString().setNum(hgtStart)+" hInc = "+QString().setNum(hInc));
-  
-	QString fileName("PointsSelected_BigLevel"+QString().setNum(m)+".csv");
-	QFile* outputFile = new QFile(fileName);
-	outputFile->open(QIODevice::WriteOnly);
-	QTextStream out(outputFile);
-	out << "Printing Data Points in Level " << m << endl;
-	Message::toScreen("Writing to "+outputFile->fileName()+" .... ");
-  
-	if(m == 0) {
-	out << "CUTHR, "<< cuthr << endl;
-	out << "CUMIN, "<< cumin << endl;
-	out << " alt(km), cu, Vd(m/s), elvn(adjusted for range in rad), ray index, az(after rotation in rad)" << endl;
-	}
-	*/ // End Comments
-  
 	rot = cca*deg2rad;               // ** 
 	// float rot = (cca-4.22)*deg2rad; **
 	// ** Special case scenerio for KBRO Data of Bret (1999)
-  
-	for(int k = 0; k < xlsDimension; k++) {
-		for(long l = 0; l < maxpoints; l++) {
-			xls[k][l] = 0;
-			yls[l] = 0;
-		}
-	}
 
-	long count = 0;
-	float h0 = hgtStart+hInc*float(m);
-	z[m] = h0;
-	float hLow = h0-hInc;
-	float hHigh = h0+hInc;
-
-	//  out << " num sweeps = " << volume->getNumSweeps();
+	gates.clear();
+	levelGates.resize(numLevels);
+	for(int m = 0; m < numLevels; m++)
+		levelGates[m].clear();
 
 	for(int s = 0; s < volume->getNumSweeps(); s++) {
-		currentSweep = volume->getSweep(s);
-		//float elevation = currentSweep->getElevation();     // deg
-		// if(elevation <= 5.0) {
+		Sweep* currentSweep = volume->getSweep(s);
 		int startRay = currentSweep->getFirstRay();
 		int stopRay = currentSweep->getLastRay();
 		for(int r = startRay; r <= stopRay; r++) {
-			currentRay = volume->getRay(r);
+			Ray* currentRay = volume->getRay(r);
 			float elevation = currentRay->getElevation();
 			// Current HVVP set elevation max to 5.0
 			// New HVVP set elevation max to 25.0
-			if(elevation <= 5.0) {                           // deg
-				vel = currentRay->getVelData();          // still in km/s
-				//	float vGateSpace = currentRay->getVel_gatesp(); // in m
-				//	vGateSpace /= 1000.0;   // now in km
-				float numGates = currentRay->getVel_numgates();
-				int first = 0;
-				// int first = currentRay->getFirst_vel_gate();   
-				// What does getFirst_vel_gate actually return?
-				// Index or distance?
-				// Are the limits on this ray right or should i go
-				// to first+numGates is ? -LM
-				float aa = currentRay->getAzimuth();
-				aa = rotateAzimuth(aa)*deg2rad;
-				float sinaa = sin(aa);
-				float cosaa = cos(aa);
-				for(int v = first; v < numGates; v++) {
-					if(vel[v]!=velNull) {
-						// PH 10/2007.  need accurate range - previously missing first gate distance 
-						// which  has usually been -0.375 m (due to radar T/R time delay) but is now
-						// 0.125 m for VCP 211.
-						float srange =  float(currentRay->getFirst_vel_gate()+(v*currentRay->getVel_gatesp()))/1000.;
-
-						//	    float srange = (rangeStart+float(v)*vGateSpace);
-						float cu = srange/rt * cos(elevation*deg2rad);    // unitless
-						//float alt = volume->absoluteRadarBeamHeight(srange, elevation);  // km
-						float alt = volume->radarBeamHeight(srange, elevation);  // km
-						if((cu > cumin)&&(cu < cuthr)&&(alt >= hLow)&&(alt < hHigh)) {
-							float ee = elevation*deg2rad;
-							ee+=asin(srange*cos(elevation*deg2rad)/(ae+alt));
-							float cosee = cos(ee);
-							float xx = srange*cosee*sinaa;
-							float yy = srange*cosee*cosaa;
-							float rr = srange*srange*cosee*cosee*cosee;
-							float zz = alt-h0;
-
-							//Used for checking the first ten entries
-							/*
-							//if(((count<=30)||(s == 6))&&(m==0)){
-							out << count << "= v: " << vel[v] << " gate " << v << " ray " <<r-startRay << " orig az = " << currentRay->getAzimuth() << endl;
-							out << " elev# " << s << " = " << elevation << endl;
-							out << count << "= srange: " << srange << " cu " << cu << " alt " << alt << " zz " << zz << endl;
-							}
-							// Comments End For Paul's Test      
-							if(m == 0) {
-							// What Paul would like to receive for comparisons
-							out << alt << ", " << cu << ", " << vel[v] << ", " << ee << ", "<< r << ", " << aa << endl;
-							}
-							// Comments Begin For Paul's Test
-	      
-							//What I was using for test comparisons
-							out << vel[v] << ", " << v << ", " << r-startRay <<", " << currentRay->getAzimuth() << ", " << s << ",  " << elevation << ", " << srange << ", " << cu << ", " << alt << ", " << zz << endl;
-		
-
-							}
-							*/
-	      
-							yls[count] = vel[v];
-							wgt[count] = 1; 
-							// why are we weighting it if they are all the same? -LM
-							xls[0][count] = sinaa*cosee;
-							xls[1][count] = cosee*sinaa*xx;
-							xls[2][count] = cosee*sinaa*zz;
-							xls[3][count] = cosaa*cosee;
-							xls[4][count] = cosee*cosaa*yy;
-							xls[5][count] = cosee*cosaa*zz;
-							xls[6][count] = cosee*sinaa*yy;
-							// For new HVVP comment out to xls[15][count]
-							xls[7][count] = rr*sinaa*sinaa*sinaa;
-							xls[8][count] = rr*sinaa*cosaa*cosaa;
-							xls[9][count] = rr*cosaa*cosaa*cosaa;
-							xls[10][count] = rr*cosaa*sinaa*sinaa;
-							xls[11][count] = cosee*sinaa*xx*zz;
-							xls[12][count] = cosee*cosaa*yy*zz;
-							xls[13][count] = cosee*sinaa*zz*zz;
-							xls[14][count] = cosee*cosaa*zz*zz;
-							xls[15][count] = cosee*sinaa*yy*zz;
-							// For new HVVP, uncomment to xls[9][count] 
-							//              xls[7][count] = rr*sinaa;
-							//              xls[8][count] = rr*cosaa;
-							//              xls[9][count] = (1.0 + sinaa*cosaa)*zz*srange*cosee*cosee;
-							if (count < maxpoints) {
-								count++;
-							} else {
-								// emit log(Message(QString("Truncating HVVP at 500k rows"), 0,this->objectName()));
-								break;
-							}
-						}
+			if(elevation > 5.0)                            // deg
+				continue;
+			float* vel = currentRay->getVelData();          // still in km/s
+			float numGates = currentRay->getVel_numgates();
+			float aa = currentRay->getAzimuth();
+			aa = rotateAzimuth(aa)*deg2rad;
+			float sinaa = sin(aa);
+			float cosaa = cos(aa);
+			for(int v = 0; v < numGates; v++) {
+				if(vel[v]==velNull)
+					continue;
+				// PH 10/2007.  need accurate range - previously missing first gate distance 
+				// which  has usually been -0.375 m (due to radar T/R time delay) but is now
+				// 0.125 m for VCP 211.
+				float srange =  float(currentRay->getFirst_vel_gate()+(v*currentRay->getVel_gatesp()))/1000.;
+				float cu = srange/rt * cos(elevation*deg2rad);    // unitless
+				if((cu <= cumin)||(cu >= cuthr))
+					continue;
+				float alt = volume->radarBeamHeight(srange, elevation);  // km
+
+				// The levels whose layer holds alt, tested the way the
+				// layers are defined so the edges fall the same way
+				int mNear = (int)floorf((alt-hgtStart)/hInc);
+				long index = gates.size();
+				bool used = false;
+				for(int m = qMax(mNear-1, 0); m <= qMin(mNear+2, numLevels-1); m++) {
+					float h0 = hgtStart+hInc*float(m);
+					float hLow = h0-hInc;
+					float hHigh = h0+hInc;
+					if((alt >= hLow)&&(alt < hHigh)) {
+						levelGates[m].push_back(index);
+						used = true;
 					}
 				}
-				vel = NULL;
+				if(!used)
+					continue;
+
+				float ee = elevation*deg2rad;
+				ee+=asin(srange*cos(elevation*deg2rad)/(ae+alt));
+				float cosee = cos(ee);
+				HvvpGate gate;
+				gate.vel = vel[v];
+				gate.sinaa = sinaa;
+				gate.cosaa = cosaa;
+				gate.cosee = cosee;
+				gate.xx = srange*cosee*sinaa;
+				gate.yy = srange*cosee*cosaa;
+				gate.rr = srange*srange*cosee*cosee*cosee;
+				gate.alt = alt;
+				gates.push_back(gate);
 			}
-			currentRay = NULL;
 		}
-		currentSweep = NULL;
 	}
-	delete currentSweep;
-	delete currentRay;
-	delete vel;
+}
+
+void Hvvp::designRow(const HvvpGate& gate, float zz, float* x) const
+{
+	// One row of the fit for a gate zz km above the level
+	float sinaa = gate.sinaa;
+	float cosaa = gate.cosaa;
+	float cosee = gate.cosee;
+	float xx = gate.xx;
+	float yy = gate.yy;
+	float rr = gate.rr;
+
+	x[0] = sinaa*cosee;
+	x[1] = cosee*sinaa*xx;
+	x[2] = cosee*sinaa*zz;
+	x[3] = cosaa*cosee;
+	x[4] = cosee*cosaa*yy;
+	x[5] = cosee*cosaa*zz;
+	x[6] = cosee*sinaa*yy;
+	// For new HVVP comment out to x[15]
+	x[7] = rr*sinaa*sinaa*sinaa;
+	x[8] = rr*sinaa*cosaa*cosaa;
+	x[9] = rr*cosaa*cosaa*cosaa;
+	x[10] = rr*cosaa*sinaa*sinaa;
+	x[11] = cosee*sinaa*xx*zz;
+	x[12] = cosee*cosaa*yy*zz;
+	x[13] = cosee*sinaa*zz*zz;
+	x[14] = cosee*cosaa*zz*zz;
+	x[15] = cosee*sinaa*yy*zz;
+	// For new HVVP, uncomment to x[9]
+	//              x[7] = rr*sinaa;
+	//              x[8] = rr*cosaa;
+	//              x[9] = (1.0 + sinaa*cosaa)*zz*srange*cosee*cosee;
+}
+
+bool Hvvp::fitGates(int m, bool skipOutliers, float* cc, float* stand_err, float& sse)
+{
+	// Least squares fit of level m, accumulating the normal equations
+	// gate by gate
+	const std::vector<long>& members = levelGates[m];
+	float h0 = hgtStart+hInc*float(m);
+	float* x = &row[0];
+
+	if(!Matrix::llsBegin(llsWork, xlsDimension))
+		return false;
+	long numData = 0;
+	for(size_t n = 0; n < members.size(); n++) {
+		if(skipOutliers && outliers[n])
+			continue;
+		const HvvpGate& gate = gates[members[n]];
+		designRow(gate, gate.alt-h0, x);
+		Matrix::llsAdd(llsWork, xlsDimension, x, gate.vel);
+		numData++;
+	}
+	if(!Matrix::llsSolve(llsWork, xlsDimension, numData, cc))
+		return false;
+
+	double sum = 0;
+	for(size_t n = 0; n < members.size(); n++) {
+		if(skipOutliers && outliers[n])
+			continue;
+		const HvvpGate& gate = gates[members[n]];
+		designRow(gate, gate.alt-h0, x);
+		float regValue = 0;
+		for(int p = 0; p < xlsDimension; p++)
+			regValue += cc[p]*x[p];
+		sum += ((gate.vel-regValue)*(gate.vel-regValue));
+	}
+	Matrix::llsErrors(llsWork, xlsDimension, numData, sum, sse, stand_err);
+	return true;
+}
+
+bool Hvvp::fitLevel(int m, bool both, float* cc, float* stand_err, float& sse)
+{
+	const std::vector<long>& members = levelGates[m];
+	float h0 = hgtStart+hInc*float(m);
+	float* x = &row[0];
 
-	//out << "Level " << m << " count = " << count << endl;
-	//Message::toScreen("Level "+QString().setNum(m)+" count = "+QString().setNum(count));
+	outliers.assign(members.size(), false);
+	if(!fitGates(m, false, cc, stand_err, sse))
+		return false;
+
+	/*
+	* Check for outliers that deviate more than two standard 
+	*   deviations from the least squares fit.
+	*
+	*/
+
+	bool outlier = false;
+	long cgood = 0;
+	for(size_t n = 0; n < members.size(); n++) {
+		const HvvpGate& gate = gates[members[n]];
+		designRow(gate, gate.alt-h0, x);
+		float vr_est = 0;
+		for(int p = 0; p < xlsDimension; p++) {
+			vr_est = vr_est+cc[p]*x[p];
+		}
+		if(fabs(vr_est-gate.vel)>2.0*sse) {
+			outliers[n] = true;
+			outlier = true;
+		}
+		else {
+			cgood++;
+		}
+	}
 
-	//outputFile->close();
+	// Re-calculate the least squares solution if outliers are found.
+	// If the second fit fails the first one stands.
+	if(both && outlier && (cgood >=long(6500)))
+		fitGates(m, true, cc, stand_err, sse);
 
-	return count;
+	return true;
 }
 
 bool Hvvp::findHVVPWinds(bool both)
@@ -339,6 +354,8 @@ bool Hvvp::findHVVPWinds(bool both)
 	// For updating the percentage bar we have 7% to give away in this routine
 	float increment = float(levels)/7.0;
 
+	collectGates(levels);
+
 	for(int m = 0; m < levels; m++) {
 
 		if(int((m+1)/increment) > last) {
@@ -348,7 +365,8 @@ bool Hvvp::findHVVPWinds(bool both)
 
 		xt[m] = velNull; 
 
-		count = hvvpPrep(m);
+		z[m] = hgtStart+hInc*float(m);
+		count = levelGates[m].size();
 
 		/* 
 		* Empirically determined limit to the minimum number of points
@@ -362,107 +380,11 @@ bool Hvvp::findHVVPWinds(bool both)
 			float sse;
 			float *stand_err = new float[xlsDimension];
 			float *cc = new float[xlsDimension];
-			bool flag, outlier;
-      
-			// Only for comparisons in Mathematica
-			/* // Comment start here
-			QString fileName("/scr/science40/mauger/Working/trunk/hvvp1824CharBigRepeat"+QString().setNum(m)+".dat");
-			writeToFile(fileName,xlsDimension,count,count,1,xls,yls);
-			QString midFileName = fileName+QString(".printA");
-			flag = Matrix::oldlls(xlsDimension, count, xls, yls, sse, cc, stand_err, midFileName);
-			Message::toScreen(QString(" count = ")+QString().setNum(count));
-			QFile* outputFile = new QFile(fileName+QString(".cpplls"));
-			outputFile->open(QIODevice::WriteOnly);
-			QTextStream out(outputFile);
-			out << "Volume Used" << volume->getDateTimeString() << endl;
-			out << "Range: " << rt << endl;
-			out << "CCA: " << cca << endl;
-			out << "RMW: " << rmw << endl;
-			out << endl;
-			out << "OLD C++ ROUTINE" << endl << endl;
-			out << "SSE: "<<sse<<endl;
-			out << "stand_dev@" << m << ": " << sse << endl;
-			for(int zz = 0; zz < xlsDimension; zz++) {
-			out << cc[zz] << " " << stand_err[zz] << endl;
-			}
-      
-			flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
-      
-			out << "NEW C++ ROUTINE" << endl << endl;
-			out << "SSE: "<< sse << endl;
-			out << "stand_dev@" << m << ": " << sse << endl;
-			for(int zz = 0; zz < xlsDimension; zz++) {
-			out << cc[zz] << " " << stand_err[zz] << endl;
-			}
-      
-			outputFile->close();
-			*/ // comments end here
+			bool flag;
       
-			flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
-
-			//Message::toScreen("SSE = "+QString().setNum(sse));
-
-			//Message::toScreen("Finished Printing in HVVP");
-
-			/*
-			* Check for outliers that deviate more than two standard 
-			*   deviations from the least squares fit.
-			*
-			*/
+			flag = fitLevel(m, both, cc, stand_err, sse);
 
 			if(flag) {
-				outlier = false;
-				long cgood = 0;
-				for (long n = 0; n < count; n++) {
-					float vr_est = 0;
-					for(int p = 0; p < xlsDimension; p++) {
-						vr_est = vr_est+cc[p]*xls[p][n];
-					}
-					if(fabs(vr_est-yls[n])>2.0*sse) {
-						yls[n] = velNull;
-						outlier = true;
-					}
-					else {
-						cgood++;
-					}
-				}
-
-				// Re-calculate the least squares solution if outliers are found.
-
-
-
-				if(both) {
-					if(outlier && (cgood >=long(6500))) {
-						long qc_count = 0;
-						float** qcxls = new float*[xlsDimension];
-						float* qcyls = new float[count];
-						for(int d = 0; d < xlsDimension; d++) {
-							qcxls[d] = new float[count];
-						} 
-						for (long n = 0; n < count; n++) {
-							qcyls[n] = 0;
-							for(int p = 0; p < xlsDimension; p++) {
-								qcxls[p][n] = 0;
-							}
-
-							if(yls[n] != velNull) {
-								qcyls[qc_count] = yls[n];
-								for(int p = 0; p < xlsDimension; p++) {
-									qcxls[p][qc_count] = xls[p][n];
-								}
-								qc_count++;
-							}
-						}
-						// Message::toScreen("qc_count = "+QString().setNum(qc_count));
-						flag=Matrix::lls(xlsDimension,qc_count,qcxls,qcyls,sse,cc,stand_err);
-						for(int ii = 0; ii < xlsDimension; ii++) {
-							delete [] qcxls[ii];
-						}
-						delete [] qcxls;
-						delete [] qcyls;
-					}
-				}
-
 				// Calculate the HVVP wind parameters:
 
 				// Radial wind above the radar.
@@ -778,66 +700,18 @@ bool Hvvp::computeCrossBeamWind(float height, float& cc0, float& cc6, float& sse
 	}
 
 	hgtStart = height;
-	int count = hvvpPrep(0);
+	collectGates(1);
+	long count = levelGates[0].size();
 
 	if(count >= 6500) {
 
 		float *stand_err = new float[xlsDimension];
 		float *cc = new float[xlsDimension];
-		bool flag, outlier;
+		bool flag;
 
-		flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
+		flag = fitLevel(0, true, cc, stand_err, sse);
 
 		if(flag) {
-			outlier = false;
-			long cgood = 0;
-			for (long n = 0; n < count; n++) {
-				float vr_est = 0;
-				for(int p = 0; p < xlsDimension; p++) {
-					vr_est = vr_est+cc[p]*xls[p][n];
-				}
-				if(fabs(vr_est-yls[n])>2.0*sse) {
-					yls[n] = velNull;
-					outlier = true;
-				}
-				else {
-					cgood++;
-				}
-			}
-
-			// Re-calculate the least squares solution if outliers are found.
-			if(1) {
-				if(outlier && (cgood >=long(6500))) {
-					long qc_count = 0;
-					float** qcxls = new float*[xlsDimension];
-					float* qcyls = new float[count];
-					for(int d = 0; d < xlsDimension; d++) {
-						qcxls[d] = new float[count];
-					} 
-					for (long n = 0; n < count; n++) {
-						qcyls[n] = 0;
-						for(int p = 0; p < xlsDimension; p++) {
-							qcxls[p][n] = 0;
-						}
-
-						if(yls[n] != velNull) {
-							qcyls[qc_count] = yls[n];
-							for(int p = 0; p < xlsDimension; p++) {
-								qcxls[p][qc_count] = xls[p][n];
-							}
-							qc_count++;
-						}
-					}
-					// Message::toScreen("qc_count = "+QString().setNum(qc_count));
-					flag=Matrix::lls(xlsDimension,qc_count,qcxls,qcyls,sse,cc,stand_err);
-					for(int ii = 0; ii < xlsDimension; ii++) {
-						delete [] qcxls[ii];
-					}
-					delete [] qcxls;
-					delete [] qcyls;
-				}
-			}
-
 			// Across-beam component of the environmental wind
 			cc0 = cc[0];
 			cc6 = cc[6];
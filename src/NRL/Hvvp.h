@@ -13,7 +13,10 @@
 
 #include "Radar/RadarData.h"
 #include "IO/Message.h"
-#include "Config/Configuration.h"
+#include "Config/ConfigSnapshot.h"
+#include "Math/Matrix.h"
+#include <vector>
+#include <QFile>
 
 
 class Hvvp : public QObject
@@ -27,7 +30,7 @@ public:
     ~Hvvp();
 
     void setRadarData(RadarData *newVolume, float range, float angle, float vortexRmw);
-    void setConfig(Configuration* newConfig);
+    void setConfig(const ConfigSnapshot& settings);
 
     bool findHVVPWinds(bool both);
 
@@ -46,7 +49,6 @@ public slots:
 
 private:
     RadarData *volume;
-    Configuration* configData;
     int levels;
     float hgtStart;
     float hInc;
@@ -75,11 +77,29 @@ private:
 
     float deg2rad, rad2deg;
 
-    float** xls;
+    // Number of predictor variables in the fit
     int xlsDimension;
-    long maxpoints;
-    float* yls;
-    float* wgt;
+
+    /*
+    * The workspace of one analysis. The gates that pass the range and
+    *   elevation checks are collected once for all levels, and each level
+    *   lists the gates within its layer. The rows of the fit are built
+    *   from the gates as the normal equations are accumulated.
+    *
+    */
+
+    class HvvpGate {
+    public:
+        float vel;
+        float sinaa, cosaa, cosee;
+        float xx, yy, rr;
+        float alt;
+    };
+    std::vector<HvvpGate> gates;
+    std::vector<std::vector<long> > levelGates;
+    std::vector<bool> outliers;
+    std::vector<float> row;
+    LLSWorkspace llsWork;
 
     float *z, *u, *v, *vm_sin, *var, av_VmSin, stdErr_VmSin;
     /*
@@ -133,7 +153,10 @@ private:
 
     float rotateAzimuth(const float &angle);
 
-    long hvvpPrep(int m);
+    void collectGates(int numLevels);
+    void designRow(const HvvpGate& gate, float zz, float* x) const;
+    bool fitGates(int m, bool skipOutliers, float* cc, float* stand_err, float& sse);
+    bool fitLevel(int m, bool both, float* cc, float* stand_err, float& sse);
 
 
     //Moved to static functions in Math/Matrix
@@ -10,13 +10,67 @@
 
 #include <stdlib.h>
 #include <cmath>
+#include <algorithm>
 #include <QInputDialog>
 #include <QString>
+#include <vector>
 
 #include "RadarQC.h"
 #include "Radar/RadarData.h"
 #include "IO/Message.h"
 #include "Math/Matrix.h"
+#include "IO/VolumeProfile.h"
+#include "Threads/ParallelSlices.h"
+
+BBWindow::BBWindow()
+{
+    size = 0;
+    oldest = 0;
+}
+
+void BBWindow::reset(int windowSize, float value)
+{
+    size = windowSize;
+    oldest = 0;
+    values.assign(size > 0 ? size : 1, value);
+    sorted.assign(size > 0 ? size : 1, value);
+}
+
+float BBWindow::push(float value)
+{
+    if (size <= 1) {
+        values[0] = sorted[0] = value;
+        return value;
+    }
+    float first = values[oldest];
+    float newest = values[(oldest + size - 1) % size];
+
+    replace(newest, value);
+    float median = sorted[size/2];
+    // Drop the oldest value and put the newest back
+    replace(first, newest);
+
+    values[oldest] = value;
+    oldest = (oldest + 1) % size;
+    return median;
+}
+
+void BBWindow::replace(float out, float in)
+{
+    int k = std::lower_bound(sorted.begin(), sorted.end(), out) - sorted.begin();
+    if (in > out) {
+        while ((k + 1 < size) && (sorted[k + 1] < in)) {
+            sorted[k] = sorted[k + 1];
+            k++;
+        }
+    } else {
+        while ((k > 0) && (sorted[k - 1] > in)) {
+            sorted[k] = sorted[k - 1];
+            k--;
+        }
+    }
+    sorted[k] = in;
+}
 
 RadarQC::RadarQC(RadarData *radarPtr, QObject *parent)
     :QObject(parent)
@@ -27,6 +81,7 @@ RadarQC::RadarQC(RadarData *radarPtr, QObject *parent)
     velNull = -999.;
     maxFold = 4;
     numVGatesAveraged = 30;
+    numThreads = 0;
     useVADWinds = false;
     useGVADWinds = false;
     useUserWinds = false;
@@ -292,7 +347,7 @@ RadarQC::~RadarQC()
     delete [] envDir;
 }
 
-void RadarQC::getConfig(QDomElement qcConfig)
+void RadarQC::getConfig(const QcSettings& qcConfig)
 {
     /*
    *   Retreves user parameters from the XML configuration file
@@ -300,19 +355,20 @@ void RadarQC::getConfig(QDomElement qcConfig)
 
     // Get Thresholding and BB Parameters
 
-    if(!qcConfig.isNull()) {
+    if(qcConfig.isSet) {
 
-        velMin = qcConfig.firstChildElement("vel_min").text().toFloat();
-        velMax = qcConfig.firstChildElement("vel_max").text().toFloat();
-        refMin = qcConfig.firstChildElement("ref_min").text().toFloat();
-        refMax = qcConfig.firstChildElement("ref_max").text().toFloat();
-        specWidthLimit = qcConfig.firstChildElement("sw_threshold").text().toFloat();
-        numVGatesAveraged = qcConfig.firstChildElement("bbcount").text().toInt();
-        maxFold = qcConfig.firstChildElement("maxfold").text().toInt();
+        velMin = qcConfig.velMin;
+        velMax = qcConfig.velMax;
+        refMin = qcConfig.refMin;
+        refMax = qcConfig.refMax;
+        specWidthLimit = qcConfig.swThreshold;
+        numVGatesAveraged = qcConfig.bbCount;
+        maxFold = qcConfig.maxFold;
+        numThreads = qcConfig.threads;
 
         // Get Information on Environmental Wind Finding Methods
 
-        wind_method = qcConfig.firstChildElement("wind_method").text();
+        wind_method = qcConfig.windMethod;
 
         if(wind_method == QString("user")) {
 
@@ -321,8 +377,8 @@ void RadarQC::getConfig(QDomElement qcConfig)
             useUserWinds = true;
             envWind = new float[1];
             envDir = new float[1];
-            envWind[0] = qcConfig.firstChildElement("windspeed").text().toFloat();
-            envDir[0] = qcConfig.firstChildElement("winddirection").text().toFloat();
+            envWind[0] = qcConfig.windSpeed;
+            envDir[0] = qcConfig.windDirection;
         }
         else {
             if (wind_method == QString("vad")) {
@@ -331,12 +387,12 @@ void RadarQC::getConfig(QDomElement qcConfig)
 
                 useVADWinds = true;
                 // Possible parameters vadthr, gvadthr
-                vadthr = qcConfig.firstChildElement("vadthr").text().toInt();
-                vadLevels = qcConfig.firstChildElement("vadlevels").text().toInt();
-                numCoEff = qcConfig.firstChildElement("numcoeff").text().toInt();
+                vadthr = qcConfig.vadThr;
+                vadLevels = qcConfig.vadLevels;
+                numCoEff = qcConfig.numCoeff;
                 gvadthr = 180;
             } else if (wind_method == QString("gvad")) {
-                gvadthr = qcConfig.firstChildElement("gvadthr").text().toInt();
+                gvadthr = qcConfig.gvadThr;
                 vadLevels = 20;
                 numCoEff = 2;
                 vadthr = 30;
@@ -459,6 +515,7 @@ void RadarQC::thresholdData()
     int numRays = radarData->getNumRays();
     Ray* currentRay;
     int numVGates = 0;
+    long rejected = 0;
 
     for(int i = 0; i < numRays; i++)
     {
@@ -507,6 +564,8 @@ void RadarQC::thresholdData()
                     // This was extended to threshold against min and max
                     // reflectivity as well but we are not currently using
                     // these thresholds - LM
+                    if(vGates[j] != velNull)
+                        rejected++;
                     vGates[j] = velNull;
                 }
                 
@@ -529,6 +588,7 @@ void RadarQC::thresholdData()
     }
     currentRay = NULL;
     delete currentRay;
+    VolumeProfile::count(VolumeProfile::GatesRejected, rejected);
 }
 
 
@@ -1623,248 +1683,235 @@ float RadarQC::getStart(Ray *currentRay)
 bool RadarQC::BB()
 {
     //emit log(Message("In BB"));
-    Ray* currentRay = NULL;
-    float numRays = radarData->getNumRays();
-    for(int i = 0; i < numRays; i++)
-    {
-        currentRay = radarData->getRay(i);
-	if (currentRay->getSweepIndex() == -999)
-	  continue;
+    int numRays = radarData->getNumRays();
+    runDealiasSlices(BBPass, (numRays + bbRaysPerSlice - 1)/bbRaysPerSlice);
 	
-        float *vGates = currentRay->getVelData();
+    //Message::toScreen("Getting out of dealias");
+    return true;
+}
 
-	// Some rays might not have VEL data
+void RadarQC::BBRay(BBWindow& window, int i)
+{
+    Ray* currentRay = radarData->getRay(i);
+    if (currentRay->getSweepIndex() == -999)
+        return;
 	
-	if(vGates == NULL)
-	  continue;
+    float *vGates = currentRay->getVelData();
+
+    // Some rays might not have VEL data
+	
+    if(vGates == NULL)
+        return;
 	
-        float startVelocity = getStart(currentRay);
-        float nyquistVelocity = currentRay->getNyquist_vel();
-        int numVelocityGates = currentRay->getVel_numgates();
-        if((numVelocityGates!=0)&&(startVelocity!=velNull))
+    float startVelocity = getStart(currentRay);
+    float nyquistVelocity = currentRay->getNyquist_vel();
+    int numVelocityGates = currentRay->getVel_numgates();
+    if((numVelocityGates!=0)&&(startVelocity!=velNull))
+    {
+        float median = startVelocity;
+        int n = 0;
+        int overMaxFold = 0;
+        bool dealiased;
+        window.reset(numVGatesAveraged, startVelocity);
+        for(int j = 0; j < numVelocityGates; j++)
         {
-            float sum = float(numVGatesAveraged)*startVelocity;
-	    float median, mean;
-	    mean = median = startVelocity;
-	    // float nyquistSum = float(numVGatesAveraged)*nyquistVelocity;
-            int n = 0;
-            int overMaxFold = 0;
-            bool dealiased;
-            float segVelocity[numVGatesAveraged];
-            for(int k = 0; k < numVGatesAveraged; k++)
-            {
-                segVelocity[k] = startVelocity;
-            }
-            for(int j = 0; j < numVelocityGates; j++)
+            //Message::toScreen("Gate "+QString().setNum(j));
+            if(vGates[j]!=velNull)
             {
-                //Message::toScreen("Gate "+QString().setNum(j));
-                if(vGates[j]!=velNull)
+                //Message::toScreen("has data");
+                n = 0;
+                dealiased = false;
+                while(dealiased!=true)
                 {
-                    //Message::toScreen("has data");
-                    n = 0;
-                    dealiased = false;
-                    while(dealiased!=true)
+                    float tryVelocity = vGates[j]+(2.0*n*nyquistVelocity);
+                    if((median+nyquistVelocity >= tryVelocity)&&
+                            (tryVelocity >= median-nyquistVelocity))
                     {
-                        float tryVelocity = vGates[j]+(2.0*n*nyquistVelocity);
-                        if((median+nyquistVelocity >= tryVelocity)&&
-                                (tryVelocity >= median-nyquistVelocity))
-                        {
-                            dealiased=true;
-                        }
-                        else
-                        {
-                            if(tryVelocity > median+nyquistVelocity){
-                                n--;
-                                //Message::toScreen("n--");
-                            }
-                            if(tryVelocity < median-nyquistVelocity){
-                                n++;
-                                //Message::toScreen("n++");
-                            }
-                            if(abs(n) >= maxFold) {
-                                //emit log(Message(QString("Ray #")+QString().setNum(i)+QString(" Gate# ")+QString().setNum(j)+QString(" exceeded maxfolds")));
-                                overMaxFold++;
-                                dealiased=true;
-                                vGates[j]=velNull;
-                            }
-                        }
-                        //Message::toScreen("Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" with "+QString().setNum(n)+" folds");
+                        dealiased=true;
                     }
-                    if(vGates[j]!=velNull)
+                    else
                     {
-                        vGates[j]+= 2.0*n*(nyquistVelocity);
-                        sum -= segVelocity[0];
-                        sum += vGates[j];
-						mean = sum / numVGatesAveraged;
-						float threshold_mean = 0.0;
-						int meancount = 0;
-						QList<float> sortVelocity;
-                        for(int m = 0; m < numVGatesAveraged-1; m++)
-                        {
-							sortVelocity << segVelocity[m];
-                            segVelocity[m] = segVelocity[m+1];
-							if (fabs(segVelocity[m] - mean) < nyquistVelocity)
-							{
-								threshold_mean += segVelocity[m];
-								meancount++;
-							}							
+                        if(tryVelocity > median+nyquistVelocity){
+                            n--;
+                            //Message::toScreen("n--");
+                        }
+                        if(tryVelocity < median-nyquistVelocity){
+                            n++;
+                            //Message::toScreen("n++");
+                        }
+                        if(abs(n) >= maxFold) {
+                            //emit log(Message(QString("Ray #")+QString().setNum(i)+QString(" Gate# ")+QString().setNum(j)+QString(" exceeded maxfolds")));
+                            overMaxFold++;
+                            dealiased=true;
+                            vGates[j]=velNull;
                         }
-						sortVelocity << vGates[j];
-						segVelocity[numVGatesAveraged-1] = vGates[j];
-						threshold_mean += vGates[j];
-						meancount++;
-						//if (meancount < numVGatesAveraged) Message::toScreen(QString("Threshold reduced to ") + QString().setNum(meancount));
-						qSort(sortVelocity);
-						int mIndex = float(numVGatesAveraged)/2;
-						median = (sortVelocity.at(mIndex));// + (threshold_mean / (float)meancount)) / 2;
                     }
+                    //Message::toScreen("Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" with "+QString().setNum(n)+" folds");
+                }
+                if(vGates[j]!=velNull)
+                {
+                    vGates[j]+= 2.0*n*(nyquistVelocity);
+                    median = window.push(vGates[j]);
                 }
             }
         }
-        vGates = NULL;
-        currentRay = NULL;
     }
+}
+
+bool RadarQC::derivativeDealias()
+{
 	
+	// Minimize 2nd derivative in azimuth after BB routine
+	runDealiasSlices(DerivativePass, radarData->getNumSweeps());
     //Message::toScreen("Getting out of dealias");
     return true;
+}	
+
+void RadarQC::runDealiasSlices(int pass, int numSlices)
+{
+	// A slice only changes its own rays
+	std::vector<DealiasWorkspace> workspaces(parallelWorkers(numSlices, numThreads));
+	runParallel(numSlices, numThreads, [&](int worker, int n) {
+		dealiasSlice(pass, workspaces[worker], n);
+	});
 }
 
-bool RadarQC::derivativeDealias()
+void RadarQC::dealiasSlice(int pass, DealiasWorkspace& workspace, int n)
 {
+	switch (pass) {
+	case BBPass: {
+		int numRays = radarData->getNumRays();
+		int lastRay = (n + 1)*bbRaysPerSlice;
+		if (lastRay > numRays)
+			lastRay = numRays;
+		for (int i = n*bbRaysPerSlice; i < lastRay; i++)
+			BBRay(workspace.window, i);
+		break;
+	}
+	case DerivativePass:
+		derivativeDealiasSweep(workspace, n);
+		break;
+	}
+}
+
+void RadarQC::derivativeDealiasSweep(DealiasWorkspace& workspace, int n)
+{
+	Sweep* currentSweep = radarData->getSweep(n);
+	int rays = currentSweep->getNumRays();
+	int gates = currentSweep->getVel_numgates();
+	if ((gates == 0) or (rays < 2)) return;
+
+	float nyquistVelocity = currentSweep->getNyquist_vel();
+	int firstRay = currentSweep->getFirstRay();
+
+	// Copy the sweep by gate, so the rays of a gate are next to each other.
+	// Ray i of gate j is at velocity[j*stride + i + 2]; the two slots on
+	// either side repeat the rays from the other end of the sweep, so the
+	// gradient stencil never has to wrap.
+	int stride = rays + 4;
+	workspace.velocity.resize((size_t)gates * stride);
+	workspace.gradient.resize((size_t)gates * rays);
+	float* veldata = &workspace.velocity[0];
+	float* a1 = &workspace.gradient[0];
+	for (int i = 0; i < rays; i++) {
+		Ray* currentRay = radarData->getRay(i + firstRay);
+		float* raydata = currentRay->getVelData();
+		int rayGates = (raydata != NULL) ? currentRay->getVel_numgates() : 0;
+		for (int j = 0; j < gates; j++)
+			veldata[(size_t)j*stride + i + 2] = (j < rayGates) ? raydata[j] : velNull;
+	}
+	for (int j = 0; j < gates; j++) {
+		float* column = veldata + (size_t)j*stride;
+		column[0] = column[rays];
+		column[1] = column[rays + 1];
+		column[rays + 2] = column[2];
+		column[rays + 3] = column[3];
+	}
 	
-	// Minimize 2nd derivative in azimuth after BB routine
-	for (int n = 0; n < radarData->getNumSweeps(); n++) {
-        Sweep* currentSweep = radarData->getSweep(n);
-		int rays = currentSweep->getNumRays();
-		int gates = currentSweep->getVel_numgates();
-        if (gates == 0) continue;
-
-		float nyquistVelocity = currentSweep->getNyquist_vel();
-		// Allocate memory for the gradient fields
-		float** a1 = new float*[rays];
-		float** veldata = new float*[rays];
-		for (int i=0; i < rays; i++) {
-			a1[i] = new float[gates];
-			veldata[i] = new float[gates];
-            for (int j=0; j < gates; j++) {
-                a1[i][j] = veldata[i][j] = velNull;
-            }
+	// Find the gradient. Every gate is summed in the same order as before,
+	// in float, so the result does not change; the loop has no branches
+	// so it can be vectorized.
+	const double weights[5] = { 1./12., -2./3., 0, 2./3., -1./12. }; 
+	for (int j = 0; j < gates; j++) {
+		const float* column = veldata + (size_t)j*stride;
+		float* gradient = a1 + (size_t)j*rays;
+		for (int i = 0; i < rays; i++) {
+			float v0 = column[i];
+			float v1 = column[i + 1];
+			float v2 = column[i + 2];
+			float v3 = column[i + 3];
+			float v4 = column[i + 4];
+			bool valid = (v0 != velNull) & (v1 != velNull) & (v2 != velNull)
+				& (v3 != velNull) & (v4 != velNull);
+			float sum = 0;
+			sum += weights[0]*v0;
+			sum += weights[1]*v1;
+			sum += weights[2]*v2;
+			sum += weights[3]*v3;
+			sum += weights[4]*v4;
+			gradient[i] = (valid & (sum != velNull)) ? fabs(sum) : velNull;
 		}
-		
-		// Find the gradient
-		float sum;
-		int ray_index;
+	}
+
+	for (int j = 0; j < gates; j++) {
+		float* column = veldata + (size_t)j*stride + 2;
+		const float* gradient = a1 + (size_t)j*rays;
+		float mingrad = 1e34;
+		int startindex = 0;
 		for (int i=0; i < rays; i++)  {
-			for (int j=0; j < gates; j++) {
-				sum = 0.0;
-				double weights[5] = { 1./12., -2./3., 0, 2./3., -1./12. }; 
-				//double weights[2] = {-1.0, 1.0};
-				sum = 0;
-				for (int m = i-2; m < i+3; m++) {
-					//for (int m = i; m < i+2; m++) {
-					ray_index = m + currentSweep->getFirstRay();
-					if (ray_index < currentSweep->getFirstRay()) ray_index += rays;
-					if (ray_index > currentSweep->getLastRay()) ray_index -= rays;
-					Ray* currentRay = radarData->getRay(ray_index);
-					float* raydata = currentRay->getVelData();
+			if ((gradient[i] != velNull) and (gradient[i] < mingrad)) {
+				mingrad = gradient[i];
+				startindex = i;
+			}
+		}
+		float startVelocity = column[startindex];
+		if(startVelocity==velNull) continue;
+
+		// Each ray is unfolded against its neighbours as they stand, so the
+		// rays of a gate have to be taken in order from the smoothest one
+		for (int ri=startindex; ri < rays+startindex; ri++)
+		{
+			int i = (ri >= rays) ? (ri-rays) : ri;
+			if(column[i]==velNull) continue;
+
+			int minfold = 0;
+			mingrad = 1e34;
+			for (int fold = -1; fold < 2; fold++)
+			{
+				double foldWeights[3] = {1.0, -2.0, 1.0};
+				float sum = 0;
+				for (int m = i-1; m < i+2; m++) {
 					int ri = (m >= rays) ? (m-rays) : m;
 					ri = (ri < 0) ? (ri+rays) : ri;
-					if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
-					   veldata[ri][j] = raydata[j];
-				    }
-					if (veldata[ri][j] != velNull) {
-						sum += weights[m-i+2]*veldata[ri][j];
-						//sum += weights[m-i]*veldata[i][j];
+					if (column[ri] != velNull) {
+						float tryVelocity = column[ri];
+						if (ri == i) tryVelocity += (2.0*fold*nyquistVelocity);
+						sum += foldWeights[m-i+1]*tryVelocity;
 					} else {
 						sum = velNull;
 						break;
 					}
 				}
-				if (sum != velNull) 
-					a1[i][j] = fabs(sum);
-			}
-		}
-		for (int j=0; j < gates; j++) {
-			float mingrad = 1e34;
-			int startindex = 0;
-			for (int i=0; i < rays; i++)  {
-				if ((a1[i][j] != velNull) and (a1[i][j] < mingrad)) {
-					mingrad = a1[i][j];
-					startindex = i;
+				if ((sum != velNull) and (fabs(sum) < mingrad)) {
+					mingrad = sum;
+					minfold = fold;
 				}
 			}
-			// Use a much smaller azimuthal average because of radial shear across eyewall
-			int azavg = 1; //numVGatesAveraged / 6;
-			float startVelocity = veldata[startindex][j];
-			if(startVelocity!=velNull)
-			{
-				float sum = float(azavg)*startVelocity;
-				float median, mean;
-				mean = median = startVelocity;
-				float segVelocity[azavg];
-				for(int k = 0; k < azavg; k++)
-				{
-					segVelocity[k] = startVelocity;
-				}
-				for (int ri=startindex; ri < rays+startindex; ri++)
-				{
-					
-					int i = (ri >= rays) ? (ri-rays) : ri;
-					
-					//Message::toScreen("Gate "+QString().setNum(j));
-					if(veldata[i][j]!=velNull)
-					{
-						int minfold = 0;
-						mingrad = 1e34;
-						for (int fold = -1; fold < 2; fold++)
-						{
-							//double weights[5] = { -1./12., 4./3., -5./2., 4./3., -1./12. }; 
-							double weights[3] = {1.0, -2.0, 1.0};
-							sum = 0;
-							//for (int m = i-2; m < i+3; m++) {
-							for (int m = i-1; m < i+2; m++) {
-								int ri = (m >= rays) ? (m-rays) : m;
-								ri = (ri < 0) ? (ri+rays) : ri;
-								if (veldata[ri][j] != velNull) {
-									float tryVelocity = veldata[ri][j];
-									if (ri == i) tryVelocity += (2.0*fold*nyquistVelocity);
-									sum += weights[m-i+1]*tryVelocity;
-									//sum += weights[m-i]*veldata[i][j];
-								} else {
-									sum = velNull;
-									break;
-								}
-							}
-							if ((sum != velNull) and (fabs(sum) < mingrad)) {
-								mingrad = sum;
-								minfold = fold;
-							}
-						}
-						if(veldata[i][j]!=velNull)
-						{
-							veldata[i][j]+= 2.0*minfold*(nyquistVelocity);
-							ray_index = i + currentSweep->getFirstRay();
-							Ray* currentRay = radarData->getRay(ray_index);
-							float* raydata = currentRay->getVelData();
-							if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
-							   raydata[j] = veldata[i][j];
-						    }
-						}
-					}
-				}
-			}			
+			column[i]+= 2.0*minfold*(nyquistVelocity);
 		}
-		for (int i=0; i < rays; i++)  {
-			delete[] veldata[i];
-			delete[] a1[i];
-		}
-		delete[] veldata;
-		delete[] a1;
-		
 	}
-    //Message::toScreen("Getting out of dealias");
-    return true;
-}	
+
+	// Put the sweep back. Gates that were not unfolded get their own value.
+	for (int i = 0; i < rays; i++) {
+		Ray* currentRay = radarData->getRay(i + firstRay);
+		float* raydata = currentRay->getVelData();
+		if (raydata == NULL) continue;
+		int rayGates = currentRay->getVel_numgates();
+		if (rayGates > gates) rayGates = gates;
+		for (int j = 0; j < rayGates; j++)
+			raydata[j] = veldata[(size_t)j*stride + i + 2];
+	}
+}
 
 bool RadarQC::multiprfDealias()
 {
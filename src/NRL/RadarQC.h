@@ -14,20 +14,68 @@
 #include "Radar/RadarData.h"
 #include "IO/Message.h"
 #include <QWidget>
-#include <QDomElement>
+#include "Config/ConfigSnapshot.h"
 #include <QObject>
 #include "Math/Matrix.h"
+#include <vector>
+
+// The last few dealiased velocities along a ray, for the reference of the
+// BB dealiaser. The values are also kept sorted, so sliding the window
+// costs a binary search and a short shift instead of a sort.
+
+class BBWindow
+{
+
+ public:
+  BBWindow();
+
+  // Fills a window of size values with value
+  void reset(int size, float value);
+
+  // Slides the window on to value and returns the median BB has always
+  // used: that of the previous window with its newest value replaced by
+  // value, element size/2 once sorted.
+  float push(float value);
+
+ private:
+  int size;
+  int oldest;
+  std::vector<float> values;   // in arrival order, from oldest
+  std::vector<float> sorted;
+
+  // Swaps one copy of out for in, keeping sorted in order
+  void replace(float out, float in);
+};
+
+// Scratch space of one dealiasing worker. Each worker keeps its own and
+// reuses it for every slice it takes, so the arrays are only grown, never
+// reallocated per sweep or ray.
+
+class DealiasWorkspace
+{
+
+ public:
+  // Velocities by gate, each gate holding its rays with two rays of the
+  // other end of the sweep before and after them
+  std::vector<float> velocity;
+  // Azimuthal gradient by gate
+  std::vector<float> gradient;
+  BBWindow window;
+};
 
 class RadarQC : public QObject
 { 
     Q_OBJECT
 
+    // Benchmark/dealiasCheck.cpp
+    friend class DealiasCheck;
+
 public:
     RadarQC(RadarData *radarPtr = 0, QObject *parent = 0);
     ~RadarQC();
 
     RadarData* getRadarData() {return radarData;}
-    void getConfig(QDomElement qcConfig);
+    void getConfig(const QcSettings& qcConfig);
     /*
    * Retreves user parameters from the XML configuration file
    */
@@ -90,6 +138,13 @@ private:
    * numVGatesAvereaged: the number of gates which are averaged together for
    *   the BB dealiasing routine.
    *
+   */
+
+    int numThreads;
+    /*
+   * numThreads: the number of rays or sweeps dealiased at once, 0 uses
+   *   every core
+   *
    */
 
     int vadLevels;
@@ -192,11 +247,29 @@ private:
    * This method is modeled after velocity dealiasing algorithm B,
    *   published by Bargain and Brown (1980).
    *
+   */
+
+    void BBRay(BBWindow& window, int i);
+    /*
+   * Runs BB on ray i. Rays are dealiased independently of each other.
+   *
    */
 
 	bool derivativeDealias();
 	/* This method tries to minimize 2nd derivatives in the radial velocity
 	 by through velocity unfolding */
+
+	void derivativeDealiasSweep(DealiasWorkspace& workspace, int n);
+	/* Runs derivativeDealias on sweep n. A sweep only reads and writes its
+	 own rays, so several can be dealiased at once */
+
+	enum DealiasPass { BBPass, DerivativePass };
+	static const int bbRaysPerSlice = 32;
+
+	void runDealiasSlices(int pass, int numSlices);
+	void dealiasSlice(int pass, DealiasWorkspace& workspace, int n);
+	/* Spread the slices of a pass, blocks of rays for BB and sweeps for
+	 derivativeDealias, over numThreads workers */
 	
 	bool multiprfDealias();
 	/* This method compares rays at different Nyquist velocities for dealiasing */
@@ -10,10 +10,28 @@
 
 #include "PressureFactory.h"
 #include "Pressure/PressureData.h"
+#include "Radar/DirectoryWatcher.h"
 #include <iostream>
 #include <QPushButton>
+#include <QThread>
+#include <QMutexLocker>
 #include <math.h>
-#include <unistd.h>
+
+// Waits for pressure files and parses them, so the analysis loop never
+// waits on a file being written
+
+class PressureIngest : public QThread
+{
+
+public:
+    PressureIngest(PressureFactory* owner) : owner(owner) {}
+
+protected:
+    void run() { owner->ingest(); }
+
+private:
+    PressureFactory* owner;
+};
 
 PressureFactory::PressureFactory(Configuration *mainCfg, QObject *parent) : QObject(parent)
 {
@@ -22,9 +40,6 @@ PressureFactory::PressureFactory(Configuration *mainCfg, QObject *parent) : QObj
     QDomElement pressureConfig = mainCfg->getConfig("pressure");
     QDomElement radarConfig = mainCfg->getConfig("radar");
 
-    // Will poll for data and return pressure objects in a queue
-    pressureQueue = new QQueue<QString>;
-
     // Get relevant configuration info
     QDate startDate = QDate::fromString(mainCfg->getParam(radarConfig,QString("startdate")),Qt::ISODate);
     QDate endDate = QDate::fromString(mainCfg->getParam(radarConfig,QString("enddate")),Qt::ISODate);
@@ -42,6 +57,8 @@ PressureFactory::PressureFactory(Configuration *mainCfg, QObject *parent) : QObj
     radarlon = mainCfg->getParam(radarConfig,"lon").toFloat();
 
     QString format = mainCfg->getParam(pressureConfig,QString("format"));
+    // Nothing is read in a format that is not supported
+    pressureFormat = netcdf;
     if (format == "HWind") {
         pressureFormat = hwind;
     } else if (format == "AWIPS") {
@@ -51,68 +68,141 @@ PressureFactory::PressureFactory(Configuration *mainCfg, QObject *parent) : QObj
     } else {
         emit log(Message("Data format not supported"));
     }
+
+    // New files are picked up from directory notifications when the
+    // filesystem supports them, <watch>poll</watch> forces polling and
+    // <settle> is how many seconds a polled file has to be left alone
+    // before it is read
+    bool forcePolling = false;
+    if(!pressureConfig.firstChildElement("watch").isNull())
+        forcePolling = (mainCfg->getParam(pressureConfig,"watch") == "poll");
+    int settleMsecs = DirectoryWatcher::defaultSettleMsecs;
+    if(!pressureConfig.firstChildElement("settle").isNull())
+        settleMsecs = (int)(1000 * mainCfg->getParam(pressureConfig,"settle").toFloat());
+    watcher = new DirectoryWatcher(dataPath.path(), forcePolling, settleMsecs);
+
+    stopIngest.storeRelease(0);
+    ingestThread = new PressureIngest(this);
 }
 
 PressureFactory::~PressureFactory()
 {
-    delete pressureQueue;
+    stop();
+    delete ingestThread;
+    delete watcher;
+    while(!batches.isEmpty())
+        delete batches.dequeue();
 }
 
-QList<PressureData>* PressureFactory::getUnprocessedData()
+void PressureFactory::start()
 {
-    // Get the latest files off the queue and make pressure objects
-    // Have to return a list in case there are multiple obs in the same file (which is likely)
+    if(!ingestThread->isRunning()) {
+        stopIngest.storeRelease(0);
+        ingestThread->start();
+    }
+}
+
+void PressureFactory::stop()
+{
+    stopIngest.storeRelease(1);
+    ingestThread->wait();
+}
 
-    if (pressureQueue->isEmpty()) {
-        // Problem, shouldn't be here
-        emit log(Message("Trying to get nonexistent pressure data off queue"));
+void PressureFactory::ingest()
+{
+    while(!stopIngest.loadAcquire()) {
+        QStringList files = watcher->takeReadyFiles(waitMsecs);
+        for(int i = 0; (i < files.size()) && !stopIngest.loadAcquire(); i++) {
+            QString fileName = dataPath.filePath(files.at(i));
+            if(fileParsed.value(fileName) || !fileInRange(files.at(i)))
+                continue;
+            // Mark it as processed
+            fileParsed[fileName] = true;
+
+            PressureList* pressureList = parseFile(fileName);
+            if(pressureList == NULL)
+                continue;
+            if(pressureList->isEmpty()) {
+                delete pressureList;
+                continue;
+            }
+            QMutexLocker locker(&batchMutex);
+            batches.enqueue(pressureList);
+        }
     }
+}
 
-    // Get the files off the queue
-    QString fileName = dataPath.filePath(pressureQueue->dequeue());
-
-    // Test file to make sure it is not growing
-    QFile pressureFile(fileName);
-    qint64 newFilesize = pressureFile.size();
-    qint64 prevFilesize = 0;
-    while (prevFilesize != newFilesize) {
-        prevFilesize = newFilesize;
-        sleep(1);
-        newFilesize = pressureFile.size();
+PressureList* PressureFactory::getUnprocessedData()
+{
+    // All the observations parsed since the last call, in one list.
+    // Have to return a list in case there are multiple obs in the same file (which is likely)
+
+    QQueue<PressureList*> parsed;
+    batchMutex.lock();
+    parsed.swap(batches);
+    batchMutex.unlock();
+
+    PressureList* pressureList = new PressureList;
+    while(!parsed.isEmpty()) {
+        PressureList* batch = parsed.dequeue();
+        for(int i = 0; i < batch->size(); i++)
+            pressureList->addObservation(batch->at(i));
+        delete batch;
     }
-    sleep(1);
+    return pressureList;
+}
 
+PressureList* PressureFactory::readDataUntil(const QDateTime& volumeTime)
+{
+    // The directory is listed again for every volume, so files that turn
+    // up during a batch run are still read in time order
+    QDir dir(dataPath.path(), QString(), QDir::Name, QDir::Files);
+    QStringList files = dir.entryList();
+
+    PressureList* pressureList = new PressureList;
+    for(int i = 0; i < files.size(); i++) {
+        QString fileName = dataPath.filePath(files.at(i));
+        if(fileParsed.value(fileName) || !fileInRange(files.at(i)))
+            continue;
+        if(fileTime(files.at(i)) > volumeTime)
+            continue;
+        // Mark it as processed
+        fileParsed[fileName] = true;
+
+        PressureList* parsed = parseFile(fileName);
+        if(parsed == NULL)
+            continue;
+        for(int j = 0; j < parsed->size(); j++)
+            pressureList->addObservation(parsed->at(j));
+        delete parsed;
+    }
+    return pressureList;
+}
 
-    // Mark it as processed
-    fileParsed[fileName] = true;
-    
+PressureList* PressureFactory::parseFile(const QString& fileName)
+{
     // Now make a new pressureList from that file and send it back
-    QList<PressureData>* pressureList = new QList<PressureData>;
+    PressureList* pressureList = new PressureList;
     switch(pressureFormat) {
     case hwind :
     {
         QFile file(fileName);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            delete pressureList;
             return 0;
+        }
 
         QTextStream in(&file);
         while (!in.atEnd()) {
             QString ob = in.readLine();
             HWind *pressureData = new HWind(ob);
             // Check to make sure it is not a duplicate -- this messes up the XML structure
-            bool duplicateOb = false;
-            for (int i = 0; i < pressureList->size(); i++) {
-                if ((pressureList->at(i).getStationName() == pressureData->getStationName())
-                        and (pressureList->at(i).getTime() == pressureData->getTime())) {
-                    //emit log(Message("Omitting duplicate surface ob"));
-                    duplicateOb = true;
-                }
-            }
+            bool duplicateOb = pressureList->hasObservation(*pressureData);
             // Check to make sure it is a near-surface measurement
             if ((pressureData->getAltitude() >= 0) and
                     (pressureData->getAltitude() <= 20) and
                     (!duplicateOb)) {
-                pressureList->append(*pressureData);
+                pressureList->addObservation(*pressureData);
             }
             delete pressureData;
         }
@@ -130,8 +220,10 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
         QDate obDate = QDate::fromString(timestamp.at(2), "yyyyMMdd");
         QTime obTime = QTime::fromString(timestamp.at(3), "hhmm");
 
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            delete pressureList;
             return 0;
+        }
 
         QTextStream in(&file);
         while (!in.atEnd()) {
@@ -140,14 +232,7 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
             //pressureData->setTime(obDateTime);
 
             // Check to make sure it is not a duplicate -- this messes up the XML structure
-            bool duplicateOb = false;
-            for (int i = 0; i < pressureList->size(); i++) {
-                if ((pressureList->at(i).getStationName() == pressureData->getStationName())
-                        and (pressureList->at(i).getTime() == pressureData->getTime())) {
-                    //emit log(Message("Omitting duplicate surface ob"));
-                    duplicateOb = true;
-                }
-            }
+            bool duplicateOb = pressureList->hasObservation(*pressureData);
             // Check to make sure it is not a duplicate and not too far away
             float obLat = pressureData->getLat();
             float obLon = pressureData->getLon();
@@ -161,7 +246,7 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
             float relY = (obLat - radarlat) * fac_lat;
             float obRange = sqrt(relX*relX + relY*relY);
             if 	((!duplicateOb) and (obRange < 500)) {
-                pressureList->append(*pressureData);
+                pressureList->addObservation(*pressureData);
             }
             delete pressureData;
         }
@@ -179,8 +264,10 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
             QDate obDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
             QTime obTime = QTime::fromString(timestamp.at(1), "hhmm");
             
-            if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                delete pressureList;
                 return 0;
+            }
             
             QTextStream in(&file);
             while (!in.atEnd()) {
@@ -190,14 +277,7 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
                 //pressureData->setTime(obDateTime);
                 
                 // Check to make sure it is not a duplicate -- this messes up the XML structure
-                bool duplicateOb = false;
-                for (int i = 0; i < pressureList->size(); i++) {
-                    if ((pressureList->at(i).getStationName() == pressureData->getStationName())
-                        and (pressureList->at(i).getTime() == pressureData->getTime())) {
-                        //emit log(Message("Omitting duplicate surface ob"));
-                        duplicateOb = true;
-                    }
-                }
+                bool duplicateOb = pressureList->hasObservation(*pressureData);
                 // Check to make sure it is not a duplicate and not too far away
                 float obLat = pressureData->getLat();
                 float obLon = pressureData->getLon();
@@ -214,7 +294,7 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
                 float obRange = sqrt(relX*relX + relY*relY);
                 if 	((!duplicateOb) and (obRange < 500) and (obAlt < 15.0)
                      and (obPressure < 1050.) and (obPressure > 850.)) {
-                    pressureList->append(*pressureData);
+                    pressureList->addObservation(*pressureData);
                 }
                 delete pressureData;
             }
@@ -233,134 +313,73 @@ QList<PressureData>* PressureFactory::getUnprocessedData()
 
     // If we get here theres a problem, return a null pointer
     emit log(Message("Problem with pressure data Factory"));
+    delete pressureList;
     return 0;
 
 }
 
 bool PressureFactory::hasUnprocessedData()
 {
+    // Never waits, the files are read by the ingest thread
+    QMutexLocker locker(&batchMutex);
+    return !batches.isEmpty();
+}
 
-    // Check the unprocessed list first, if it has files no need to reread directory yet
-    if(!pressureQueue->isEmpty()) {
-        return true;
-    }
-
-    // Otherwise, check the directory for appropriate files
+QDateTime PressureFactory::fileTime(const QString& file) const
+{
+    // Get the date info from the file name
+    QStringList timestamp = file.split("_");
+    QDateTime fileDateTime;
 
     switch(pressureFormat) {
     case hwind:
     {
         // Assuming that the filename structure is a timestamp
-        //dataPath.setNameFilters(QStringList("*"));
-        dataPath.setFilter(QDir::Files);
-        //dataPath.setSorting(QDir::Time | QDir::Reversed);
-        dataPath.setSorting(QDir::Name);
-        QStringList filenames = dataPath.entryList();
-
-        // Check to see which are in the time limits
-        for (int i = 0; i < filenames.size(); ++i) {
-            QString file = filenames.at(i);
-            QString timepart = file;
-            // Parse the timestamps
-            QStringList timestamp = timepart.split("_");
-            if(timestamp.size()<2)
-                continue;
-            QDate fileDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
-            QTime fileTime = QTime::fromString(timestamp.at(1), "hhmmss");
-            QDateTime fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
-
-            if (fileDateTime >= startDateTime && fileDateTime <= endDateTime) {
-                // Valid time and pressure name, check to see if it has been processed
-                if (!fileParsed[dataPath.filePath(file)]) {
-                    // File has not been parsed, add it to the queue
-                    pressureQueue->enqueue(file);
-                }
-            }
-        }
-
+        if(timestamp.size()<2)
+            return QDateTime();
+        QDate fileDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
+        QTime fileTime = QTime::fromString(timestamp.at(1), "hhmmss");
+        fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
         break;
     }
 
     case awips:
     {
         // Assuming that the filename structure has a trailing timestamp
-        //dataPath.setNameFilters(QStringList("*"));
-        dataPath.setFilter(QDir::Files);
-        //dataPath.setSorting(QDir::Time | QDir::Reversed);
-        dataPath.setSorting(QDir::Name);
-        QStringList filenames = dataPath.entryList();
-
-        // Check to see which are in the time limits
-        for (int i = 0; i < filenames.size(); ++i) {
-            QString file = filenames.at(i);
-            QString timepart = file;
-            // Parse the timestamps
-            QStringList timestamp = timepart.split("_");
-            if(timestamp.size()<4)
-                continue;
-            QDate fileDate = QDate::fromString(timestamp.at(2), "yyyyMMdd");
-            QTime fileTime = QTime::fromString(timestamp.at(3), "hhmm");
-            QDateTime fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
-
-            if (fileDateTime >= startDateTime && fileDateTime <= endDateTime) {
-                // Valid time and pressure name, check to see if it has been processed
-                if (!fileParsed[dataPath.filePath(file)]) {
-                    // File has not been parsed, add it to the queue
-                    pressureQueue->enqueue(file);
-                }
-            }
-        }
-
+        if(timestamp.size()<4)
+            return QDateTime();
+        QDate fileDate = QDate::fromString(timestamp.at(2), "yyyyMMdd");
+        QTime fileTime = QTime::fromString(timestamp.at(3), "hhmm");
+        fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
         break;
     }
-        case madis:
-        {
-            // Assuming that the filename structure has a trailing timestamp
-            //dataPath.setNameFilters(QStringList("*"));
-            dataPath.setFilter(QDir::Files);
-            //dataPath.setSorting(QDir::Time | QDir::Reversed);
-            dataPath.setSorting(QDir::Name);
-            QStringList filenames = dataPath.entryList();
-            
-            // Check to see which are in the time limits
-            for (int i = 0; i < filenames.size(); ++i) {
-                QString file = filenames.at(i);
-                QString timepart = file;
-                // Parse the timestamps
-                QStringList timestamp = timepart.split("_");
-                if(timestamp.size()<3)
-                    continue;
-                QDate fileDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
-                QTime fileTime = QTime::fromString(timestamp.at(1), "hhmm");
-                QDateTime fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
-                if (fileDateTime >= startDateTime && fileDateTime <= endDateTime) {
-                    // Valid time and pressure name, check to see if it has been processed
-                    if (!fileParsed[dataPath.filePath(file)]) {
-                        // File has not been parsed, add it to the queue
-                        pressureQueue->enqueue(file);
-                    }
-                }
-            }
-            
-            break;
-        }
 
-    case netcdf:
+    case madis:
     {
-        // Not yet implemented
+        if(timestamp.size()<3)
+            return QDateTime();
+        QDate fileDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
+        QTime fileTime = QTime::fromString(timestamp.at(1), "hhmm");
+        fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
         break;
     }
 
+    case netcdf:
+    {
+        // Not yet implemented
+        return QDateTime();
     }
-
-    // See if we added any new files to the queue
-    if(!pressureQueue->isEmpty()) {
-        return true;
     }
 
-    // We made it here so there must be nothing new
-    return false;
+    return fileDateTime;
+}
 
+bool PressureFactory::fileInRange(const QString& file) const
+{
+    QDateTime fileDateTime = fileTime(file);
+    if(!fileDateTime.isValid())
+        return false;
+    return (fileDateTime >= startDateTime && fileDateTime <= endDateTime);
 }
 
 void PressureFactory::catchLog(const Message& message)
@@ -17,6 +17,8 @@
 #include <QDomElement>
 #include <QQueue>
 #include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
 #include "Config/Configuration.h"
 #include "Pressure/PressureList.h"
 #include "Pressure/HWind.h"
@@ -25,6 +27,15 @@
 #include "IO/Message.h"
 #include "GUI/ConfigTree.h"
 
+class DirectoryWatcher;
+class PressureIngest;
+
+// In real time, pressure files are read on a thread of their own as soon
+// as they are complete, and the analysis loop collects what has been
+// parsed so far without waiting. A batch run does not start the thread and
+// reads the files up to each volume's time itself, so what a volume gets
+// does not depend on timing.
+
 class PressureFactory : public QObject
 {
 
@@ -33,8 +44,16 @@ class PressureFactory : public QObject
 public:
     PressureFactory(Configuration *wholeConfig, QObject *parent = 0);
     ~PressureFactory();
-    QList<PressureData>* getUnprocessedData();
+    // Starts and stops the ingest thread, which logs from its own thread
+    void start();
+    void stop();
+    // The observations parsed since the last call, the caller deletes them
+    PressureList* getUnprocessedData();
     bool hasUnprocessedData();
+    // Parses every file not yet read whose time is at or before
+    // volumeTime, in name order, on the calling thread. For batch runs,
+    // which do not start the ingest thread. The caller deletes the list.
+    PressureList* readDataUntil(const QDateTime& volumeTime);
 
 public slots:
     void catchLog(const Message& message);
@@ -50,14 +69,31 @@ private:
         netcdf
     };
 
+    friend class PressureIngest;
+
     QDir dataPath;
     dataFormat pressureFormat;
-    QQueue<QString> *pressureQueue;
     QDateTime startDateTime;
     QDateTime endDateTime;
     QHash<QString, bool> fileParsed;
     float radarlat, radarlon;
 
+    DirectoryWatcher *watcher;
+    PressureIngest *ingestThread;
+    // Set by stop() on the analysis thread, read by the ingest thread
+    QAtomicInt stopIngest;
+    // How long the ingest thread waits for a file before checking for stop
+    static const int waitMsecs = 500;
+    // Parsed files waiting for the analysis loop
+    QMutex batchMutex;
+    QQueue<PressureList*> batches;
+
+    void ingest();
+    // Time in the file name, invalid if the name does not have one
+    QDateTime fileTime(const QString& file) const;
+    bool fileInRange(const QString& file) const;
+    PressureList* parseFile(const QString& fileName);
+
 };
 
 
@@ -11,17 +11,25 @@
 
 #include <QDir>
 #include <QXmlStreamWriter>
+#include <QDomDocument>
 #include <QFile>
 #include <QStringList>
 #include <QString>
 
 #include <iostream>
+#include <math.h>
 
 #include "PressureList.h"
+#include "IO/ListSnapshot.h"
 
-PressureList::PressureList(QString prsFilePath) : QList<PressureData>()
+const float PressureList::bucketDegrees = 1.0;
+
+PressureList::PressureList(QString prsFilePath) : QList<PressureData>(), _journal("pressure")
 {
     _filePath = prsFilePath;
+    _journal.setListFilePath(prsFilePath);
+    _journaling = false;
+    _indexedCount = 0;
 }
 PressureList::~PressureList()
 {
@@ -30,6 +38,95 @@ PressureList::~PressureList()
 void PressureList::setFilePath(QString prsFilePath)
 {
     _filePath=prsFilePath;
+    _journal.setListFilePath(prsFilePath);
+}
+
+bool PressureList::addObservation(const PressureData& observation)
+{
+  updateIndex();
+  if(_byTimeStation.contains(observationKey(observation)))
+    return false;
+  append(observation);
+  updateIndex();
+  return true;
+}
+
+bool PressureList::hasObservation(const PressureData& observation) const
+{
+  updateIndex();
+  return _byTimeStation.contains(observationKey(observation));
+}
+
+QList<int> PressureList::findObservations(float lat, float lon, float radius,
+                                          const QDateTime& first, const QDateTime& last) const
+{
+  updateIndex();
+
+  // A degree of latitude is at least 110.5 km. Longitude uses the same
+  // factor as GriddedData::getCartesianPoint, with some room to spare.
+  float latRadians = lat * acos(-1.0) / 180.0;
+  float latRadius = radius / 110.5;
+  float lonFactor = 111.41513 * cos(latRadians) - 0.09455 * cos(3.0 * latRadians);
+  float lonRadius = 360;
+  if(lonFactor > 0)
+    lonRadius = qMin(1.05f * radius / lonFactor, 360.0f);
+
+  qint64 firstMsecs = first.toMSecsSinceEpoch();
+  qint64 lastMsecs = last.toMSecsSinceEpoch();
+  Bucket low = bucketOf(lat - latRadius, lon - lonRadius);
+  Bucket high = bucketOf(lat + latRadius, lon + lonRadius);
+
+  QList<int> found;
+  for(int latCell = low.first; latCell <= high.first; latCell++) {
+    for(int lonCell = low.second; lonCell <= high.second; lonCell++) {
+      QHash<Bucket, QMultiMap<qint64, int> >::const_iterator bucket
+        = _buckets.constFind(Bucket(latCell, lonCell));
+      if(bucket == _buckets.constEnd())
+        continue;
+      QMultiMap<qint64, int>::const_iterator it = bucket.value().lowerBound(firstMsecs);
+      for(; (it != bucket.value().constEnd()) && (it.key() <= lastMsecs); ++it) {
+        const PressureData& observation = this->at(it.value());
+        if((fabs(observation.getLat() - lat) <= latRadius)
+           && (fabs(observation.getLon() - lon) <= lonRadius))
+          found.append(it.value());
+      }
+    }
+  }
+  qSort(found);
+  return found;
+}
+
+void PressureList::clear()
+{
+  QList<PressureData>::clear();
+  invalidateIndex();
+}
+
+void PressureList::invalidateIndex()
+{
+  _indexedCount = 0;
+  _byTimeStation.clear();
+  _buckets.clear();
+}
+
+PressureList::ObservationKey PressureList::observationKey(const PressureData& observation)
+{
+  return ObservationKey(observation.getTime().toMSecsSinceEpoch(), observation.getStationName());
+}
+
+PressureList::Bucket PressureList::bucketOf(float lat, float lon)
+{
+  return Bucket((int)floorf(lat / bucketDegrees), (int)floorf(lon / bucketDegrees));
+}
+
+void PressureList::updateIndex() const
+{
+  for(; _indexedCount < count(); _indexedCount++) {
+    const PressureData& observation = this->at(_indexedCount);
+    _byTimeStation.insert(observationKey(observation), _indexedCount);
+    _buckets[bucketOf(observation.getLat(), observation.getLon())]
+      .insert(observation.getTime().toMSecsSinceEpoch(), _indexedCount);
+  }
 }
 
 bool PressureList::saveXML()
@@ -74,10 +171,201 @@ bool PressureList::saveXML()
 	
     xmlWriter.writeEndElement();
   }
+  xmlWriter.writeEndElement();
+  file.close();
+
+  return true;
+}
+
+bool PressureList::save()
+{
+  bool ok = true;
+  if(!_journaling)
+    ok = saveXML();
+  return appendToJournal() && ok;
+}
+
+bool PressureList::saveAll()
+{
+  bool ok = saveXML();
+  return saveSnapshot() && ok;
+}
+
+bool PressureList::compact()
+{
+  bool ok = true;
+  if(_journaling)
+    ok = saveXML();
+  return saveSnapshot() && ok;
+}
+
+bool PressureList::appendToJournal()
+{
+  // Only records that were added since the last save are written,
+  // unless the journal has to start over from a snapshot
+  int saved = _journal.savedCount();
+  QString savedKey;
+  if((saved > 0) && (saved <= count()))
+    savedKey = recordKey(this->at(saved - 1));
+  int first = _journal.firstUnsaved(count(), savedKey);
+  if((first < 0) || _journal.needsCompaction())
+    return compact();
+  for(int ii = first; ii < count(); ++ii) {
+    QDataStream* out = _journal.beginRecord();
+    if(out == NULL)
+      return compact();
+    writeRecord(*out, this->at(ii));
+    if(!_journal.commitRecord(recordKey(this->at(ii)))) {
+      std::cout<<"error: Cannot append to "<<_journal.getFilePath().toStdString()<<std::endl;
+      return compact();
+    }
+  }
+  return true;
+}
+
+void PressureList::setJournaling(bool journal)
+{
+  _journaling = journal;
+}
+
+QString PressureList::recordKey(const PressureData& record)
+{
+  // Several stations report at the same time
+  return record.getTime().toString("yyyy-MM-ddThh:mm:ss.zzz") + " " + record.getStationName();
+}
+
+QString PressureList::lastKey() const
+{
+  if(isEmpty())
+    return QString();
+  return recordKey(last());
+}
+
+void PressureList::writeRecord(QDataStream& out, const PressureData& record)
+{
+  out << record.getTime() << record.getStationName() << record.getLat() << record.getLon()
+      << record.getAltitude() << record.getPressure() << record.getWindSpeed()
+      << record.getWindDirection();
+}
+
+bool PressureList::readRecord(QDataStream& in, QList<PressureData>& records)
+{
+  QDateTime time;
+  QString stationName;
+  float lat, lon, altitude, pressure, windSpeed, windDirection;
+  in >> time >> stationName >> lat >> lon >> altitude >> pressure >> windSpeed >> windDirection;
+  if(in.status() != QDataStream::Ok)
+    return false;
+
+  PressureData record;
+  record.setTime(time);
+  record.setStationName(stationName);
+  record.setLat(lat);
+  record.setLon(lon);
+  record.setAltitude(altitude);
+  record.setPressure(pressure);
+  record.setWindSpeed(windSpeed);
+  record.setWindDirection(windDirection);
+  records.append(record);
   return true;
 }
 
+bool PressureList::saveSnapshot()
+{
+  ListSnapshot snapshot(_filePath, "pressure");
+  quint64 snapshotId = _journal.nextSnapshotId();
+  QDataStream* out = snapshot.beginWrite(count(), snapshotId);
+  if(out == NULL) {
+    std::cout<<"error: Cannot open file"<<snapshot.getFilePath().toStdString()<<std::endl;
+    return false;
+  }
+
+  for(int ii = 0; ii < count(); ++ii)
+    writeRecord(*out, this->at(ii));
+  if(!snapshot.commit())
+    return false;
+  return _journal.snapshotSaved(snapshotId, count(), lastKey());
+}
+
 bool PressureList::restore()
 {
+  if(restoreSnapshot())
+    return true;
+  return restoreXML();
+}
+
+bool PressureList::restoreSnapshot()
+{
+  ListSnapshot snapshot(_filePath, "pressure");
+  int numRecords;
+  quint64 snapshotId;
+  QDataStream* in = snapshot.beginRead(numRecords, &snapshotId);
+  if(in == NULL)
+    return false;
+
+  QList<PressureData> records;
+  for(int ii = 0; ii < numRecords; ++ii) {
+    if(!readRecord(*in, records))
+      return false;
+  }
+
+  // Then the records saved since the snapshot
+  QList<QByteArray> entries;
+  _journal.readEntries(snapshotId, entries);
+  for(int ii = 0; ii < entries.count(); ++ii) {
+    QDataStream entry(entries.at(ii));
+    ListJournal::prepareStream(entry);
+    if(!readRecord(entry, records))
+      return false;
+  }
+
+  clear();
+  append(records);
+  _journal.restored(snapshotId, count(), lastKey());
+  return true;
+}
+
+bool PressureList::restoreXML()
+{
+  QFile file(_filePath);
+  if(!file.open(QFile::ReadOnly|QFile::Text))
+    return false;
+  QDomDocument doc;
+  if(!doc.setContent(&file))
+    return false;
+  file.close();
+
+  // Only accept a list written for this hurricane and radar
+  QStringList fileParts=QFileInfo(_filePath).fileName().split("_");
+  QDomElement root = doc.documentElement();
+  if((fileParts.count() < 2) || (root.tagName() != "pressures")
+     || (root.firstChildElement("hurricane").text() != fileParts.at(0))
+     || (root.firstChildElement("radar").text() != fileParts.at(1)))
     return false;
+
+  QList<PressureData> records;
+  for(QDomElement element = root.firstChildElement("record"); !element.isNull();
+      element = element.nextSiblingElement("record")) {
+    QDateTime time = QDateTime::fromString(element.firstChildElement("time").text(),
+                                           "yyyy/MM/dd hh:mm:ss");
+    time.setTimeSpec(Qt::UTC);
+    QStringList location = element.firstChildElement("location").text().split(",");
+    if(!time.isValid() || (location.count() != 3))
+      return false;
+
+    PressureData record;
+    record.setTime(time);
+    record.setStationName(element.firstChildElement("stationName").text());
+    record.setLat(location.at(0).trimmed().toFloat());
+    record.setLon(location.at(1).trimmed().toFloat());
+    record.setAltitude(location.at(2).trimmed().toFloat());
+    record.setPressure(element.firstChildElement("pressure").text().trimmed().toFloat());
+    record.setWindSpeed(element.firstChildElement("windSpeed").text().trimmed().toFloat());
+    record.setWindDirection(element.firstChildElement("windDirection").text().trimmed().toFloat());
+    records.append(record);
+  }
+
+  clear();
+  append(records);
+  return true;
 }
@@ -14,21 +14,86 @@
 
 #include <QList>
 #include <QString>
+#include <QStringList>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QPair>
 
 #include "Pressure/PressureData.h"
+#include "IO/ListJournal.h"
 
-class PressureList : public QList<PressureData>
+// The list is only changed through addObservation, clear and restore, so
+// the index below always matches it. The QList is private for that reason.
+class PressureList : private QList<PressureData>
 {
 
 public:
+    using QList<PressureData>::at;
+    using QList<PressureData>::count;
+    using QList<PressureData>::size;
+    using QList<PressureData>::isEmpty;
+
     PressureList(QString prsFilePath=QString());
     virtual ~PressureList();
+    // Writes the xml file
     bool saveXML();
+    // Writes the xml file and a snapshot of the whole list, and starts a
+    // new journal. For the end of a run.
+    bool saveAll();
+    // Appends the records added since the last save to the journal, and
+    // rewrites the xml file unless journaling is on. The snapshot is only
+    // written when the journal is compacted.
+    bool save();
+    // With journaling on the xml file is only rewritten on compaction
+    void setJournaling(bool journal);
+    // Rebuild the list from the snapshot and journal, or from the
+    // xml file if there is no usable snapshot
     bool restore();
     void setFilePath(QString prsFilePath);
+
+    // Appends the observation unless the station has already reported at
+    // that time. Returns false for a duplicate.
+    bool addObservation(const PressureData& observation);
+    bool hasObservation(const PressureData& observation) const;
+    // Positions in the list, in order, of the observations taken from
+    // first to last and inside the latitude and longitude box that holds
+    // every point within radius km of (lat, lon). Callers measure the
+    // distance to each of them themselves.
+    QList<int> findObservations(float lat, float lon, float radius,
+                                const QDateTime& first, const QDateTime& last) const;
+    void clear();
 private:
     QString _filePath;
+    ListJournal _journal;
+    bool _journaling;
+
+    // Observations by time and station for the duplicate check, and by
+    // time within bucketDegrees square latitude and longitude cells for
+    // the searches. Appends are indexed by the next call, anything else
+    // has to invalidateIndex.
+    typedef QPair<qint64, QString> ObservationKey;
+    typedef QPair<int, int> Bucket;
+    static const float bucketDegrees;
+    mutable int _indexedCount;
+    mutable QMap<ObservationKey, int> _byTimeStation;
+    mutable QHash<Bucket, QMultiMap<qint64, int> > _buckets;
+    static ObservationKey observationKey(const PressureData& observation);
+    static Bucket bucketOf(float lat, float lon);
+    void updateIndex() const;
+    void invalidateIndex();
     void createDomPressureDataEntry(const PressureData &newData);
+
+    static QString recordKey(const PressureData& record);
+    QString lastKey() const;
+    static void writeRecord(QDataStream& out, const PressureData& record);
+    static bool readRecord(QDataStream& in, QList<PressureData>& records);
+    bool saveSnapshot();
+    bool appendToJournal();
+    bool compact();
+    bool restoreSnapshot();
+    bool restoreXML();
 };
 
 #endif
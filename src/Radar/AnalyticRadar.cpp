@@ -23,6 +23,7 @@
   numRays = 0;
   vcp = 0;
   velNull = -999.;
+  fixedSeed = false;
   data = NULL;
   elevations = NULL;
 
@@ -240,7 +241,8 @@ Ray* AnalyticRadar::addRay()
 	//Message::toScreen("Random gate = "+QString().setNum(percentOfGates));
 	if(percentOfGates < noisyGates) {
 	  //Message::toScreen("Got Noise");
-	  srand(time(NULL));  // reinitializes random number generator
+	  if(!fixedSeed)
+	    srand(time(NULL));  // reinitializes random number generator
 	  float noise = rand()%1000/1000.0 -.5;
 	  vel_data[gateNum]+= noiseScale*noise;
 	}
@@ -370,6 +372,19 @@ bool AnalyticRadar::readVolumeAnalytic()
   
   radarDateTime = QDateTime::currentDateTime();
 
+  // A fixed seed and volume time make the sampled volume reproducible
+  QDomElement seed = analytic_radar.firstChildElement("seed");
+  if(!seed.isNull()) {
+    srand(seed.text().toUInt());
+    fixedSeed = true;
+  }
+  QDomElement volumeTime = analytic_radar.firstChildElement("datetime");
+  if(!volumeTime.isNull()) {
+    QDateTime fixedTime = QDateTime::fromString(volumeTime.text().trimmed(), Qt::ISODate);
+    if(fixedTime.isValid())
+      radarDateTime = fixedTime;
+  }
+
   radarName = QString("Analytic Radar"); 
   
   GriddedFactory *factory = new GriddedFactory();
@@ -71,6 +71,9 @@ class AnalyticRadar : public RadarData
   int noisyGates;
   // Analytic radar parameter, which are read from the configuration
 
+  bool fixedSeed;
+  // True when the noise comes from the seed in the configuration
+
   float *elevations;
   // elevations contains the sweep angles used
 
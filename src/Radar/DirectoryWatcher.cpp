@@ -0,0 +1,235 @@
+/*
+ *  DirectoryWatcher.cpp
+ *  VORTRAC
+ *
+ *  Reports files that have been completely written to a data directory
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QElapsedTimer>
+#include "DirectoryWatcher.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+
+static bool isRemoteFilesystem(const QString& path)
+{
+    // inotify only sees changes made by this host on these
+    struct statfs info;
+    if(statfs(QFile::encodeName(path).constData(), &info) != 0)
+        return false;
+    switch((unsigned int)info.f_type) {
+    case 0x6969u:        // NFS
+    case 0x517Bu:        // SMB
+    case 0xFF534D42u:    // CIFS
+    case 0xFE534D42u:    // SMB2
+    case 0x65735546u:    // FUSE
+        return true;
+    }
+    return false;
+}
+#endif
+
+DirectoryWatcher::DirectoryWatcher(const QString& path, bool forcePolling, int settle)
+{
+    dirPath = path;
+    settleMsecs = settle;
+    notifyFd = -1;
+    watchId = -1;
+    rescan = true;
+
+    // Start watching before the first listing so nothing falls in between
+    if(!forcePolling)
+        openNotifier();
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    closeNotifier();
+}
+
+QStringList DirectoryWatcher::takeReadyFiles(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for(;;) {
+        if(isNotifying())
+            readEvents(0);
+        if(rescan || !isNotifying())
+            scanDirectory();
+        if(!settling.isEmpty())
+            checkSettling();
+        if(!ready.isEmpty())
+            break;
+
+        qint64 left = msecs - timer.elapsed();
+        if(left <= 0)
+            break;
+        // Files waiting to settle have to be looked at again
+        int wait = (int)left;
+        if(!isNotifying() || !settling.isEmpty())
+            wait = qMin(wait, (int)pollMsecs);
+        if(isNotifying())
+            readEvents(wait);
+        else
+            QThread::msleep(wait);
+    }
+
+    QStringList files = ready;
+    ready.clear();
+    return files;
+}
+
+bool DirectoryWatcher::openNotifier()
+{
+#ifdef Q_OS_LINUX
+    if(!QFileInfo(dirPath).isDir() || isRemoteFilesystem(dirPath))
+        return false;
+
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(notifyFd < 0)
+        return false;
+    watchId = inotify_add_watch(notifyFd, QFile::encodeName(dirPath).constData(),
+                                IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+    if(watchId < 0) {
+        closeNotifier();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DirectoryWatcher::closeNotifier()
+{
+#ifdef Q_OS_LINUX
+    if(notifyFd >= 0)
+        close(notifyFd);
+#endif
+    notifyFd = -1;
+    watchId = -1;
+}
+
+void DirectoryWatcher::readEvents(int msecs)
+{
+#ifdef Q_OS_LINUX
+    struct pollfd pfd;
+    pfd.fd = notifyFd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if(poll(&pfd, 1, msecs) <= 0)
+        return;
+
+    char buffer[16*(sizeof(struct inotify_event) + NAME_MAX + 1)]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    for(;;) {
+        ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+        if(length <= 0)
+            break;
+
+        for(char *ptr = buffer; ptr < buffer + length; ) {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW) {
+                // Events were dropped, list the directory again
+                rescan = true;
+                continue;
+            }
+            if(event->mask & IN_IGNORED) {
+                // The directory itself is gone or was unmounted
+                closeNotifier();
+                rescan = true;
+                return;
+            }
+            if((event->len == 0) || (event->mask & IN_ISDIR))
+                continue;
+
+            QString name = QFile::decodeName(event->name);
+            if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                // A file written again under the same name is new data
+                settling.remove(name);
+                ready.removeAll(name);
+                reported.remove(name);
+            } else {
+                markReady(name);
+            }
+        }
+    }
+#else
+    Q_UNUSED(msecs);
+#endif
+}
+
+void DirectoryWatcher::scanDirectory()
+{
+    // Only list the directory when an entry has been added or removed
+    QDateTime modified = QFileInfo(dirPath).lastModified();
+    if(!rescan && (modified == dirModified))
+        return;
+    dirModified = modified;
+    // The time stamp may be too coarse to tell two changes apart
+    rescan = !isNotifying() && (modified.msecsTo(QDateTime::currentDateTime()) < settleMsecs);
+
+    QFileInfoList entries = QDir(dirPath).entryInfoList(QDir::Files, QDir::Name);
+    for(int i = 0; i < entries.size(); i++) {
+        const QFileInfo& info = entries.at(i);
+        QString name = info.fileName();
+        if(reported.contains(name) || settling.contains(name))
+            continue;
+        Pending pending;
+        pending.size = info.size();
+        pending.modified = info.lastModified();
+        settling.insert(name, pending);
+    }
+}
+
+void DirectoryWatcher::checkSettling()
+{
+    QDir dir(dirPath);
+    QDateTime now = QDateTime::currentDateTime();
+    QStringList complete;
+    QHash<QString, Pending>::iterator it = settling.begin();
+    while(it != settling.end()) {
+        QFileInfo info(dir.filePath(it.key()));
+        if(!info.exists()) {
+            it = settling.erase(it);
+            continue;
+        }
+        qint64 size = info.size();
+        QDateTime modified = info.lastModified();
+        if((size == it.value().size) && (modified == it.value().modified)
+           && (modified.msecsTo(now) >= settleMsecs)) {
+            complete.append(it.key());
+        } else {
+            it.value().size = size;
+            it.value().modified = modified;
+        }
+        ++it;
+    }
+
+    complete.sort();
+    for(int i = 0; i < complete.size(); i++)
+        markReady(complete.at(i));
+}
+
+void DirectoryWatcher::markReady(const QString& name)
+{
+    settling.remove(name);
+    if(reported.contains(name))
+        return;
+    reported.insert(name);
+    ready.append(name);
+}
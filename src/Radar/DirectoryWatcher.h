@@ -0,0 +1,79 @@
+/*
+ *  DirectoryWatcher.h
+ *  VORTRAC
+ *
+ *  Reports files that have been completely written to a data directory
+ *
+ *  Copyright 2005 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+
+// Each file name is reported once, as soon as the file is complete.
+// On Linux the directory is watched with inotify and a file is complete
+// when it has been closed after writing or moved into the directory.
+// Elsewhere, on network filesystems that do not deliver notifications,
+// or when polling is requested, the directory is only listed again when
+// its modification time changes, and a new file is complete once its
+// size and time stamp have stopped changing.
+
+class DirectoryWatcher
+{
+
+ public:
+  static const int defaultSettleMsecs = 1000;
+
+  // settleMsecs is how long a file has to be left alone before polling
+  // calls it complete
+  DirectoryWatcher(const QString& path, bool forcePolling = false,
+                   int settleMsecs = defaultSettleMsecs);
+  ~DirectoryWatcher();
+
+  // Returns the files that became complete since the last call, waiting
+  // up to msecs for one to show up
+  QStringList takeReadyFiles(int msecs = 0);
+
+  bool isNotifying() const { return (notifyFd >= 0); }
+  QString getPath() const { return dirPath; }
+
+ private:
+  class Pending {
+  public:
+    qint64 size;
+    QDateTime modified;
+  };
+
+  QString dirPath;
+  int notifyFd;
+  int watchId;
+  QDateTime dirModified;
+  bool rescan;
+
+  QSet<QString> reported;
+  QHash<QString, Pending> settling;
+  QStringList ready;
+
+  int settleMsecs;
+  static const int pollMsecs = 250;
+
+  bool openNotifier();
+  void closeNotifier();
+  void readEvents(int msecs);
+  void scanDirectory();
+  void checkSettling();
+  void markReady(const QString& name);
+
+  DirectoryWatcher(const DirectoryWatcher&);
+  DirectoryWatcher& operator=(const DirectoryWatcher&);
+};
+
+#endif
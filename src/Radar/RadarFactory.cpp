@@ -10,10 +10,10 @@
 
 #include <iostream>
 #include <QPushButton>
-#include <unistd.h>
 
 #include "RadarFactory.h"
 #include "DateChecker.h"
+#include "DirectoryWatcher.h"
 
 RadarFactory::RadarFactory(Configuration* radarConfig, QObject *parent): QObject(parent)
 {
@@ -55,6 +55,14 @@ RadarFactory::RadarFactory(Configuration* radarConfig, QObject *parent): QObject
         // Will implement more later but give error for now
         emit log(Message("Data format not supported"));
     }
+    checker = DateCheckerFactory::newChecker(radarFormat);
+
+    // New volumes are picked up from directory notifications when the
+    // filesystem supports them, <watch>poll</watch> forces polling
+    bool forcePolling = false;
+    if(!radar.firstChildElement("watch").isNull())
+        forcePolling = (mainConfig->getParam(radar,"watch") == "poll");
+    watcher = new DirectoryWatcher(path, forcePolling);
 }
 
 RadarFactory::~RadarFactory()
@@ -62,6 +70,8 @@ RadarFactory::~RadarFactory()
     mainConfig = NULL;
     delete mainConfig;
     delete radarQueue;
+    delete watcher;
+    delete checker;
 }
 
 RadarData* RadarFactory::getUnprocessedData()
@@ -75,18 +85,12 @@ RadarData* RadarFactory::getUnprocessedData()
     }
 
     // Get the files off the queue
-    QString fileName = dataPath.filePath(radarQueue->dequeue());
-
-    // Test file to make sure it is not growing
-    QFile radarFile(fileName);
-    qint64 newFilesize = radarFile.size();
-    qint64 prevFilesize = 0;
-    while (prevFilesize != newFilesize) {
-        prevFilesize = newFilesize;
-        sleep(1);
-        newFilesize = radarFile.size();
-    }
-    sleep(1);
+    QString file = radarQueue->dequeue();
+    fileTimes.remove(file);
+    QString fileName = dataPath.filePath(file);
+
+    // The watcher only hands out files that are completely written,
+    // no need to wait for it to stop growing
     // Mark it as processed
     fileAnalyzed[fileName] = true;
 
@@ -154,26 +158,8 @@ bool RadarFactory::hasUnprocessedData()
         return true;
     }
 
-    // Get a list of files in the radar directory
-
-    dataPath.setFilter(QDir::Files);
-    dataPath.setSorting(QDir::Name);
-    QStringList filenames = dataPath.entryList();
-
-    DateChecker *checker = DateCheckerFactory::newChecker(radarFormat);
-
-    for (int i = 0; i < filenames.size(); i++) {
-      QString file = filenames.at(i);
-
-      if ( fileAnalyzed[dataPath.filePath(file)])	// been there, done that?
-	continue;
-
-      // Get the date info from the file name
-      if(checker->fileInRange(file, radarName, startDateTime, endDateTime))
-	radarQueue->enqueue(file);
-    }
-
-    delete checker;
+    // Only files that showed up since the last call need to be looked at
+    queueReadyFiles(watcher->takeReadyFiles(0));
 
 #if 0
 
@@ -367,6 +353,47 @@ bool RadarFactory::hasUnprocessedData()
 
 }
 
+bool RadarFactory::waitForNewData(int msecs)
+{
+    // Returns as soon as a new volume is complete, or after msecs
+    if ( ! radarQueue->isEmpty() ) {
+        return true;
+    }
+    queueReadyFiles(watcher->takeReadyFiles(msecs));
+    return !radarQueue->isEmpty();
+}
+
+void RadarFactory::queueReadyFiles(const QStringList& files)
+{
+    if (checker == NULL)
+        return;
+
+    for (int i = 0; i < files.size(); i++) {
+      QString file = files.at(i);
+
+      if ( fileAnalyzed.value(dataPath.filePath(file)))	// been there, done that?
+	continue;
+
+      // Get the date info from the file name
+      if(!checker->fileInRange(file, radarName, startDateTime, endDateTime))
+	continue;
+
+      // Keep the queue in time order, files may not arrive in order
+      QDateTime fileTime = checker->getTime();
+      int first = 0;
+      int last = radarQueue->size();
+      while (first < last) {
+	int mid = (first + last) / 2;
+	if (fileTime < fileTimes.value(radarQueue->at(mid)))
+	  last = mid;
+	else
+	  first = mid + 1;
+      }
+      fileTimes.insert(file, fileTime);
+      radarQueue->insert(first, file);
+    }
+}
+
 void RadarFactory::catchLog(const Message& message)
 {
     emit log (message);
@@ -374,115 +401,24 @@ void RadarFactory::catchLog(const Message& message)
 
 void RadarFactory::updateDataQueue(const VortexList* list)
 {
-  if(!(list->count()>0))
+    // Drops the volumes a resumed run has already analyzed. The list is
+    // in time order and so is the queue, so those are the files at the
+    // front of the queue up to the last volume in the list. The time in a
+    // file name can be a little after the volume's own time, hence the
+    // 30 s of slack. Works from the times the checker took from the file
+    // names, the same for every format. Model file names have no time, so
+    // those are left for workThread to skip once it has read them.
+    if(list->isEmpty())
         return;
-    int totalFiles = radarQueue->count();
-    for(int i = totalFiles-1; i >= 0; i--)
-    {
-        switch(radarFormat) {
-        case ncdclevelII:
-        {   // Check to see which are in the time limits
-            QString file = radarQueue->at(i);
-            QString timepart = file;
-            // Replace the radarname so we just have timestamps
-            //KAMX20050825_060806-->20050825,060806
-            timepart.replace(radarName, "");
-            QStringList timestamp = timepart.split("_");
-            QDate fileDate = QDate::fromString(timestamp.at(0), "yyyyMMdd");
-            QTime fileTime = QTime::fromString(timestamp.at(1), "hhmmss");
-            QDateTime fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
-
-            if (fileDateTime >= startDateTime && fileDateTime <= endDateTime){
-                // Valid time and radar name, check to see if it
-                //  has been processed in vortexList
-                for(int j = 0; j < list->size(); j++) {
-                    QDateTime processedTime = list->at(j).getTime();
-                    if(abs(processedTime.secsTo(fileDateTime)) < 30) {
-                        if (!fileAnalyzed[dataPath.filePath(file)]) {
-                            // File has been analyzed, remove it from the queue
-                            radarQueue->removeAt(radarQueue->indexOf(file));
-                            fileAnalyzed[dataPath.filePath(file)] = true;
-                        }
-                    }
-                    else {
-                        if(list->last().getTime() >  fileDateTime)
-                            if(!fileAnalyzed[dataPath.filePath(file)]) {
-                                radarQueue->removeAt(radarQueue->indexOf(file));
-                                fileAnalyzed[dataPath.filePath(file)] = true;
-                            }
-                    }
-                }
-            }
-            break;
-        }
-        case ldmlevelII:
-        {
-            // Should have filenames starting with radar ID
-            // Check to see which are already in vortexList
-            QString file = radarQueue->at(i);
-            QString timepart = file.split("/").last();
-            // Replace the radarname so we just have timestamps
-            timepart.replace(radarName, "");
-            QDate fileDate;
-            QTime fileTime;
-            if (timepart.contains('.')) {
-                // NRL Format
-                QStringList timestamp = timepart.split(".");
-                fileDate = QDate::fromString(timestamp.at(1).left(8), "yyyyMMdd");
-                fileTime = QTime::fromString(timestamp.at(1).right(6), "hhmmss");
-            }  else if (timepart.contains('_')) {
-                // Purdue Format
-                QStringList timestamp = timepart.split("_");
-                fileDate = QDate::fromString(timestamp.at(1), "yyyyMMdd");
-                if (timestamp.size() > 2) {
-                    fileTime = QTime::fromString(timestamp.at(2), "hhmm");
-                } else {
-                    emit log(Message(QString("Problem with time in level_II filename, this may be a NCDC file"),0,this->objectName(),Red,QString("Radar format mismatch?")));
-                }
-            }
-
-            QDateTime fileDateTime = QDateTime(fileDate, fileTime, Qt::UTC);
-            if (fileDateTime >= startDateTime && fileDateTime <= endDateTime){
-                // Valid time and radar name, check to see if it
-                //  has been processed in vortexList
-                for(int j = 0; j < list->size(); j++) {
-                    QDateTime processedTime = list->at(j).getTime();
-                    if(abs(processedTime.secsTo(fileDateTime)) < 30) {
-                        if (!fileAnalyzed[dataPath.filePath(file)]) {
-                            // File has been analyzed, remove it from the queue
-                            radarQueue->removeAt(radarQueue->indexOf(file));
-                            fileAnalyzed[dataPath.filePath(file)] = true;
-                            //  Message::toScreen("Plucked file "+file+" from the list");
-                        }
-                    }
-                    else {
-                        if(list->last().getTime() >  fileDateTime)
-                            if(!fileAnalyzed[dataPath.filePath(file)]) {
-                                radarQueue->removeAt(radarQueue->indexOf(file));
-                                fileAnalyzed[dataPath.filePath(file)] = true;
-                            }
-                    }
-                }
-            }
+    QDateTime lastProcessed = list->last().getTime().addSecs(30);
+    while(!radarQueue->isEmpty()) {
+        QString file = radarQueue->head();
+        QDateTime fileTime = fileTimes.value(file);
+        if(!fileTime.isValid() || (fileTime >= lastProcessed))
             break;
-        }
-        case model:
-        {
-            // Not yet implemented
-            break;
-        }
-        case dorade:
-        {
-            // Not yet implemented
-            break;
-        }
-        case netcdf:
-        {
-            // Not yet implemented
-            break;
-        }
-
-        }
+        radarQueue->dequeue();
+        fileTimes.remove(file);
+        fileAnalyzed[dataPath.filePath(file)] = true;
     }
 }
 
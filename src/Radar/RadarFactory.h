@@ -28,6 +28,9 @@
 #include "GUI/ConfigTree.h"
 #include "DataObjects/VortexList.h"
 
+class DirectoryWatcher;
+class DateChecker;
+
 class RadarFactory : public QObject
 {
 
@@ -39,6 +42,7 @@ public:
     ~RadarFactory();
     RadarData* getUnprocessedData();
     bool hasUnprocessedData();
+    bool waitForNewData(int msecs);
     int getNumProcessed() const;
 
     enum dataFormat {
@@ -67,11 +71,16 @@ private:
     float radarAlt;
     dataFormat radarFormat;
     QQueue<QString> *radarQueue;
+    QHash<QString, QDateTime> fileTimes;
+    DirectoryWatcher *watcher;
+    DateChecker *checker;
     QDateTime startDateTime;
     QDateTime endDateTime;
     QHash<QString, bool> fileAnalyzed;
     QDateTime radarDateTime;
     Configuration* mainConfig;
+
+    void queueReadyFiles(const QStringList& files);
 };
 
 #endif
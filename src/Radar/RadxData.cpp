@@ -20,23 +20,30 @@ RadxData::RadxData(const QString &radarname, const float &lat, const float &lon,
   numRays = 0;
   radarLat = lat;
   radarLon = lon;
+  volume = NULL;
 
 }
 
 RadxData::~RadxData()
 {
+  release();
+}
+
+void RadxData::release()
+{
+  // Rays first, they point into the volume
   delete [] Sweeps;
   delete [] Rays;
   Sweeps = NULL;
   Rays = NULL;
+  delete volume;
+  volume = NULL;
+  missingVel.clear();
 }
 
-// TODO
-// This essentially takes an array of float from the Radx library,
-// and shoves it into an array of float in the Radar object.
-// See if we can change the RadarData interface to access the
-// Radx data directly
-// Maybe put a handle to the field instead of the arrays
+// Returns the data of a field of the ray in place, in the float buffer of
+// the volume, with missing values set to -999. The volume has to be
+// converted to float32 already.
 
 float *RadxData::getRayData(RadxRay *fileRay, const char *fieldName)
 {
@@ -45,30 +52,22 @@ float *RadxData::getRayData(RadxRay *fileRay, const char *fieldName)
   if (field == NULL)
     return NULL;
 
-  float *retVal = new float[field->getNPoints()];
-  if (retVal == NULL) {
-    std::cerr << "RadxData::fillRayData: Failed to allocate data array" << std::endl;
-    return NULL;
-  }
-
-  // Convert field to float32
-  field->convertToFl32();
-  
   // When homebrew picks up the fixed version,
-  // uncomment the next line, and remove the check
-  // for missingFl32.
-  // field->setMissingFl32(-999.0);
-
-  const float missing32 = field->getMissingFl32();
-
-  const Radx::fl32 *fieldPtr = field->getDataFl32();
-  for(size_t index = 0; index < field->getNPoints(); index++) {
-    float val = fieldPtr[index];
-    if (val == missing32)
-      val = -999.0;
-    retVal[index] = val;
+  // use field->setMissingFl32(-999.0) instead
+  // of the check for missingFl32.
+
+  const Radx::fl32 missing32 = field->getMissingFl32();
+
+  Radx::fl32 *fieldPtr = field->getDataFl32();
+  if (fieldPtr == NULL)
+    return NULL;
+  if (missing32 != -999.0) {
+    for(size_t index = 0; index < field->getNPoints(); index++) {
+      if (fieldPtr[index] == missing32)
+	fieldPtr[index] = -999.0;
+    }
   }
-  return retVal;
+  return fieldPtr;
 }
 
 bool RadxData::readVolume()
@@ -77,7 +76,9 @@ bool RadxData::readVolume()
   // The file can be in any format supported by the Radx library.
 
   RadxFile file;
-  RadxVol vol;
+  release();
+  volume = new RadxVol;
+  RadxVol &vol = *volume;
 
   QString fileName = getFileName();
 
@@ -100,6 +101,10 @@ bool RadxData::readVolume()
 
   int scanID = vol.getScanId();  // VCP
 
+  // Convert every field to float32 once, the rays use that data in place
+
+  vol.convertToFl32();
+
   // Allocate storage for sweeps and rays
 
   Sweeps = new Sweep[numSweeps];
@@ -107,10 +112,22 @@ bool RadxData::readVolume()
 
   // Iterate on the rays (since they have info we need for the sweep)
 
-  const vector<RadxRay *> rays = vol.getRays();
+  const vector<RadxRay *> &rays = vol.getRays();
   vector<RadxRay *>::const_iterator ray_it;
   int rayCount = 0;
 
+  // Lots of algorithms (QC Cappi, can't deal with missing Vel)
+  // So set aside velocity data filled with -999 for rays without one.
+  // Every ray gets its own part since QC changes velocities in place.
+
+  size_t missingGates = 0;
+  for(ray_it = rays.begin(); ray_it < rays.end(); ray_it++) {
+    if ((*ray_it)->getField("VEL") == NULL)
+      missingGates += (*ray_it)->getNGates();
+  }
+  missingVel.assign(missingGates, -999.0);
+  size_t missingOffset = 0;
+
   for(ray_it = rays.begin(); ray_it < rays.end(); ray_it++, rayCount++) {
     RadxRay *fileRay = *ray_it;
     Ray *myRay = &Rays[rayCount];
@@ -157,19 +174,12 @@ bool RadxData::readVolume()
     // With file.setReadPreserveSweeps(true) above (to match what the old reader was doing),
     //    we might have long rays that don't have VEL and SW
 
-    myRay->setRefData(getRayData(fileRay, "REF"));
-    myRay->setVelData(getRayData(fileRay, "VEL"));
-    myRay->setSwData( getRayData(fileRay, "SW"));
-
-    // Lots of algorithms (QC Cappi, can't deal with missing Vel)
-    // So fill in the Velocity data with -999)
-
-    if(myRay->getVelData() == NULL) {
-      float *buffer = new float[nGates];
-      for(int i = 0; i < nGates; i++)
-	buffer[i] = -999;
-      myRay->setVelData(buffer);
+    float *velData = getRayData(fileRay, "VEL");
+    if ((velData == NULL) && (nGates > 0) && (missingOffset + nGates <= missingVel.size())) {
+      velData = &missingVel[missingOffset];
+      missingOffset += nGates;
     }
+    myRay->setDataView(getRayData(fileRay, "REF"), velData, getRayData(fileRay, "SW"));
   }
 
   // Iterate on the sweeps
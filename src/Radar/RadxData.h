@@ -1,9 +1,12 @@
 #ifndef RADXDATA_H
 #define RADXDATA_H
 
+#include <vector>
 #include "Radx/RadxRay.hh"
 #include "Radar/RadarData.h"
 
+class RadxVol;
+
 class RadxData : public RadarData
 {
  public:
@@ -14,7 +17,16 @@ class RadxData : public RadarData
 
   bool readVolume();
   float *getRayData(RadxRay *fileRay, const char *fieldName);
-  
+
+ private:
+
+  // The rays point straight into the float fields of the volume, so it
+  // lives as long as this object
+  RadxVol *volume;
+  // Stands in for the velocity of rays that have none
+  std::vector<float> missingVel;
+
+  void release();
 };
 
 #endif
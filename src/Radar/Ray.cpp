@@ -23,6 +23,7 @@ Ray::Ray()
   refData = NULL;
   velData = NULL;
   swData = NULL;
+  ownData = true;
   unambig_range = -999;
   nyquist_vel = -999;
   first_ref_gate = -999;
@@ -36,11 +37,20 @@ Ray::Ray()
 
 Ray::~Ray()
 {
+  if (!ownData)
+    return;
   if (refData != NULL) delete [] refData;
   if (velData != NULL) delete [] velData;
   if (swData != NULL) delete [] swData;
 }
 
+void Ray::setDataView(float *ref, float *vel, float *sw) {
+  refData = ref;
+  velData = vel;
+  swData = sw;
+  ownData = false;
+}
+
 void Ray::setTime(const int &value) {
   //  Message::toScreen("Does This Function Get Used? - setTime");
   time = value;
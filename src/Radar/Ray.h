@@ -47,6 +47,9 @@ class Ray
   void setRefData(float *buffer) { refData = buffer; };
   void setVelData(float *buffer) { velData = buffer; };
   void setSwData(float *buffer)  { swData = buffer; };
+  // The buffers belong to someone else (the reader's volume) who keeps
+  // them alive as long as the ray. They can still be modified in place.
+  void setDataView(float *ref, float *vel, float *sw);
   
   int getTime();
   int getDate();
@@ -84,6 +87,7 @@ class Ray
   float *refData;
   float *velData;
   float *swData;
+  bool ownData;
   float unambig_range;
   float nyquist_vel;
   int first_ref_gate;
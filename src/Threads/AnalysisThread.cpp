@@ -408,7 +408,7 @@ void AnalysisThread::run()
 
             connect(dealiaser, SIGNAL(log(const Message&)), this,
                     SLOT(catchLog(const Message&)));
-            dealiaser->getConfig(configData->getConfig("qc"));
+            dealiaser->getConfig(configData->getSnapshot().qc);
 
             if(dealiaser->dealias()) {
                 emit log(Message("Finished QC and Dealiasing",1, this->objectName()));  // 10 %
@@ -456,7 +456,7 @@ void AnalysisThread::run()
                                                  &radarLat, &radarLon);
         }
         else {
-            _gridData = gridFactory.makeCappi(radarVolume, configData,&vortexLat, &vortexLon);
+            _gridData = gridFactory.makeCappi(radarVolume, configData->getSnapshot(),&vortexLat, &vortexLon);
         }
 
         emit log(Message("Done with Cappi",15,this->objectName()));
@@ -554,7 +554,7 @@ void AnalysisThread::run()
             mutex.lock();
             // Get the GBVTD winds
             emit log(Message(QString(), 2,this->objectName()));
-            vortexThread->getWinds(configData, _gridData, radarVolume,vortexData, pressureList);
+            vortexThread->getWinds(configData->getSnapshot(), _gridData, radarVolume,vortexData, pressureList);
             waitForWinds.wait(&mutex);
             mutex.unlock();
         }
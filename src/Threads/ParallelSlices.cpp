@@ -0,0 +1,69 @@
+/*
+ *  ParallelSlices.cpp
+ *  VORTRAC
+ *
+ *  Runs the slices of a pass, like grid columns, sweeps or simplex
+ *  searches, on a pool of workers
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+
+#include "ParallelSlices.h"
+
+class SliceWorker : public QRunnable
+{
+
+ public:
+    SliceWorker(const std::function<void(int, int)>& work, int worker,
+                int numSlices, QAtomicInt* nextSlice)
+        : work(work), worker(worker), numSlices(numSlices), nextSlice(nextSlice) {}
+
+    void run()
+    {
+        for (int n = nextSlice->fetchAndAddRelaxed(1); n < numSlices;
+             n = nextSlice->fetchAndAddRelaxed(1))
+            work(worker, n);
+    }
+
+ private:
+    const std::function<void(int, int)>& work;
+    int worker;
+    int numSlices;
+    QAtomicInt* nextSlice;
+};
+
+int parallelWorkers(int numSlices, int threads)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    if (threads > numSlices)
+        threads = numSlices;
+    if (threads < 1)
+        threads = 1;
+    return threads;
+}
+
+void runParallel(int numSlices, int threads,
+                 const std::function<void(int worker, int n)>& work)
+{
+    int workers = parallelWorkers(numSlices, threads);
+    if (workers <= 1) {
+        for (int n = 0; n < numSlices; n++)
+            work(0, n);
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QAtomicInt nextSlice(0);
+    for (int t = 0; t < workers; t++)
+        pool.start(new SliceWorker(work, t, numSlices, &nextSlice));
+    pool.waitForDone();
+}
@@ -0,0 +1,33 @@
+/*
+ *  ParallelSlices.h
+ *  VORTRAC
+ *
+ *  Runs the slices of a pass, like grid columns, sweeps or simplex
+ *  searches, on a pool of workers
+ *
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef PARALLELSLICES_H
+#define PARALLELSLICES_H
+
+#include <functional>
+
+// Workers pull slices off a shared counter until they run out. A slice
+// should only write to its own part of the output, so the result does not
+// depend on which worker ran it.
+
+// Number of workers runParallel uses: threads, or every core if threads
+// is 0, but no more than there are slices and at least one
+int parallelWorkers(int numSlices, int threads);
+
+// Calls work(worker, n) for every n below numSlices. worker is below
+// parallelWorkers(numSlices, threads), so scratch space kept per worker
+// can be indexed by it. With one worker the slices run in order on the
+// calling thread.
+void runParallel(int numSlices, int threads,
+                 const std::function<void(int worker, int n)>& work);
+
+#endif
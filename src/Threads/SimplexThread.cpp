@@ -9,6 +9,7 @@
  */
 
 #include <QtGui>
+#include <QThread>
 #include <math.h>
 #include "SimplexThread.h"
 #include "DataObjects/Coefficient.h"
@@ -16,29 +17,41 @@
 #include "VTD/VTDFactory.h"
 #include "Math/Matrix.h"
 #include "NRL/Hvvp.h"
+#include "IO/VolumeProfile.h"
+#include "Threads/ParallelSlices.h"
 
 // TODO debug
 # include <iostream>
 
+SimplexWorkspace::SimplexWorkspace(QString& geometry, QString& closure, int& maxWave, float*& dataGaps)
+{
+    vtd = VTDFactory::createVTD(geometry, closure, maxWave, dataGaps);
+    vtdCoeffs = new Coefficient[20];
+}
+
+SimplexWorkspace::~SimplexWorkspace()
+{
+    delete   vtd;
+    delete[] vtdCoeffs;
+}
+
 SimplexThread::SimplexThread(QObject* parent):QObject(parent)
 {
     this->setObjectName("Simplex");
     velNull = -999.;
     gridData = NULL;
-    configData = NULL;
 
     _dataGaps = NULL;
-    _vtdCoeffs = NULL;
+    _maxWave = 0;
+    _velField = -1;
 }
 
 SimplexThread::~SimplexThread()
 {
-    delete   _simplexVTD;
-    delete[] _vtdCoeffs;
     delete[] _dataGaps;
 }
 
-void SimplexThread::initParam(Configuration *wholeConfig,GriddedData *dataPtr,float latGuess,float lonGuess)
+void SimplexThread::initParam(const ConfigSnapshot& settings,GriddedData *dataPtr,float latGuess,float lonGuess)
 {
 
     // Set the grid object
@@ -49,7 +62,7 @@ void SimplexThread::initParam(Configuration *wholeConfig,GriddedData *dataPtr,fl
     _lonGuess = lonGuess;
 
     // Set the configuration info
-    configData = wholeConfig;
+    centerConfig = settings.center;
 }
 
 bool SimplexThread::findCenter(SimplexList* simplexList)
@@ -57,18 +70,17 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
 
     //STEP 1: retrieve all the parameters for Simplex algorithm
 
-    QDomElement simplexCfg = configData->getConfig("center");
-    QString geometry = configData->getParam(simplexCfg,QString("geometry"));
-    QString velField = configData->getParam(simplexCfg,QString("velocity"));
-    QString closure = configData->getParam(simplexCfg,QString("closure"));
+    _geometry = centerConfig.geometry;
+    QString velField = centerConfig.velocity;
+    _closure = centerConfig.closure;
 
-    firstLevel= configData->getParam(simplexCfg,QString("bottomlevel")).toFloat();
-    lastLevel = configData->getParam(simplexCfg,QString("toplevel")).toFloat();
-    firstRing = configData->getParam(simplexCfg,QString("innerradius")).toFloat();
-    lastRing  = configData->getParam(simplexCfg,QString("outerradius")).toFloat();
+    firstLevel= centerConfig.bottomLevel;
+    lastLevel = centerConfig.topLevel;
+    firstRing = centerConfig.innerRadius;
+    lastRing  = centerConfig.outerRadius;
 
-    float boxSize = configData->getParam(simplexCfg,QString("boxdiameter")).toFloat();
-    float numPoints = configData->getParam(simplexCfg,QString("numpoints")).toFloat();
+    float boxSize = centerConfig.boxDiameter;
+    float numPoints = centerConfig.numPoints;
 
     if(numPoints >= 25) {
       std::cerr << "*** Error: <numpoints> is greater than 25 "
@@ -79,33 +91,29 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     float boxRowLength = sqrt(numPoints);
     float boxIncr = boxSize / (sqrt(numPoints) - 1);
 
-    float radiusOfInfluence = configData->getParam(simplexCfg,QString("influenceradius")).toFloat();
-    float convergeCriterion = configData->getParam(simplexCfg,QString("convergence")).toFloat();
-    float maxIterations = configData->getParam(simplexCfg,QString("maxiterations")).toFloat();
-    float ringWidth = configData->getParam(simplexCfg,QString("ringwidth")).toFloat();
-    int   maxWave = configData->getParam(simplexCfg,QString("maxwavenumber")).toInt();
+    _radiusOfInfluence = centerConfig.influenceRadius;
+    _convergeCriterion = centerConfig.convergence;
+    _maxIterations = centerConfig.maxIterations;
+    float ringWidth = centerConfig.ringWidth;
+    _maxWave = centerConfig.maxWaveNumber;
 
     // Define the maximum allowable data gaps
 
-    _dataGaps = new float[maxWave+1];
-    for (int i = 0; i <= maxWave; i++) {
-        _dataGaps[i] = configData->getParam(simplexCfg, QString("maxdatagap"), QString("wavenum"),
-					    QString().setNum(i)).toFloat();
+    delete[] _dataGaps;
+    _dataGaps = new float[_maxWave+1];
+    for (int i = 0; i <= _maxWave; i++) {
+        _dataGaps[i] = centerConfig.maxDataGap.value(i);
     }
 
-    //SETP 2: initialize a VTD object for whole simplex to use
-
-    _simplexVTD = VTDFactory::createVTD(geometry, closure, maxWave, _dataGaps);
-    _vtdCoeffs  = new Coefficient[20];
+    _velField = gridData->getFieldIndex(velField);
 
-    //STEP 3: perform simplex algorithm
+    //SETP 2: lay out the searches. Each worker creates its own VTD object,
+    //        see SimplexWorkspace
 
     // Set ring width in cappi so that griddedData access function use this
 
     gridData->setCylindricalAzimuthSpacing(ringWidth);
 
-    QDomElement cappi = configData->getConfig("cappi");
-
     int nTotalLevels = (int) floor( (lastLevel - firstLevel) / gridData->getKGridsp() + 1.5 );
 
     // We want 1 km spaced rings regardless of ring width
@@ -117,13 +125,12 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     // the ring count should be divided by the ring width
     simplexData->setNumPointsUsed((int)numPoints);
 
-    // Allocate memory for the vertices
-    float** vertex = new float*[3];
-    vertex[0 ]= new float[2];
-    vertex[1] = new float[2];
-    vertex[2] = new float[2];
-    float* VT = new float[3];
-    float* vertexSum = new float[2];
+    // One entry per level and ring, in the order they are archived.
+    // ringFirstSearch is -1 when the first guess is outside the cappi.
+    QList<float> ringHeight;
+    QList<float> ringRadius;
+    QList<int> ringFirstSearch;
+    _searches.clear();
 
     // Loop through the levels and rings,
     // TODO Should this have some reference to grid spacing?
@@ -139,30 +146,19 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
             float CornerI = gridData->getCartesianRefPointI();
             float CornerJ = gridData->getCartesianRefPointJ();
 
-            // std::cout << "** ring: "<< radius <<" RefI: " << CornerI << " RefJ: "<< CornerJ << std::endl;
-
-            float RefK = gridData->getCartesianRefPointK();
             float RefI = CornerI;
             float RefJ = CornerJ;
 
+            ringHeight.append(height);
+            ringRadius.append(radius);
             if ((gridData->getRefPointI() < 0) || (gridData->getRefPointJ() < 0) || (gridData->getRefPointK() < 0))  {
                 emit log(Message(QString("Initial simplex guess is outside CAPPI"),0,this->objectName()));
-                archiveNull(simplexData, radius, height, numPoints);
+                ringFirstSearch.append(-1);
                 continue;
             }
+            ringFirstSearch.append((int)_searches.size());
 
-            // Initialize mean values
-
-            int meanCount = 0;
-            meanXall = meanYall = meanVTall = 0;
-            meanX = meanY = meanVT = 0;
-            stdDevVertexAll = stdDevVTAll = 0;
-            stdDevVertex = stdDevVT = 0;
-            convergingCenters = 0;
-
-            // Loop through the initial guesses
-	    // std::cout << "** Num of points: " << numPoints << std::endl;
-
+            // Lay out the initial guesses
             for (int point = 0; point < numPoints; point++) {
                 if (point < boxRowLength)
                     RefI = CornerI + float(point) * boxIncr;
@@ -171,117 +167,136 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
 
                 RefJ = CornerJ + float(point / int(boxRowLength)) * boxIncr;
 
-                startX[point] = RefI;
-                startY[point] = RefJ;
-
-                // Initialize vertices
-                float sqr32 = 0.866025;
-                vertex[0][0] = RefI;
-                vertex[0][1] = RefJ + radiusOfInfluence;
-                vertex[1][0] = RefI + sqr32 * radiusOfInfluence;
-                vertex[1][1] = RefJ - 0.5 * radiusOfInfluence;
-                vertex[2][0] = RefI - sqr32 * radiusOfInfluence;
-                vertex[2][1] = RefJ - 0.5 * radiusOfInfluence;
-                vertexSum[0] = 0;
-                vertexSum[1] = 0;
-
-                for (int v = 0; v <= 2; v++) {
-		  //Calculate mean wind at each vertex
-		  VT[v] = _getSymWind(vertex[v][0], vertex[v][1], int(RefK), radius, height, velField);
-                }
+                SimplexSearch search;
+                search.height = height;
+                search.radius = radius;
+                search.startX = RefI;
+                search.startY = RefJ;
+                _searches.push_back(search);
+            }
+        } //ring loop end
+    } //height loop end
 
-                // Run the simplex search loop
-                float VTsolution = .0, Xsolution = 0. , Ysolution=0.;
-                _getVertexSum(vertex, vertexSum);
-                _centerIterate(vertex, vertexSum, VT, maxIterations, convergeCriterion, RefK, radius,
-			       height, velField, VTsolution, Xsolution, Ysolution);
-
-                // Done with simplex loop, should have values for the current point
-                if ((VTsolution < 100.) and (VTsolution > 0.)) {
-                    // Add to sum
-                    meanXall  += Xsolution;
-                    meanYall  += Ysolution;
-                    meanVTall += VTsolution;
-                    meanCount++;
-                    // Add to array for storage
-                    endX[point]  = Xsolution;
-                    endY[point]  = Ysolution;
-                    VTind[point] = VTsolution;
-                } else {
-                    endX[point]  = Center::_fillv;
-                    endY[point]  = Center::_fillv;
-                    VTind[point] = Center::_fillv;
-                }
-            } //point loop end
+    //STEP 3: perform simplex algorithm
 
-	    // std::cout << "Mean count before: " << meanCount << std::endl;
+    // Every search writes only to its own slot, so the results do not
+    // depend on which worker ran it
+    int numSearches = (int)_searches.size();
+    int numThreads = _getNumThreads();
+    QList<SimplexWorkspace*> workspaces;
+    for (int t = 0; t < parallelWorkers(numSearches, numThreads); t++)
+        workspaces.append(new SimplexWorkspace(_geometry, _closure, _maxWave, _dataGaps));
+    runParallel(numSearches, numThreads, [&](int worker, int n) {
+        _runSearch(*workspaces[worker], _searches[n]);
+    });
+    qDeleteAll(workspaces);
+
+    //STEP 4: combine the initial guesses of each level and ring, in order
+
+    for (int r = 0; r < ringHeight.size(); r++) {
+        float height = ringHeight[r];
+        float radius = ringRadius[r];
+        if (ringFirstSearch[r] < 0) {
+            archiveNull(simplexData, radius, height, numPoints);
+            continue;
+        }
 
-            if (meanCount == 0) {
-                archiveNull(simplexData, radius, height, numPoints);
+        // Initialize mean values
+
+        int meanCount = 0;
+        meanXall = meanYall = meanVTall = 0;
+        meanX = meanY = meanVT = 0;
+        stdDevVertexAll = stdDevVTAll = 0;
+        stdDevVertex = stdDevVT = 0;
+        convergingCenters = 0;
+
+        for (int point = 0; point < numPoints; point++) {
+            const SimplexSearch& search = _searches[ringFirstSearch[r] + point];
+            if (search.coefficientError)
+                emit log(Message("Error retrieving VTC0 in simplex!"));
+            if (search.maxIterationsExceeded)
+                emit log(Message(QString("Maximum iterations exceeded in Simplex"),0,this->objectName()));
+
+            startX[point] = search.startX;
+            startY[point] = search.startY;
+            float VTsolution = search.VT;
+            float Xsolution = search.endX;
+            float Ysolution = search.endY;
+
+            // Done with simplex loop, should have values for the current point
+            if ((VTsolution < 100.) and (VTsolution > 0.)) {
+                // Add to sum
+                meanXall  += Xsolution;
+                meanYall  += Ysolution;
+                meanVTall += VTsolution;
+                meanCount++;
+                // Add to array for storage
+                endX[point]  = Xsolution;
+                endY[point]  = Ysolution;
+                VTind[point] = VTsolution;
             } else {
-                meanXall = meanXall / float(meanCount);
-                meanYall = meanYall / float(meanCount);
-                meanVTall = meanVTall / float(meanCount);
-                for (int i = 0; i < numPoints; i++) {
-                    if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
-                        stdDevVertexAll += ((endX[i] - meanXall)
+                endX[point]  = Center::_fillv;
+                endY[point]  = Center::_fillv;
+                VTind[point] = Center::_fillv;
+            }
+        } //point loop end
+
+        if (meanCount == 0) {
+            archiveNull(simplexData, radius, height, numPoints);
+        } else {
+            meanXall = meanXall / float(meanCount);
+            meanYall = meanYall / float(meanCount);
+            meanVTall = meanVTall / float(meanCount);
+            for (int i = 0; i < numPoints; i++) {
+                if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
+                    stdDevVertexAll += ((endX[i] - meanXall)
 					    * (endX[i] - meanXall) + (endY[i] - meanYall)
 					    * (endY[i] - meanYall));
-                        stdDevVTAll += (VTind[i] - meanVTall) * (VTind[i] - meanVTall);
-                    }
+                    stdDevVTAll += (VTind[i] - meanVTall) * (VTind[i] - meanVTall);
                 }
-                stdDevVertexAll = sqrt(stdDevVertexAll/float(meanCount - 1));
-                stdDevVTAll = sqrt(stdDevVTAll/float(meanCount - 1));
-
-                // Now remove centers beyond 1 standard deviation
-                meanCount = 0;
-                for (int i = 0; i < numPoints; i++) {
-                    if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
-                        float vertexDist = sqrt((endX[i] - meanXall) * (endX[i] - meanXall)
+            }
+            stdDevVertexAll = sqrt(stdDevVertexAll/float(meanCount - 1));
+            stdDevVTAll = sqrt(stdDevVTAll/float(meanCount - 1));
+
+            // Now remove centers beyond 1 standard deviation
+            meanCount = 0;
+            for (int i = 0; i < numPoints; i++) {
+                if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
+                    float vertexDist = sqrt((endX[i] - meanXall) * (endX[i] - meanXall)
 						+ (endY[i] - meanYall) * (endY[i] - meanYall));
-                        if (vertexDist < stdDevVertexAll) {
-                            Xconv[meanCount] = endX[i];
-                            Yconv[meanCount] = endY[i];
-                            VTconv[meanCount] = VTind[i];
-                            meanX += endX[i];
-                            meanY += endY[i];
-                            meanVT+= VTind[i];
-                            meanCount++;
-                        }
+                    if (vertexDist < stdDevVertexAll) {
+                        Xconv[meanCount] = endX[i];
+                        Yconv[meanCount] = endY[i];
+                        VTconv[meanCount] = VTind[i];
+                        meanX += endX[i];
+                        meanY += endY[i];
+                        meanVT+= VTind[i];
+                        meanCount++;
                     }
                 }
-		// std::cout << "Mean count after: " << meanCount << std::endl;
-
-                if (meanCount == 0) {
-                    archiveNull(simplexData, radius, height, numPoints);
-                } else {
-                    meanX = meanX / float(meanCount);
-                    meanY = meanY / float(meanCount);
-                    meanVT = meanVT / float(meanCount);
-                    convergingCenters = meanCount;
-                    for (int i = 0; i < convergingCenters - 1; i++) {
-                        stdDevVertex += ((Xconv[i] - meanX) * (Xconv[i] - meanX)+ (Yconv[i] - meanY) * (Yconv[i] - meanY));
-                        stdDevVT += (VTconv[i] - meanVT) * (VTconv[i] - meanVT);
-                    }
-                    stdDevVertex = sqrt(stdDevVertex / float(meanCount - 1));
-                    stdDevVT = sqrt(stdDevVT / float(meanCount - 1));
-
-                    // All done with this radius and height, archive it
-                    archiveCenters(simplexData, radius, height, numPoints);
+            }
+            if (meanCount == 0) {
+                archiveNull(simplexData, radius, height, numPoints);
+            } else {
+                meanX = meanX / float(meanCount);
+                meanY = meanY / float(meanCount);
+                meanVT = meanVT / float(meanCount);
+                convergingCenters = meanCount;
+                for (int i = 0; i < convergingCenters - 1; i++) {
+                    stdDevVertex += ((Xconv[i] - meanX) * (Xconv[i] - meanX)+ (Yconv[i] - meanY) * (Yconv[i] - meanY));
+                    stdDevVT += (VTconv[i] - meanVT) * (VTconv[i] - meanVT);
                 }
+                stdDevVertex = sqrt(stdDevVertex / float(meanCount - 1));
+                stdDevVT = sqrt(stdDevVT / float(meanCount - 1));
+
+                // All done with this radius and height, archive it
+                archiveCenters(simplexData, radius, height, numPoints);
             }
-        } //ring loop end
-    } //height loop end
+        }
+    } //ring loop end
 
     simplexList->append(*simplexData);
     delete simplexData;
-    // Deallocate memory for the vertices
-    delete[] vertex[0];
-    delete[] vertex[1];
-    delete[] vertex[2];
-    delete[] vertex;
-    delete[] VT;
-    delete[] vertexSum;
 
     return true;
 }
@@ -351,42 +366,101 @@ inline void SimplexThread::_getVertexSum(float** vertex,float* vertexSum)
     }
 }
 
-float SimplexThread::_simplexTest(float**& vertex,float*& VT,float*& vertexSum,
-                                 float& radius, float& height, float& RefK,
-                                 QString& velField, int& low, double factor)
+int SimplexThread::_getNumThreads()
+{
+    // Optional: missing or 0 uses every core, 1 runs the searches serially
+    int numThreads = centerConfig.threads;
+    if (numThreads <= 0)
+        numThreads = QThread::idealThreadCount();
+    if (numThreads < 1)
+        numThreads = 1;
+    return numThreads;
+}
+
+void SimplexThread::_runSearch(SimplexWorkspace& workspace, SimplexSearch& search)
+{
+    // Runs on a worker thread. Only reads the grid and the search parameters
+    // and only writes to the workspace and this search.
+
+    float radius = search.radius;
+    float height = search.height;
+    float RefI = search.startX;
+    float RefJ = search.startY;
+    search.maxIterationsExceeded = false;
+    search.coefficientError = false;
+
+    float vertexStore[3][2];
+    float* vertex[3] = { vertexStore[0], vertexStore[1], vertexStore[2] };
+    float VT[3];
+    float vertexSum[2];
+
+    // Initialize vertices
+    float sqr32 = 0.866025;
+    vertex[0][0] = RefI;
+    vertex[0][1] = RefJ + _radiusOfInfluence;
+    vertex[1][0] = RefI + sqr32 * _radiusOfInfluence;
+    vertex[1][1] = RefJ - 0.5 * _radiusOfInfluence;
+    vertex[2][0] = RefI - sqr32 * _radiusOfInfluence;
+    vertex[2][1] = RefJ - 0.5 * _radiusOfInfluence;
+    vertexSum[0] = 0;
+    vertexSum[1] = 0;
+
+    for (int v = 0; v <= 2; v++) {
+        //Calculate mean wind at each vertex
+        VT[v] = _getSymWind(workspace, vertex[v][0], vertex[v][1], radius, height);
+    }
+
+    // Run the simplex search loop
+    float VTsolution = .0, Xsolution = 0. , Ysolution=0.;
+    _getVertexSum(vertex, vertexSum);
+    _centerIterate(workspace, search, vertex, vertexSum, VT, radius, height,
+                   VTsolution, Xsolution, Ysolution);
+
+    search.endX = Xsolution;
+    search.endY = Ysolution;
+    search.VT = VTsolution;
+}
+
+float SimplexThread::_simplexTest(SimplexWorkspace& workspace, SimplexSearch& search,
+                                  float**& vertex,float*& VT,float*& vertexSum,
+                                  float& radius, float& height, int& low, double factor)
 {
     // Test a simplex vertex
     float VTtest = -999;
-    float* vertexTest = new float[2];
+    float vertexTest[2];
     float factor1 = (1.0 - factor)/2;
     float factor2 = factor1 - factor;
     for (int i=0; i<=1; i++)
         vertexTest[i] = vertexSum[i]*factor1 - vertex[low][i]*factor2;
 
     // Get the data
-    gridData->setCartesianReferencePoint(int(vertexTest[0]),int(vertexTest[1]),int(RefK));
-    int numData = gridData->getCylindricalAzimuthLength(radius, height);
-    float* ringData = new float[numData];
-    float* ringAzimuths = new float[numData];
-    gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
-    gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
+    const RingIndex& ring = gridData->getCylindricalRing(int(vertexTest[0]), int(vertexTest[1]),
+                                                         radius, height, workspace.rings);
+    int numData = ring.size();
+    if ((int)workspace.ringData.size() < numData + 1) {
+        workspace.ringData.resize(numData + 1);
+        workspace.ringAzimuths.resize(numData + 1);
+    }
+    float* ringData = &workspace.ringData[0];
+    float* ringAzimuths = &workspace.ringAzimuths[0];
+    gridData->getCylindricalRingData(ring, _velField, ringData);
+    gridData->getCylindricalRingPositions(ring, ringAzimuths);
 
     // Call vtd
-    if (_simplexVTD->analyzeRing(vertexTest[0], vertexTest[1], radius, height, numData,
-				 ringData,ringAzimuths, _vtdCoeffs, vtdStdDev)) {
-        if (_vtdCoeffs[0].getParameter() == "VTC0") {
-            VTtest = _vtdCoeffs[0].getValue();
+    float vtdStdDev;
+    if (workspace.vtd->analyzeRing(vertexTest[0], vertexTest[1], radius, height, numData,
+                                   ringData,ringAzimuths, workspace.vtdCoeffs, vtdStdDev)) {
+        if (workspace.vtdCoeffs[0].getTerm() == Coefficient::VTC0) {
+            VTtest = workspace.vtdCoeffs[0].getValue();
         } else {
-            emit log(Message("Error retrieving VTC0 in simplex!"));
+            // Logged by findCenter once the search is done
+            search.coefficientError = true;
         }
     } else {
         VTtest = -999;
         // emit log(Message("Not enough data in simplex ring"));
     }
 
-    delete[] ringData;
-    delete[] ringAzimuths;
-
     // If its a better point than the worst, replace it
     if (VTtest > VT[low]) {
         VT[low] = VTtest;
@@ -395,21 +469,26 @@ float SimplexThread::_simplexTest(float**& vertex,float*& VT,float*& vertexSum,
             vertex[low][i] = vertexTest[i];
         }
     }
-    delete[] vertexTest;
     return VTtest;
 
 }
 
-float SimplexThread::_getSymWind(float vertex_x,float vertex_y,int RefK,float radius,float height,QString velField)
+float SimplexThread::_getSymWind(SimplexWorkspace& workspace, float vertex_x,float vertex_y,
+                                 float radius,float height)
 {
     float VT=-999.0f;
-    gridData->setCartesianReferencePoint(int(vertex_x),int(vertex_y),RefK);
-    int numData = gridData->getCylindricalAzimuthLength(radius, height);    // TODO
-    float* ringData = new float[numData];
-    float* ringAzimuths = new float[numData];
-    gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
+    const RingIndex& ring = gridData->getCylindricalRing(int(vertex_x), int(vertex_y),
+                                                         radius, height, workspace.rings);
+    int numData = ring.size();
+    if ((int)workspace.ringData.size() < numData + 1) {
+        workspace.ringData.resize(numData + 1);
+        workspace.ringAzimuths.resize(numData + 1);
+    }
+    float* ringData = &workspace.ringData[0];
+    float* ringAzimuths = &workspace.ringAzimuths[0];
+    gridData->getCylindricalRingData(ring, _velField, ringData);
     // azimuth data should look like sine wave
-    gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
+    gridData->getCylindricalRingPositions(ring, ringAzimuths);
 #if 0
     // TODO debug
     for(int d = 0; d < numData; d++) {
@@ -417,33 +496,33 @@ float SimplexThread::_getSymWind(float vertex_x,float vertex_y,int RefK,float ra
 		<< " azimuth: " << ringAzimuths[d] << std::endl;
     }
 #endif
-    Coefficient*  vtdCoeffs=new Coefficient[20];
     float   vtdStdDev;
 
     // vtCoeff[0..numCoeffs].value will be set by this call
 
-    if (_simplexVTD->analyzeRing(vertex_x, vertex_y, radius, height, numData, ringData, ringAzimuths, vtdCoeffs, vtdStdDev)) {
-        if (vtdCoeffs[0].getParameter() == "VTC0")
-            VT = vtdCoeffs[0].getValue();
+    if (workspace.vtd->analyzeRing(vertex_x, vertex_y, radius, height, numData, ringData, ringAzimuths,
+                                   workspace.vtdCoeffs, vtdStdDev)) {
+        if (workspace.vtdCoeffs[0].getTerm() == Coefficient::VTC0)
+            VT = workspace.vtdCoeffs[0].getValue();
     }
 
-    delete[] ringData;
-    delete[] ringAzimuths;
-    delete[] vtdCoeffs;
     return VT;
 }
 
-void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT, int maxIterations, float convergeCriterion,
-                                   float RefK, float radius, float height, QString velField,
+void SimplexThread::_centerIterate(SimplexWorkspace& workspace, SimplexSearch& search,
+                                   float** vertex, float* vertexSum, float* VT,
+                                   float radius, float height,
                                    float& VTsolution, float& Xsolution, float& Ysolution)
 {
     VTsolution = Xsolution = Ysolution = 0.0f;
 
     int numIterations = 0;
+    int passes = 0;
     int low = 0;
     int mid = 0;
     int high = 0;
     for(;;) {
+        passes++;
         low = 0;
         // Sort the initial guesses
         high = VT[0] > VT[1] ? (mid = 1,0) : (mid = 0,1);
@@ -457,7 +536,7 @@ void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT,
 
         // Check convergence
         float epsilon = 2.0 * fabs(VT[high]-VT[low])/(fabs(VT[high]) + fabs(VT[low]) + 1.0e-10);
-        if (epsilon < convergeCriterion) {
+        if (epsilon < _convergeCriterion) {
             VTsolution = VT[high];
             Xsolution = vertex[high][0];
             Ysolution = vertex[high][1];
@@ -465,27 +544,28 @@ void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT,
         }
 
         // Check iterations
-        if (numIterations > maxIterations) {
-            emit log(Message(QString("Maximum iterations exceeded in Simplex"),0,this->objectName()));
+        if (numIterations > _maxIterations) {
+            // Logged by findCenter once the search is done
+            search.maxIterationsExceeded = true;
             break;
         }
 
         numIterations += 2;
         // Reflection
-        float VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, -1.0);
+        float VTtest = _simplexTest(workspace, search, vertex, VT, vertexSum, radius, height, low, -1.0);
         if (VTtest >= VT[high])
             // Better point than highest, so try expansion
-            VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, 2.0);
+            VTtest = _simplexTest(workspace, search, vertex, VT, vertexSum, radius, height, low, 2.0);
         else if (VTtest <= VT[mid]) {
             // Worse point than second highest, so try contraction
             float VTsave = VT[low];
-            VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, 0.5);
+            VTtest = _simplexTest(workspace, search, vertex, VT, vertexSum, radius, height, low, 0.5);
             if (VTtest <= VTsave) {
                 for (int v=0; v<=2; v++) {
                     if (v != high) {
                         for (int i=0; i<=1; i++)
                             vertex[v][i] = vertexSum[i] = 0.5*(vertex[v][i] + vertex[high][i]);
-                        VT[v]=_getSymWind(vertex[v][0],vertex[v][1],int(RefK),radius,height,velField);
+                        VT[v]=_getSymWind(workspace, vertex[v][0],vertex[v][1],radius,height);
                     }
                 }
                 numIterations += 2;
@@ -495,4 +575,5 @@ void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT,
         else
             --numIterations;
     }
+    VolumeProfile::count(VolumeProfile::SimplexIterations, passes);
 }
@@ -14,9 +14,10 @@
 #include <QSize>
 #include <QList>
 #include <QObject>
+#include <vector>
 
 #include "IO/Message.h"
-#include "Config/Configuration.h"
+#include "Config/ConfigSnapshot.h"
 #include "DataObjects/GriddedData.h"
 #include "VTD/GBVTD.h"
 #include "DataObjects/Coefficient.h"
@@ -25,14 +26,34 @@
 #include "DataObjects/VortexData.h"
 
 
+// Scratch space for one Nelder-Mead search. A VTD keeps its work arrays as
+// members, so every thread running searches needs its own, as well as its
+// own ring cache for the shared grid.
+
+class SimplexWorkspace
+{
+
+ public:
+  SimplexWorkspace(QString& geometry, QString& closure, int& maxWave, float*& dataGaps);
+  ~SimplexWorkspace();
+
+  VTD* vtd;
+  Coefficient* vtdCoeffs;
+  RingCache rings;
+  std::vector<float> ringData;
+  std::vector<float> ringAzimuths;
+
+};
+
 class SimplexThread:public QObject
 {
     Q_OBJECT
-    
+
+
 public:
     SimplexThread(QObject* parent=0);
     ~SimplexThread();
-    void initParam(Configuration *wholeConfig, GriddedData *dataPtr,float latGuess, float lonGuess);
+    void initParam(const ConfigSnapshot& settings, GriddedData *dataPtr,float latGuess, float lonGuess);
     bool findCenter(SimplexList* simplexList);
 
 public slots:
@@ -42,20 +63,33 @@ signals:
     void log(const Message& message);
 
 private:
+    // One search: a single initial guess on one ring of one level
+    class SimplexSearch {
+    public:
+        float height, radius;
+        float startX, startY;
+        float endX, endY, VT;
+        bool maxIterationsExceeded;
+        bool coefficientError;
+    };
+
     GriddedData   *gridData;
-    Configuration *configData;
+    CenterSettings centerConfig;
     float _latGuess;
     float _lonGuess;
     float* _dataGaps;
-    VTD* _simplexVTD;
-    Coefficient* _vtdCoeffs;
-    float* VT;
-    float* vertexSum;
+    QString _geometry;
+    QString _closure;
+    int   _maxWave;
+    int   _velField;
+    float _radiusOfInfluence;
+    float _convergeCriterion;
+    int   _maxIterations;
+    std::vector<SimplexSearch> _searches;
     float firstLevel;
     float lastLevel;
     float firstRing;
     float lastRing;
-    float vtdStdDev;
     float meanXall, meanYall, meanVTall;
     float meanX, meanY, meanVT;
     float stdDevVertexAll, stdDevVTAll;
@@ -65,19 +99,22 @@ private:
     float Xconv[25],Yconv[25],VTconv[25];
     float startX[25], startY[25];
 
+    int  _getNumThreads();
+    void _runSearch(SimplexWorkspace& workspace, SimplexSearch& search);
 
     void archiveCenters(SimplexData* simplexData,float radius,float height,float numPoints);
     void archiveNull(SimplexData* simplexData,float& radius,float& height,float& numPoints);
     inline void _getVertexSum(float** vertex,float* vertexSum);
-    float _simplexTest(float**& vertex, float*& VT, float*& vertexSum,
-                      float& radius, float& height, float& RefK,
-                      QString& velField, int& high,double factor);
+    float _simplexTest(SimplexWorkspace& workspace, SimplexSearch& search,
+                       float**& vertex, float*& VT, float*& vertexSum,
+                       float& radius, float& height, int& high,double factor);
 
     // Choosecenter variables
     float velNull;
-    float _getSymWind(float vertex_x,float vertex_y,int RefK,float radius,float height,QString velField);
-    void  _centerIterate(float** vertex,float* vertexSum, float* VT,int maxIterations,float convergeCriterion,
-                          float RefK,float radius,float height,QString velField,float& VTsolution,float& Xsolution,float& Ysolution);
+    float _getSymWind(SimplexWorkspace& workspace, float vertex_x,float vertex_y,float radius,float height);
+    void  _centerIterate(SimplexWorkspace& workspace, SimplexSearch& search,
+                         float** vertex,float* vertexSum, float* VT,
+                         float radius,float height,float& VTsolution,float& Xsolution,float& Ysolution);
 };
 
 #endif
@@ -53,7 +53,7 @@ VortexThread::~VortexThread()
     delete [] dataGaps;
 }
 
-void VortexThread::getWinds(Configuration *wholeConfig, GriddedData *dataPtr, RadarData *radarPtr,
+void VortexThread::getWinds(const ConfigSnapshot& settings, GriddedData *dataPtr, RadarData *radarPtr,
 			    VortexData* vortexPtr, PressureList *pressurePtr)
 {
     pressureList = pressurePtr;
@@ -64,7 +64,7 @@ void VortexThread::getWinds(Configuration *wholeConfig, GriddedData *dataPtr, Ra
     // Set the vortex data object
     vortexData = vortexPtr;
     // Set the configuration info
-    configData = wholeConfig;
+    configData = &settings;
 
     run();
 }
@@ -153,21 +153,15 @@ void VortexThread::run()
         // compute crossbeam wind to correct GBVTD result
 
         int gradientIndex = heightToIndex(gradientHeight);
-        QDomElement radar = configData->getConfig("radar");
-        float radarLat = configData->getParam(radar,"lat").toFloat();
-        float radarLon = configData->getParam(radar,"lon").toFloat();
+        float radarLat = configData->radar.lat;
+        float radarLon = configData->radar.lon;
         float vortexLat = vortexData->getLat(gradientIndex);
         float vortexLon = vortexData->getLon(gradientIndex);
 
         float* distance = gridData->getCartesianPoint(&radarLat, &radarLon, &vortexLat, &vortexLon);
         float rt = sqrt(distance[0]*distance[0]+distance[1]*distance[1]);
-        float cca = atan2(distance[0], distance[1])*180/acos(-1);
         delete [] distance;
 
-        Hvvp *hvvp = new Hvvp;
-        hvvp->setConfig(configData);
-        hvvp->setRadarData(radarVolume, rt, cca, vortexData->getAveRMW());
-
 	float Vm = 0.0;
 
         // should we be incrementing radius using ringwidth? -LM
@@ -186,7 +180,7 @@ void VortexThread::run()
             // Call gbvtd
             if (vtd->analyzeRing(xCenter, yCenter, radius, height, numData, ringData,
                                  ringAzimuths, vtdCoeffs, vtdStdDev)) {
-                if (vtdCoeffs[0].getParameter() == "VTC0") {
+                if (vtdCoeffs[0].getTerm() == Coefficient::VTC0) {
                     // VT[v] = vtdCoeffs[0].getValue();
                     if(vtdCoeffs[0].getValue() != -999.f){
                         vtdCoeffs[0].setValue( vtdCoeffs[0].getValue()-Vm*radius/rt );
@@ -245,7 +239,7 @@ void VortexThread::archiveWinds(float radius, int hIndex, int maxCoeffs, Coeffic
     int ring = int(radius - firstRing);
 
     for (int coeff = 0; coeff < maxCoeffs; coeff++) {
-        vortexData->setCoefficient(level, ring, coeff, vtdCoeffs[coeff]);
+        vortexData->setCoefficient(level, ring, vtdCoeffs[coeff]);
         Coefficient current = vtdCoeffs[coeff];
 
 	// DEBUG
@@ -268,7 +262,7 @@ void VortexThread::archiveWinds(VortexData& data, float& radius, int& hIndex, in
     int ring = int(radius - firstRing);
 
     for (int coeff = 0; coeff < maxCoeffs; coeff++) {
-        data.setCoefficient(level, ring, coeff, vtdCoeffs[coeff]);
+        data.setCoefficient(level, ring, vtdCoeffs[coeff]);
     }
 }
 
@@ -292,9 +286,8 @@ void VortexThread::getPressureDeficit(VortexData* data, float* pDeficit,const fl
     float f = 2 * 7.29e-5 * sin(data->getLat(heightIndex) * 3.141592653589793238462643 / 180.);
 
     for (float radius = firstRing; radius <= lastRing; radius++) {
-      // if (!(data->getCoefficient(height, radius, QString("VTC0")) == Coefficient())) {
-      if ( (data->getCoefficient(height, radius, QString("VTC0"))).isValid()) {
-            float meanVT = data->getCoefficient(height, radius, QString("VTC0")).getValue();
+      float meanVT = data->getCoefficientValue(height, radius, Coefficient::VTC0);
+      if (meanVT != -999) {
             if (meanVT != 0) {
                 dpdr[(int)radius] = ((f * meanVT) + (meanVT * meanVT)/(radius * deltar)) * rhoBar[ (int) height - 1];
             }
@@ -339,32 +332,37 @@ void VortexThread::calcCentralPressure(VortexData* vortex, float* pD, float heig
     float pressWeightSum = 0;
     float pressSum = 0;
     numEstimates = 0;
-    float* pressEstimates = new float[pressureList->size()];
-    float* weightEstimates = new float[pressureList->size()];
 
-    // Iterate through the pressure data
+    // Only the observations near the vortex in space and time
+    float vortexLat = vortex->getLat(heightIndex);
+    float vortexLon = vortex->getLon(heightIndex);
+    QDateTime vortexTime = vortex->getTime();
+    QList<int> nearby = pressureList->findObservations(vortexLat, vortexLon, maxObRadius,
+                                                       vortexTime.addSecs(-(qint64)maxObTimeDiff - 1),
+                                                       vortexTime);
+    // One more for the environmental pressure
+    float* pressEstimates = new float[nearby.size() + 1];
+    float* weightEstimates = new float[nearby.size() + 1];
+
     //Message::toScreen("Size of searching List = "+QString().setNum(pressureList->size())+" within time "+QString().setNum(maxObTimeDiff)+" of vortex time "+vortex->getTime().toString(Qt::ISODate));
-    for (int i = 0; i < pressureList->size(); i++) {
-        float obPressure = pressureList->at(i).getPressure();
+    for (int n = 0; n < nearby.size(); n++) {
+        const PressureData& observation = pressureList->at(nearby.at(n));
+        float obPressure = observation.getPressure();
 
         if (obPressure > 0) {
             // Check the time
-            QString obTime = pressureList->at(i).getTime().toString(Qt::ISODate);
-            QString vortexTime = vortex->getTime().toString(Qt::ISODate);
-            int obTimeDiff = pressureList->at(i).getTime().secsTo(vortex->getTime());
+            int obTimeDiff = observation.getTime().secsTo(vortexTime);
             if ((obTimeDiff > 0) and (obTimeDiff <= maxObTimeDiff)) {
                 // Check the distance
-                float vortexLat = vortex->getLat(heightIndex);
-                float vortexLon = vortex->getLon(heightIndex);
-                float obLat = pressureList->at(i).getLat();
-                float obLon = pressureList->at(i).getLon();
+                float obLat = observation.getLat();
+                float obLon = observation.getLon();
                 float* relDist = gridData->getCartesianPoint(&vortexLat, &vortexLon,&obLat, &obLon);
                 float obRadius = sqrt(relDist[0]*relDist[0] + relDist[1]*relDist[1]);
                 delete [] relDist;
                 if ((obRadius >= 20) and (obRadius <= maxObRadius)) {
                 //if ((obRadius >= vortex->getRMW(heightIndex)) and (obRadius <= maxObRadius)) {
                     // Good ob anchor!
-                    _presObs.append(pressureList->at(i));
+                    _presObs.append(observation);
                     float pPrimeOuter;
                     if (obRadius >= lastRing) {
                         pPrimeOuter = pD[(int)lastRing];
@@ -500,7 +498,7 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
 
             // Call gbvtd
             if (vtd->analyzeRing(xCenter, yCenter, radius, height, numData, ringData, ringAzimuths, vtdCoeffs, vtdStdDev)) {
-                if (vtdCoeffs[0].getParameter() != "VTC0") {
+                if (vtdCoeffs[0].getTerm() != Coefficient::VTC0) {
                     emit log(Message(QString("CalcPressureUncertainty:Error retrieving VTC0 in vortex!"), 0, this->objectName()));
                 }
 
@@ -604,39 +602,40 @@ float VortexThread::indexToHeight(const int index)
 
 void VortexThread::readInConfig()
 {
-    QDomElement vtdConfig = configData->getConfig("vtd");
-    QDomElement pressureConfig = configData->getConfig("pressure");
+    const VtdSettings& vtdConfig = configData->vtd;
+    const PressureSettings& pressureConfig = configData->pressure;
 
-    vortexPath = configData->getParam(vtdConfig,QString("dir"));
-    geometry = configData->getParam(vtdConfig,QString("geometry"));
-    refField =  configData->getParam(vtdConfig,QString("reflectivity"));
-    velField = configData->getParam(vtdConfig,QString("velocity"));
-    closure = configData->getParam(vtdConfig,QString("closure"));
+    vortexPath = vtdConfig.dir;
+    geometry = vtdConfig.geometry;
+    refField =  vtdConfig.reflectivity;
+    velField = vtdConfig.velocity;
+    closure = vtdConfig.closure;
 
-    firstLevel = configData->getParam(vtdConfig,QString("bottomlevel")).toFloat();
-    lastLevel  = configData->getParam(vtdConfig,QString("toplevel")).toFloat();
+    firstLevel = vtdConfig.bottomLevel;
+    lastLevel  = vtdConfig.topLevel;
 
-    firstRing = configData->getParam(vtdConfig,QString("innerradius")).toFloat();
-    lastRing  = configData->getParam(vtdConfig,QString("outerradius")).toFloat();
+    firstRing = vtdConfig.innerRadius;
+    lastRing  = vtdConfig.outerRadius;
 
-    ringWidth = configData->getParam(vtdConfig,QString("ringwidth")).toFloat();
-    maxWave = configData->getParam(vtdConfig,QString("maxwavenumber")).toInt();
+    ringWidth = vtdConfig.ringWidth;
+    maxWave = vtdConfig.maxWaveNumber;
 
     // Define the maximum allowable data gaps
+    delete [] dataGaps;
     dataGaps = new float[maxWave+1];
     for (int i = 0; i <= maxWave; i++) {
-        dataGaps[i] = configData->getParam(vtdConfig, QString("maxdatagap"), QString("wavenum"),QString().setNum(i)).toFloat();
+        dataGaps[i] = vtdConfig.maxDataGap.value(i);
     }
 
     // Set GriddedData to use ringwidth for spacing
     gridData->setCylindricalAzimuthSpacing(ringWidth);
 
     maxObRadius = 0;
-    maxObTimeDiff = 60 * configData->getParam(pressureConfig, "maxobstime").toFloat();
-    if(configData->getParam(pressureConfig, "maxobsmethod") == "center")
-        maxObRadius = configData->getParam(pressureConfig, "maxobdist").toFloat();
-    if(configData->getParam(pressureConfig, "maxobsmethod") == "ring")
-        maxObRadius = lastRing+configData->getParam(pressureConfig, "maxobsdist").toFloat();
+    maxObTimeDiff = 60 * pressureConfig.maxObsTime;
+    if(pressureConfig.maxObsMethod == "center")
+        maxObRadius = pressureConfig.maxObsDist;
+    if(pressureConfig.maxObsMethod == "ring")
+        maxObRadius = lastRing + pressureConfig.maxObsDist;
 
     if(maxObRadius == -999){
         maxObRadius = lastRing + 50;
@@ -646,9 +645,8 @@ void VortexThread::readInConfig()
     }
     // gradientHeight = firstLevel;
     gradientHeight = 2; // Default. There is a "presumably 2km" in a comment in the run() method
-    QString gradientConfig = configData->getParam(pressureConfig, "gradient_height");
-    if(gradientConfig != "")
-      gradientHeight = gradientConfig.toFloat();
+    if(pressureConfig.gradientHeight != -999)
+      gradientHeight = pressureConfig.gradientHeight;
     if(gradientHeight < firstLevel) {
       gradientHeight = firstLevel;
       std::cout << "Warning: VortexThread gradientHeight adjusted to " << firstLevel << std::endl;
@@ -670,9 +668,8 @@ bool VortexThread::calcHVVP(bool printOutput)
    */
 
     int gradientIndex = heightToIndex(gradientHeight);
-    QDomElement radar = configData->getConfig("radar");
-    float radarLat = configData->getParam(radar,"lat").toFloat();
-    float radarLon = configData->getParam(radar,"lon").toFloat();
+    float radarLat = configData->radar.lat;
+    float radarLon = configData->radar.lon;
     float vortexLat = vortexData->getLat(gradientIndex);
     float vortexLon = vortexData->getLon(gradientIndex);
 
@@ -692,7 +689,7 @@ bool VortexThread::calcHVVP(bool printOutput)
     }
 
     Hvvp *envWindFinder = new Hvvp;
-    envWindFinder->setConfig(configData);
+    envWindFinder->setConfig(*configData);
     envWindFinder->setPrintOutput(printOutput);
     connect(envWindFinder, SIGNAL(log(const Message)),this, SLOT(catchLog(const Message)));
     envWindFinder->setRadarData(radarVolume,rt, cca, vortexData->getAveRMW());
@@ -759,14 +756,13 @@ void VortexThread::getMaxSfcWind(VortexData* data)
 	    // float centerDistance = sqrt(xCenter * xCenter + yCenter * yCenter);
 
             // Get the winds
-	    // if (!(data->getCoefficient(height, radius, QString("VTC0")) == Coefficient())) {
-	    if ( (data->getCoefficient(height, radius, QString("VTC0"))).isValid()) {
-
-	      float vtc0 = data->getCoefficient(height, radius, QString("VTC0")).getValue();
-	      float vrc0 = data->getCoefficient(height, radius, QString("VRC0")).getValue();
-	      float vmc0 = data->getCoefficient(height, radius, QString("VMC0")).getValue();
-	      float vtc1 = data->getCoefficient(height, radius, QString("VTC1")).getValue();
-	      float vts1 = data->getCoefficient(height, radius, QString("VTS1")).getValue();
+	    float vtc0 = data->getCoefficientValue(height, radius, Coefficient::VTC0);
+	    if (vtc0 != -999) {
+
+	      float vrc0 = data->getCoefficientValue(height, radius, Coefficient::VRC0);
+	      float vmc0 = data->getCoefficientValue(height, radius, Coefficient::VMC0);
+	      float vtc1 = data->getCoefficientValue(height, radius, Coefficient::VTC1);
+	      float vts1 = data->getCoefficientValue(height, radius, Coefficient::VTS1);
 	      double PI = acos(-1.0);
 
 	      for (int i = 0; i < 360; i++) {
@@ -15,7 +15,7 @@
 #include <QObject>
 
 #include "IO/Message.h"
-#include "Config/Configuration.h"
+#include "Config/ConfigSnapshot.h"
 #include "DataObjects/GriddedData.h"
 #include "VTD/VTD.h"
 #include "DataObjects/Coefficient.h"
@@ -32,7 +32,7 @@ class VortexThread : public QObject
   
   VortexThread(QObject *parent = 0);
   ~VortexThread();
-  void getWinds(Configuration *wholeConfig, GriddedData *dataPtr, RadarData *radarPtr,
+  void getWinds(const ConfigSnapshot& settings, GriddedData *dataPtr, RadarData *radarPtr,
 		VortexData *vortexPtr, PressureList *pressurePtr);
   void run();
     void setEnvPressure(const float& pressure) { envPressure = pressure; }
@@ -52,7 +52,7 @@ class VortexThread : public QObject
      RadarData *radarVolume;
      VortexData *vortexData;
      PressureList *pressureList;
-     Configuration *configData;
+     const ConfigSnapshot *configData;
      
      float* dataGaps;
      VTD* vtd;
@@ -15,6 +15,9 @@
 #include "NRL/RadarQC.h"
 #include <unistd.h>
 #include "DataObjects/SimplexList.h"
+#include "DataObjects/CappiWriter.h"
+#include "DataObjects/CappiGrid.h"
+#include "IO/VolumeProfile.h"
 
 workThread::workThread(QObject *parent)
 	: QObject(parent)
@@ -22,10 +25,12 @@ workThread::workThread(QObject *parent)
 	this->setObjectName("Master");
 	abort = false;
 	runOnce = false;
+	continuePreviousRun = false;
 
 	dataSource= NULL;
 	pressureSource= NULL;
 	configData= NULL;
+	centerFinder= NULL;
 }
 
 workThread::~workThread()
@@ -44,20 +49,34 @@ void workThread::run()
 	std::cout << "Running workThread ...\n";
 
 	//Initialize configuration
-	bool preGridded = "true" == configData->getParam(configData->getConfig("radar"),
-							 "pre_gridded");
+	// The run works from its own copy, so a parameter changed while a
+	// volume is analysed does not reach the threads half way through it
+	settings = configData->getSnapshot();
+	if(!settings.isValid()) {
+		const QStringList& problems = settings.getProblems();
+		for(int i = 0; i < problems.count(); i++)
+			emit log(Message(QString("Configuration: " + problems[i]), -1, this->objectName(),
+					 Red, QString("Bad Configuration Value")));
+		//if in batch mode, abort
+		if (this->parent()){
+			abort = true;
+			emit finished();
+		}
+		return;
+	}
 
-	bool runSimplex = "true" !=
-	  configData->getParam(configData->getConfig("center"), "skipsimplex");
+	bool preGridded = settings.radar.preGridded;
 
-	float bottomLevel = configData->getParam(configData->getConfig("center"), "bottomlevel").toFloat();
+	bool runSimplex = !settings.center.skipSimplex;
+
+	float bottomLevel = settings.center.bottomLevel;
 
 	// Load vortex centers if the config file specifies a path
-	loadCenterLocations(configData->getParam(configData->getConfig("vortex"), "centers"));
+	loadCenterLocations(settings.vortex.centers);
 
-	QString mode = configData->getParam(configData->getConfig("vortex"), "mode");
-	QDir workingDir(configData->getParam(configData->getConfig("vortex"),"dir"));
-	QString vortexName = configData->getParam(configData->getConfig("vortex"), "name");
+	QString mode = settings.vortex.mode;
+	QDir workingDir(settings.vortex.dir);
+	QString vortexName = settings.vortex.name;
 
 	if (vortexName == "Unknown") {
 		// Problem with ATCF data
@@ -65,12 +84,10 @@ void workThread::run()
 		Red,"ATCF Error");
 		emit log(newMsg);
 	}
-	QDomElement radar = configData->getConfig("radar");
-	float radarLat = configData->getParam(radar,"lat").toFloat();
-	float radarLon = configData->getParam(radar,"lon").toFloat();
-	QString radarName = configData->getParam(radar, "name");
-	QString year = QString().setNum(QDate::fromString(configData->getParam(configData->getConfig("radar"),
-									     "startdate"), "yyyy-MM-dd").year());
+	float radarLat = settings.radar.lat;
+	float radarLon = settings.radar.lon;
+	QString radarName = settings.radar.name;
+	QString year = QString().setNum(settings.radar.startDate.year());
 	QString namePrefix = vortexName + "_" + radarName + "_" + year + "_";
 
 	//initialize the saving path of data-list
@@ -78,30 +95,54 @@ void workThread::run()
 	_vortexList.setFilePath(workingDir.filePath(namePrefix+"vortexlist.xml"));
 	_pressureList.setFilePath(workingDir.filePath(namePrefix+"pressurelist.xml"));
 
-	if(continuePreviousRun){
-		_simplexList.restore();
-		_vortexList.restore();
-		_pressureList.restore();
-	}
+	// Each volume appends its records to the journals a resumed run
+	// restores from. With journal persistence the xml files are only
+	// rewritten when the journals are compacted, not for every volume.
+	bool journal = (settings.vortex.persistence == "journal");
+	_vortexList.setJournaling(journal);
+	_simplexList.setJournaling(journal);
+	_pressureList.setJournaling(journal);
 
-	// where to save coefficients.
+	bool resumed = false;
+	if(continuePreviousRun)
+		resumed = restorePreviousRun();
+
+	// where to save coefficients. A resumed run keeps adding to the old file
 	QString coeffFilePath = workingDir.filePath(namePrefix + "coefficientlist.csv");
-	std::ofstream outfile(coeffFilePath.toLatin1().data());
-	// Put a comment with column headers
-	outfile << "# level, radius, param, value" << std::endl;
-	outfile.close();
+	if(!resumed || !QFile::exists(coeffFilePath)) {
+		std::ofstream outfile(coeffFilePath.toLatin1().data());
+		// Put a comment with column headers
+		outfile << "# level, radius, param, value" << std::endl;
+		outfile.close();
+	}
 
 	//create data monitor object
 	dataSource = new RadarFactory(configData);
 	connect(dataSource, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
-	PressureFactory *pressureSource = new PressureFactory(configData);
-	connect(pressureSource, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
+	pressureSource = new PressureFactory(configData);
+	// In real time the pressure files are read on their own thread, and
+	// this thread's event loop is busy until the run ends. A batch run
+	// reads them with each volume instead, so it gives the same answer
+	// every time.
+	bool batch = (this->parent() != NULL);
+	connect(pressureSource, SIGNAL(log(const Message&)),this, SIGNAL(log(const Message&)),
+		Qt::DirectConnection);
+	if(!batch)
+		pressureSource->start();
 
 	// Flag to just construct the cappi.
 	// Useful if all you want to do is look at the radar data on the display
 
-	bool just_display = "true" == configData->getParam(configData->getConfig("cappi"),
-							 "just_display");
+	bool just_display = settings.cappi.justDisplay;
+
+	// Format the CAPPIs are saved in, NULL if they are not saved
+	CappiWriter *cappiWriter = CappiWriterFactory::newWriter(settings.cappi);
+	// Per volume timing and counters, NULL unless the config asks for them
+	VolumeProfile *profile = VolumeProfile::newProfile(settings.vortex,
+							   workingDir.filePath(namePrefix));
+	if(profile != NULL)
+		emit log(Message(QString("Writing the volume profile to " + profile->getFilePath()),
+				 0, this->objectName()));
 	// Begin working loop
 
 	while(!abort) {
@@ -118,15 +159,35 @@ void workThread::run()
 			}
 
 			emit log(Message("Found file:" + newVolume->getFileName(), -1, this->objectName()));
+			if(profile != NULL)
+				profile->beginVolume(newVolume->getFileName());
 
 			// Check to makes sure that the file still exists and is readable
-			if((!newVolume->fileIsReadable()) or (!newVolume->readVolume())) {
+			ProfileTimer readTimer(VolumeProfile::ReadVolume);
+			bool readable = newVolume->fileIsReadable() && newVolume->readVolume();
+			readTimer.stop();
+			if(!readable) {
 			  emit log(Message(QString("The radar data file " + newVolume->getFileName() +
 						   " is not readable"), -1, this->objectName()));
+			  if(profile != NULL)
+			    profile->endVolume(false);
+			  delete newVolume;
+			  continue;
+			}
+			// A resumed run may be handed a volume it has already analyzed
+			// when the file name has no time in it
+			if(resumed && !_vortexList.isEmpty()
+			   && (newVolume->getDateTime() <= _vortexList.last().getTime())) {
+			  emit log(Message(QString("Skipping " + newVolume->getFileName() +
+						   ", it has already been analyzed"), -1, this->objectName()));
+			  if(profile != NULL)
+			    profile->endVolume(false);
 			  delete newVolume;
 			  continue;
 			}
 			std::cout << newVolume->getDateTimeString().toStdString() << ": ";
+			if(profile != NULL)
+				profile->setVolumeTime(newVolume->getDateTime());
 
 			// TODO what do we do with that? not needed, will it break anything "volume coverage pattern"
 			emit newVCP(newVolume->getVCP());
@@ -136,15 +197,14 @@ void workThread::run()
 
 			if (preGridded) {
 
-			  gridData = gridFactory->fillPreGriddedData(newVolume, configData);
+			  ProfileTimer cappiTimer(VolumeProfile::Cappi);
+			  gridData = gridFactory->fillPreGriddedData(newVolume, settings);
+			  cappiTimer.stop();
 			  newVolume->setPreGridded();
 
 			  // See if the config wants to overwrite the default max unambiguated range
-			  QDomElement n = configData->getConfig("radar").firstChildElement("max_unambig_range");
-			  if (! n.isNull() ) {
-			    float maxRange = n.text().toFloat();
-			    newVolume->setMaxRange(maxRange);
-			  }
+			  if (settings.radar.maxUnambigRange != -1)
+			    newVolume->setMaxRange(settings.radar.maxUnambigRange);
 
 			  //STEP 3: get the first guess of center Lat,Lon for simplex
 			  _latlonFirstGuess(newVolume);
@@ -157,11 +217,13 @@ void workThread::run()
 			} else {
 
 			  //radar data quality control
+			  ProfileTimer qcTimer(VolumeProfile::QualityControl);
 			  RadarQC* dealiaser=new RadarQC(newVolume);
 			  connect(dealiaser,SIGNAL(log(const Message&)),
 				  this,SLOT(catchLog(const Message&)));
-			  dealiaser->getConfig(configData->getConfig("qc"));
+			  dealiaser->getConfig(settings.qc);
 			  dealiaser->dealias();
+			  qcTimer.stop();
 			  emit log(Message("Finished QC and Dealiasing",10, this->objectName()));
 			  delete dealiaser;
 			  if(abort) {
@@ -180,12 +242,23 @@ void workThread::run()
 			  if(abort) break;
 
 			  //STEP 4: from Radardata ---> Griddata, make cappi
-			  gridData = gridFactory->makeCappi(newVolume, configData, &_firstGuessLat, &_firstGuessLon);
+			  ProfileTimer cappiTimer(VolumeProfile::Cappi);
+			  gridData = gridFactory->makeCappi(newVolume, settings, &_firstGuessLat, &_firstGuessLon);
+			  CappiGrid* cappi = dynamic_cast<CappiGrid*>(gridData);
+			  if (cappi != NULL)
+			    emit log(Message(QString("Gridded the cappi with " + cappi->getInterpolation()
+						     + " interpolation in "
+						     + QString().setNum(cappi->getInterpolationMsecs()) + " ms"),
+					     0, this->objectName()));
 			}
 
-			gridData->writeAsi();
+			if ((cappiWriter != NULL) && !preGridded) {
+			  if (!gridData->writeCappi(*cappiWriter, newVolume->getDateTime()))
+			    emit log(Message(QString("Could not write the cappi for " + newVolume->getFileName()),
+					     0, this->objectName()));
+			}
 			emit log(Message("Done with Cappi", 15, this->objectName()));
-			emit newCappi(*gridData);
+			emit newCappi(gridData->snapshot());
 
 			if(abort) {
 			  delete newVolume;
@@ -195,6 +268,8 @@ void workThread::run()
 			}
 
 			if(just_display) {
+			  if(profile != NULL)
+			    profile->endVolume(false);
 			  // sleep 3 seconds to give the user a chance to click around
 			  sleep(3);
 			  continue;
@@ -203,8 +278,12 @@ void workThread::run()
 			VortexData *vortexData;
 			int bestLevel;
 
+			ProfileTimer centerTimer(VolumeProfile::FindCenter);
 			if (runSimplex) {
 			  if ( ! findCenter(newVolume, gridData, bottomLevel, &vortexData, &bestLevel) ) {
+			    centerTimer.stop();
+			    if(profile != NULL)
+			      profile->endVolume(false);
 			    delete newVolume;
 			    delete gridFactory;
 			    delete gridData;
@@ -216,23 +295,20 @@ void workThread::run()
                           bestLevel = vortexData->getBestLevel();
 			  updateCappiDisplayInfo(gridData, vortexData, radarLat, radarLon, _firstGuessLat, _firstGuessLon);
   			}
+			centerTimer.stop();
 
 			//STEP 6: Check for new pressure data to process for the current volume
 
-			if( pressureSource->hasUnprocessedData()) {
-				// Create a list of new pressure observations that have not yet been processed
-				QList<PressureData>* newObs = pressureSource->getUnprocessedData();
+			// Create a list of new pressure observations that have not yet been processed
+			PressureList* newObs = NULL;
+			if(batch)
+				newObs = pressureSource->readDataUntil(newVolume->getDateTime());
+			else if(pressureSource->hasUnprocessedData())
+				newObs = pressureSource->getUnprocessedData();
+			if(newObs != NULL) {
 				// Add any new observations to the list of observations which are used to calculate the current pressure
 				for (int i = newObs->size()-1;i>=0; i--) {
-					bool match = false;
-					for(int j = 0; (!match)&&(j < _pressureList.size()); j++) {
-						if(_pressureList.value(j)==newObs->value(i)) {
-							match = true;
-						}
-					}
-					if(!match) {
-						_pressureList.append(newObs->at(i));
-					}
+					_pressureList.addObservation(newObs->at(i));
 				}
 				delete newObs;
 			}
@@ -250,9 +326,7 @@ void workThread::run()
 			float range = GriddedData::getCartesianDistance(radarLat, radarLon,
 									vortexData->getLat(bestLevel),
 									vortexData->getLon(bestLevel));
-			if (range < newVolume->getMaxUnambig_range()
-			    - configData->getParam(configData->getConfig("center"),
-						   "innerradius").toFloat()) {
+			if (range < newVolume->getMaxUnambig_range() - settings.center.innerRadius) {
 
 			  emit log(Message("Estimating pressure", 1, this->objectName()));
 
@@ -263,7 +337,9 @@ void workThread::run()
 	                pVtd->setOuterRadius(atcf->getOuterRadius());
 	            }
 
-		    pVtd->getWinds(configData, gridData, newVolume, vortexData, &_pressureList); // Runs the VortexThread
+		    ProfileTimer windsTimer(VolumeProfile::Winds);
+		    pVtd->getWinds(settings, gridData, newVolume, vortexData, &_pressureList); // Runs the VortexThread
+		    windsTimer.stop();
 	            delete pVtd;
 
 		    if (vortexData->getMaxValidRadius() != -999) {
@@ -302,6 +378,7 @@ void workThread::run()
 
             //STEP 8: finish a round of analysis, clear up
             emit vortexListUpdate(&_vortexList);
+            emit volumeAnalyzed(newVolume->getDateTime());
             emit log(Message(QString("Completed Analysis On Volume "+newVolume->getFileName()),100,this->objectName()));
             delete newVolume;
             delete gridFactory;
@@ -310,13 +387,18 @@ void workThread::run()
         if(abort) break;
 
             //STEP 9: after finish process each volume,save data to XML
-            _vortexList.saveXML();
-            _simplexList.saveXML();
-            _pressureList.saveXML();
+            ProfileTimer saveTimer(VolumeProfile::SaveLists);
+            _vortexList.save();
+            _simplexList.save();
+            _pressureList.save();
 	    vortexData->saveCoefficients(coeffFilePath);
+	    saveTimer.stop();
+	    if(profile != NULL)
+		profile->endVolume();
         } else {
-            //if there's no data, have a little rest
-            sleep(2);
+            //if there's no data, wait for the next volume to be written
+            if (dataSource->waitForNewData(2000))
+                continue;
             //if in batch mode, abort
             if (this->parent()){
 				std::cout<<"Finished processing all files in batch mode\n";
@@ -326,8 +408,18 @@ void workThread::run()
         }
 
 	} // while ! abort
+
+	// Leave complete xml files behind for the tools that read them, and
+	// snapshots for the next run to restore from
+	_vortexList.saveAll();
+	_simplexList.saveAll();
+	_pressureList.saveAll();
+    delete profile;
+    delete cappiWriter;
     delete dataSource;
     delete pressureSource;
+    delete centerFinder;
+    centerFinder = NULL;
 }
 
 // This slot is used for log message relaying
@@ -345,7 +437,7 @@ void workThread::catchVCP(const int vcp)
 	emit newVCP(vcp);
 }
 
-void workThread::catchCappi(const GriddedData& cappi)
+void workThread::catchCappi(const CappiSnapshot& cappi)
 {
 	emit newCappi(cappi);
 }
@@ -362,9 +454,8 @@ void workThread::setContinuePreviousRun(const bool &decision)
 void workThread::checkIntensification()
 {
 	// Checks for any rapid changes in pressure
-	QDomElement pressure = configData->getConfig("pressure");
 	// Units of mb/hr
-	float rapidRate = configData->getParam(pressure, QString("rapidlimit")).toFloat();
+	float rapidRate = settings.pressure.rapidLimit;
 	if(std::isnan(rapidRate)) {
 		emit log(Message(QString("Could Not Find Rapid Intensification Rate, Using 3 mb/hr"),0,this->objectName()));
 		rapidRate = 3.0;
@@ -372,7 +463,7 @@ void workThread::checkIntensification()
 
 	// So we don't report falsely there must be a rapid increase trend which
 	// spans several measurements Number of volumes which are averaged.
-	int volSpan = configData->getParam(pressure, QString("av_interval")).toInt();
+	int volSpan = settings.pressure.avInterval;
 	if(std::isnan(volSpan)) {
 		emit log(Message(QString("Could Not Find Pressure Averaging Interval for Rapid Intensification, Using 8 volumes"),0,this->objectName()));
 		volSpan = 8;
@@ -430,6 +521,60 @@ void workThread::checkIntensification()
 }
 
 
+bool workThread::restorePreviousRun()
+{
+	// Reload the lists of an interrupted run. RadarFactory::updateDataQueue
+	// then skips every volume up to the last one in the vortex list.
+	bool vortexOk = _vortexList.restore();
+	bool simplexOk = _simplexList.restore();
+	if(!_pressureList.restore())
+		_pressureList.clear();
+
+	if(!vortexOk || !simplexOk || _vortexList.isEmpty()) {
+		emit log(Message(QString("No usable lists from a previous run were found, starting from the first volume"),0,this->objectName()));
+		_vortexList.clear();
+		_simplexList.clear();
+		return false;
+	}
+
+	// Simplex results are only comparable if the center search is set up
+	// the same way as in the previous run
+	const CenterSettings& center = settings.center;
+	float firstRing = center.innerRadius;
+	float lastRing = center.outerRadius;
+	int numRadii = (int)floor((lastRing - firstRing) + 1.5);
+	int numPoints = center.numPoints;
+	int numLevels = -1;
+	bool preGridded = settings.radar.preGridded;
+	float zGridsp = settings.cappi.zgridsp;
+	if(!preGridded && (zGridsp > 0)) {
+		float firstLevel = center.bottomLevel;
+		float lastLevel = center.topLevel;
+		numLevels = (int)floor((lastLevel - firstLevel) / zGridsp + 1.5);
+	}
+	for(int ss = 0; ss < _simplexList.count(); ss++) {
+		const SimplexData& simplex = _simplexList.at(ss);
+		if((simplex.getNumRadii() != numRadii) || (simplex.getNumPointsUsed() != numPoints)
+		   || ((numLevels >= 0) && (simplex.getNumLevels() != numLevels))) {
+			emit log(Message(QString("The previous run used a different center search configuration, starting from the first volume"),0,this->objectName()));
+			_vortexList.clear();
+			_simplexList.clear();
+			return false;
+		}
+	}
+
+	_vortexList.timeSort();
+	_simplexList.timeSort();
+	checkListConsistency();
+	if(_vortexList.isEmpty())
+		return false;
+
+	emit log(Message(QString("Resuming previous run after the volume at "
+				 + _vortexList.last().getTime().toString(Qt::ISODate)),0,this->objectName()));
+	emit vortexListUpdate(&_vortexList);
+	return true;
+}
+
 void workThread::checkListConsistency()
 {
 	if(_vortexList.count()!=_simplexList.count()) {
@@ -461,10 +606,12 @@ void workThread::checkListConsistency()
 	}
 	// Removing the last ones for safety, any partially formed file could do serious damage
 	// to data integrity
-	_simplexList.removeAt(_simplexList.count()-1);
-	_simplexList.saveXML();
-	_vortexList.removeAt(_vortexList.count()-1);
-	_vortexList.saveXML();
+	if(!_simplexList.isEmpty())
+		_simplexList.removeAt(_simplexList.count()-1);
+	_simplexList.saveAll();
+	if(!_vortexList.isEmpty())
+		_vortexList.removeAt(_vortexList.count()-1);
+	_vortexList.saveAll();
 }
 
 void workThread::catchCappiInfo(float x, float y, float rmwEstimate, float sMin, float sMax, float vMax,
@@ -514,7 +661,7 @@ void workThread::loadCenterLocations(QString fName)
 
 void workThread::_latlonFirstGuess(RadarData* radarVolume)
 {
-  QString mode = configData->getParam(configData->getConfig("vortex"),"mode");
+  QString mode = settings.vortex.mode;
   QDateTime volDateTime = radarVolume->getDateTime();
 
   if (mode == "operational") {
@@ -547,8 +694,8 @@ void workThread::_latlonFirstGuess(RadarData* radarVolume)
   // This assumes that the storm speed and direction are somewhat correct in the config file.
   // If set to 0, this will end up being the Lat and Lon specified in the config.
 
-  float stormSpd = configData->getParam(configData->getConfig("vortex"),"speed").toFloat();
-  float stormDir = configData->getParam(configData->getConfig("vortex"),"direction").toFloat();
+  float stormSpd = settings.vortex.speed;
+  float stormDir = settings.vortex.direction;
   stormDir = 450.0f - stormDir;
   if(stormDir > 360.0f)
     stormDir -= 360.0f;
@@ -557,11 +704,9 @@ void workThread::_latlonFirstGuess(RadarData* radarVolume)
   //calculate the expolation from user define center
 
   // Get initial lat and lon
-  float initLat = configData->getParam(configData->getConfig("vortex"),"lat").toFloat();
-  float initLon = configData->getParam(configData->getConfig("vortex"),"lon").toFloat();
-  QDate obsDate = QDate::fromString(configData->getParam(configData->getConfig("vortex"),"obsdate"),"yyyy-MM-dd");
-  QTime obsTime = QTime::fromString(configData->getParam(configData->getConfig("vortex"),"obstime"),"hh:mm:ss");
-  QDateTime usrDateTime = QDateTime(obsDate, obsTime, Qt::UTC);
+  float initLat = settings.vortex.lat;
+  float initLon = settings.vortex.lon;
+  QDateTime usrDateTime = QDateTime(settings.vortex.obsDate, settings.vortex.obsTime, Qt::UTC);
   int elapsedSeconds = usrDateTime.secsTo(volDateTime);
 
   float distanceMoved = elapsedSeconds*stormSpd / 1000.0;
@@ -611,8 +756,8 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
 {
   emit log(Message("Finding center",1,this->objectName()));
 
-  float radarLat = configData->getParam(configData->getConfig("radar"), "lat").toFloat();
-  float radarLon = configData->getParam(configData->getConfig("radar"), "lon").toFloat();
+  float radarLat = settings.radar.lat;
+  float radarLon = settings.radar.lon;
 
   VortexData *vortexData = new VortexData();
 
@@ -621,7 +766,7 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
   std::cout << "Vortex time: " << radar_data->getDateTime().toString("hh:mm").toLatin1().data() << std::endl;
 
   SimplexThread* pSimplex = new SimplexThread();
-  pSimplex->initParam(configData, grid_data, _firstGuessLat, _firstGuessLon);
+  pSimplex->initParam(settings, grid_data, _firstGuessLat, _firstGuessLon);
 
   // TODO this does the work.
   // We get "Center Not Found" if we pick a center bottom_level too low in the config file.
@@ -667,9 +812,11 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
   if (maxConvergedLevel > -1) {
     _simplexList.timeSort();
 
-    ChooseCenter *centerFinder = new ChooseCenter(configData, &_simplexList, vortexData);
+    if(centerFinder == NULL)
+      centerFinder = new ChooseCenter(settings, &_simplexList, vortexData);
+    else
+      centerFinder->setVortexData(vortexData);
     centerFinder->findCenter(maxConvergedLevel);
-    delete centerFinder;
 
     // Find the best std dev among all the levels that have enough converged rings.
 
@@ -705,8 +852,7 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
 						    vortexData->getLat(bestLevel),
 						    vortexData->getLon(bestLevel));
     if( (userDistance > 25.0f)
-	or (range > radar_data->getMaxUnambig_range() -
-	    configData->getParam(configData->getConfig("center"), "innerradius").toFloat())) {
+	or (range > radar_data->getMaxUnambig_range() - settings.center.innerRadius)) {
       Message newMsg(QString(), 5, this->objectName(),
 		     Yellow, "Center Not Found");
       emit log(newMsg);
@@ -777,9 +923,8 @@ VortexData *workThread::useBestGuessCenter(RadarData *radar_data, float bottom_l
   //       Need to put that in a function
 
   int gradientHeight = 2; // default
-  QString gradientConfig = configData->getParam(configData->getConfig("pressure"), "gradient_height");
-  if(gradientConfig != "")
-    gradientHeight = gradientConfig.toFloat();
+  if(settings.pressure.gradientHeight != -999)
+    gradientHeight = settings.pressure.gradientHeight;
   if(gradientHeight < bottom_level) {
     gradientHeight = bottom_level;
     std::cout << "Warning: VortexThread gradientHeight adjusted to " << bottom_level << std::endl;
@@ -805,18 +950,15 @@ void workThread::updateCappiDisplayInfo(GriddedData *grid_data, VortexData *vort
 					float radar_lat, float radar_lon,
 					float simplex_lat, float simplex_lon)
 {
-  QDomElement simplex = configData->getConfig("center");
-  QDomElement vtd   = configData->getConfig("vtd");
-
   int bestLevel = vortex_data->getBestLevel();
 
   float* xyValues = grid_data->getCartesianPoint(&radar_lat, &radar_lon, &simplex_lat, &simplex_lon);
   float xPercent = float(grid_data->getIndexFromCartesianPointI(xyValues[0])+1)/grid_data->getIdim();
   float yPercent = float(grid_data->getIndexFromCartesianPointJ(xyValues[1])+1)/grid_data->getJdim();
   float rmwEstimate = vortex_data->getRMW(bestLevel)/(grid_data->getIGridsp()*grid_data->getIdim());
-  float sMin = configData->getParam(simplex, "innerradius").toFloat()/(grid_data->getIGridsp()*grid_data->getIdim());
-  float sMax = configData->getParam(simplex, "outerradius").toFloat()/(grid_data->getIGridsp()*grid_data->getIdim());
-  float vMax = configData->getParam(vtd, "outerradius").toFloat()/(grid_data->getIGridsp()*grid_data->getIdim());
+  float sMin = settings.center.innerRadius/(grid_data->getIGridsp()*grid_data->getIdim());
+  float sMax = settings.center.outerRadius/(grid_data->getIGridsp()*grid_data->getIdim());
+  float vMax = settings.vtd.outerRadius/(grid_data->getIGridsp()*grid_data->getIdim());
   emit newCappiInfo(xPercent, yPercent, rmwEstimate, sMin, sMax, vMax, radar_lat, radar_lon, simplex_lat, simplex_lon);
   delete [] xyValues;
 }
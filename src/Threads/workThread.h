@@ -50,7 +50,7 @@ public:
 public slots:
     void catchLog(const Message& message);
     void catchVCP(const int vcp);
-    void catchCappi(const GriddedData& cappi);
+    void catchCappi(const CappiSnapshot& cappi);
     void catchCappiInfo(float x,float y,float rmwEstimate,float sMin,float sMax,float vMax,
                         float userLat,float userLon,float lat,float lon);
     void setOnlyRunOnce(const bool newRunOnce = true);
@@ -61,9 +61,10 @@ signals:
     void log(const Message& message);
     void newVCP(const int);
     void vortexListUpdate(VortexList* list);
-    void newCappi(const GriddedData& cappi);
+    void newCappi(const CappiSnapshot& cappi);
     void newCappiInfo(float x,float y,float rmwEstimate,float sMin,float sMax,float vMax,
                       float userLat,float userLon,float lat,float lon);
+    void volumeAnalyzed(const QDateTime& volumeTime);
     void finished();
 
 private:
@@ -75,6 +76,10 @@ private:
     RadarFactory    *dataSource;
     PressureFactory *pressureSource;
     Configuration   *configData;
+    // Copy of the configuration the current run works from
+    ConfigSnapshot  settings;
+    // Kept for the whole run so past volumes are not scored again
+    ChooseCenter    *centerFinder;
 
     VortexList   _vortexList;
     SimplexList  _simplexList;
@@ -85,6 +90,7 @@ private:
     
     void _latlonFirstGuess(RadarData* radarVolume);
     void checkIntensification();
+    bool restorePreviousRun();
     void checkListConsistency();
     void loadCenterLocations(QString centerFile);
     
@@ -12,6 +12,7 @@
 #include <math.h>
 #include "IO/Message.h"
 #include "Math/Matrix.h"
+#include "IO/VolumeProfile.h"
 
 GBVTD::GBVTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
   : VTD(initClosure, wavenumbers, gaps, hvvpwind)
@@ -26,38 +27,29 @@ bool GBVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& he
                         float*& ringData, float*& ringAzimuths, Coefficient*& vtdCoeffs, float& vtdStdDev)
 {
   // Analyze a ring of data
-  
-  // Make a Psi array
-  ringPsi = new float[numData];
-  vel = new float[numData];
-  psi = new float[numData];
+  VolumeProfile::count(VolumeProfile::RingsAnalyzed);
 
   // Get thetaT
   thetaT = atan2(yCenter,xCenter);
   thetaT = fixAngle(thetaT);
   centerDistance = sqrt(xCenter*xCenter + yCenter*yCenter);
 
+  // Convert the good points to Psi, thresholding bad values
+  reserveRing(numData);
+  int goodCount = 0;
+
   for (int i = 0; i <= numData - 1; i++) {
-    // Convert to Psi
+    if (ringData[i] == -999.)
+      continue;
     float angle = ringAzimuths[i] * DEG2RAD - thetaT;
     angle = fixAngle(angle);
     float xx = xCenter + radius * cos(angle + thetaT);
     float yy = yCenter + radius * sin(angle + thetaT);
     float psiCorrection = atan2(yy, xx) - thetaT;
-    ringPsi[i] = angle - psiCorrection;
-    ringPsi[i] = fixAngle(ringPsi[i]);
-  }
-
-  // Threshold bad values
-  int goodCount = 0;
-
-  for (int i = 0; i <= numData - 1; i++) {
-    if (ringData[i] != -999.) {
-      // Good point
-      vel[goodCount] = ringData[i];
-      psi[goodCount] = ringPsi[i];
-      goodCount++;
-    }
+    float ringPsi = angle - psiCorrection;
+    vel[goodCount] = ringData[i];
+    psi[goodCount] = fixAngle(ringPsi);
+    goodCount++;
   }
   numData = goodCount;
 
@@ -72,51 +64,17 @@ bool GBVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& he
     }
     vtdStdDev = -999;
     setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
     return false;
   }
 
   // Least squares
-  float** xLLS = new float*[numCoeffs];
-  for (int i = 0; i <= numCoeffs - 1; i++) {
-    xLLS[i] = new float[numData];
-  }
-  float* yLLS = new float[numData];
-  for (int i = 0; i <= numData - 1; i++) {
-    xLLS[0][i] = 1.;
-    for (int j = 1; j <= (numCoeffs / 2); j++) {
-      xLLS[2 * j - 1][i] = sin(float(j) * psi[i]);
-      xLLS[ 2 * j][i] = cos(float(j) * psi[i]);
-    }
-    yLLS[i] = vel[i];
-  }
-
-  float* stdError = new float[numCoeffs];
-  if( ! Matrix::lls(numCoeffs, numData, xLLS, yLLS, vtdStdDev, FourierCoeffs, stdError)) {
+  if( ! fitRing(numData, numCoeffs, vtdStdDev)) {
     //Message::toScreen("GBVTD Returned Nothing from LLS");
-    for (int i = 0; i <= numCoeffs - 1; i++)
-      delete[] xLLS[i];
-    delete[] yLLS;
-    delete[] stdError;
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
     return false;
   }
 
   // Convert Fourier coefficients into wind coefficients
   setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
-  for (int i = 0; i <= numCoeffs - 1; i++)
-    delete[] xLLS[i];
-  delete[] xLLS;
-  delete[] yLLS;
-  delete[] stdError;
-  delete[] ringPsi;
-  delete[] vel;
-  delete[] psi;
-  
   return true;
 }
 
@@ -157,7 +115,7 @@ void GBVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs,
 
     vtdCoeffs[0].setLevel(level);
     vtdCoeffs[0].setRadius(radius);
-    vtdCoeffs[0].setParameter("VTC0");
+    vtdCoeffs[0].setTerm(Coefficient::VTC0);
     float value;
     if(closure.contains(QString("hvvp"), Qt::CaseInsensitive) and
        (B[1] != 0)) {
@@ -170,19 +128,19 @@ void GBVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs,
 
     vtdCoeffs[1].setLevel(level);
     vtdCoeffs[1].setRadius(radius);
-    vtdCoeffs[1].setParameter("VRC0");
+    vtdCoeffs[1].setTerm(Coefficient::VRC0);
     value = A[1] +A[3];
     vtdCoeffs[1].setValue(value);
 
     vtdCoeffs[2].setLevel(level);
     vtdCoeffs[2].setRadius(radius);
-    vtdCoeffs[2].setParameter("VMC0");
+    vtdCoeffs[2].setTerm(Coefficient::VMC0);
     value = A[0] + A[2]+ A[4];
     vtdCoeffs[2].setValue(value);
 
     vtdCoeffs[3].setLevel(level);
     vtdCoeffs[3].setRadius(radius);
-    vtdCoeffs[3].setParameter("VTS1");
+    vtdCoeffs[3].setTerm(Coefficient::VTS1);
 
     if ((sinAlphamax < 0.8) and (numCoeffs >= 5)) {
       value = A[2] - A[0] + A[4] + (A[0] + A[2] + A[4]) * cosAlphamax;
@@ -197,7 +155,7 @@ void GBVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs,
 
     vtdCoeffs[4].setLevel(level);
     vtdCoeffs[4].setRadius(radius);
-    vtdCoeffs[4].setParameter("VTC1");
+    vtdCoeffs[4].setTerm(Coefficient::VTC1);
 	
     if ((sinAlphamax < 0.8) and (numCoeffs >= 5)) {
       value = -2. * (B[2] + B[4]);
@@ -213,15 +171,13 @@ void GBVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs,
     for (int i=5; i <= numCoeffs - 1; i += 2) {
       vtdCoeffs[i].setLevel(level);
       vtdCoeffs[i].setRadius(radius);
-      QString param = "VTC" + QString().setNum(int(i / 2));
-      vtdCoeffs[i].setParameter(param);
+      vtdCoeffs[i].setTerm(Coefficient::cosineTerm(i / 2));
       value = -2. * B[i / 2 + 1];
       vtdCoeffs[i].setValue(value);
 
       vtdCoeffs[i+1].setLevel(level);
       vtdCoeffs[i+1].setRadius(radius);
-      param = "VTS" + QString().setNum(int(i / 2));
-      vtdCoeffs[i + 1].setParameter(param);
+      vtdCoeffs[i + 1].setTerm(Coefficient::sineTerm(i / 2));
       value = 2 * A[i / 2 + 1];
       vtdCoeffs[i + 1].setValue(value);
     }
@@ -14,6 +14,7 @@
 #include <math.h>
 #include "IO/Message.h"
 #include "Math/Matrix.h"
+#include "IO/VolumeProfile.h"
 
 
 GVTD::GVTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
@@ -30,39 +31,28 @@ bool GVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& hei
 {
   // Implement GVTD by Ting-Yu Cha, 11/03/2017
   // Analye a ring of data
-
-  // Make a Psi array
-  
-  ringPsi = new float[numData];
-  vel = new float[numData];
-  psi = new float[numData];
-  float *ringDistance = new float[numData];
+  VolumeProfile::count(VolumeProfile::RingsAnalyzed);
 
   // Get thetaT
   thetaT = atan2(yCenter,xCenter);
   thetaT = fixAngle(thetaT);
   centerDistance = sqrt(xCenter * xCenter + yCenter * yCenter);
 
+  // Convert the good points to Psi, thresholding bad values
+  reserveRing(numData);
+  int goodCount = 0;
+
   for (int i = 0; i < numData; i++) {
-    // Convert to Psi
+    if (ringData[i] == -999.)
+      continue;
     float angle = ringAzimuths[i] * DEG2RAD - thetaT;
     angle = fixAngle(angle);
     float xx = xCenter + radius * cos(angle + thetaT);
     float yy = yCenter + radius * sin(angle + thetaT);
-    ringDistance[i] = sqrt(xx * xx + yy * yy);
-    ringPsi[i] = angle;
-  }
-
-  // Threshold bad values
-  int goodCount = 0;
-
-  for (int i = 0; i < numData; i++) {
-    if (ringData[i] != -999.) {
-      // Good point
-      vel[goodCount] = ringData[i] * ringDistance[i] / centerDistance;
-      psi[goodCount] = ringPsi[i];
-      goodCount++;
-    }
+    float ringDistance = sqrt(xx * xx + yy * yy);
+    vel[goodCount] = ringData[i] * ringDistance / centerDistance;
+    psi[goodCount] = angle;
+    goodCount++;
   }
   numData = goodCount;
 
@@ -76,53 +66,15 @@ bool GVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& hei
     }
     vtdStdDev = -999;
     setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
-    delete[] ringDistance;
     return false;
   }
 
   // Least squares
-  
-  float** xLLS = new float*[numCoeffs];
-  for (int i = 0; i <= numCoeffs - 1; i++) {
-    xLLS[i] = new float[numData];
-  }
-  float* yLLS = new float[numData];
-  for (int i = 0; i <= numData - 1; i++) {
-    xLLS[0][i] = 1.;
-    for (int j = 1; j <= (numCoeffs / 2); j++) {
-      xLLS[2 * j - 1][i] = sin(float(j) * psi[i]);
-      xLLS[ 2 * j][i] = cos(float(j) * psi[i]);
-    }
-    yLLS[i] = vel[i];
-  }
-
-  float* stdError = new float[numCoeffs];
-  if( ! Matrix::lls(numCoeffs, numData, xLLS, yLLS, vtdStdDev, FourierCoeffs, stdError)) {
-    for (int i = 0; i <= numCoeffs - 1; i++)
-      delete[] xLLS[i];
-    delete[] yLLS;
-    delete[] stdError;
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
+  if( ! fitRing(numData, numCoeffs, vtdStdDev))
     return false;
-  }
 
   // Convert Fourier coefficients into wind coefficients
   setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
-  
-  for (int i = 0; i <= numCoeffs - 1; i++)
-    delete[] xLLS[i];
-  
-  delete[] xLLS;
-  delete[] yLLS;
-  delete[] stdError;
-  delete[] ringPsi;
-  delete[] vel;
-  delete[] psi;
 
   return true;
 }
@@ -189,14 +141,14 @@ void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs, floa
       // Implement GVTD by Ting-Yu Cha 11/03/2017
       vtdCoeffs[0].setLevel(level);
       vtdCoeffs[0].setRadius(radius);
-      vtdCoeffs[0].setParameter("VTC0");
+      vtdCoeffs[0].setTerm(Coefficient::VTC0);
       float value;
       value = - B[1] - B[3];
       vtdCoeffs[0].setValue(value);
 
       vtdCoeffs[1].setLevel(level);
       vtdCoeffs[1].setRadius(radius);
-      vtdCoeffs[1].setParameter("VRC0");
+      vtdCoeffs[1].setTerm(Coefficient::VRC0);
       value = (A[0] + A[1] + A[2] + A[3] + A[4]) / ( 1 + radius / centerDistance);
       vtdCoeffs[1].setValue(value);
 
@@ -206,22 +158,20 @@ void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs, floa
       for (int i=3; i <= numCoeffs - 1; i += 2) {
 	vtdCoeffs[i].setLevel(level);
 	vtdCoeffs[i].setRadius(radius);
-	QString param = "VTC" + QString().setNum(int(i / 2));
-	vtdCoeffs[i].setParameter(param);
+	vtdCoeffs[i].setTerm(Coefficient::cosineTerm(i / 2));
 	value = -2. * B[i / 2 + 1];
 	vtdCoeffs[i].setValue(value);
 
 	vtdCoeffs[i+1].setLevel(level);
 	vtdCoeffs[i+1].setRadius(radius);
-	param = "VTS" + QString().setNum(int(i / 2));
-	vtdCoeffs[i + 1].setParameter(param);
+	vtdCoeffs[i + 1].setTerm(Coefficient::sineTerm(i / 2));
 	value = 2 * A[i / 2 + 1];
 	vtdCoeffs[i + 1].setValue(value);
       }
       
       vtdCoeffs[2].setLevel(level);
       vtdCoeffs[2].setRadius(radius);
-      vtdCoeffs[2].setParameter("VMC0");
+      vtdCoeffs[2].setTerm(Coefficient::VMC0);
       value = A[0] - ( radius / centerDistance * vtdCoeffs[1].getValue() ) + 0.5 * vtdCoeffs[4].getValue();
       // rhs value is VRC0 value computed just above
       vtdCoeffs[2].setValue(value);
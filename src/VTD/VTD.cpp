@@ -26,6 +26,9 @@ VTD::VTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
     _maxWaveNum = wavenumbers;
     dataGaps = gaps;
     FourierCoeffs = new float[_maxWaveNum * 2 + 3];
+    llsWork.reserve(_maxWaveNum * 2 + 3);
+    llsRow.resize(_maxWaveNum * 2 + 3);
+    stdError.resize(_maxWaveNum * 2 + 3);
     _hvvpMean = hvvpwind;
 }
 
@@ -81,6 +84,50 @@ int VTD::getNumCoefficients(int& numData)
     return 0;
 }
 
+void VTD::reserveRing(int numData)
+{
+    if ((int)vel.size() < numData) {
+        vel.resize(numData);
+        psi.resize(numData);
+    }
+}
+
+bool VTD::fitRing(int numData, int numCoeffs, float& stdDev)
+{
+    if (numData < numCoeffs)
+        return false;
+    if (!Matrix::llsBegin(llsWork, numCoeffs))
+        return false;
+
+    // Columns are 1, then sin and cos of each wavenumber
+    float* row = &llsRow[0];
+    row[0] = 1.;
+    for (int i = 0; i <= numData - 1; i++) {
+        for (int j = 1; j <= (numCoeffs / 2); j++) {
+            row[2 * j - 1] = sin(float(j) * psi[i]);
+            row[2 * j] = cos(float(j) * psi[i]);
+        }
+        Matrix::llsAdd(llsWork, numCoeffs, row, vel[i]);
+    }
+    if (!Matrix::llsSolve(llsWork, numCoeffs, numData, FourierCoeffs))
+        return false;
+
+    // Residuals of the fit, with the rows built again rather than kept
+    double sum = 0;
+    for (int i = 0; i <= numData - 1; i++) {
+        for (int j = 1; j <= (numCoeffs / 2); j++) {
+            row[2 * j - 1] = sin(float(j) * psi[i]);
+            row[2 * j] = cos(float(j) * psi[i]);
+        }
+        float regValue = 0;
+        for (int j = 0; j < numCoeffs; j++)
+            regValue += FourierCoeffs[j] * row[j];
+        sum += ((vel[i] - regValue) * (vel[i] - regValue));
+    }
+    Matrix::llsErrors(llsWork, numCoeffs, numData, sum, stdDev, &stdError[0]);
+    return true;
+}
+
 float VTD::fixAngle(float& angle)
 {
     // Make sure an angle is between 0 and 2Pi
@@ -12,6 +12,8 @@
 
 #include <QString>
 #include "DataObjects/Coefficient.h"
+#include "Math/Matrix.h"
+#include <vector>
 
 class VTD
 {
@@ -40,7 +42,14 @@ class VTD
   float fixAngle(float& angle);
 
  protected:
-    
+
+  // Fits the Fourier series to the first numData points of vel and psi,
+  // into FourierCoeffs. The rows go straight into llsWork, so a ring
+  // allocates nothing.
+  bool fitRing(int numData, int numCoeffs, float& stdDev);
+  // Grows vel and psi to hold numData points
+  void reserveRing(int numData);
+
   static const float PI     ;
   static const float DEG2RAD;
   static const float RAD2DEG;
@@ -50,13 +59,18 @@ class VTD
   int _maxWaveNum;
   float* dataGaps;
 
-  float* ringPsi;
-  float* vel;
-  float* psi;
+  // Good points of the ring being analyzed, grown to the largest ring
+  std::vector<float> vel;
+  std::vector<float> psi;
   float thetaT;
   float centerDistance;
   float level;
   float* FourierCoeffs;
+  // Reused by every ring fit, sized for the maximum wavenumber
+  LLSWorkspace llsWork;
+  // One row of the fit and the standard errors, sized with llsWork
+  std::vector<float> llsRow;
+  std::vector<float> stdError;
 
   float _hvvpMean;
 
@@ -40,7 +40,7 @@ float MGBVTD::computeCrossBeamWind(float guessMax, QString& velField, GBVTD* gbv
 		Coefficient* coeff = new Coefficient[20];
 		float vtdDev;
 		if(gbvtd->analyzeRing(m_centerx, m_centery, rng, m_centerz, numData, ringData, ringAzi, coeff, vtdDev)){
-			if(coeff[0].getParameter()=="VTC0"){
+			if(coeff[0].getTerm()==Coefficient::VTC0){
 				vt.push_back(coeff[0].getValue());
 				vt_rng.push_back(rng);
 			}
@@ -58,6 +58,7 @@ QMAKE_CXXFLAGS += -std=c++0x
 HEADERS += Threads/workThread.h \
            Threads/SimplexThread.h \
            Threads/VortexThread.h \
+           Threads/ParallelSlices.h \
            DataObjects/VortexData.h \
            DataObjects/SimplexData.h \
            DataObjects/VortexList.h \
@@ -65,9 +66,15 @@ HEADERS += Threads/workThread.h \
            DataObjects/Coefficient.h \
            DataObjects/Center.h \
            Config/Configuration.h \
+           Config/ConfigSnapshot.h \
            DataObjects/AnalyticGrid.h \
            DataObjects/CappiGrid.h \
+           DataObjects/GateIndex.h \
+           DataObjects/CappiInterpolator.h \
            DataObjects/GriddedData.h \
+           DataObjects/FieldGrid.h \
+           DataObjects/RingIndex.h \
+           DataObjects/CappiWriter.h \
            DataObjects/GriddedFactory.h \
            GUI/ConfigTree.h \
            GUI/ConfigurationDialog.h \
@@ -87,8 +94,12 @@ HEADERS += Threads/workThread.h \
            IO/Message.h \
            IO/Log.h \
            IO/ATCF.h \
+           IO/ListSnapshot.h \
+           IO/ListJournal.h \
+           IO/VolumeProfile.h \
            Radar/DateChecker.h \
            Radar/RadarFactory.h \
+           Radar/DirectoryWatcher.h \
            Radar/LevelII.h \
            Radar/NcdcLevelII.h \
            Radar/RadxGrid.h \
@@ -123,6 +134,7 @@ SOURCES += main.cpp \
            Threads/workThread.cpp \
            Threads/SimplexThread.cpp \
            Threads/VortexThread.cpp \
+           Threads/ParallelSlices.cpp \
            DataObjects/VortexData.cpp \
            DataObjects/SimplexData.cpp \
            DataObjects/VortexList.cpp \
@@ -130,9 +142,15 @@ SOURCES += main.cpp \
            DataObjects/Coefficient.cpp \
            DataObjects/Center.cpp \
            Config/Configuration.cpp \
+           Config/ConfigSnapshot.cpp \
            DataObjects/AnalyticGrid.cpp \
            DataObjects/CappiGrid.cpp \
+           DataObjects/GateIndex.cpp \
+           DataObjects/CappiInterpolator.cpp \
            DataObjects/GriddedData.cpp \
+           DataObjects/FieldGrid.cpp \
+           DataObjects/RingIndex.cpp \
+           DataObjects/CappiWriter.cpp \
            DataObjects/GriddedFactory.cpp \
            GUI/ConfigTree.cpp \
            GUI/ConfigurationDialog.cpp \
@@ -152,8 +170,12 @@ SOURCES += main.cpp \
            IO/Message.cpp \
            IO/Log.cpp \
            IO/ATCF.cpp \
+           IO/ListSnapshot.cpp \
+           IO/ListJournal.cpp \
+           IO/VolumeProfile.cpp \
            Radar/DateChecker.cpp \
            Radar/RadarFactory.cpp \
+           Radar/DirectoryWatcher.cpp \
            Radar/LevelII.cpp \
            Radar/NcdcLevelII.cpp \
            Radar/RadxGrid.cpp \